@@ -112,6 +112,20 @@ typedef struct {
 	 IntPoint end;						/**< Specifies the end co-ordinates */
 } GimpGradientInfo;
 
+typedef CF_ENUM(int, GimpBlurMode) {
+  GIMP_BLUR_AUTO,        /**< Specifies the recursive filter, or three box blurs for huge radii */
+  GIMP_BLUR_RECURSIVE,   /**< Specifies a fourth order recursive approximation of the gaussian */
+  GIMP_BLUR_TRIPLE_BOX   /**< Specifies three successive box blurs */
+};
+
+typedef struct {
+	 GimpBlurMode mode;					/**< Specifies the method used, never automatic */
+	 double n_p[5], n_m[5];				/**< Specifies the input coefficients of the recursive filter */
+	 double d[5];						/**< Specifies the feedback coefficients of the recursive filter */
+	 double edge_p, edge_m;				/**< Specifies how the recursive filter settles at the ends of a line */
+	 int box[3];						/**< Specifies the radius of each box blur */
+} GimpBlurInfo;
+
 typedef struct _GimpVector2 GimpVector2;
 
 struct _GimpVector2
@@ -152,4 +166,35 @@ void GCDrawPolygon(unsigned char *dest, int destWidth, int destHeight, GimpVecto
  */
 void GCRotateImage(unsigned char **dest, int *destWidth, int *destHeight, int *destX, int *destY, unsigned char *src, int srcWidth, int srcHeight, float angle, GimpInterpolationType interpolation_type, int spp, ProgressFunction progress_callback);
 
+/*!
+	@function	GCMakeBlurInfo
+	@discussion	Prepares a gaussian blur of the given radius (the distance at which
+				the gaussian falls to 1/255, less one) for GCBlurColumns and
+				GCBlurRows. The result may be shared between threads.
+ */
+GimpBlurInfo GCMakeBlurInfo(double radius, GimpBlurMode mode);
+
+/*!
+	@function	GCBlurColumns
+	@discussion	Blurs each column of the source bitmap vertically in to the destination
+				bitmap, which may be the same. Only the first channels samples of each
+				pixel are blurred, the rest of the destination is left alone. Columns
+				are independent so a wide bitmap may be split between threads.
+ */
+void GCBlurColumns(unsigned char *dest, int destRowBytes, unsigned char *src, int srcRowBytes, int width, int height, int spp, int channels, const GimpBlurInfo *info);
+
+/*!
+	@function	GCBlurRows
+	@discussion	Blurs each row of the source bitmap horizontally in to the destination
+				bitmap, in the same way as GCBlurColumns.
+ */
+void GCBlurRows(unsigned char *dest, int destRowBytes, unsigned char *src, int srcRowBytes, int width, int height, int spp, int channels, const GimpBlurInfo *info);
+
+/*!
+	@function	GCGaussianBlur
+	@discussion	Blurs the source bitmap in to the destination bitmap, which may be the
+				same, spreading the work across the available cores.
+ */
+void GCGaussianBlur(unsigned char *dest, int destRowBytes, unsigned char *src, int srcRowBytes, int width, int height, int spp, int channels, double radius, GimpBlurMode mode);
+
 #endif /* GIMPCORE_H */
@@ -0,0 +1,379 @@
+#include "GIMPCore.h"
+#include "GIMPBridge.h"
+#include <dispatch/dispatch.h>
+
+/*  Lines are blurred kBlurTile at a time, side by side, so that each step
+ *  of the recursion works on a whole row of the tile at once. Columns are
+ *  taken as they lie in memory, rows are first transposed in to a tile.
+ */
+#define kBlurTile 16
+
+/*  The lines of a tile are padded by this many samples at each end  */
+#define kBlurPad 4
+
+/*  The greatest number of samples across a tile  */
+#define kBlurLanes (kBlurTile * MAX_CHANNELS)
+
+/*  Blurs beyond this radius use three box blurs when the mode is automatic  */
+#define kBlurBoxRadius 250.0
+
+/*  The recursive filter is unstable for deviations below this  */
+#define kBlurMinDeviation 0.5
+
+/*  Each task of GCGaussianBlur handles this many tiles  */
+#define kBlurTilesPerTask 8
+
+static void
+find_constants (double n_p[],
+                double n_m[],
+                double d_p[],
+                double d_m[],
+                double *edge_p,
+                double *edge_m,
+                double std_dev)
+{
+  gint    i;
+  gdouble constants [8];
+  gdouble div;
+  gdouble sum_n_p, sum_n_m, sum_d;
+
+  /*  The constants used in the implemenation of a casual sequence
+   *  using a 4th order approximation of the gaussian operator
+   */
+
+  div = sqrt(2 * G_PI) * std_dev;
+  constants [0] = -1.783 / std_dev;
+  constants [1] = -1.723 / std_dev;
+  constants [2] = 0.6318 / std_dev;
+  constants [3] = 1.997  / std_dev;
+  constants [4] = 1.6803 / div;
+  constants [5] = 3.735 / div;
+  constants [6] = -0.6803 / div;
+  constants [7] = -0.2598 / div;
+
+  n_p [0] = constants[4] + constants[6];
+  n_p [1] = exp (constants[1]) *
+    (constants[7] * sin (constants[3]) -
+     (constants[6] + 2 * constants[4]) * cos (constants[3])) +
+       exp (constants[0]) *
+         (constants[5] * sin (constants[2]) -
+          (2 * constants[6] + constants[4]) * cos (constants[2]));
+  n_p [2] = 2 * exp (constants[0] + constants[1]) *
+    ((constants[4] + constants[6]) * cos (constants[3]) * cos (constants[2]) -
+     constants[5] * cos (constants[3]) * sin (constants[2]) -
+     constants[7] * cos (constants[2]) * sin (constants[3])) +
+       constants[6] * exp (2 * constants[0]) +
+         constants[4] * exp (2 * constants[1]);
+  n_p [3] = exp (constants[1] + 2 * constants[0]) *
+    (constants[7] * sin (constants[3]) - constants[6] * cos (constants[3])) +
+      exp (constants[0] + 2 * constants[1]) *
+        (constants[5] * sin (constants[2]) - constants[4] * cos (constants[2]));
+  n_p [4] = 0.0;
+
+  d_p [0] = 0.0;
+  d_p [1] = -2 * exp (constants[1]) * cos (constants[3]) -
+    2 * exp (constants[0]) * cos (constants[2]);
+  d_p [2] = 4 * cos (constants[3]) * cos (constants[2]) * exp (constants[0] + constants[1]) +
+    exp (2 * constants[1]) + exp (2 * constants[0]);
+  d_p [3] = -2 * cos (constants[2]) * exp (constants[0] + 2 * constants[1]) -
+    2 * cos (constants[3]) * exp (constants[1] + 2 * constants[0]);
+  d_p [4] = exp (2 * constants[0] + 2 * constants[1]);
+
+  for (i = 0; i <= 4; i++)
+    d_m [i] = d_p [i];
+
+  n_m[0] = 0.0;
+  for (i = 1; i <= 4; i++)
+    n_m [i] = n_p[i] - d_p[i] * n_p[0];
+
+  /*  Beyond the ends of a line the input is taken to repeat the end
+   *  sample, for which the output of each direction settles at the end
+   *  sample scaled by these factors
+   */
+  sum_n_p = 0.0;
+  sum_n_m = 0.0;
+  sum_d = 0.0;
+  for (i = 0; i <= 4; i++)
+    {
+      sum_n_p += n_p[i];
+      sum_n_m += n_m[i];
+      sum_d += d_p[i];
+    }
+
+  *edge_p = sum_n_p / (1.0 + sum_d);
+  *edge_m = sum_n_m / (1.0 + sum_d);
+}
+
+/*  The radii of three box blurs that together approximate a gaussian  */
+static void
+find_boxes (int box[3], double std_dev)
+{
+  gdouble ideal;
+  gint    lower, smaller, i;
+
+  ideal = sqrt (12.0 * std_dev * std_dev / 3.0 + 1.0);
+  lower = (int) floor (ideal);
+  if (lower % 2 == 0)
+    lower--;
+  smaller = (int) ROUND ((12.0 * std_dev * std_dev - 3 * lower * lower - 12 * lower - 9) / (-4.0 * lower - 4.0));
+  for (i = 0; i < 3; i++)
+    box[i] = ((i < smaller) ? lower : lower + 2) / 2;
+}
+
+GimpBlurInfo GCMakeBlurInfo(double radius, GimpBlurMode mode)
+{
+	GimpBlurInfo info;
+	double blurRadius, std_dev, d_m[5];
+
+	// The radius is where the curve falls to 1/255 (less one, as in the GIMP)
+	blurRadius = fabs(radius) + 1.0;
+	std_dev = sqrt(-(blurRadius * blurRadius) / (2 * log(1.0 / 255.0)));
+
+	if (mode == GIMP_BLUR_AUTO)
+		mode = (radius > kBlurBoxRadius) ? GIMP_BLUR_TRIPLE_BOX : GIMP_BLUR_RECURSIVE;
+	if (std_dev < kBlurMinDeviation)
+		mode = GIMP_BLUR_TRIPLE_BOX;
+
+	memset(&info, 0, sizeof(info));
+	info.mode = mode;
+	switch (mode) {
+		case GIMP_BLUR_TRIPLE_BOX:
+			find_boxes(info.box, std_dev);
+		break;
+		default:
+			// Both directions share their feedback coefficients
+			find_constants(info.n_p, info.n_m, info.d, d_m, &info.edge_p, &info.edge_m, std_dev);
+		break;
+	}
+
+	return info;
+}
+
+/*  Runs the recursive filter forwards and backwards along 'count' rows of
+ *  'lanes' samples in 'buf', leaving the result in 'out'. Both have
+ *  kBlurPad rows of space before and after.
+ */
+static void
+blur_lanes_recursive (const GimpBlurInfo *info, double *buf, double *out, int count, int lanes)
+{
+	double ring[8][kBlurLanes];
+	double n0 = info->n_p[0], n1 = info->n_p[1], n2 = info->n_p[2], n3 = info->n_p[3], n4 = info->n_p[4];
+	double m1 = info->n_m[1], m2 = info->n_m[2], m3 = info->n_m[3], m4 = info->n_m[4];
+	double d1 = info->d[1], d2 = info->d[2], d3 = info->d[3], d4 = info->d[4];
+	double *x, *y, *y1, *y2, *y3, *y4;
+	int n, l, k;
+
+	// Repeat the end samples in to the padding
+	for (k = 1; k <= kBlurPad; k++) {
+		for (l = 0; l < lanes; l++) {
+			buf[-k * lanes + l] = buf[l];
+			buf[(count - 1 + k) * lanes + l] = buf[(count - 1) * lanes + l];
+			out[-k * lanes + l] = buf[l] * info->edge_p;
+			ring[(count - 1 + k) & 7][l] = buf[(count - 1) * lanes + l] * info->edge_m;
+		}
+	}
+
+	// The causal pass
+	for (n = 0; n < count; n++) {
+		x = buf + n * lanes;
+		y = out + n * lanes;
+		for (l = 0; l < lanes; l++) {
+			y[l] = n0 * x[l] + n1 * x[l - lanes] + n2 * x[l - 2 * lanes] + n3 * x[l - 3 * lanes] + n4 * x[l - 4 * lanes]
+				- d1 * y[l - lanes] - d2 * y[l - 2 * lanes] - d3 * y[l - 3 * lanes] - d4 * y[l - 4 * lanes];
+		}
+	}
+
+	// The anti-causal pass, only the last four results are needed so they are kept in a ring
+	for (n = count - 1; n >= 0; n--) {
+		x = buf + n * lanes;
+		y = out + n * lanes;
+		y1 = ring[(n + 1) & 7];
+		y2 = ring[(n + 2) & 7];
+		y3 = ring[(n + 3) & 7];
+		y4 = ring[(n + 4) & 7];
+		for (l = 0; l < lanes; l++) {
+			ring[n & 7][l] = m1 * x[l + lanes] + m2 * x[l + 2 * lanes] + m3 * x[l + 3 * lanes] + m4 * x[l + 4 * lanes]
+				- d1 * y1[l] - d2 * y2[l] - d3 * y3[l] - d4 * y4[l];
+			y[l] += ring[n & 7][l];
+		}
+	}
+}
+
+/*  Blurs 'count' rows of 'lanes' samples in 'in' with a box of the given
+ *  radius, repeating the end samples, and places the result in 'out'
+ */
+static void
+blur_lanes_box (double *in, double *out, int count, int lanes, int radius)
+{
+	double sum[kBlurLanes];
+	double scale = 1.0 / (2 * radius + 1);
+	double *add, *sub;
+	int n, l, k;
+
+	for (l = 0; l < lanes; l++)
+		sum[l] = in[l] * (radius + 1);
+	for (k = 1; k <= radius; k++) {
+		add = in + MIN(k, count - 1) * lanes;
+		for (l = 0; l < lanes; l++)
+			sum[l] += add[l];
+	}
+
+	for (n = 0; n < count; n++) {
+		add = in + MIN(n + radius + 1, count - 1) * lanes;
+		sub = in + MAX(n - radius, 0) * lanes;
+		for (l = 0; l < lanes; l++) {
+			out[n * lanes + l] = sum[l] * scale;
+			sum[l] += add[l] - sub[l];
+		}
+	}
+}
+
+/*  Blurs a tile held in 'buf', returning whichever buffer holds the result  */
+static double *
+blur_lanes (const GimpBlurInfo *info, double *buf, double *tmp, int count, int lanes)
+{
+	switch (info->mode) {
+		case GIMP_BLUR_TRIPLE_BOX:
+			blur_lanes_box(buf, tmp, count, lanes, info->box[0]);
+			blur_lanes_box(tmp, buf, count, lanes, info->box[1]);
+			blur_lanes_box(buf, tmp, count, lanes, info->box[2]);
+		break;
+		default:
+			blur_lanes_recursive(info, buf, tmp, count, lanes);
+		break;
+	}
+
+	return tmp;
+}
+
+static inline unsigned char
+clamp_sample (double value)
+{
+	if (value <= 0.0)
+		return 0;
+	if (value >= 255.0)
+		return 255;
+	return (unsigned char)(value + 0.5);
+}
+
+/*  Allocates a tile with padding, returning a pointer to its first row  */
+static double *
+alloc_tile (int count)
+{
+	double *tile = malloc((count + 2 * kBlurPad) * kBlurLanes * sizeof(double));
+
+	return tile ? tile + kBlurPad * kBlurLanes : NULL;
+}
+
+static void
+free_tile (double *tile)
+{
+	if (tile)
+		free(tile - kBlurPad * kBlurLanes);
+}
+
+void GCBlurColumns(unsigned char *dest, int destRowBytes, unsigned char *src, int srcRowBytes, int width, int height, int spp, int channels, const GimpBlurInfo *info)
+{
+	double *buf, *tmp, *result;
+	int x, tile, lanes, r, p, c;
+	unsigned char *line;
+
+	if (width <= 0 || height <= 0 || channels <= 0)
+		return;
+	buf = alloc_tile(height);
+	tmp = alloc_tile(height);
+	if (buf && tmp) {
+		for (x = 0; x < width; x += kBlurTile) {
+			// Adjacent columns lie side by side in memory so need no transposing
+			tile = MIN(kBlurTile, width - x);
+			lanes = tile * channels;
+			for (r = 0; r < height; r++) {
+				line = src + r * srcRowBytes + x * spp;
+				for (p = 0; p < tile; p++) {
+					for (c = 0; c < channels; c++)
+						buf[r * lanes + p * channels + c] = line[p * spp + c];
+				}
+			}
+			result = blur_lanes(info, buf, tmp, height, lanes);
+			for (r = 0; r < height; r++) {
+				line = dest + r * destRowBytes + x * spp;
+				for (p = 0; p < tile; p++) {
+					for (c = 0; c < channels; c++)
+						line[p * spp + c] = clamp_sample(result[r * lanes + p * channels + c]);
+				}
+			}
+		}
+	}
+	free_tile(buf);
+	free_tile(tmp);
+}
+
+void GCBlurRows(unsigned char *dest, int destRowBytes, unsigned char *src, int srcRowBytes, int width, int height, int spp, int channels, const GimpBlurInfo *info)
+{
+	double *buf, *tmp, *result;
+	int y, tile, lanes, r, x, c;
+	unsigned char *line;
+
+	if (width <= 0 || height <= 0 || channels <= 0)
+		return;
+	buf = alloc_tile(width);
+	tmp = alloc_tile(width);
+	if (buf && tmp) {
+		for (y = 0; y < height; y += kBlurTile) {
+			// Transpose the rows so each becomes a lane of the tile
+			tile = MIN(kBlurTile, height - y);
+			lanes = tile * channels;
+			for (r = 0; r < tile; r++) {
+				line = src + (y + r) * srcRowBytes;
+				for (x = 0; x < width; x++) {
+					for (c = 0; c < channels; c++)
+						buf[x * lanes + r * channels + c] = line[x * spp + c];
+				}
+			}
+			result = blur_lanes(info, buf, tmp, width, lanes);
+			for (r = 0; r < tile; r++) {
+				line = dest + (y + r) * destRowBytes;
+				for (x = 0; x < width; x++) {
+					for (c = 0; c < channels; c++)
+						line[x * spp + c] = clamp_sample(result[x * lanes + r * channels + c]);
+				}
+			}
+		}
+	}
+	free_tile(buf);
+	free_tile(tmp);
+}
+
+typedef struct {
+	unsigned char *dest, *src;
+	int destRowBytes, srcRowBytes, width, height, spp, channels, span;
+	GimpBlurInfo info;
+} BlurTask;
+
+static void blur_column_task(void *context, size_t i)
+{
+	BlurTask *task = context;
+	int x = (int)i * task->span;
+
+	GCBlurColumns(task->dest + x * task->spp, task->destRowBytes, task->src + x * task->spp, task->srcRowBytes, MIN(task->span, task->width - x), task->height, task->spp, task->channels, &task->info);
+}
+
+static void blur_row_task(void *context, size_t i)
+{
+	BlurTask *task = context;
+	int y = (int)i * task->span;
+
+	GCBlurRows(task->dest + y * task->destRowBytes, task->destRowBytes, task->dest + y * task->destRowBytes, task->destRowBytes, task->width, MIN(task->span, task->height - y), task->spp, task->channels, &task->info);
+}
+
+void GCGaussianBlur(unsigned char *dest, int destRowBytes, unsigned char *src, int srcRowBytes, int width, int height, int spp, int channels, double radius, GimpBlurMode mode)
+{
+	BlurTask task = { dest, src, destRowBytes, srcRowBytes, width, height, spp, channels, kBlurTile * kBlurTilesPerTask, GCMakeBlurInfo(radius, mode) };
+
+	if (width <= 0 || height <= 0)
+		return;
+
+	// First the columns from the source in to the destination, then the rows in place
+	dispatch_apply_f((width + task.span - 1) / task.span, dispatch_get_global_queue(0, 0), &task, blur_column_task);
+	dispatch_apply_f((height + task.span - 1) / task.span, dispatch_get_global_queue(0, 0), &task, blur_row_task);
+}
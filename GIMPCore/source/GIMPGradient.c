@@ -745,7 +745,7 @@ void GCFillGradient(unsigned char *dest, int destWidth, int destHeight, IntRect
 				else if (spp == 2) {
 					double gray = INTENSITY (color.r, color.g, color.b);
 					dest[(y * destWidth + x) * spp] = gray * 255.0;
-					dest[(y * destWidth + x) * spp + 3] = color.a * 255.0;
+					dest[(y * destWidth + x) * spp + 1] = color.a * 255.0;
 				}
 			}
 			progress += rect.size.width;
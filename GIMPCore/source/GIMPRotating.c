@@ -298,7 +298,7 @@ void GCRotateImage(unsigned char **dest, int *destWidth, int *destHeight, int *d
       ty = yinc * (tx1 + 0.5) + m[1][1] * (y + 0.5) + m[1][2] - 0.5;
       tw = winc * (tx1 + 0.5) + m[2][1] * (y + 0.5) + m[2][2];
 
-      d = *dest + width * y * spp;
+      d = *dest + width * (y - ty1) * spp;
       for (x = tx1; x < tx2; x++)
 	{
 	  /*  normalize homogeneous coords  */
@@ -83,7 +83,7 @@ get_premultiplied_double_row (PixelRegion *srcPR,
 static void
 expand_line (gdouble               *dest,
 	     gdouble               *src,
-	     guint                  bpp,
+	     gint                   bpp,
 	     guint                  old_width,
 	     gint                   width,
 	     GimpInterpolationType  interp)
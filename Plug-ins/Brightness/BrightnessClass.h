@@ -12,6 +12,8 @@
 #import "SeaPlugins.h"
 #import "SSKCIPlugin.h"
 
+@class SeaColorPipeline;
+
 @interface BrightnessClass : SSKVisualPlugin
 //! The brightness
 @property CGFloat brightness;
@@ -89,6 +91,14 @@
 */
 - (void)adjust;
 
+/*!
+	@method		pipeline
+	@discussion	Returns the brightness and contrast curve for the current
+				settings, built when first needed.
+	@result		Returns the colour pipeline to run over the selection.
+*/
+- (SeaColorPipeline *)pipeline;
+
 /*!
 	@method		validateMenuItem:
 	@discussion	Determines whether a given menu item should be enabled or
@@ -4,10 +4,14 @@
 #import "BrightnessClass.h"
 #import "PluginData.h"
 #import "SeaWhiteboard.h"
+#import <SeashoreKit/ColorPipeline.h>
 
 #define gOurBundle [NSBundle bundleForClass:[self class]]
 
-@implementation BrightnessClass
+@implementation BrightnessClass {
+	// The curve for the current settings, built when first needed
+	SeaColorPipeline *pipeline;
+}
 @synthesize brightness;
 @synthesize contrast;
 
@@ -49,6 +53,9 @@
 	refresh = NO;
 	
 	self.brightness = self.contrast = 0.0;
+	@synchronized (self) {
+		pipeline = nil;
+	}
 	
 	success = NO;
 	pluginData = [self.seaPlugins data];
@@ -94,101 +101,90 @@
 {
 	PluginData *pluginData = [self.seaPlugins data];
 	
-	if (refresh)
-		[self adjust];
-	[pluginData preview];
+	if (refresh) {
+		[pluginData previewProgressively:^{
+			[self adjust];
+		}];
+	}
+	else {
+		[pluginData preview];
+	}
 	refresh = NO;
 }
 
-- (void)adjust
+- (IBAction)update:(id)sender
 {
-	PluginData *pluginData;
-	IntRect selection;
-	int spp, i, j, k, width, channel, pos;
-	unsigned char *data, *overlay, *replace;
-	float nvalue, value;
-	double power;
-	
-	pluginData = [self.seaPlugins data];
-	[pluginData setOverlayOpacity:255];
-	[pluginData setOverlayBehaviour:SeaOverlayBehaviourReplacing];
-	selection = [pluginData selection];
-	channel = [pluginData channel];
-	spp = [pluginData spp];
-	width = [pluginData width];
-	data = [pluginData data];
-	overlay = [pluginData overlay];
-	replace = [pluginData replace];
-	
-	for (j = selection.origin.y; j < selection.origin.y + selection.size.height; j++) {
-		for (i = selection.origin.x; i < selection.origin.x + selection.size.width; i++) {
+	@synchronized (self) {
+		pipeline = nil;
+	}
+	[super update:sender];
+}
+
+- (SeaColorPipeline *)pipeline
+{
+	@synchronized (self) {
+		if (!pipeline) {
+			CGFloat brightnessValue = brightness, contrastValue = contrast;
 			
-			for (k = 0; k < spp; k++) {
+			pipeline = [[SeaColorPipeline alloc] init];
+			[pipeline addCurve:^int(int sample) {
+				float nvalue, value = sample / 255.0;
+				double power;
 				
-				pos = (j * width + i) * spp + k;
+				if (brightnessValue < 0.0)
+					value = value * (1.0 + brightnessValue);
+				else
+					value = value + ((1.0 - value) * brightnessValue);
 				
-				if ((channel == kPrimaryChannels || channel == kAlphaChannel) && k == spp - 1) {
-					overlay[pos] = 255;
+				if (contrastValue < 0.0) {
+					if (value > 0.5)
+						nvalue = 1.0 - value;
+					else
+						nvalue = value;
 					
-				} else if (channel == kAllChannels && k == spp - 1) {
+					if (nvalue < 0.0)
+						nvalue = 0.0;
 					
-					overlay[pos] = data[pos];
-				} else if (channel == kAlphaChannel && k > 0) {
-					overlay[pos] = overlay[pos - k];
-				} else {
-					if (channel == kAlphaChannel)
-						value = data[(j * width + i + 1) * spp - 1] / 255.0;
-					else
-						value = data[pos] / 255.0;
+					nvalue = 0.5 * pow (nvalue * 2.0 , (double) (1.0 + contrastValue));
 					
-					if (brightness < 0.0)
-						value = value * (1.0 + brightness);
+					if (value > 0.5)
+						value = 1.0 - nvalue;
+					else
+						value = nvalue;
+				} else {
+					if (value > 0.5)
+						nvalue = 1.0 - value;
 					else
-						value = value + ((1.0 - value) * brightness);
+						nvalue = value;
 					
-					if (contrast < 0.0) {
-						if (value > 0.5)
-							nvalue = 1.0 - value;
-						else
-							nvalue = value;
-						
-						if (nvalue < 0.0)
-							nvalue = 0.0;
-						
-						nvalue = 0.5 * pow (nvalue * 2.0 , (double) (1.0 + contrast));
-						
-						if (value > 0.5)
-							value = 1.0 - nvalue;
-						else
-							value = nvalue;
-					} else {
-						if (value > 0.5)
-							nvalue = 1.0 - value;
-						else
-							nvalue = value;
-						
-						if (nvalue < 0.0)
-							nvalue = 0.0;
-						
-						power = (contrast == 1.0) ? 127 : 1.0 / (1.0 - contrast);
-						nvalue = 0.5 * pow (2.0 * nvalue, power);
-						
-						if (value > 0.5)
-							value = 1.0 - nvalue;
-						else
-							value = nvalue;
-					}
+					if (nvalue < 0.0)
+						nvalue = 0.0;
 					
-					overlay[pos] = value * 255.0;
+					power = (contrastValue == 1.0) ? 127 : 1.0 / (1.0 - contrastValue);
+					nvalue = 0.5 * pow (2.0 * nvalue, power);
 					
+					if (value > 0.5)
+						value = 1.0 - nvalue;
+					else
+						value = nvalue;
 				}
-			}
-			
-			replace[j * width + i] = 255;
+				
+				return (unsigned char)(value * 255.0);
+			}];
 		}
+		return pipeline;
 	}
 }
 
+- (void)adjust
+{
+	PluginData *pluginData = [self.seaPlugins data];
+	
+	[pluginData setOverlayOpacity:255];
+	[pluginData setOverlayBehaviour:SeaOverlayBehaviourReplacing];
+	[pluginData runColorPipeline:[self pipeline]];
+}
+
 - (BOOL)validateMenuItem:(id)menuItem
 {
 	return YES;
@@ -3,6 +3,7 @@
 #include <tgmath.h>
 #include <ApplicationServices/ApplicationServices.h>
 #import "CMYKClass.h"
+#import <SeashoreKit/ColorPipeline.h>
 
 #define gOurBundle [NSBundle bundleForClass:[self class]]
 
@@ -32,12 +33,6 @@
 	PluginData *pluginData = [self.seaPlugins data];
 	[pluginData setOverlayOpacity:255];
 	[pluginData setOverlayBehaviour:SeaOverlayBehaviourReplacing];
-	IntRect selection = [pluginData selection];
-	int width = [pluginData width];
-	unsigned char *data = [pluginData data];
-	unsigned char *overlay = [pluginData overlay];
-	unsigned char *replace = [pluginData replace];
-	int channel = [pluginData channel];
 	
 	ColorSyncProfileRef srcProf = ColorSyncProfileCreateWithDisplayID(0);
 	ColorSyncProfileRef destProf = ColorSyncProfileCreateWithName(kColorSyncGenericCMYKProfile);
@@ -60,35 +55,10 @@
 	
 	ColorSyncTransformRef cw = ColorSyncTransformCreate((__bridge CFArrayRef)(profSeq), NULL);
 	
-	for (int j = selection.origin.y; j < selection.origin.y + selection.size.height; j++) {
-		int pos = j * width + selection.origin.x;
-		
-		ColorSyncDataLayout srcLayout = kColorSyncByteOrderDefault;
-		ColorSyncDataDepth srcDepth = kColorSync8BitInteger;
-		size_t srcRowBytes;
-		void *srcBytes;
-		void *dstBytes = &(overlay[pos * 4]);
-		
-		if (channel == kPrimaryChannels) {
-			srcBytes = &(data[pos * 3]);
-			srcRowBytes = selection.size.width * 3;
-			srcLayout |= kColorSyncAlphaNone;
-		} else {
-			srcBytes = &(data[pos * 4]);
-			srcRowBytes = selection.size.width * 4;
-			srcLayout |= kColorSyncAlphaLast;
-		}
-		
-		ColorSyncTransformConvert(cw, selection.size.width, 1, dstBytes, kColorSync8BitInteger, srcLayout, srcRowBytes, srcBytes, srcDepth, srcLayout, srcRowBytes, NULL);
-		
-		for (int i = selection.size.width; i >= 0; i--) {
-			if (channel == kPrimaryChannels)
-				overlay[(pos + i) * 4 + 3] = 255;
-			else
-				overlay[(pos + i) * 4 + 3] = data[(pos + i) * 4 + 3];
-			replace[pos + i] = 255;
-		}
-	}
+	SeaColorPipeline *pipeline = [[SeaColorPipeline alloc] init];
+	
+	[pipeline addTransform:cw];
+	[pluginData runColorPipeline:pipeline];
 	
 	CFRelease(cw);
 	CFRelease(srcProf);
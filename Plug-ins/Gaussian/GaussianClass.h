@@ -10,7 +10,6 @@
 
 #import <Cocoa/Cocoa.h>
 #import "SeaPlugins.h"
-#import "GaussianFuncs.h"
 #import "SSKCIPlugin.h"
 
 @interface GaussianClass : SSKVisualPlugin
@@ -92,10 +91,8 @@
 /*!
 	@method		gauss
 	@discussion	Executes the Gaussian blur.
-	@param		method
-				Runs the Gaussian blur with the given method.
 */
-- (void)gauss:(BlurMethod)method;
+- (void)gauss;
 
 /*!
 	@method		validateMenuItem:
@@ -12,6 +12,8 @@
 #import "SeaPlugins.h"
 #import "SSKCIPlugin.h"
 
+@class SeaColorPipeline;
+
 @interface HSVClass : SSKVisualPlugin
 //! The hue
 @property CGFloat hue;
@@ -98,6 +100,15 @@
 */
 - (void)adjust;
 
+/*!
+	@method		pipeline
+	@discussion	Returns the hue, saturation and value adjustment for the
+				current settings, which is kept so the preview and the final
+				application share it.
+	@result		Returns the colour pipeline to run over the selection.
+*/
+- (SeaColorPipeline *)pipeline;
+
 /*!
 	@method		validateMenuItem:
 	@discussion	Determines whether a given menu item should be enabled or
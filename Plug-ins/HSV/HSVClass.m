@@ -3,10 +3,14 @@
 #import "PluginData.h"
 #import "SeaWhiteboard.h"
 #import <SeashoreKit/ColorConversion.h>
+#import <SeashoreKit/ColorPipeline.h>
 
 #define gOurBundle [NSBundle bundleForClass:[self class]]
 
-@implementation HSVClass
+@implementation HSVClass {
+	// The adjustment for the current settings, built when first needed
+	SeaColorPipeline *pipeline;
+}
 @synthesize hue;
 @synthesize saturation;
 @synthesize value;
@@ -49,6 +53,9 @@
 	refresh = NO;
 	
 	self.hue = self.saturation = self.value = 0.0;
+	@synchronized (self) {
+		pipeline = nil;
+	}
 	
 	success = NO;
 	pluginData = [self.seaPlugins data];
@@ -94,9 +101,14 @@
 {
 	PluginData *pluginData = [self.seaPlugins data];
 	
-	if (refresh)
-		[self adjust];
-	[pluginData preview];
+	if (refresh) {
+		[pluginData previewProgressively:^{
+			[self adjust];
+		}];
+	}
+	else {
+		[pluginData preview];
+	}
 	refresh = NO;
 }
 
@@ -106,8 +118,11 @@
 	
 	[panel setAlphaValue:1.0];
 	refresh = YES;
+	@synchronized (self) {
+		pipeline = nil;
+	}
+	[self preview:self];
 	if ([[NSApp currentEvent] type] == NSLeftMouseUp) {
-		[self preview:self];
 		pluginData = [self.seaPlugins data];
 		if ([pluginData window])
 			[panel setAlphaValue:0.4];
@@ -117,39 +132,39 @@
 static inline unsigned char CLAMP(int x) { return (x < 0) ? 0 : ((x > 255) ? 255 : x); }
 static inline unsigned char WRAPAROUND(int x) { return (x < 0) ? (255 + ((x + 1) % 255)) : ((x > 255) ? (x % 255) : x); }
 
+- (SeaColorPipeline *)pipeline
+{
+	@synchronized (self) {
+		if (!pipeline) {
+			int hueShift = (int)(hue * 255.0);
+			int saturationShift = (int)(saturation * 255.0);
+			int valueShift = (int)(value * 255.0);
+			
+			pipeline = [[SeaColorPipeline alloc] init];
+			[pipeline addFunction:^(const float *rgb, float *output) {
+				int r = rgb[0] * 255.0f + 0.5f, g = rgb[1] * 255.0f + 0.5f, b = rgb[2] * 255.0f + 0.5f;
+				
+				SeaRGBtoHSV(&r, &g, &b);
+				r = WRAPAROUND(r + hueShift);
+				g = CLAMP(g + saturationShift);
+				b = CLAMP(b + valueShift);
+				SeaHSVtoRGB(&r, &g, &b);
+				output[0] = r / 255.0f;
+				output[1] = g / 255.0f;
+				output[2] = b / 255.0f;
+			}];
+		}
+		return pipeline;
+	}
+}
+
 - (void)adjust
 {
 	PluginData *pluginData = [self.seaPlugins data];
-	int r, g, b;
 	
 	[pluginData setOverlayOpacity:255];
 	[pluginData setOverlayBehaviour:SeaOverlayBehaviourReplacing];
-	IntRect selection = [pluginData selection];
-	//channel = [pluginData channel];
-	int spp = [pluginData spp];
-	int width = [pluginData width];
-	unsigned char *data = [pluginData data];
-	unsigned char *overlay = [pluginData overlay];
-	unsigned char *replace = [pluginData replace];
-	
-	for (int j = selection.origin.y; j < selection.origin.y + selection.size.height; j++) {
-		for (int i = selection.origin.x; i < selection.origin.x + selection.size.width; i++) {
-			int pos = (j * width + i) * spp;
-			r = data[pos];
-			g = data[pos + 1];
-			b = data[pos + 2];
-			overlay[pos + 3] = data[pos + 3];
-			SeaRGBtoHSV(&r, &g, &b);
-			r = WRAPAROUND(r + (int)(hue * 255.0));
-			g = CLAMP(g + (int)(saturation * 255.0));
-			b = CLAMP(b + (int)(value * 255.0));
-			SeaHSVtoRGB(&r, &g, &b);
-			overlay[pos] = (unsigned char)r;
-			overlay[pos + 1] = (unsigned char)g;
-			overlay[pos + 2] = (unsigned char)b;
-			replace[j * width + i] = 255;
-		}
-	}
+	[pluginData runColorPipeline:[self pipeline]];
 }
 
 - (BOOL)validateMenuItem:(id)menuItem
@@ -50,19 +50,15 @@ static inline int specmod(int a, int b)
 {
 	int width;
 	unsigned char *overlay;
-	IntRect selection;
 	IntPoint point, apoint;
 	unsigned char backColorAlpha[4], foreColorAlpha[4];
 	int amount;
-	int spp, pos;
-	int i, j, k;
-	BOOL black;
+	int spp;
 	PluginData *pluginData = [self.seaPlugins data];
 	
 	// Get plug-in data
 	width = [pluginData width];
 	spp = [pluginData spp];
-	selection = [pluginData selection];
 	point = [pluginData point:0];
 	apoint = [pluginData point:1];
 	amount = abs(apoint.y - point.y);
@@ -92,22 +88,28 @@ static inline int specmod(int a, int b)
 	}
 	
 	// Run checkboard
-	for (j = selection.origin.y; j < selection.origin.y + selection.size.height; j++) {
-		for (i = selection.origin.x; i < selection.origin.x + selection.size.width; i++) {
+	const unsigned char *foreColor = foreColorAlpha, *backColor = backColorAlpha;
+	[pluginData runKernel:^(IntRect rect) {
+		int i, j, k, pos;
+		BOOL black;
+		
+		for (j = rect.origin.y; j < rect.origin.y + rect.size.height; j++) {
+			for (i = rect.origin.x; i < rect.origin.x + rect.size.width; i++) {
 			
-			pos = j * width + i;
+				pos = j * width + i;
 			
-			black = (specmod(j - point.y, amount * 2) < amount);
-			for (k = 0; k < spp; k++) {
-				if (black) {
-					memcpy(&(overlay[pos * spp]), foreColorAlpha, spp);
-				} else {
-					memcpy(&(overlay[pos * spp]), backColorAlpha, spp);
+				black = (specmod(j - point.y, amount * 2) < amount);
+				for (k = 0; k < spp; k++) {
+					if (black) {
+						memcpy(&(overlay[pos * spp]), foreColor, spp);
+					} else {
+						memcpy(&(overlay[pos * spp]), backColor, spp);
+					}
 				}
-			}
 			
+			}
 		}
-	}
+	} halo:0];
 
 	// Apply the change and record success
 	[pluginData apply];
@@ -1,6 +1,7 @@
 #include <GIMPCore/GIMPCore.h>
 #import "InvertClass.h"
 #import "PluginData.h"
+#import <SeashoreKit/ColorPipeline.h>
 
 #define gOurBundle [NSBundle bundleForClass:[self class]]
 
@@ -29,48 +30,14 @@
 - (void)run
 {
 	PluginData *pluginData = [self.seaPlugins data];
-	IntRect selection;
-	unsigned char *data, *overlay, *replace;
-	int pos, i, j, k, width, spp, channel;
+	SeaColorPipeline *pipeline = [[SeaColorPipeline alloc] init];
 	
 	[pluginData setOverlayOpacity:255];
 	[pluginData setOverlayBehaviour:SeaOverlayBehaviourReplacing];
-	selection = [pluginData selection];
-	spp = [pluginData spp];
-	width = [pluginData width];
-	data = [pluginData data];
-	overlay = [pluginData overlay];
-	replace = [pluginData replace];
-	channel = [pluginData channel];
-	
-	for (j = selection.origin.y; j < selection.origin.y + selection.size.height; j++) {
-		for (i = selection.origin.x; i < selection.origin.x + selection.size.width; i++) {
-			
-			pos = j * width + i;
-			
-			if (channel == kAllChannels) {
-				for (k = 0; k < spp - 1; k++)
-					overlay[pos * spp + k] = 255 - data[pos * spp + k];
-				overlay[(pos + 1) * spp - 1] = data[(pos + 1) * spp - 1];
-			}
-			
-			if (channel == kPrimaryChannels) {
-				for (k = 0; k < spp - 1; k++)
-					overlay[pos * spp + k] = 255 - data[pos * spp + k];
-				overlay[(pos + 1) * spp - 1] = 255;
-			}
-			
-			if (channel == kAlphaChannel) {
-				pos = j * width + i;
-				for (k = 0; k < spp - 1; k++)
-					overlay[pos * spp + k] = 255 - data[(pos + 1) * spp - 1];
-				overlay[(pos + 1) * spp - 1] = 255;
-			}
-			
-			replace[pos] = 255;
-			
-		}
-	}
+	[pipeline addCurve:^int(int value) {
+		return 255 - value;
+	}];
+	[pluginData runColorPipeline:pipeline];
 	[pluginData apply];
 }
 
@@ -34,9 +34,8 @@ int compar(const void *a, const void *b)
 {
 	PluginData *pluginData = [self.seaPlugins data];
 	IntRect selection;
-	unsigned char *data, *overlay, *replace;
-	int pos, i, j, x, y, z, k, width, spp, channel;
-	unsigned char vals[4][9];
+	unsigned char *data, *overlay;
+	int width, spp, channel;
 	
 	[pluginData setOverlayOpacity:255];
 	[pluginData setOverlayBehaviour:SeaOverlayBehaviourReplacing];
@@ -45,77 +44,76 @@ int compar(const void *a, const void *b)
 	width = [pluginData width];
 	data = [pluginData data];
 	overlay = [pluginData overlay];
-	replace = [pluginData replace];
 	channel = [pluginData channel];
 	
-	for (j = selection.origin.y; j < selection.origin.y + selection.size.height; j++) {
-		for (i = selection.origin.x; i < selection.origin.x + selection.size.width; i++) {
-			
-			if (channel == kAllChannels) {
+	[pluginData runKernel:^(IntRect rect) {
+		int pos, i, j, x, y, z, k;
+		unsigned char vals[4][9] = {{0}};
+		
+		for (j = rect.origin.y; j < rect.origin.y + rect.size.height; j++) {
+			for (i = rect.origin.x; i < rect.origin.x + rect.size.width; i++) {
 				
-				pos = j * width + i;
-				z = -1;
-				for (y = j - 1; y < j + 2; y++) {
-					for (x = i - 1; x < i + 2; x++) {
-						z++;
-						if (x >= selection.origin.x && y >= selection.origin.y  && x < selection.origin.x + selection.size.width && y < selection.origin.y + selection.size.height) {
-							for (k = 0; k < spp; k++)
-								vals[k][z] = data[((y * width) + x) * spp + k];
+				if (channel == kAllChannels) {
+					
+					pos = j * width + i;
+					z = -1;
+					for (y = j - 1; y < j + 2; y++) {
+						for (x = i - 1; x < i + 2; x++) {
+							z++;
+							if (x >= selection.origin.x && y >= selection.origin.y  && x < selection.origin.x + selection.size.width && y < selection.origin.y + selection.size.height) {
+								for (k = 0; k < spp; k++)
+									vals[k][z] = data[((y * width) + x) * spp + k];
+							}
 						}
 					}
+					for (k = 0; k < spp; k++) {
+						qsort(vals[k], 9, sizeof(unsigned char), &compar);
+						overlay[pos * spp + k] = vals[k][4];
+					}
+					
 				}
-				for (k = 0; k < spp; k++) {
-					qsort(vals[k], 9, sizeof(unsigned char), &compar);
-					overlay[pos * spp + k] = vals[k][4];
-				}
-				replace[pos] = 255;
 				
-			}
-			
-			if (channel == kPrimaryChannels) {
-			
-				pos = j * width + i;
-				z = -1;
-				for (y = j - 1; y < j + 2; y++) {
-					for (x = i - 1; x < i + 2; x++) {
-						z++;
-						if (x >= selection.origin.x && y >= selection.origin.y  && x < selection.origin.x + selection.size.width && y < selection.origin.y + selection.size.height) {
-							for (k = 0; k < spp - 1; k++)
-								vals[k][z] = data[((y * width) + x) * spp + k];
+				if (channel == kPrimaryChannels) {
+				
+					pos = j * width + i;
+					z = -1;
+					for (y = j - 1; y < j + 2; y++) {
+						for (x = i - 1; x < i + 2; x++) {
+							z++;
+							if (x >= selection.origin.x && y >= selection.origin.y  && x < selection.origin.x + selection.size.width && y < selection.origin.y + selection.size.height) {
+								for (k = 0; k < spp - 1; k++)
+									vals[k][z] = data[((y * width) + x) * spp + k];
+							}
 						}
 					}
+					for (k = 0; k < spp - 1; k++) {
+						qsort(vals[k], 9, sizeof(unsigned char), &compar);
+						overlay[pos * spp + k] = vals[k][4];
+					}
+					
 				}
-				for (k = 0; k < spp - 1; k++) {
-					qsort(vals[k], 9, sizeof(unsigned char), &compar);
-					overlay[pos * spp + k] = vals[k][4];
-				}
-				overlay[(pos + 1) * spp - 1] = 255;
-				replace[pos] = 255;
-				
-			}
-			
-			if (channel == kAlphaChannel) {
 				
-				pos = j * width + i;
-				z = -1;
-				for (y = j - 1; y < j + 2; y++) {
-					for (x = i - 1; x < i + 2; x++) {
-						z++;
-						if (x >= selection.origin.x && y >= selection.origin.y  && x < selection.origin.x + selection.size.width && y < selection.origin.y + selection.size.height) {
-							vals[0][z] = data[((y * width) + x + 1) * spp - 1];
+				if (channel == kAlphaChannel) {
+					
+					pos = j * width + i;
+					z = -1;
+					for (y = j - 1; y < j + 2; y++) {
+						for (x = i - 1; x < i + 2; x++) {
+							z++;
+							if (x >= selection.origin.x && y >= selection.origin.y  && x < selection.origin.x + selection.size.width && y < selection.origin.y + selection.size.height) {
+								vals[0][z] = data[((y * width) + x + 1) * spp - 1];
+							}
 						}
 					}
+					qsort(vals[0], 9, sizeof(unsigned char), &compar);
+					for (k = 0; k < spp - 1; k++)
+						overlay[pos * spp + k] = vals[0][4];
+					
 				}
-				qsort(vals[0], 9, sizeof(unsigned char), &compar);
-				for (k = 0; k < spp - 1; k++)
-					overlay[pos * spp + k] = vals[0][4];
-				overlay[(pos + 1) * spp - 1] = 255;
-				replace[pos] = 255;
 				
 			}
-			
 		}
-	}
+	} halo:1];
 	[pluginData apply];
 }
 
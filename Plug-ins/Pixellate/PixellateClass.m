@@ -97,9 +97,14 @@
 {
 	PluginData *pluginData = [self.seaPlugins data];
 	
-	if (refresh)
-		[self pixellate];
-	[pluginData preview];
+	if (refresh) {
+		[pluginData previewProgressively:^{
+			[self pixellate];
+		}];
+	}
+	else {
+		[pluginData preview];
+	}
 	refresh = NO;
 }
 
@@ -123,8 +128,8 @@
 	
 	[panel setAlphaValue:1.0];
 	refresh = YES;
+	[self preview:sender];
 	if ([[NSApp currentEvent] type] == NSLeftMouseUp) {
-		[self preview:sender];
 		pluginData = [self.seaPlugins data];
 		if ([pluginData window])
 			[panel setAlphaValue:0.4];
@@ -134,83 +139,81 @@
 - (void)pixellate
 {
 	PluginData *pluginData = [self.seaPlugins data];
-	IntRect selection;
-	unsigned char *data, *overlay, *replace, newPixel[4];
-	NSInteger pos, i, j, k, i2, j2;
-	int width, height, spp, channel;
-	int total[4], n = 1, x_stblk, x_endblk, y_stblk, y_endblk;
+	unsigned char *data, *overlay;
+	int width, height, spp, channel, blockSize;
 	
 	[pluginData setOverlayOpacity:255];
 	[pluginData setOverlayBehaviour:SeaOverlayBehaviourReplacing];
-	selection = [pluginData selection];
 	spp = [pluginData spp];
 	width = [pluginData width];
 	height = [pluginData height];
 	data = [pluginData data];
 	overlay = [pluginData overlay];
-	replace = [pluginData replace];
 	channel = [pluginData channel];
+	blockSize = (int)scale;
 	
-	x_stblk = selection.origin.x / scale;
-	x_endblk = (selection.origin.x + selection.size.width) / scale + ((selection.origin.x + selection.size.width) % scale != 0);
-	y_stblk = selection.origin.y / scale;
-	y_endblk = (selection.origin.y + selection.size.height) / scale + ((selection.origin.y + selection.size.height) % scale != 0);
-	
-	for (j = y_stblk; j < y_endblk; j++) {
-		for (i = x_stblk; i < x_endblk; i++) {
-			
-			// Sum and count the present pixels in the  block
-			total[0] = total[1] = total[2] = total[3] = 0;
-			n = 0;
-			for (j2 = 0; j2 < scale; j2++) {
-				for (i2 = 0; i2 < scale; i2++) {
-					if (i * scale + i2 < width && j * scale + j2 < height) {
-						pos = (j * scale + j2) * width + (i * scale + i2);
-						for (k = 0; k < spp; k++) {
-							total[k] += data[pos * spp + k];
+	// Blocks are averaged whole but only drawn where they cross the band, a
+	// preview skipping rows would average each block again for every row
+	[pluginData runKernel:^(IntRect rect) {
+		unsigned char newPixel[4];
+		NSInteger pos, i, j, k, i2, j2;
+		int total[4], n = 1, x_stblk, x_endblk, y_stblk, y_endblk;
+		
+		x_stblk = rect.origin.x / blockSize;
+		x_endblk = (rect.origin.x + rect.size.width) / blockSize + ((rect.origin.x + rect.size.width) % blockSize != 0);
+		y_stblk = rect.origin.y / blockSize;
+		y_endblk = (rect.origin.y + rect.size.height) / blockSize + ((rect.origin.y + rect.size.height) % blockSize != 0);
+		
+		for (j = y_stblk; j < y_endblk; j++) {
+			for (i = x_stblk; i < x_endblk; i++) {
+				
+				// Sum and count the present pixels in the  block
+				total[0] = total[1] = total[2] = total[3] = 0;
+				n = 0;
+				for (j2 = 0; j2 < blockSize; j2++) {
+					for (i2 = 0; i2 < blockSize; i2++) {
+						if (i * blockSize + i2 < width && j * blockSize + j2 < height) {
+							pos = (j * blockSize + j2) * width + (i * blockSize + i2);
+							for (k = 0; k < spp; k++) {
+								total[k] += data[pos * spp + k];
+							}
+							n++;
 						}
-						n++;
 					}
 				}
-			}
-			
-			// Determine the revised pixel
-			switch (channel) {
-				case kAllChannels:
-					for (k = 0; k < spp; k++) {
-						newPixel[k] = total[k] / n;
-					}
-					break;
-				case kPrimaryChannels:
-					for (k = 0; k < spp - 1; k++) {
-						newPixel[k] = total[k] / n;
-					}
-					newPixel[spp - 1] = 255;
-					break;
-				case kAlphaChannel:
-					for (k = 0; k < spp - 1; k++) {
-						newPixel[k] = total[spp - 1] / n;
-					}
-					newPixel[spp - 1] = 255;
-					break;
-			}
-			
-			// Fill the block with this pixel
-			for (j2 = 0; j2 < scale; j2++) {
-				for (i2 = 0; i2 < scale; i2++) {
-					//pos = (j * scale + j2) * width + (i * scale + i2);
-					if (i * scale + i2 < width && j * scale + j2 < height) {
-						pos = (j * scale + j2) * width + (i * scale + i2);
+				
+				// Determine the revised pixel
+				switch (channel) {
+					case kAllChannels:
+						for (k = 0; k < spp; k++) {
+							newPixel[k] = total[k] / n;
+						}
+						break;
+					case kPrimaryChannels:
+						for (k = 0; k < spp - 1; k++) {
+							newPixel[k] = total[k] / n;
+						}
+						break;
+					case kAlphaChannel:
+						for (k = 0; k < spp - 1; k++) {
+							newPixel[k] = total[spp - 1] / n;
+						}
+						break;
+				}
+				
+				// Fill the block with this pixel
+				for (j2 = MAX(j * blockSize, rect.origin.y); j2 < MIN((j + 1) * blockSize, rect.origin.y + rect.size.height); j2++) {
+					for (i2 = MAX(i * blockSize, rect.origin.x); i2 < MIN((i + 1) * blockSize, rect.origin.x + rect.size.width); i2++) {
+						pos = j2 * width + i2;
 						for (k = 0; k < spp; k++) {
 							overlay[pos * spp + k] = newPixel[k];
 						}
-						replace[pos] = 255;
 					}
 				}
+				
 			}
-			
 		}
-	}
+	} halo:blockSize skipRows:NO];
 }
 
 - (BOOL)validateMenuItem:(id)menuItem
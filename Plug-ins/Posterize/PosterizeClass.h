@@ -11,6 +11,8 @@
 #import "SeaPlugins.h"
 #import "SSKCIPlugin.h"
 
+@class SeaColorPipeline;
+
 @interface PosterizeClass : SSKVisualPlugin
 //! The posterize value
 @property NSInteger posterizeValue;
@@ -93,6 +95,13 @@
 */
 - (void)posterize;
 
+/*!
+	@method		pipeline
+	@discussion	Returns the posterize curve for the current number of levels.
+	@result		Returns the colour pipeline to run over the selection.
+*/
+- (SeaColorPipeline *)pipeline;
+
 /*!
 	@method		validateMenuItem:
 	@discussion	Determines whether a given menu item should be enabled or
@@ -1,9 +1,13 @@
 #include <GIMPCore/GIMPCore.h>
 #import "PosterizeClass.h"
+#import <SeashoreKit/ColorPipeline.h>
 
 #define gOurBundle [NSBundle bundleForClass:[self class]]
 
-@implementation PosterizeClass
+@implementation PosterizeClass {
+	// The curve for the current number of levels, built when first needed
+	SeaColorPipeline *pipeline;
+}
 @synthesize posterizeValue = posterize;
 
 - (instancetype)initWithManager:(SeaPlugins *)manager
@@ -50,6 +54,9 @@
 	
 	if (posterize < 2 || posterize > 255)
 		self.posterizeValue = 1;
+	@synchronized (self) {
+		pipeline = nil;
+	}
 	
 	refresh = YES;
 	
@@ -101,9 +108,14 @@
 {
 	PluginData *pluginData = [self.seaPlugins data];
 	
-	if (refresh)
-		[self posterize];
-	[pluginData preview];
+	if (refresh) {
+		[pluginData previewProgressively:^{
+			[self posterize];
+		}];
+	}
+	else {
+		[pluginData preview];
+	}
 	refresh = NO;
 }
 
@@ -113,62 +125,41 @@
 	
 	[panel setAlphaValue:1.0];
 	refresh = YES;
+	@synchronized (self) {
+		pipeline = nil;
+	}
+	[self preview:self];
 	if ([[NSApp currentEvent] type] == NSLeftMouseUp) {
-		[self preview:self];
 		pluginData = [self.seaPlugins data];
 		if ([pluginData window])
 			[panel setAlphaValue:0.4];
 	}
 }
 
+- (SeaColorPipeline *)pipeline
+{
+	@synchronized (self) {
+		if (!pipeline) {
+			int levels = (int)posterize;
+			
+			pipeline = [[SeaColorPipeline alloc] init];
+			[pipeline addCurve:^int(int value) {
+				value = (float)value * (float)levels / 255.0;
+				value = (float)value * 255.0 / (float)(levels - 1);
+				return value;
+			}];
+		}
+		return pipeline;
+	}
+}
+
 - (void)posterize
 {
 	PluginData *pluginData = [self.seaPlugins data];
-	IntRect selection;
-	int i, j, k, spp, width, channel, value;
-	unsigned char *data, *overlay, *replace;
 	
 	[pluginData setOverlayOpacity:255];
 	[pluginData setOverlayBehaviour:SeaOverlayBehaviourReplacing];
-	
-	selection = [pluginData selection];
-	spp = [pluginData spp];
-	width = [pluginData width];
-	data = [pluginData data];
-	overlay = [pluginData overlay];
-	replace = [pluginData replace];
-	channel = [pluginData channel];
-	
-	for (j = selection.origin.y; j < selection.origin.y + selection.size.height; j++) {
-		for (i = selection.origin.x; i < selection.origin.x + selection.size.width; i++) {
-			if (channel == kAllChannels || channel == kPrimaryChannels) {
-				for (k = 0; k < spp - 1; k++) {
-					value = data[(j * width + i) * spp + k];
-					value = (float)value * (float)posterize / 255.0;
-					value = (float)value * 255.0 / (float)(posterize - 1);
-					if (value > 255)
-						value = 255;
-					if (value < 0)
-						value = 0;
-					overlay[(j * width + i) * spp +	k] = value;
-				}
-				overlay[(j * width + i + 1) * spp - 1] = data[(j * width + i + 1) * spp - 1];
-				replace[j * width + i] = 255;
-			} else if (channel == kAlphaChannel) {
-				value = data[(j * width + i + 1) * spp - 1];
-				value = (float)value * (float)posterize / 255.0;
-				value = (float)value * 255.0 / (float)(posterize - 1);
-				if (value > 255)
-					value = 255;
-				if (value < 0)
-					value = 0;
-				memset(&(overlay[(j * width + i) * spp]), value, spp - 1);
-				overlay[(j * width + i + 1) * spp - 1] = 255;
-				replace[j * width + i] = 255;
-			}
-			
-		}
-	}
+	[pluginData runColorPipeline:[self pipeline]];
 }
 
 - (BOOL)validateMenuItem:(id)menuItem
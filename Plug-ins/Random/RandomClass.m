@@ -31,20 +31,18 @@
 - (void)run
 {
 	PluginData *pluginData = [self.seaPlugins data];
-	IntRect selection;
-	unsigned char *data, *overlay, *replace;
-	int pos, i, j, k, width, spp;
-	unsigned char background[4], random[4];
+	unsigned char *overlay;
+	int width, spp;
+	unsigned char background[4];
+	const unsigned char *backColor = background;
+	unsigned int seed;
 	BOOL opaque;
 	
 	[pluginData setOverlayOpacity:255];
 	[pluginData setOverlayBehaviour:SeaOverlayBehaviourReplacing];
-	selection = [pluginData selection];
 	spp = [pluginData spp];
 	width = [pluginData width];
-	data = [pluginData data];
 	overlay = [pluginData overlay];
-	replace = [pluginData replace];
 	opaque = ![pluginData hasAlpha];
 	if (opaque) {
 		if (spp == 2) {
@@ -58,25 +56,31 @@
 		}
 	}
 	
-	//srand(time(NULL) & 0xffffffff);
-	for (j = selection.origin.y; j < selection.origin.y + selection.size.height; j++) {
-		for (i = selection.origin.x; i < selection.origin.x + selection.size.width; i++) {
-			
-			pos = j * width + i;
-			if (opaque) {
-				memcpy(&overlay[pos * spp], background, spp);
-				for (k = 0; k < spp; k++)
-					random[k] = (rand() << 8) >> 20;
-				SeaSpecialMerge(spp, overlay, pos * spp, random, 0, 255);
-			}
-			else {
-				for (k = 0; k < spp; k++)
-					overlay[pos * spp + k] = (rand() << 8) >> 20;
-			}
-			replace[pos] = 255;
+	// Each band draws from its own generator, seeded from the shared one
+	seed = rand();
+	[pluginData runKernel:^(IntRect rect) {
+		unsigned int state = seed ^ (rect.origin.y * 2654435761u);
+		unsigned char random[4];
+		int pos, i, j, k;
 		
+		for (j = rect.origin.y; j < rect.origin.y + rect.size.height; j++) {
+			for (i = rect.origin.x; i < rect.origin.x + rect.size.width; i++) {
+				
+				pos = j * width + i;
+				if (opaque) {
+					memcpy(&overlay[pos * spp], backColor, spp);
+					for (k = 0; k < spp; k++)
+						random[k] = (rand_r(&state) << 8) >> 20;
+					SeaSpecialMerge(spp, overlay, pos * spp, random, 0, 255);
+				}
+				else {
+					for (k = 0; k < spp; k++)
+						overlay[pos * spp + k] = (rand_r(&state) << 8) >> 20;
+				}
+				
+			}
 		}
-	}
+	} halo:0];
 	[pluginData apply];
 }
 
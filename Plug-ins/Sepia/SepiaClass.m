@@ -2,9 +2,9 @@
 #include <math.h>
 #include <tgmath.h>
 #import "SepiaClass.h"
+#import <SeashoreKit/ColorPipeline.h>
 
 #define gOurBundle [NSBundle bundleForClass:[self class]]
-#define int_mult(a,b,t)  ((t) = (a) * (b) + 0x80, ((((t) >> 8) + (t)) >> 8))
 
 @implementation SepiaClass
 
@@ -31,37 +31,17 @@
 - (void)run
 {
 	PluginData *pluginData = [self.seaPlugins data];
-	IntRect selection;
-	unsigned char *data, *overlay, *replace;
-	int pos, i, j, width, spp, channel;
-	int t[5];
+	SeaColorPipeline *pipeline = [[SeaColorPipeline alloc] init];
+	static const float sepia[12] = {
+		100.0 / 255.0, 196.0 / 255.0, 48.0 / 255.0, 0.0,
+		89.0 / 255.0, 175.0 / 255.0, 43.0 / 255.0, 0.0,
+		69.0 / 255.0, 136.0 / 255.0, 33.0 / 255.0, 0.0
+	};
 	
 	[pluginData setOverlayOpacity:255];
 	[pluginData setOverlayBehaviour:SeaOverlayBehaviourReplacing];
-	selection = [pluginData selection];
-	spp = [pluginData spp];
-	width = [pluginData width];
-	data = [pluginData data];
-	overlay = [pluginData overlay];
-	replace = [pluginData replace];
-	channel = [pluginData channel];
-	
-	for (j = selection.origin.y; j < selection.origin.y + selection.size.height; j++) {
-		for (i = selection.origin.x; i < selection.origin.x + selection.size.width; i++) {
-			
-			pos = j * width + i;
-			overlay[pos * spp] = MIN(int_mult(data[pos * spp], 100, t[0]) + int_mult(data[pos * spp + 1], 196, t[1]) + int_mult(data[pos * spp + 2], 48, t[2]), 255);
-			overlay[pos * spp + 1] = MIN(int_mult(data[pos * spp], 89, t[0]) + int_mult(data[pos * spp + 1], 175, t[1]) + int_mult(data[pos * spp + 2], 43, t[2]), 255);
-			overlay[pos * spp + 2] = MIN(int_mult(data[pos * spp], 69, t[0]) + int_mult(data[pos * spp + 1], 136, t[1]) + int_mult(data[pos * spp + 2], 33, t[2]), 255);
-			
-			if (channel == kAllChannels) 
-				overlay[(pos + 1) * spp - 1] = data[(pos + 1) * spp - 1];
-			else
-				overlay[(pos + 1) * spp - 1] = 255;
-			replace[pos] = 255;
-			
-		}
-	}
+	[pipeline addMatrix:sepia];
+	[pluginData runColorPipeline:pipeline];
 	[pluginData apply];
 }
 
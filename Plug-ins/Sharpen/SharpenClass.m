@@ -100,9 +100,14 @@
 {
 	PluginData *pluginData = [self.seaPlugins data];
 	
-	if (refresh)
-		[self sharpen];
-	[pluginData preview];
+	if (refresh) {
+		[pluginData previewProgressively:^{
+			[self sharpen];
+		}];
+	}
+	else {
+		[pluginData preview];
+	}
 	refresh = NO;
 }
 
@@ -112,8 +117,8 @@
 	
 	[panel setAlphaValue:1.0];
 	refresh = YES;
+	[self preview:self];
 	if ([[NSApp currentEvent] type] == NSLeftMouseUp) {
-		[self preview:self];
 		pluginData = [self.seaPlugins data];
 		if ([pluginData window])
 			[panel setAlphaValue:0.4];
@@ -136,17 +141,12 @@ static inline void set_row(unsigned char *out_row, unsigned char *in_row, int sp
 {
 	int i, j;
 	
-	if (channel == kAllChannels) {
-		memcpy(out_row, in_row, width * spp);
-	} else if (channel == kPrimaryChannels) {
+	if (channel == kAllChannels || channel == kPrimaryChannels) {
 		memcpy(out_row, in_row, width * spp);
-		for (i = 0; i < width; i++)
-			out_row[i * spp - 1] = 255;
 	} else {
 		for (i = 0; i < width; i++) {
 			for (j = 0; j < spp - 1; j++)
 				out_row[i * spp + j] = in_row[i * 2];
-			out_row[(i + 1) * spp - 1] = 255;
 		}
 	}
 }
@@ -155,12 +155,8 @@ static inline void set_row(unsigned char *out_row, unsigned char *in_row, int sp
 {
 	PluginData *pluginData = [self.seaPlugins data];
 	IntRect selection;
-	unsigned char *src_rows[4], *dst_row;
-	unsigned char *data, *overlay, *replace;
-	unsigned char *src_ptr;
-	intneg *neg_rows[4];
-	intneg *neg_ptr;
-	int swidth, spp, rspp, row, count, i, y, channel;
+	unsigned char *data, *overlay;
+	int swidth, spp, rspp, channel;
 	void (*filter)(int, guchar *, guchar *, intneg *, intneg *, intneg *) = NULL;
 	int y1, y2, x1, width;
 	
@@ -180,24 +176,9 @@ static inline void set_row(unsigned char *out_row, unsigned char *in_row, int sp
 	width = [pluginData width];
 	data = [pluginData data];
 	overlay = [pluginData overlay];
-	replace = [pluginData replace];
 	
 	compute_luts(extent);
 	
-	for (row = 0; row < 4; row ++) {
-		src_rows[row] = malloc(swidth);
-		neg_rows[row] = malloc(swidth * sizeof(intneg));
-    }
-	dst_row = malloc(swidth);
-	
-	get_row(src_rows[0], &(data[(y1 * width + x1) * spp]), spp, channel, selection.size.width);
-	
-	for (i = swidth, src_ptr = src_rows[0], neg_ptr = neg_rows[0]; i > 0; i--, src_ptr++, neg_ptr++)
-		*neg_ptr = neg_lut[*src_ptr];
-	
-	row = 1;
-	count = 1;
-	
 	switch (rspp) {
 		case 2:
 			filter = graya_filter;
@@ -208,47 +189,50 @@ static inline void set_row(unsigned char *out_row, unsigned char *in_row, int sp
 			break;
 	}
 	
-	for (y = y1; y < y2; y++) {
-		if ((y + 1) < y2) {
-			
-			if (count >= 3)
-				count--;
-			
-			get_row(src_rows[row], &(data[((y + 1) * width + x1) * spp]), spp, channel, selection.size.width);
-			
+	// Each band keeps the three rows around the one being filtered, the
+	// first and last rows of the selection are left unsharpened, rows are
+	// never skipped as each would reread and rebuild its neighbours
+	[pluginData runKernel:^(IntRect rect) {
+		unsigned char *src_rows[3], *dst_row;
+		unsigned char *src_ptr;
+		intneg *neg_rows[3];
+		intneg *neg_ptr;
+		int row, i, y, first, last, bottom;
+		
+		bottom = rect.origin.y + rect.size.height;
+		first = MAX(rect.origin.y - 1, y1);
+		last = MIN(bottom, y2 - 1);
+		
+		for (row = 0; row < 3; row++) {
+			src_rows[row] = malloc(swidth);
+			neg_rows[row] = malloc(swidth * sizeof(intneg));
+		}
+		dst_row = malloc(swidth);
+		
+		for (y = first; y <= last; y++) {
+			row = (y - first) % 3;
+			get_row(src_rows[row], &(data[(y * width + x1) * spp]), spp, channel, selection.size.width);
 			for (i = swidth, src_ptr = src_rows[row], neg_ptr = neg_rows[row]; i > 0; i--, src_ptr++, neg_ptr++)
 				*neg_ptr = neg_lut[*src_ptr];
 			
-			count++;
-			row = (row + 1) & 3;
+			if (y >= rect.origin.y && y < bottom && (y == y1 || y == y2 - 1))
+				set_row(&(overlay[(y * width + x1) * spp]), src_rows[row], spp, channel, selection.size.width);
 			
-		} else {
-			count--;
+			if (y - 1 > y1 && y - 1 >= rect.origin.y && y - 1 < bottom) {
+				(* filter) (selection.size.width, src_rows[(y - first + 2) % 3], dst_row,
+							neg_rows[(y - first + 1) % 3] + rspp,
+							neg_rows[(y - first + 2) % 3] + rspp,
+							neg_rows[row] + rspp);
+				set_row(&(overlay[((y - 1) * width + x1) * spp]), dst_row, spp, channel, selection.size.width);
+			}
 		}
 		
-		if (count == 3) {
-			(* filter) (selection.size.width, src_rows[(row + 2) & 3], dst_row,
-						neg_rows[(row + 1) & 3] + rspp,
-						neg_rows[(row + 2) & 3] + rspp,
-						neg_rows[(row + 3) & 3] + rspp);
-			set_row(&(overlay[(y * width + x1) * spp]), dst_row, spp, channel, selection.size.width);
-		} else if (count == 2) {
-			if (y == y1)
-				set_row(&(overlay[(y * width + x1) * spp]), src_rows[0], spp, channel, selection.size.width);
-			else
-				set_row(&(overlay[(y * width + x1) * spp]), src_rows[(selection.size.height - 1) & 3], spp, channel, selection.size.width);
+		for (row = 0; row < 3; row++) {
+			free(src_rows[row]);
+			free(neg_rows[row]);
 		}
-		
-	}
-	
-	for (row = 0; row < 4; row ++) {
-		free(src_rows[row]);
-		free(neg_rows[row]);
-	}
-	free(dst_row);
-	
-	for (i = y1; i < y2; i++)
-		memset(&(replace[i * width + x1]), 255, selection.size.width);
+		free(dst_row);
+	} halo:1 skipRows:NO];
 }
 
 - (BOOL)validateMenuItem:(id)menuItem
@@ -12,6 +12,8 @@
 #import "ThresholdView.h"
 #import <SeashoreKit/SSKCIPlugin.h>
 
+@class SeaColorPipeline;
+
 @interface ThresholdClass : SSKVisualPlugin
 //! The threshold range
 @property (weak) IBOutlet NSTextField *rangeLabel;
@@ -111,6 +113,14 @@
 */
 - (void)adjust;
 
+/*!
+	@method		pipeline
+	@discussion	Returns the threshold for the current range, which maps the
+				mean of the primary channels to black or white.
+	@result		Returns the colour pipeline to run over the selection.
+*/
+- (SeaColorPipeline *)pipeline;
+
 /*!
 	@method		validateMenuItem:
 	@discussion	Determines whether a given menu item should be enabled or
@@ -3,10 +3,14 @@
 #include <tgmath.h>
 #import "ThresholdView.h"
 #import "ThresholdClass.h"
+#import <SeashoreKit/ColorPipeline.h>
 
 #define gOurBundle [NSBundle bundleForClass:[self class]]
 
-@implementation ThresholdClass
+@implementation ThresholdClass {
+	// The threshold for the current range, built when first needed
+	SeaColorPipeline *pipeline;
+}
 @synthesize bottomValue;
 @synthesize topValue;
 @synthesize rangeLabel;
@@ -52,6 +56,9 @@
 	
 	self.topValue = 0;
 	self.bottomValue = 255;
+	@synchronized (self) {
+		pipeline = nil;
+	}
 	
 	[rangeLabel setStringValue:[NSString stringWithFormat:@"%ld - %ld", (long)topValue, (long)bottomValue]];
 	
@@ -99,9 +106,14 @@
 {
 	PluginData *pluginData = [self.seaPlugins data];
 	
-	if (refresh)
-		[self adjust];
-	[pluginData preview];
+	if (refresh) {
+		[pluginData previewProgressively:^{
+			[self adjust];
+		}];
+	}
+	else {
+		[pluginData preview];
+	}
 	refresh = NO;
 }
 
@@ -116,65 +128,50 @@
 	
 	[panel setAlphaValue:1.0];
 	refresh = YES;
+	@synchronized (self) {
+		pipeline = nil;
+	}
 	
 	[view setNeedsDisplay:YES];
+	[self preview:self];
 	if ([[NSApp currentEvent] type] == NSLeftMouseUp) {
-		[self preview:self];
 		pluginData = [self.seaPlugins data];
 		if ([pluginData window])
 			[panel setAlphaValue:0.4];
 	}
 }
 
+- (SeaColorPipeline *)pipeline
+{
+	// Average the primary channels, rounding down, then pick black or white
+	static const float mean[12] = {
+		1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0, -1.0 / 765.0,
+		1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0, -1.0 / 765.0,
+		1.0 / 3.0, 1.0 / 3.0, 1.0 / 3.0, -1.0 / 765.0
+	};
+	
+	@synchronized (self) {
+		if (!pipeline) {
+			int low = (int)MIN(topValue, bottomValue);
+			int high = (int)MAX(topValue, bottomValue);
+			
+			pipeline = [[SeaColorPipeline alloc] init];
+			[pipeline addMatrix:mean];
+			[pipeline addCurve:^int(int value) {
+				return (low <= value && value <= high) ? 255 : 0;
+			}];
+		}
+		return pipeline;
+	}
+}
+
 - (void)adjust
 {
 	PluginData *pluginData = [self.seaPlugins data];
-	IntRect selection;
-	int i, j, k, spp, width, channel, mid;
-	unsigned char *data, *overlay, *replace;
 	
 	[pluginData setOverlayOpacity:255];
 	[pluginData setOverlayBehaviour:SeaOverlayBehaviourReplacing];
-	
-	selection = [pluginData selection];
-	spp = [pluginData spp];
-	width = [pluginData width];
-	data = [pluginData data];
-	overlay = [pluginData overlay];
-	replace = [pluginData replace];
-	channel = [pluginData channel];
-	
-	for (j = selection.origin.y; j < selection.origin.y + selection.size.height; j++) {
-		for (i = selection.origin.x; i < selection.origin.x + selection.size.width; i++) {
-			
-			if (channel == kAllChannels || channel == kPrimaryChannels) {
-				mid = 0;
-				for (k = 0; k < spp - 1; k++)
-					mid += data[(j * width + i) * spp + k];
-				mid /= (spp - 1);
-				
-				if (MIN(topValue, bottomValue) <= mid && mid <= MAX(topValue, bottomValue))
-					memset(&(overlay[(j * width + i) * spp]), 255, spp - 1);
-				else
-					memset(&(overlay[(j * width + i) * spp]), 0, spp - 1);
-				
-				overlay[(j * width + i + 1) * spp - 1] = data[(j * width + i + 1) * spp - 1];
-				
-				replace[j * width + i] = 255;
-			} else if (channel == kAlphaChannel) {
-				mid = data[(j * width + i + 1) * spp - 1];
-				
-				if (MIN(topValue, bottomValue) <= mid && mid <= MAX(topValue, bottomValue))
-					memset(&(overlay[(j * width + i) * spp]), 255, spp - 1);
-				else
-					memset(&(overlay[(j * width + i) * spp]), 0, spp - 1);
-				
-				overlay[(j * width + i + 1) * spp - 1] = 255;
-				
-				replace[j * width + i] = 255;
-			}
-		}
-	}
+	[pluginData runColorPipeline:[self pipeline]];
 }
 
 - (BOOL)validateMenuItem:(id)menuItem
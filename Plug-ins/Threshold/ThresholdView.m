@@ -5,37 +5,20 @@
 
 - (void)calculateHistogram:(PluginData *)pluginData
 {
-	unsigned char *data = [pluginData data];
-	int spp = [pluginData spp];
-	int width = [pluginData width];
-	int height = [pluginData height];
+	const PluginStatistics *statistics = [pluginData statistics];
 	int channel = [pluginData channel];
-	int i, j, mid = 0;
-	__block int max = 1;
+	int i, index, max = 1;
 	
-	memset(histogram, 0, sizeof(histogram));
+	// Show the histogram of what the threshold is applied to
+	if (channel == kAlphaChannel)
+		index = [pluginData spp] - 1;
+	else
+		index = kLuminanceHistogram;
 	
-	if (channel == kAllChannels || channel == kPrimaryChannels) {
-		for (i = 0; i < width * height; i++) {
-			for (j = 0; j < spp - 1; j++)
-				mid += data[i * spp + j];
-			mid /= (spp - 1);
-			histogram[mid]++; 
-		}
-	} else if (channel == kAlphaChannel) {
-		for (i = 0; i < width * height; i++) {
-			mid = data[(i + 1) * spp - 1];
-			histogram[mid]++; 
-		}
-	}
-	
-	dispatch_apply(256, dispatch_get_global_queue(0, 0), ^(size_t i) {
-		max = (histogram[i] > max) ? histogram[i] : max;
-	});
-
-	dispatch_apply(256, dispatch_get_global_queue(0, 0), ^(size_t i) {
-		histogram[i] = (int)(((float)histogram[i] / (float)max) * 120.0);
-	});
+	for (i = 0; i < 256; i++)
+		max = MAX(max, (int)statistics->histogram[index][i]);
+	for (i = 0; i < 256; i++)
+		histogram[i] = (int)(((float)statistics->histogram[index][i] / (float)max) * 120.0);
 }
 
 - (void)drawRect:(NSRect)rect
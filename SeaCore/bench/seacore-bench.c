@@ -0,0 +1,857 @@
+/*
+	seacore-bench times the pixel core over synthetic images.
+
+	Each benchmark is run once to warm up then timed for a number of samples,
+	reporting the percentiles of the samples, the throughput at the median in
+	megapixels and megabytes a second, and the allocations made per run. The
+	results are written as JSON with one result to a line, so a results file
+	can be passed back with --baseline to compare a later run against it.
+*/
+
+#include "SeaCorePrivate.h"
+#include "Bucket.h"
+#include <getopt.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+
+// The format of the results, increased if they stop being comparable
+#define kBenchVersion 1
+
+// The longest benchmark name
+#define kMaxNameLength 48
+
+// The seed of the image most benchmarks work on
+#define kImageSeed 0x5ea5
+
+// The most a tile can take up once compressed, as allowed for by the XCF writer
+#define kMaxCompressedTile (XCF_TILE_WIDTH * XCF_TILE_HEIGHT * 4 + 1 + (XCF_TILE_WIDTH * XCF_TILE_HEIGHT * 4 / 128) * 3)
+
+/*
+	Allocation counting
+
+	When linked with --wrap for malloc, calloc and realloc, every allocation
+	made by the kernels and SeaCore is counted. Allocations made inside shared
+	libraries such as libpng are not seen.
+*/
+
+static atomic_ulong allocationCount, allocatedBytes;
+
+#ifdef SEACORE_BENCH_COUNT_ALLOCATIONS
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+	atomic_fetch_add_explicit(&allocationCount, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&allocatedBytes, size, memory_order_relaxed);
+	return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+	atomic_fetch_add_explicit(&allocationCount, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&allocatedBytes, count * size, memory_order_relaxed);
+	return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+	atomic_fetch_add_explicit(&allocationCount, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&allocatedBytes, size, memory_order_relaxed);
+	return __real_realloc(ptr, size);
+}
+
+#define kCountsAllocations true
+
+#else
+
+#define kCountsAllocations false
+
+#endif
+
+/*
+	Synthetic inputs
+*/
+
+typedef struct {
+	int width, height, spp, layers;
+	int samples;
+	const char *filter;
+	const char *output;
+	const char *baseline;
+	double threshold;
+} Options;
+
+typedef struct {
+	Options options;
+	unsigned char *image, *second, *dest, *overlay, *mask, *scaled, *blurred;
+	int scaledWidth, scaledHeight, upWidth, upHeight;
+	unsigned char **tiles;
+	int *tileLengths, tileCount;
+	SeaCoreDocumentRef document;
+	SeaCoreBitmap canvas;
+	SeaCoreLayer layer;
+	IntPoint fillSeed;
+	double filledPixels;
+	unsigned char *compressed;
+	char xcfPath[PATH_MAX];
+	XcfLayerMode mode;
+} State;
+
+static uint32_t random32(uint32_t *seed)
+{
+	// xorshift32, the inputs only need to be the same on every run
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 17;
+	*seed ^= *seed << 5;
+
+	return *seed;
+}
+
+// Returns the kind of block a pixel is in, blocks 1, 2 and 4 being the same continuous gradient
+static int blockAt(int x, int y, uint32_t seed)
+{
+	return ((x / 128) + (y / 128) + (int)(seed & 0xff)) % 5;
+}
+
+// Fills an image with gradients, flat blocks and a little noise so fills and compression see realistic runs
+static void makeImage(unsigned char *data, int width, int height, int spp, uint32_t seed)
+{
+	int x, y, k, block, offset = seed & 0xff;
+	uint32_t noise = seed | 1;
+	unsigned char *pixel;
+
+	for (y = 0; y < height; y++) {
+		for (x = 0; x < width; x++) {
+			pixel = data + ((size_t)y * width + x) * spp;
+			block = blockAt(x, y, seed);
+			for (k = 0; k < spp - 1; k++) {
+				if (block == 0)
+					pixel[k] = (unsigned char)(64 * k + 40);
+				else
+					pixel[k] = (unsigned char)(offset % 32 + (x * (k + 1) + y * (3 - k)) * 223 / (3 * (width + height)));
+				if (block == 4)
+					pixel[k] += random32(&noise) & 7;
+			}
+			pixel[spp - 1] = (block == 3) ? (unsigned char)(x + y) : 255;
+		}
+	}
+}
+
+static bool makeTiles(State *state)
+{
+	int width = state->options.width, height = state->options.height, spp = state->options.spp;
+	int across = (width + XCF_TILE_WIDTH - 1) / XCF_TILE_WIDTH, down = (height + XCF_TILE_HEIGHT - 1) / XCF_TILE_HEIGHT;
+	int i, j, y, tileWidth, tileHeight, t = 0;
+	unsigned char tile[XCF_TILE_WIDTH * XCF_TILE_HEIGHT * 4];
+
+	state->tileCount = across * down;
+	state->tiles = calloc(state->tileCount, sizeof(unsigned char *));
+	state->tileLengths = calloc(state->tileCount, sizeof(int));
+	if (!state->tiles || !state->tileLengths)
+		return false;
+	for (j = 0; j < down; j++) {
+		for (i = 0; i < across; i++, t++) {
+			tileWidth = MIN(XCF_TILE_WIDTH, width - i * XCF_TILE_WIDTH);
+			tileHeight = MIN(XCF_TILE_HEIGHT, height - j * XCF_TILE_HEIGHT);
+			for (y = 0; y < tileHeight; y++)
+				memcpy(tile + y * tileWidth * spp, state->image + ((size_t)(j * XCF_TILE_HEIGHT + y) * width + i * XCF_TILE_WIDTH) * spp, tileWidth * spp);
+			state->tiles[t] = malloc(kMaxCompressedTile);
+			if (!state->tiles[t])
+				return false;
+			state->tileLengths[t] = SeaRLECompress(state->tiles[t], tile, tileWidth, tileHeight, spp);
+		}
+	}
+
+	return true;
+}
+
+static void clearOverlay(State *state);
+static void runBucketFill(State *state);
+
+static bool setUp(State *state)
+{
+	Options *options = &state->options;
+	int width = options->width, height = options->height, spp = options->spp;
+	size_t size = (size_t)width * height * spp;
+	SeaCoreLayer *layer;
+	int fd;
+
+	state->image = malloc(size);
+	state->second = malloc(size);
+	state->dest = malloc(size);
+	state->overlay = malloc(size);
+	state->blurred = malloc(size);
+	state->mask = malloc((size_t)width * height);
+	state->scaledWidth = MAX(width / 2, 1);
+	state->scaledHeight = MAX(height / 2, 1);
+	state->upWidth = MIN(width * 2, kMaxImageSize);
+	state->upHeight = MIN(height * 2, kMaxImageSize);
+	state->scaled = malloc((size_t)state->upWidth * state->upHeight * spp);
+	state->compressed = malloc(kMaxCompressedTile);
+	if (!state->image || !state->second || !state->dest || !state->overlay || !state->blurred || !state->mask || !state->scaled || !state->compressed)
+		return false;
+	makeImage(state->image, width, height, spp, kImageSeed);
+	makeImage(state->second, width, height, spp, 0xc0de);
+	if (!makeTiles(state))
+		return false;
+
+	// Fills start in the gradient nearest the centre, their throughput counting only the pixels filled
+	state->fillSeed = IntMakePoint(width / 2, height / 2);
+	for (int y = height / 2; y < height && blockAt(state->fillSeed.x, state->fillSeed.y, kImageSeed) != 1; y++) {
+		for (int x = width / 2; x < width; x++) {
+			if (blockAt(x, y, kImageSeed) == 1) {
+				state->fillSeed = IntMakePoint(x, y);
+				break;
+			}
+		}
+	}
+	clearOverlay(state);
+	runBucketFill(state);
+	for (size_t i = 0; i < (size_t)width * height; i++)
+		state->filledPixels += (state->overlay[i * spp + spp - 1] != 0);
+	state->filledPixels = MAX(state->filledPixels, 1.0);
+
+	// The layers are offset from each other and cycle through some common modes
+	state->document = SeaCoreDocumentCreate(width, height, spp);
+	if (!state->document)
+		return false;
+	for (int i = 0; i < options->layers; i++) {
+		static const XcfLayerMode modes[] = { XCF_NORMAL_MODE, XCF_MULTIPLY_MODE, XCF_SCREEN_MODE, XCF_OVERLAY_MODE, XCF_HUE_MODE };
+		layer = SeaCoreDocumentAddLayer(state->document, "Layer", (i * 17) % 64, (i * 29) % 64, width, height);
+		if (!layer)
+			return false;
+		makeImage(layer->bitmap.data, width, height, spp, 0x1000 + i);
+		layer->mode = (i == 0) ? XCF_NORMAL_MODE : modes[i % 5];
+		layer->opacity = (i == 0) ? 255 : 160 + (i * 23) % 96;
+	}
+	if (SeaCoreBitmapCreate(&state->canvas, width, height, spp))
+		return false;
+	state->layer.bitmap.width = width;
+	state->layer.bitmap.height = height;
+	state->layer.bitmap.spp = spp;
+	state->layer.bitmap.data = state->second;
+	state->layer.opacity = 200;
+	state->layer.visible = true;
+
+	// A saved copy of the document for loading
+	snprintf(state->xcfPath, sizeof(state->xcfPath), "%s/seacore-bench-XXXXXX", getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp");
+	fd = mkstemp(state->xcfPath);
+	if (fd < 0) {
+		state->xcfPath[0] = 0;
+		return false;
+	}
+	close(fd);
+
+	return SeaCoreDocumentWriteXCF(state->document, state->xcfPath) == SeaCoreErrorNone;
+}
+
+static void tearDown(State *state)
+{
+	if (state->xcfPath[0])
+		unlink(state->xcfPath);
+	for (int i = 0; i < state->tileCount && state->tiles; i++)
+		free(state->tiles[i]);
+	free(state->tiles);
+	free(state->tileLengths);
+	SeaCoreDocumentRelease(state->document);
+	SeaCoreBitmapFree(&state->canvas);
+	free(state->image);
+	free(state->second);
+	free(state->dest);
+	free(state->overlay);
+	free(state->blurred);
+	free(state->mask);
+	free(state->scaled);
+	free(state->compressed);
+}
+
+/*
+	The benchmarks
+*/
+
+static void resetDest(State *state)
+{
+	memcpy(state->dest, state->image, (size_t)state->options.width * state->options.height * state->options.spp);
+}
+
+static void resetCanvas(State *state)
+{
+	memcpy(state->canvas.data, state->image, (size_t)state->options.width * state->options.height * state->options.spp);
+}
+
+static void clearOverlay(State *state)
+{
+	memset(state->overlay, 0, (size_t)state->options.width * state->options.height * state->options.spp);
+}
+
+static void clearMask(State *state)
+{
+	memset(state->mask, 0, (size_t)state->options.width * state->options.height);
+}
+
+static void runNormalMerge(State *state)
+{
+	int spp = state->options.spp, count = state->options.width * state->options.height;
+
+	for (int i = 0; i < count; i++)
+		SeaNormalMerge(spp, state->dest, i * spp, state->second, i * spp, 200);
+}
+
+static void runSelectMerge(State *state)
+{
+	int spp = state->options.spp, width = state->options.width, height = state->options.height;
+	unsigned char *temp = state->overlay;
+
+	// As SeaCompositor does, the source is merged on to a copy of the destination which is then blended back
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			int loc = (y * width + x) * spp;
+			memcpy(temp, state->dest + loc, spp);
+			SeaSelectMerge(state->mode, spp, temp, 0, state->second, loc, x, y);
+			SeaNormalMerge(spp, state->dest, loc, temp, 0, 200);
+		}
+	}
+}
+
+static void runComposite(State *state)
+{
+	state->layer.mode = state->mode;
+	SeaCoreCompositeLayer(&state->canvas, &state->layer);
+}
+
+static void runFlatten(State *state)
+{
+	SeaCoreBitmap result;
+
+	if (SeaCoreDocumentFlatten(state->document, &result) == SeaCoreErrorNone)
+		SeaCoreBitmapFree(&result);
+}
+
+static void runRLECompress(State *state)
+{
+	int width = state->options.width, height = state->options.height, spp = state->options.spp;
+	int across = (width + XCF_TILE_WIDTH - 1) / XCF_TILE_WIDTH, i, j, y, tileWidth, tileHeight;
+	unsigned char tile[XCF_TILE_WIDTH * XCF_TILE_HEIGHT * 4];
+	for (int t = 0; t < state->tileCount; t++) {
+		i = t % across;
+		j = t / across;
+		tileWidth = MIN(XCF_TILE_WIDTH, width - i * XCF_TILE_WIDTH);
+		tileHeight = MIN(XCF_TILE_HEIGHT, height - j * XCF_TILE_HEIGHT);
+		for (y = 0; y < tileHeight; y++)
+			memcpy(tile + y * tileWidth * spp, state->image + ((size_t)(j * XCF_TILE_HEIGHT + y) * width + i * XCF_TILE_WIDTH) * spp, tileWidth * spp);
+		SeaRLECompress(state->compressed, tile, tileWidth, tileHeight, spp);
+	}
+}
+
+static void runRLEDecompress(State *state)
+{
+	int width = state->options.width, height = state->options.height, spp = state->options.spp;
+	int across = (width + XCF_TILE_WIDTH - 1) / XCF_TILE_WIDTH, tileWidth, tileHeight;
+	unsigned char tile[XCF_TILE_WIDTH * XCF_TILE_HEIGHT * 4];
+
+	for (int t = 0; t < state->tileCount; t++) {
+		tileWidth = MIN(XCF_TILE_WIDTH, width - (t % across) * XCF_TILE_WIDTH);
+		tileHeight = MIN(XCF_TILE_HEIGHT, height - (t / across) * XCF_TILE_HEIGHT);
+		SeaRLEDecompress(tile, state->tiles[t], state->tileLengths[t], tileWidth, tileHeight, spp);
+	}
+}
+
+static void runBucketFill(State *state)
+{
+	int width = state->options.width, height = state->options.height;
+	unsigned char colour[4] = { 200, 40, 90, 255 };
+
+	colour[state->options.spp - 1] = 255;
+	SeaBucketFill(state->options.spp, IntMakeRect(0, 0, width, height), state->overlay, state->image, width, height, &state->fillSeed, 1, colour, 48, kAllChannels);
+}
+
+static void runColorMask(State *state)
+{
+	int width = state->options.width, height = state->options.height;
+
+	SeaColorMask(state->options.spp, IntMakeRect(0, 0, width, height), state->mask, state->image, width, height, &state->fillSeed, 1, 48, 16, kAllChannels);
+}
+
+static void runGaussianBlur(State *state)
+{
+	int width = state->options.width, spp = state->options.spp;
+
+	GCGaussianBlur(state->blurred, width * spp, state->image, width * spp, width, state->options.height, spp, spp, 8.0, GIMP_BLUR_AUTO);
+}
+
+static void runScaleDown(State *state)
+{
+	GCScalePixels(state->scaled, state->scaledWidth, state->scaledHeight, state->image, state->options.width, state->options.height, GIMP_INTERPOLATION_CUBIC, state->options.spp);
+}
+
+static void runScaleUp(State *state)
+{
+	GCScalePixels(state->scaled, state->upWidth, state->upHeight, state->image, state->options.width, state->options.height, GIMP_INTERPOLATION_LINEAR, state->options.spp);
+}
+
+static void runRotate(State *state)
+{
+	unsigned char *rotated = NULL;
+	int width, height, x, y;
+
+	GCRotateImage(&rotated, &width, &height, &x, &y, state->image, state->options.width, state->options.height, 0.5f, GIMP_INTERPOLATION_CUBIC, state->options.spp, NULL);
+	free(rotated);
+}
+
+static void runGradient(State *state, GimpGradientType type)
+{
+	int width = state->options.width, height = state->options.height;
+	GimpGradientInfo info = { type, GIMP_REPEAT_NONE, false, 3, 0.2, { 255, 0, 0, 255 }, { width / 4, height / 4 }, { 0, 0, 255, 128 }, { width * 3 / 4, height * 3 / 4 } };
+
+	GCFillGradient(state->overlay, width, height, IntMakeRect(0, 0, width, height), state->options.spp, info, NULL);
+}
+
+static void runLinearGradient(State *state)
+{
+	runGradient(state, GIMP_GRADIENT_LINEAR);
+}
+
+static void runRadialGradient(State *state)
+{
+	runGradient(state, GIMP_GRADIENT_RADIAL);
+}
+
+static void runXCFSave(State *state)
+{
+	SeaCoreDocumentWriteXCF(state->document, state->xcfPath);
+}
+
+static void runXCFLoad(State *state)
+{
+	SeaCoreError error;
+
+	SeaCoreDocumentRelease(SeaCoreDocumentCreateWithXCF(state->xcfPath, &error));
+}
+
+static void runXCFRender(State *state)
+{
+	SeaCoreBitmap result;
+
+	if (SeaCoreRenderXCF(state->xcfPath, &result) == SeaCoreErrorNone)
+		SeaCoreBitmapFree(&result);
+}
+
+/*
+	Running and reporting
+*/
+
+// How much of the image a benchmark covers in a run
+typedef enum {
+	kCoversImage,
+	kCoversFill,
+	kCoversLayers,
+	kCoversScaledDown,
+	kCoversScaledUp
+} Coverage;
+
+typedef struct {
+	const char *name;
+	void (*prepare)(State *state);
+	void (*run)(State *state);
+	Coverage coverage;
+	XcfLayerMode mode;
+} Benchmark;
+
+typedef struct {
+	char name[kMaxNameLength];
+	double minimum, mean, p50, p90, p99;
+	double pixels, bytes;
+	unsigned long allocations, allocated;
+	double baseline;
+} Result;
+
+static const struct {
+	XcfLayerMode mode;
+	const char *name;
+} modeNames[] = {
+	{ XCF_DISSOLVE_MODE, "dissolve" },
+	{ XCF_MULTIPLY_MODE, "multiply" },
+	{ XCF_SCREEN_MODE, "screen" },
+	{ XCF_OVERLAY_MODE, "overlay" },
+	{ XCF_DIFFERENCE_MODE, "difference" },
+	{ XCF_ADDITION_MODE, "addition" },
+	{ XCF_SUBTRACT_MODE, "subtract" },
+	{ XCF_DARKEN_ONLY_MODE, "darken" },
+	{ XCF_LIGHTEN_ONLY_MODE, "lighten" },
+	{ XCF_HUE_MODE, "hue" },
+	{ XCF_SATURATION_MODE, "saturation" },
+	{ XCF_COLOR_MODE, "color" },
+	{ XCF_VALUE_MODE, "value" },
+	{ XCF_DIVIDE_MODE, "divide" },
+	{ XCF_DODGE_MODE, "dodge" },
+	{ XCF_BURN_MODE, "burn" },
+	{ XCF_HARDLIGHT_MODE, "hardlight" },
+	{ XCF_SOFTLIGHT_MODE, "softlight" },
+	{ XCF_GRAIN_EXTRACT_MODE, "grain-extract" },
+	{ XCF_GRAIN_MERGE_MODE, "grain-merge" }
+};
+
+#define kModeCount (int)(sizeof(modeNames) / sizeof(modeNames[0]))
+
+static const Benchmark fixedBenchmarks[] = {
+	{ "merge/normal", resetDest, runNormalMerge, kCoversImage, XCF_NORMAL_MODE },
+	{ "composite/normal", resetCanvas, runComposite, kCoversImage, XCF_NORMAL_MODE },
+	{ "composite/multiply", resetCanvas, runComposite, kCoversImage, XCF_MULTIPLY_MODE },
+	{ "composite/overlay", resetCanvas, runComposite, kCoversImage, XCF_OVERLAY_MODE },
+	{ "composite/hue", resetCanvas, runComposite, kCoversImage, XCF_HUE_MODE },
+	{ "composite/dissolve", resetCanvas, runComposite, kCoversImage, XCF_DISSOLVE_MODE },
+	{ "flatten", NULL, runFlatten, kCoversLayers, XCF_NORMAL_MODE },
+	{ "rle/compress", NULL, runRLECompress, kCoversImage, XCF_NORMAL_MODE },
+	{ "rle/decompress", NULL, runRLEDecompress, kCoversImage, XCF_NORMAL_MODE },
+	{ "bucket/fill", clearOverlay, runBucketFill, kCoversFill, XCF_NORMAL_MODE },
+	{ "bucket/color-mask", clearMask, runColorMask, kCoversImage, XCF_NORMAL_MODE },
+	{ "blur/gaussian", NULL, runGaussianBlur, kCoversImage, XCF_NORMAL_MODE },
+	{ "scale/down-cubic", NULL, runScaleDown, kCoversScaledDown, XCF_NORMAL_MODE },
+	{ "scale/up-linear", NULL, runScaleUp, kCoversScaledUp, XCF_NORMAL_MODE },
+	{ "rotate", NULL, runRotate, kCoversImage, XCF_NORMAL_MODE },
+	{ "gradient/linear", NULL, runLinearGradient, kCoversImage, XCF_NORMAL_MODE },
+	{ "gradient/radial", NULL, runRadialGradient, kCoversImage, XCF_NORMAL_MODE },
+	{ "xcf/save", NULL, runXCFSave, kCoversLayers, XCF_NORMAL_MODE },
+	{ "xcf/load", NULL, runXCFLoad, kCoversLayers, XCF_NORMAL_MODE },
+	{ "xcf/render", NULL, runXCFRender, kCoversLayers, XCF_NORMAL_MODE }
+};
+
+#define kFixedCount (int)(sizeof(fixedBenchmarks) / sizeof(fixedBenchmarks[0]))
+
+static double now(void)
+{
+	struct timespec time;
+
+	clock_gettime(CLOCK_MONOTONIC, &time);
+
+	return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+static int compareDoubles(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+// Returns the nearest rank percentile of sorted samples
+static double percentile(const double *sorted, int count, double fraction)
+{
+	int rank = (int)ceil(fraction * count);
+
+	return sorted[MAX(MIN(rank, count), 1) - 1];
+}
+
+static void measure(State *state, const Benchmark *benchmark, Result *result)
+{
+	int samples = state->options.samples, width = state->options.width, height = state->options.height;
+	double *times = malloc(samples * sizeof(double)), start, total = 0.0, pixels;
+	unsigned long allocations = 0, allocated = 0, before, beforeBytes;
+
+	state->mode = benchmark->mode;
+
+	// One run to warm the caches and the thread pool
+	if (benchmark->prepare)
+		benchmark->prepare(state);
+	benchmark->run(state);
+
+	for (int i = 0; i < samples; i++) {
+		if (benchmark->prepare)
+			benchmark->prepare(state);
+		before = atomic_load(&allocationCount);
+		beforeBytes = atomic_load(&allocatedBytes);
+		start = now();
+		benchmark->run(state);
+		times[i] = now() - start;
+		allocations += atomic_load(&allocationCount) - before;
+		allocated += atomic_load(&allocatedBytes) - beforeBytes;
+		total += times[i];
+	}
+	qsort(times, samples, sizeof(double), compareDoubles);
+
+	switch (benchmark->coverage) {
+		case kCoversFill:
+			pixels = state->filledPixels;
+		break;
+		case kCoversLayers:
+			pixels = (double)width * height * state->options.layers;
+		break;
+		case kCoversScaledDown:
+			pixels = (double)state->scaledWidth * state->scaledHeight;
+		break;
+		case kCoversScaledUp:
+			pixels = (double)state->upWidth * state->upHeight;
+		break;
+		default:
+			pixels = (double)width * height;
+		break;
+	}
+
+	snprintf(result->name, kMaxNameLength, "%s", benchmark->name);
+	result->minimum = times[0];
+	result->mean = total / samples;
+	result->p50 = percentile(times, samples, 0.5);
+	result->p90 = percentile(times, samples, 0.9);
+	result->p99 = percentile(times, samples, 0.99);
+	result->pixels = pixels;
+	result->bytes = pixels * state->options.spp;
+	result->allocations = allocations / samples;
+	result->allocated = allocated / samples;
+	result->baseline = -1.0;
+	free(times);
+}
+
+// Finds a number following a key in a line of the results
+static bool findNumber(const char *line, const char *key, double *value)
+{
+	const char *found = strstr(line, key);
+	char *end;
+
+	if (!found)
+		return false;
+	found += strlen(key);
+	*value = strtod(found, &end);
+
+	return end != found;
+}
+
+// Reads the median times from a results file, which are only comparable when it was made with the same options
+static bool readBaseline(State *state, Result *results, int count)
+{
+	FILE *file = fopen(state->options.baseline, "r");
+	char line[1024], name[kMaxNameLength];
+	const char *start, *end;
+	double value;
+
+	if (!file) {
+		fprintf(stderr, "seacore-bench: cannot read the baseline %s\n", state->options.baseline);
+		return false;
+	}
+	while (fgets(line, sizeof(line), file)) {
+		if (strstr(line, "\"config\"")) {
+			if ((findNumber(line, "\"width\": ", &value) && value != state->options.width) ||
+				(findNumber(line, "\"height\": ", &value) && value != state->options.height) ||
+				(findNumber(line, "\"spp\": ", &value) && value != state->options.spp) ||
+				(findNumber(line, "\"layers\": ", &value) && value != state->options.layers)) {
+				fprintf(stderr, "seacore-bench: the baseline was made with other image options\n");
+				fclose(file);
+				return false;
+			}
+			continue;
+		}
+		start = strstr(line, "\"name\": \"");
+		if (!start || !findNumber(line, "\"p50_ms\": ", &value))
+			continue;
+		start += strlen("\"name\": \"");
+		end = strchr(start, '"');
+		if (!end || end - start >= kMaxNameLength)
+			continue;
+		memcpy(name, start, end - start);
+		name[end - start] = 0;
+		for (int i = 0; i < count; i++) {
+			if (strcmp(results[i].name, name) == 0)
+				results[i].baseline = value / 1000.0;
+		}
+	}
+	fclose(file);
+
+	return true;
+}
+
+static void writeResults(FILE *file, State *state, Result *results, int count, int regressions)
+{
+	Options *options = &state->options;
+
+	fprintf(file, "{\n");
+	fprintf(file, "  \"version\": %d,\n", kBenchVersion);
+	fprintf(file, "  \"config\": { \"width\": %d, \"height\": %d, \"spp\": %d, \"layers\": %d, \"samples\": %d, \"processors\": %ld, \"counts_allocations\": %s },\n",
+		options->width, options->height, options->spp, options->layers, options->samples, sysconf(_SC_NPROCESSORS_ONLN), kCountsAllocations ? "true" : "false");
+	fprintf(file, "  \"results\": [\n");
+	for (int i = 0; i < count; i++) {
+		Result *result = &results[i];
+		fprintf(file, "    { \"name\": \"%s\", \"pixels\": %.0f, \"bytes\": %.0f, \"min_ms\": %.4f, \"mean_ms\": %.4f, \"p50_ms\": %.4f, \"p90_ms\": %.4f, \"p99_ms\": %.4f, \"mpix_s\": %.2f, \"mb_s\": %.2f, \"allocations\": %lu, \"allocated_bytes\": %lu",
+			result->name, result->pixels, result->bytes, result->minimum * 1000.0, result->mean * 1000.0, result->p50 * 1000.0, result->p90 * 1000.0, result->p99 * 1000.0,
+			result->pixels / result->p50 / 1e6, result->bytes / result->p50 / 1e6, result->allocations, result->allocated);
+		if (result->baseline > 0.0)
+			fprintf(file, ", \"baseline_p50_ms\": %.4f, \"change\": %.4f", result->baseline * 1000.0, result->p50 / result->baseline - 1.0);
+		fprintf(file, " }%s\n", (i + 1 < count) ? "," : "");
+	}
+	fprintf(file, "  ]");
+	if (options->baseline)
+		fprintf(file, ",\n  \"threshold\": %.4f,\n  \"regressions\": %d", options->threshold, regressions);
+	fprintf(file, "\n}\n");
+}
+
+static bool wanted(State *state, const char *name)
+{
+	return !state->options.filter || strstr(name, state->options.filter);
+}
+
+static void usage(FILE *stream)
+{
+	fprintf(stream,
+		"usage: seacore-bench [options]\n"
+		"Times the pixel core over synthetic images and writes the results as JSON.\n"
+		"  -W, --width pixels      the width of the images (default 1024)\n"
+		"  -H, --height pixels     the height of the images (default 1024)\n"
+		"  -s, --spp samples       2 for grey or 4 for colour (default 4)\n"
+		"  -l, --layers count      the layers in the document (default 4)\n"
+		"  -n, --samples count     the timed runs of each benchmark (default 15)\n"
+		"  -f, --filter text       only run benchmarks whose names contain the text\n"
+		"  -o, --output file       write the results here rather than to standard output\n"
+		"  -b, --baseline file     compare the medians against an earlier results file\n"
+		"  -t, --threshold percent the slowdown counted as a regression (default 10)\n"
+		"Exits with 1 when a benchmark is slower than the baseline by more than the threshold\n"
+		"and with 2 when the baseline cannot be compared.\n");
+}
+
+static bool parseInt(const char *string, int minimum, int maximum, int *value)
+{
+	char *end;
+	long result = strtol(string, &end, 10);
+
+	*value = (int)result;
+
+	return end != string && *end == 0 && result >= minimum && result <= maximum;
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct option longOptions[] = {
+		{ "width", required_argument, NULL, 'W' },
+		{ "height", required_argument, NULL, 'H' },
+		{ "spp", required_argument, NULL, 's' },
+		{ "layers", required_argument, NULL, 'l' },
+		{ "samples", required_argument, NULL, 'n' },
+		{ "filter", required_argument, NULL, 'f' },
+		{ "output", required_argument, NULL, 'o' },
+		{ "baseline", required_argument, NULL, 'b' },
+		{ "threshold", required_argument, NULL, 't' },
+		{ "help", no_argument, NULL, 'h' },
+		{ NULL, 0, NULL, 0 }
+	};
+	State state;
+	Options *options = &state.options;
+	Benchmark benchmarks[kFixedCount + kModeCount];
+	char modeBenchmarkNames[kModeCount][kMaxNameLength];
+	Result *results;
+	FILE *output = stdout;
+	int option, count = 0, resultCount = 0, regressions = 0;
+	bool valid = true, compared;
+	char *end;
+
+	memset(&state, 0, sizeof(State));
+	options->width = options->height = 1024;
+	options->spp = 4;
+	options->layers = 4;
+	options->samples = 15;
+	options->threshold = 0.1;
+	while ((option = getopt_long(argc, argv, "W:H:s:l:n:f:o:b:t:h", longOptions, NULL)) != -1) {
+		switch (option) {
+			case 'W':
+				valid = valid && parseInt(optarg, 1, kMaxImageSize, &options->width);
+			break;
+			case 'H':
+				valid = valid && parseInt(optarg, 1, kMaxImageSize, &options->height);
+			break;
+			case 's':
+				valid = valid && parseInt(optarg, 2, 4, &options->spp) && options->spp != 3;
+			break;
+			case 'l':
+				valid = valid && parseInt(optarg, 1, 256, &options->layers);
+			break;
+			case 'n':
+				valid = valid && parseInt(optarg, 1, 100000, &options->samples);
+			break;
+			case 'f':
+				options->filter = optarg;
+			break;
+			case 'o':
+				options->output = optarg;
+			break;
+			case 'b':
+				options->baseline = optarg;
+			break;
+			case 't':
+				options->threshold = strtod(optarg, &end) / 100.0;
+				valid = valid && end != optarg && *end == 0 && options->threshold >= 0.0;
+			break;
+			case 'h':
+				usage(stdout);
+				return 0;
+			default:
+				valid = false;
+			break;
+		}
+	}
+	if (!valid || optind != argc) {
+		usage(stderr);
+		return 2;
+	}
+
+	// The fixed benchmarks then every mode through the merge kernel
+	for (int i = 0; i < kFixedCount; i++) {
+		if (wanted(&state, fixedBenchmarks[i].name))
+			benchmarks[count++] = fixedBenchmarks[i];
+	}
+	for (int i = 0; i < kModeCount; i++) {
+		snprintf(modeBenchmarkNames[i], kMaxNameLength, "merge/%s", modeNames[i].name);
+		if (wanted(&state, modeBenchmarkNames[i]))
+			benchmarks[count++] = (Benchmark){ modeBenchmarkNames[i], resetDest, runSelectMerge, kCoversImage, modeNames[i].mode };
+	}
+	if (count == 0) {
+		fprintf(stderr, "seacore-bench: no benchmarks match %s\n", options->filter);
+		return 2;
+	}
+
+	if (!setUp(&state)) {
+		fprintf(stderr, "seacore-bench: could not create the inputs\n");
+		tearDown(&state);
+		return 1;
+	}
+	results = calloc(count, sizeof(Result));
+	for (int i = 0; i < count && results; i++) {
+		fprintf(stderr, "%-24s", benchmarks[i].name);
+		measure(&state, &benchmarks[i], &results[resultCount]);
+		fprintf(stderr, "%10.3f ms %10.2f MPix/s\n", results[resultCount].p50 * 1000.0, results[resultCount].pixels / results[resultCount].p50 / 1e6);
+		resultCount++;
+	}
+	tearDown(&state);
+
+	// Compare the medians against the baseline
+	compared = options->baseline && results && readBaseline(&state, results, resultCount);
+	if (compared) {
+		for (int i = 0; i < resultCount; i++) {
+			if (results[i].baseline <= 0.0)
+				continue;
+			if (results[i].p50 > results[i].baseline * (1.0 + options->threshold)) {
+				regressions++;
+				fprintf(stderr, "seacore-bench: %s regressed by %.1f%%\n", results[i].name, (results[i].p50 / results[i].baseline - 1.0) * 100.0);
+			}
+		}
+	}
+
+	if (options->output) {
+		output = fopen(options->output, "w");
+		if (!output) {
+			fprintf(stderr, "seacore-bench: cannot write %s\n", options->output);
+			free(results);
+			return 1;
+		}
+	}
+	if (results)
+		writeResults(output, &state, results, resultCount, regressions);
+	if (output != stdout)
+		fclose(output);
+	free(results);
+
+	if (!results || regressions > 0)
+		return 1;
+
+	return (options->baseline && !compared) ? 2 : 0;
+}
@@ -0,0 +1,10 @@
+/*!
+	@header		Cocoa
+	@abstract	Stands in for Cocoa when the pixel core is built as plain C.
+	@discussion	The kernels only need what Foundation provides.
+				<br><br>
+				<b>License:</b> GNU General Public License<br>
+				<b>Copyright:</b> N/A
+*/
+
+#include <Foundation/Foundation.h>
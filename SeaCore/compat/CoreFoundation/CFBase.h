@@ -0,0 +1,15 @@
+/*!
+	@header		CFBase
+	@abstract	Stands in for CoreFoundation when GIMPCore is built as plain C.
+	@discussion	N/A
+				<br><br>
+				<b>License:</b> GNU General Public License<br>
+				<b>Copyright:</b> N/A
+*/
+
+#ifndef SEACORE_CFBASE_H
+#define SEACORE_CFBASE_H
+
+#define CF_ENUM(_type, _name) _type _name; enum
+
+#endif /* SEACORE_CFBASE_H */
@@ -0,0 +1,76 @@
+/*!
+	@header		Foundation
+	@abstract	Stands in for Foundation when the pixel core is built as plain C.
+	@discussion	Only what the kernels shared with Seashore need is provided:
+				the basic types, the enumeration macros and the rectangle
+				types. Nothing here may be used by Seashore itself.
+				<br><br>
+				<b>License:</b> GNU General Public License<br>
+				<b>Copyright:</b> N/A
+*/
+
+#ifndef SEACORE_FOUNDATION_H
+#define SEACORE_FOUNDATION_H
+
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/cdefs.h>
+#include <dispatch/dispatch.h>
+
+#ifndef __BEGIN_DECLS
+#ifdef __cplusplus
+#define __BEGIN_DECLS extern "C" {
+#define __END_DECLS }
+#else
+#define __BEGIN_DECLS
+#define __END_DECLS
+#endif
+#endif
+
+typedef signed char BOOL;
+#define YES ((BOOL)1)
+#define NO ((BOOL)0)
+
+typedef long NSInteger;
+typedef unsigned long NSUInteger;
+
+typedef double CGFloat;
+#define CGFLOAT_IS_DOUBLE 1
+
+typedef struct { CGFloat x; CGFloat y; } NSPoint;
+typedef struct { CGFloat width; CGFloat height; } NSSize;
+typedef struct { NSPoint origin; NSSize size; } NSRect;
+
+static inline BOOL NSPointInRect(NSPoint point, NSRect rect)
+{
+	return point.x >= rect.origin.x && point.y >= rect.origin.y && point.x < rect.origin.x + rect.size.width && point.y < rect.origin.y + rect.size.height;
+}
+
+#ifndef MIN
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+// NS_ENUM(type, name) declares the type then the constants, NS_ENUM(type) only the constants
+#define SEACORE_ENUM_PICK(_1, _2, macro, ...) macro
+#define SEACORE_NAMED_ENUM(_type, _name) _type _name; enum
+#define SEACORE_ANONYMOUS_ENUM(_type) enum
+#define NS_ENUM(...) SEACORE_ENUM_PICK(__VA_ARGS__, SEACORE_NAMED_ENUM, SEACORE_ANONYMOUS_ENUM)(__VA_ARGS__)
+#define NS_OPTIONS(_type, _name) _type _name; enum
+
+#define NS_SWIFT_NAME(_name)
+#define NS_SWIFT_UNAVAILABLE(_message)
+#define NS_REFINED_FOR_SWIFT
+#define NS_RETURNS_INNER_POINTER
+#define NS_ASSUME_NONNULL_BEGIN
+#define NS_ASSUME_NONNULL_END
+
+#endif /* SEACORE_FOUNDATION_H */
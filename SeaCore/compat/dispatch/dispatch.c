@@ -0,0 +1,82 @@
+#include "dispatch.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+// The most helper threads a single call may start
+#define kMaxHelpers 64
+
+typedef struct {
+	void *context;
+	void (*work)(void *context, size_t iteration);
+	size_t iterations;
+	atomic_size_t next;
+} ApplyJob;
+
+// The helper threads that may still be started across all calls
+static atomic_int available;
+static pthread_once_t availableOnce = PTHREAD_ONCE_INIT;
+
+static void initAvailable(void)
+{
+	long processors = sysconf(_SC_NPROCESSORS_ONLN);
+
+	atomic_init(&available, (int)((processors > 1) ? processors - 1 : 0));
+}
+
+// Takes up to the given number of helpers from those available
+static int reserveHelpers(int wanted)
+{
+	int current = atomic_load(&available), taken;
+
+	do {
+		taken = (current < wanted) ? current : wanted;
+		if (taken <= 0)
+			return 0;
+	} while (!atomic_compare_exchange_weak(&available, &current, current - taken));
+
+	return taken;
+}
+
+static void *runJob(void *argument)
+{
+	ApplyJob *job = argument;
+	size_t i;
+
+	while ((i = atomic_fetch_add(&job->next, 1)) < job->iterations)
+		job->work(job->context, i);
+
+	return NULL;
+}
+
+dispatch_queue_t dispatch_get_global_queue(long identifier, unsigned long flags)
+{
+	(void)identifier;
+	(void)flags;
+
+	return NULL;
+}
+
+void dispatch_apply_f(size_t iterations, dispatch_queue_t queue, void *context, void (*work)(void *context, size_t iteration))
+{
+	pthread_t helpers[kMaxHelpers];
+	ApplyJob job = { context, work, iterations, 0 };
+	int wanted, reserved, started, i;
+
+	(void)queue;
+	if (iterations == 0)
+		return;
+
+	// Start what helpers are free, the calling thread always works too
+	pthread_once(&availableOnce, initAvailable);
+	wanted = (iterations - 1 < kMaxHelpers) ? (int)(iterations - 1) : kMaxHelpers;
+	reserved = reserveHelpers(wanted);
+	for (started = 0; started < reserved; started++) {
+		if (pthread_create(&helpers[started], NULL, runJob, &job))
+			break;
+	}
+	runJob(&job);
+	for (i = 0; i < started; i++)
+		pthread_join(helpers[i], NULL);
+	atomic_fetch_add(&available, reserved);
+}
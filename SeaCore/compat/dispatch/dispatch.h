@@ -0,0 +1,60 @@
+/*!
+	@header		dispatch
+	@abstract	Stands in for libdispatch where it is not available.
+	@discussion	Only dispatch_apply_f is provided, which is all the pixel core
+				uses. The iterations are shared between the calling thread and
+				helper threads, never using more helpers in total than there
+				are other processors, so kernels called from several threads
+				at once do not oversubscribe the machine.
+				<br><br>
+				<b>License:</b> GNU General Public License<br>
+				<b>Copyright:</b> N/A
+*/
+
+#ifndef SEACORE_DISPATCH_H
+#define SEACORE_DISPATCH_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+	@typedef	dispatch_queue_t
+	@discussion	A placeholder for a queue, every queue is the global queue.
+*/
+typedef struct dispatch_queue_s *dispatch_queue_t;
+
+/*!
+	@function	dispatch_get_global_queue
+	@discussion	Returns the global queue.
+	@param		identifier
+				Ignored.
+	@param		flags
+				Ignored.
+	@result		Returns the global queue.
+*/
+dispatch_queue_t dispatch_get_global_queue(long identifier, unsigned long flags);
+
+/*!
+	@function	dispatch_apply_f
+	@discussion	Calls a function once for each iteration, possibly from
+				several threads at once, returning when every call has.
+	@param		iterations
+				The number of iterations.
+	@param		queue
+				Ignored.
+	@param		context
+				The context passed to each call.
+	@param		work
+				The function called with the context and the index of the
+				iteration.
+*/
+void dispatch_apply_f(size_t iterations, dispatch_queue_t queue, void *context, void (*work)(void *context, size_t iteration));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SEACORE_DISPATCH_H */
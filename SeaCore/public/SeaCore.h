@@ -0,0 +1,412 @@
+/*!
+	@header		SeaCore
+	@abstract	The pixel core of Seashore as a portable C library.
+	@discussion	SeaCore loads, composites, scales and saves documents without
+				AppKit, using the same kernels as Seashore (StandardMerge, RLE
+				and GIMPCore), so a document renders the same on any platform.
+				All functions may be called from several threads at once as
+				long as each document and bitmap is only used by one of them.
+				<br><br>
+				<b>License:</b> GNU General Public License<br>
+				<b>Copyright:</b> N/A
+*/
+
+#ifndef SEACORE_H
+#define SEACORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+	@enum		SeaCoreError
+	@constant	SeaCoreErrorNone
+				Indicates success.
+	@constant	SeaCoreErrorFile
+				Indicates a file could not be opened, read or written.
+	@constant	SeaCoreErrorFormat
+				Indicates a file is damaged or is not of the expected format.
+	@constant	SeaCoreErrorUnsupported
+				Indicates a file uses a feature that is not supported, such as
+				floating point samples.
+	@constant	SeaCoreErrorMemory
+				Indicates memory could not be allocated.
+	@constant	SeaCoreErrorArgument
+				Indicates an argument was out of range.
+*/
+typedef enum {
+	SeaCoreErrorNone,
+	SeaCoreErrorFile,
+	SeaCoreErrorFormat,
+	SeaCoreErrorUnsupported,
+	SeaCoreErrorMemory,
+	SeaCoreErrorArgument
+} SeaCoreError;
+
+/*!
+	@enum		SeaCoreInterpolation
+	@discussion	The interpolation used when scaling, which has the same values
+				as GimpInterpolationType.
+	@constant	SeaCoreInterpolationNone
+				Specifies no interpolation.
+	@constant	SeaCoreInterpolationLinear
+				Specifies linear interpolation.
+	@constant	SeaCoreInterpolationCubic
+				Specifies cubic interpolation.
+*/
+typedef enum {
+	SeaCoreInterpolationNone,
+	SeaCoreInterpolationLinear,
+	SeaCoreInterpolationCubic
+} SeaCoreInterpolation;
+
+/*!
+	@typedef	SeaCoreBitmap
+	@discussion	A bitmap in the form Seashore keeps layers in, with rows from
+				top to bottom, samples interleaved, the alpha sample last and
+				the colour samples not premultiplied.
+	@field		width
+				The width of the bitmap.
+	@field		height
+				The height of the bitmap.
+	@field		spp
+				The samples per pixel of the bitmap, 2 for grey and alpha, 4
+				for RGB and alpha or 1 for a mask.
+	@field		data
+				The samples of the bitmap, owned by the bitmap.
+*/
+typedef struct {
+	int width;
+	int height;
+	int spp;
+	unsigned char *data;
+} SeaCoreBitmap;
+
+/*!
+	@typedef	SeaCoreLayer
+	@discussion	A layer of a document. Layers in groups follow the group they
+				are in, so the stack reads the same way as the layers palette.
+	@field		name
+				The name of the layer, owned by the layer.
+	@field		x
+				The x co-ordinate of the layer's origin in the document.
+	@field		y
+				The y co-ordinate of the layer's origin in the document.
+	@field		opacity
+				The opacity of the layer (from 0 to 255).
+	@field		mode
+				How the layer is merged, one of XcfLayerMode.
+	@field		visible
+				Whether the layer is visible.
+	@field		group
+				Whether the layer is a group, in which case its bitmap is
+				empty and it is made from the layers that follow it with a
+				greater depth.
+	@field		depth
+				The number of groups the layer is in.
+	@field		bitmap
+				The pixels of the layer, with the same samples per pixel as the
+				document.
+	@field		mask
+				The mask applied to the alpha of the layer, covering the same
+				area as the layer, or an empty bitmap if there is none. The
+				mask of a group covers the group's area in the same way.
+*/
+typedef struct {
+	char *name;
+	int x;
+	int y;
+	int opacity;
+	int mode;
+	bool visible;
+	bool group;
+	int depth;
+	SeaCoreBitmap bitmap;
+	SeaCoreBitmap mask;
+} SeaCoreLayer;
+
+/*!
+	@typedef	SeaCoreDocumentRef
+	@discussion	A document, a stack of layers over a canvas of a given size.
+*/
+typedef struct SeaCoreDocument *SeaCoreDocumentRef;
+
+/*!
+	@function	SeaCoreErrorDescription
+	@discussion	Describes an error.
+	@param		error
+				The error to describe.
+	@result		Returns a short description of the error in English.
+*/
+const char *SeaCoreErrorDescription(SeaCoreError error);
+
+/*!
+	@function	SeaCoreBitmapCreate
+	@discussion	Creates a transparent bitmap.
+	@param		bitmap
+				The bitmap to fill in, which is emptied on failure.
+	@param		width
+				The width of the bitmap.
+	@param		height
+				The height of the bitmap.
+	@param		spp
+				The samples per pixel of the bitmap (1, 2 or 4).
+	@result		Returns SeaCoreErrorNone upon success.
+*/
+SeaCoreError SeaCoreBitmapCreate(SeaCoreBitmap *bitmap, int width, int height, int spp);
+
+/*!
+	@function	SeaCoreBitmapFree
+	@discussion	Frees the samples of a bitmap and empties it.
+	@param		bitmap
+				The bitmap to free.
+*/
+void SeaCoreBitmapFree(SeaCoreBitmap *bitmap);
+
+/*!
+	@function	SeaCoreBitmapIsOpaque
+	@discussion	Determines whether every pixel of a bitmap is opaque.
+	@param		bitmap
+				The bitmap to test.
+	@result		Returns true if the bitmap is opaque or is a mask, false
+				otherwise.
+*/
+bool SeaCoreBitmapIsOpaque(const SeaCoreBitmap *bitmap);
+
+/*!
+	@function	SeaCoreBitmapScale
+	@discussion	Scales a bitmap in the same way Seashore scales a layer (see
+				GCScalePixels).
+	@param		result
+				The bitmap to fill in with the scaled pixels, which is emptied
+				on failure.
+	@param		bitmap
+				The bitmap to scale.
+	@param		width
+				The width to scale to.
+	@param		height
+				The height to scale to.
+	@param		interpolation
+				The interpolation to use.
+	@result		Returns SeaCoreErrorNone upon success.
+*/
+SeaCoreError SeaCoreBitmapScale(SeaCoreBitmap *result, const SeaCoreBitmap *bitmap, int width, int height, SeaCoreInterpolation interpolation);
+
+/*!
+	@function	SeaCoreBitmapWritePNG
+	@discussion	Writes a bitmap to a PNG file. The alpha channel is left out
+				if the bitmap is opaque.
+	@param		bitmap
+				The bitmap to write, with 2 or 4 samples per pixel.
+	@param		path
+				The path of the file to write.
+	@result		Returns SeaCoreErrorNone upon success.
+*/
+SeaCoreError SeaCoreBitmapWritePNG(const SeaCoreBitmap *bitmap, const char *path);
+
+/*!
+	@function	SeaCoreBitmapWriteTIFF
+	@discussion	Writes a bitmap to a TIFF file with LZW compression, as
+				Seashore's TIFF exporter does. The alpha channel is left out
+				if the bitmap is opaque.
+	@param		bitmap
+				The bitmap to write, with 2 or 4 samples per pixel.
+	@param		path
+				The path of the file to write.
+	@result		Returns SeaCoreErrorNone upon success.
+*/
+SeaCoreError SeaCoreBitmapWriteTIFF(const SeaCoreBitmap *bitmap, const char *path);
+
+/*!
+	@function	SeaCoreCompositeLayer
+	@discussion	Composites a layer on to a bitmap covering the document in the
+				same way Seashore's compositor does, using the layer's opacity,
+				mode and mask. The layer's visibility is ignored, as is whether
+				it is a group.
+	@param		canvas
+				The bitmap covering the document.
+	@param		layer
+				The layer to composite, with the same samples per pixel as the
+				canvas.
+	@result		Returns SeaCoreErrorNone upon success.
+*/
+SeaCoreError SeaCoreCompositeLayer(SeaCoreBitmap *canvas, const SeaCoreLayer *layer);
+
+/*!
+	@function	SeaCoreDocumentCreate
+	@discussion	Creates a document with no layers.
+	@param		width
+				The width of the document.
+	@param		height
+				The height of the document.
+	@param		spp
+				The samples per pixel of the document, 2 for greyscale or 4
+				for colour.
+	@result		Returns the new document or NULL upon failure.
+*/
+SeaCoreDocumentRef SeaCoreDocumentCreate(int width, int height, int spp);
+
+/*!
+	@function	SeaCoreDocumentCreateWithXCF
+	@discussion	Loads a document from an XCF file. Files from any version of
+				the GIMP are read as long as their samples are integers, with
+				indexed documents becoming colour documents and samples with
+				more than 8 bits being reduced to 8 bits. Layer modes added
+				after the GIMP 2.8 are replaced by their nearest equivalent in
+				XcfLayerMode, or the normal mode if there is none.
+	@param		path
+				The path of the file to load.
+	@param		error
+				Set to the reason for failure, may be NULL.
+	@result		Returns the new document or NULL upon failure.
+*/
+SeaCoreDocumentRef SeaCoreDocumentCreateWithXCF(const char *path, SeaCoreError *error);
+
+/*!
+	@function	SeaCoreDocumentCreateWithXCFData
+	@discussion	Loads a document from XCF data in memory, in the same way as
+				SeaCoreDocumentCreateWithXCF.
+	@param		bytes
+				The XCF data.
+	@param		length
+				The length of the XCF data.
+	@param		error
+				Set to the reason for failure, may be NULL.
+	@result		Returns the new document or NULL upon failure.
+*/
+SeaCoreDocumentRef SeaCoreDocumentCreateWithXCFData(const void *bytes, size_t length, SeaCoreError *error);
+
+/*!
+	@function	SeaCoreDocumentRelease
+	@discussion	Frees a document and all of its layers.
+	@param		document
+				The document to free, may be NULL.
+*/
+void SeaCoreDocumentRelease(SeaCoreDocumentRef document);
+
+/*!
+	@function	SeaCoreDocumentGetWidth
+	@param		document
+				The document.
+	@result		Returns the width of the document.
+*/
+int SeaCoreDocumentGetWidth(SeaCoreDocumentRef document);
+
+/*!
+	@function	SeaCoreDocumentGetHeight
+	@param		document
+				The document.
+	@result		Returns the height of the document.
+*/
+int SeaCoreDocumentGetHeight(SeaCoreDocumentRef document);
+
+/*!
+	@function	SeaCoreDocumentGetSpp
+	@param		document
+				The document.
+	@result		Returns the samples per pixel of the document's layers.
+*/
+int SeaCoreDocumentGetSpp(SeaCoreDocumentRef document);
+
+/*!
+	@function	SeaCoreDocumentGetLayerCount
+	@param		document
+				The document.
+	@result		Returns the number of layers in the document, including
+				groups.
+*/
+int SeaCoreDocumentGetLayerCount(SeaCoreDocumentRef document);
+
+/*!
+	@function	SeaCoreDocumentGetLayer
+	@discussion	Returns a layer of the document, which may be changed in place
+				as long as its bitmap keeps the document's samples per pixel.
+	@param		document
+				The document.
+	@param		index
+				The index of the layer, 0 being the top of the stack.
+	@result		Returns the layer or NULL if the index is out of range.
+*/
+SeaCoreLayer *SeaCoreDocumentGetLayer(SeaCoreDocumentRef document, int index);
+
+/*!
+	@function	SeaCoreDocumentAddLayer
+	@discussion	Adds a transparent, visible and opaque layer in the normal mode
+				to the top of the stack, outside any group.
+	@param		document
+				The document.
+	@param		name
+				The name of the layer.
+	@param		x
+				The x co-ordinate of the layer's origin in the document.
+	@param		y
+				The y co-ordinate of the layer's origin in the document.
+	@param		width
+				The width of the layer.
+	@param		height
+				The height of the layer.
+	@result		Returns the new layer or NULL upon failure.
+*/
+SeaCoreLayer *SeaCoreDocumentAddLayer(SeaCoreDocumentRef document, const char *name, int x, int y, int width, int height);
+
+/*!
+	@function	SeaCoreDocumentFlatten
+	@discussion	Composites the visible layers of a document from the bottom of
+				the stack up on to a transparent canvas, each group being
+				composited on its own canvas first.
+	@param		document
+				The document.
+	@param		result
+				The bitmap to fill in, which covers the document and is emptied
+				on failure.
+	@result		Returns SeaCoreErrorNone upon success.
+*/
+SeaCoreError SeaCoreDocumentFlatten(SeaCoreDocumentRef document, SeaCoreBitmap *result);
+
+/*!
+	@function	SeaCoreDocumentWriteXCF
+	@discussion	Writes a document to an XCF file with RLE compression, which
+				is readable by the GIMP 2.8 and later and, if it has no groups,
+				by Seashore and any earlier version of the GIMP.
+	@param		document
+				The document.
+	@param		path
+				The path of the file to write.
+	@result		Returns SeaCoreErrorNone upon success.
+*/
+SeaCoreError SeaCoreDocumentWriteXCF(SeaCoreDocumentRef document, const char *path);
+
+/*!
+	@function	SeaCoreRenderXCF
+	@discussion	Loads and flattens an XCF file in one pass, holding no more
+				than one layer in memory at a time besides the canvas of each
+				group being composited. The result is the same as loading the
+				document and flattening it.
+	@param		path
+				The path of the file to render.
+	@param		result
+				The bitmap to fill in, which is emptied on failure.
+	@result		Returns SeaCoreErrorNone upon success.
+*/
+SeaCoreError SeaCoreRenderXCF(const char *path, SeaCoreBitmap *result);
+
+/*!
+	@function	SeaCoreRenderXCFMemory
+	@discussion	Estimates the most memory SeaCoreRenderXCF will allocate for a
+				file, reading only the headers of the file.
+	@param		path
+				The path of the file to render.
+	@param		bytes
+				Set to the number of bytes.
+	@result		Returns SeaCoreErrorNone upon success.
+*/
+SeaCoreError SeaCoreRenderXCFMemory(const char *path, size_t *bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SEACORE_H */
@@ -0,0 +1,370 @@
+/*
+	seashore-render flattens XCF files to PNG or TIFF using SeaCore.
+
+	Files are rendered by a pool of worker threads. Before a file is started
+	its peak memory is estimated from its headers and the file waits, in the
+	order given, until that much of the memory budget is free. A file larger
+	than the whole budget is still rendered but only once nothing else is.
+*/
+
+#include <SeaCore.h>
+#include <errno.h>
+#include <getopt.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+// The largest side SeaCore accepts, as for Seashore's kMaxImageSize
+#define kMaxOutputSize 8192
+
+typedef enum {
+	kFormatPNG,
+	kFormatTIFF
+} OutputFormat;
+
+typedef struct {
+	// The options
+	const char *outputDirectory;
+	OutputFormat format;
+	int width, height;
+	SeaCoreInterpolation interpolation;
+	size_t budget;
+	bool quiet;
+
+	// The files
+	char **paths;
+	int count;
+
+	// The shared state, guarded by lock
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+	int next, admitted, inFlight, failures;
+	size_t used;
+} Renderer;
+
+static void usage(FILE *stream)
+{
+	fprintf(stream,
+		"usage: seashore-render [options] [file.xcf ...]\n"
+		"Flattens each XCF file, reading the paths from standard input when none are given.\n"
+		"  -o directory  write the results here rather than beside each file\n"
+		"  -f format     png (the default) or tiff\n"
+		"  -j jobs       the number of files to render at once (default: processors)\n"
+		"  -m megabytes  the memory to share between the jobs (default: half the RAM)\n"
+		"  -w width      scale the result to this width\n"
+		"  -h height     scale the result to this height\n"
+		"  -i method     interpolation for scaling: none, linear or cubic (default)\n"
+		"  -q            only report failures\n");
+}
+
+// Returns the path of the result for a file
+static char *outputPath(Renderer *renderer, const char *path)
+{
+	const char *slash = strrchr(path, '/'), *name = slash ? slash + 1 : path, *dot;
+	const char *extension = (renderer->format == kFormatTIFF) ? ".tiff" : ".png";
+	int directoryLength, nameLength;
+	char *result;
+
+	dot = strrchr(name, '.');
+	nameLength = dot && dot != name ? (int)(dot - name) : (int)strlen(name);
+	if (renderer->outputDirectory) {
+		path = renderer->outputDirectory;
+		directoryLength = (int)strlen(path);
+	}
+	else {
+		directoryLength = (int)(name - path);
+	}
+	result = malloc(directoryLength + nameLength + strlen(extension) + 2);
+	if (!result)
+		return NULL;
+	if (renderer->outputDirectory && directoryLength > 0 && path[directoryLength - 1] != '/')
+		sprintf(result, "%.*s/%.*s%s", directoryLength, path, nameLength, name, extension);
+	else
+		sprintf(result, "%.*s%.*s%s", directoryLength, path, nameLength, name, extension);
+
+	return result;
+}
+
+// Works out the size of the result, keeping the aspect ratio when only one side is given
+static void outputSize(Renderer *renderer, int width, int height, int *outWidth, int *outHeight)
+{
+	*outWidth = width;
+	*outHeight = height;
+	if (renderer->width > 0 && renderer->height > 0) {
+		*outWidth = renderer->width;
+		*outHeight = renderer->height;
+	}
+	else if (renderer->width > 0) {
+		*outWidth = renderer->width;
+		*outHeight = (int)MAX(1, (long long)height * renderer->width / width);
+	}
+	else if (renderer->height > 0) {
+		*outHeight = renderer->height;
+		*outWidth = (int)MAX(1, (long long)width * renderer->height / height);
+	}
+}
+
+static SeaCoreError renderFile(Renderer *renderer, const char *path, const char *output)
+{
+	SeaCoreBitmap bitmap, scaled;
+	SeaCoreError error;
+	int width, height;
+
+	if ((error = SeaCoreRenderXCF(path, &bitmap)))
+		return error;
+	outputSize(renderer, bitmap.width, bitmap.height, &width, &height);
+	if (width != bitmap.width || height != bitmap.height) {
+		error = SeaCoreBitmapScale(&scaled, &bitmap, width, height, renderer->interpolation);
+		SeaCoreBitmapFree(&bitmap);
+		if (error)
+			return error;
+		bitmap = scaled;
+	}
+	if (renderer->format == kFormatTIFF)
+		error = SeaCoreBitmapWriteTIFF(&bitmap, output);
+	else
+		error = SeaCoreBitmapWritePNG(&bitmap, output);
+	SeaCoreBitmapFree(&bitmap);
+
+	return error;
+}
+
+// Estimates the memory needed for a file, including scaling and export
+static size_t estimateFile(Renderer *renderer, const char *path)
+{
+	size_t bytes = 0;
+	int width = renderer->width, height = renderer->height;
+
+	if (SeaCoreRenderXCFMemory(path, &bytes))
+		return 0;
+
+	// Scaling holds a second bitmap and export may strip the alpha into a third
+	if (width > 0 || height > 0) {
+		if (width <= 0 || height <= 0)
+			return bytes * 2;
+		bytes += (size_t)width * height * 4;
+	}
+
+	return bytes + bytes / 4;
+}
+
+static void *worker(void *context)
+{
+	Renderer *renderer = context;
+	SeaCoreError error;
+	size_t estimate;
+	char *output;
+	int index;
+
+	for (;;) {
+		pthread_mutex_lock(&renderer->lock);
+		index = renderer->next++;
+		pthread_mutex_unlock(&renderer->lock);
+		if (index >= renderer->count)
+			break;
+
+		// Wait for our turn and for enough memory to be free
+		estimate = estimateFile(renderer, renderer->paths[index]);
+		pthread_mutex_lock(&renderer->lock);
+		while (renderer->admitted != index || (renderer->inFlight > 0 && renderer->used + estimate > renderer->budget))
+			pthread_cond_wait(&renderer->changed, &renderer->lock);
+		renderer->admitted++;
+		renderer->inFlight++;
+		renderer->used += estimate;
+		pthread_cond_broadcast(&renderer->changed);
+		pthread_mutex_unlock(&renderer->lock);
+
+		output = outputPath(renderer, renderer->paths[index]);
+		error = output ? renderFile(renderer, renderer->paths[index], output) : SeaCoreErrorMemory;
+
+		pthread_mutex_lock(&renderer->lock);
+		renderer->inFlight--;
+		renderer->used -= estimate;
+		if (error) {
+			renderer->failures++;
+			fprintf(stderr, "seashore-render: %s: %s\n", renderer->paths[index], SeaCoreErrorDescription(error));
+		}
+		else if (!renderer->quiet) {
+			printf("%s -> %s\n", renderer->paths[index], output);
+		}
+		pthread_cond_broadcast(&renderer->changed);
+		pthread_mutex_unlock(&renderer->lock);
+		free(output);
+	}
+
+	return NULL;
+}
+
+// Reads one path per line from standard input
+static char **readPaths(int *count)
+{
+	char **paths = NULL, **grown, *line = NULL;
+	size_t capacity = 0, size = 0;
+	ssize_t length;
+
+	*count = 0;
+	while ((length = getline(&line, &size, stdin)) >= 0) {
+		while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+			line[--length] = 0;
+		if (length == 0)
+			continue;
+		if ((size_t)*count == capacity) {
+			capacity = MAX(capacity * 2, 64);
+			grown = realloc(paths, capacity * sizeof(char *));
+			if (!grown)
+				break;
+			paths = grown;
+		}
+		paths[*count] = strdup(line);
+		if (!paths[*count])
+			break;
+		(*count)++;
+	}
+	free(line);
+
+	return paths;
+}
+
+static bool parseInt(const char *string, long minimum, long maximum, long *value)
+{
+	char *end;
+
+	errno = 0;
+	*value = strtol(string, &end, 10);
+
+	return errno == 0 && end != string && *end == 0 && *value >= minimum && *value <= maximum;
+}
+
+int main(int argc, char *argv[])
+{
+	Renderer renderer;
+	pthread_t *threads;
+	long value, jobs, pages, pageSize;
+	bool fromInput;
+	int option, i, started;
+
+	memset(&renderer, 0, sizeof(Renderer));
+	renderer.interpolation = SeaCoreInterpolationCubic;
+	jobs = MAX(sysconf(_SC_NPROCESSORS_ONLN), 1);
+	pages = sysconf(_SC_PHYS_PAGES);
+	pageSize = sysconf(_SC_PAGESIZE);
+	renderer.budget = (pages > 0 && pageSize > 0) ? (size_t)pages * pageSize / 2 : (size_t)1 << 30;
+
+	while ((option = getopt(argc, argv, "o:f:j:m:w:h:i:q")) != -1) {
+		switch (option) {
+			case 'o':
+				renderer.outputDirectory = optarg;
+			break;
+			case 'f':
+				if (strcasecmp(optarg, "png") == 0) {
+					renderer.format = kFormatPNG;
+				}
+				else if (strcasecmp(optarg, "tiff") == 0 || strcasecmp(optarg, "tif") == 0) {
+					renderer.format = kFormatTIFF;
+				}
+				else {
+					usage(stderr);
+					return 2;
+				}
+			break;
+			case 'j':
+				if (!parseInt(optarg, 1, 1024, &jobs)) {
+					usage(stderr);
+					return 2;
+				}
+			break;
+			case 'm':
+				if (!parseInt(optarg, 1, LONG_MAX >> 20, &value)) {
+					usage(stderr);
+					return 2;
+				}
+				renderer.budget = (size_t)value << 20;
+			break;
+			case 'w':
+			case 'h':
+				if (!parseInt(optarg, 1, kMaxOutputSize, &value)) {
+					usage(stderr);
+					return 2;
+				}
+				if (option == 'w')
+					renderer.width = (int)value;
+				else
+					renderer.height = (int)value;
+			break;
+			case 'i':
+				if (strcasecmp(optarg, "none") == 0) {
+					renderer.interpolation = SeaCoreInterpolationNone;
+				}
+				else if (strcasecmp(optarg, "linear") == 0) {
+					renderer.interpolation = SeaCoreInterpolationLinear;
+				}
+				else if (strcasecmp(optarg, "cubic") == 0) {
+					renderer.interpolation = SeaCoreInterpolationCubic;
+				}
+				else {
+					usage(stderr);
+					return 2;
+				}
+			break;
+			case 'q':
+				renderer.quiet = true;
+			break;
+			default:
+				usage(stderr);
+				return 2;
+		}
+	}
+
+	fromInput = (optind == argc);
+	if (fromInput) {
+		renderer.paths = readPaths(&renderer.count);
+	}
+	else {
+		renderer.paths = argv + optind;
+		renderer.count = argc - optind;
+	}
+	if (renderer.count == 0) {
+		usage(stderr);
+		return 2;
+	}
+
+	// The workers share the processors with the kernels they call, which are already parallel
+	jobs = MIN(jobs, renderer.count);
+	threads = malloc(jobs * sizeof(pthread_t));
+	if (!threads) {
+		fprintf(stderr, "seashore-render: %s\n", SeaCoreErrorDescription(SeaCoreErrorMemory));
+		return 1;
+	}
+	pthread_mutex_init(&renderer.lock, NULL);
+	pthread_cond_init(&renderer.changed, NULL);
+	for (started = 0; started < jobs; started++) {
+		if (pthread_create(&threads[started], NULL, worker, &renderer) != 0)
+			break;
+	}
+	if (started == 0)
+		worker(&renderer);
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+	pthread_cond_destroy(&renderer.changed);
+	pthread_mutex_destroy(&renderer.lock);
+	free(threads);
+
+	if (fromInput) {
+		for (i = 0; i < renderer.count; i++)
+			free(renderer.paths[i]);
+		free(renderer.paths);
+	}
+
+	return renderer.failures ? 1 : 0;
+}
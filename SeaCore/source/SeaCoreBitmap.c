@@ -0,0 +1,76 @@
+#include "SeaCorePrivate.h"
+
+const char *SeaCoreErrorDescription(SeaCoreError error)
+{
+	switch (error) {
+		case SeaCoreErrorNone:
+			return "no error";
+		case SeaCoreErrorFile:
+			return "the file could not be read or written";
+		case SeaCoreErrorFormat:
+			return "the file is damaged or of the wrong format";
+		case SeaCoreErrorUnsupported:
+			return "the file uses an unsupported feature";
+		case SeaCoreErrorMemory:
+			return "out of memory";
+		case SeaCoreErrorArgument:
+			return "an argument is out of range";
+	}
+
+	return "unknown error";
+}
+
+SeaCoreError SeaCoreBitmapCreate(SeaCoreBitmap *bitmap, int width, int height, int spp)
+{
+	memset(bitmap, 0, sizeof(SeaCoreBitmap));
+	if (width < 0 || height < 0 || (spp != 1 && spp != 2 && spp != 4))
+		return SeaCoreErrorArgument;
+	if (width > kMaxImageSize || height > kMaxImageSize)
+		return SeaCoreErrorUnsupported;
+
+	// An empty bitmap still has samples so it can be written out
+	bitmap->data = calloc(MAX((size_t)width * height * spp, 1), 1);
+	if (!bitmap->data)
+		return SeaCoreErrorMemory;
+	bitmap->width = width;
+	bitmap->height = height;
+	bitmap->spp = spp;
+
+	return SeaCoreErrorNone;
+}
+
+void SeaCoreBitmapFree(SeaCoreBitmap *bitmap)
+{
+	free(bitmap->data);
+	memset(bitmap, 0, sizeof(SeaCoreBitmap));
+}
+
+bool SeaCoreBitmapIsOpaque(const SeaCoreBitmap *bitmap)
+{
+	size_t i, count = (size_t)bitmap->width * bitmap->height;
+	int spp = bitmap->spp;
+
+	if (spp == 1)
+		return true;
+	for (i = 0; i < count; i++) {
+		if (bitmap->data[i * spp + spp - 1] != 255)
+			return false;
+	}
+
+	return true;
+}
+
+SeaCoreError SeaCoreBitmapScale(SeaCoreBitmap *result, const SeaCoreBitmap *bitmap, int width, int height, SeaCoreInterpolation interpolation)
+{
+	SeaCoreError error;
+
+	if (width <= 0 || height <= 0 || bitmap->width <= 0 || bitmap->height <= 0 || interpolation < SeaCoreInterpolationNone || interpolation > SeaCoreInterpolationCubic) {
+		memset(result, 0, sizeof(SeaCoreBitmap));
+		return SeaCoreErrorArgument;
+	}
+	if ((error = SeaCoreBitmapCreate(result, width, height, bitmap->spp)))
+		return error;
+	GCScalePixels(result->data, width, height, bitmap->data, bitmap->width, bitmap->height, (GimpInterpolationType)interpolation, bitmap->spp);
+
+	return SeaCoreErrorNone;
+}
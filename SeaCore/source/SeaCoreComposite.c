@@ -0,0 +1,207 @@
+#include "SeaCorePrivate.h"
+
+typedef struct {
+	SeaCoreBitmap *canvas;
+	const SeaCoreLayer *layer;
+	int startX, endX, startY;
+} CompositeContext;
+
+// Composites one row of a layer in the same way as SeaCompositor
+static void compositeRow(void *context, size_t row)
+{
+	CompositeContext *ctx = context;
+	const SeaCoreLayer *layer = ctx->layer;
+	int spp = ctx->canvas->spp, lwidth = layer->bitmap.width, xoff = layer->x, yoff = layer->y;
+	int j = ctx->startY + (int)row, srcLoc, destLoc, t1;
+	unsigned char *srcPtr = layer->bitmap.data, *destPtr = ctx->canvas->data, *mask = layer->mask.data;
+	unsigned char tempSpace[4], tempSpace2[4];
+
+	for (int i = ctx->startX; i < ctx->endX; i++) {
+		srcLoc = (j * lwidth + i) * spp;
+		destLoc = ((j + yoff) * ctx->canvas->width + (i + xoff)) * spp;
+		for (int k = 0; k < spp; k++)
+			tempSpace2[k] = srcPtr[srcLoc + k];
+		if (mask)
+			tempSpace2[spp - 1] = int_mult(tempSpace2[spp - 1], mask[j * lwidth + i], t1);
+		if (layer->mode != XCF_NORMAL_MODE) {
+			for (int k = 0; k < spp; k++)
+				tempSpace[k] = destPtr[destLoc + k];
+			SeaSelectMerge(layer->mode, spp, tempSpace, 0, tempSpace2, 0, i + xoff, j + yoff);
+			SeaNormalMerge(spp, destPtr, destLoc, tempSpace, 0, layer->opacity);
+		}
+		else {
+			SeaNormalMerge(spp, destPtr, destLoc, tempSpace2, 0, layer->opacity);
+		}
+	}
+}
+
+SeaCoreError SeaCoreCompositeLayer(SeaCoreBitmap *canvas, const SeaCoreLayer *layer)
+{
+	CompositeContext ctx;
+	int endY;
+
+	if (layer->bitmap.spp != canvas->spp || (canvas->spp != 2 && canvas->spp != 4))
+		return SeaCoreErrorArgument;
+	if (layer->mask.data && (layer->mask.width != layer->bitmap.width || layer->mask.height != layer->bitmap.height || layer->mask.spp != 1))
+		return SeaCoreErrorArgument;
+
+	// If the layer has an opacity of zero it does not need to be composited
+	if (layer->opacity <= 0 || !layer->bitmap.data)
+		return SeaCoreErrorNone;
+
+	// Determine what is being copied
+	ctx.canvas = canvas;
+	ctx.layer = layer;
+	ctx.startX = MAX(-layer->x, 0);
+	ctx.startY = MAX(-layer->y, 0);
+	ctx.endX = MIN(canvas->width - layer->x, layer->bitmap.width);
+	endY = MIN(canvas->height - layer->y, layer->bitmap.height);
+	if (ctx.endX - ctx.startX <= 0 || endY - ctx.startY <= 0)
+		return SeaCoreErrorNone;
+
+	// Rows are independent, dissolving depends only on the position
+	dispatch_apply_f(endY - ctx.startY, dispatch_get_global_queue(0, 0), &ctx, compositeRow);
+
+	return SeaCoreErrorNone;
+}
+
+SeaCoreError SeaCoreFlattenerBegin(SeaCoreFlattener *flattener, int width, int height, int spp)
+{
+	memset(flattener, 0, sizeof(SeaCoreFlattener));
+	flattener->width = width;
+	flattener->height = height;
+	flattener->spp = spp;
+
+	return SeaCoreBitmapCreate(&flattener->canvases[0], width, height, spp);
+}
+
+// Multiplies the alpha of a group's canvas by the group's mask
+static void maskCanvas(SeaCoreBitmap *canvas, const SeaCoreLayer *group)
+{
+	int spp = canvas->spp, startX, startY, endX, endY, t1;
+	unsigned char *pixel;
+
+	startX = MAX(-group->x, 0);
+	startY = MAX(-group->y, 0);
+	endX = MIN(canvas->width - group->x, group->mask.width);
+	endY = MIN(canvas->height - group->y, group->mask.height);
+	for (int j = startY; j < endY; j++) {
+		pixel = canvas->data + ((j + group->y) * canvas->width + startX + group->x) * spp;
+		for (int i = startX; i < endX; i++, pixel += spp)
+			pixel[spp - 1] = int_mult(pixel[spp - 1], group->mask.data[j * group->mask.width + i], t1);
+	}
+}
+
+// Finishes the innermost group, compositing it with the given properties
+static SeaCoreError leaveGroup(SeaCoreFlattener *flattener, const SeaCoreLayer *group)
+{
+	SeaCoreBitmap *canvas = &flattener->canvases[flattener->level];
+	SeaCoreLayer merged;
+	SeaCoreError error = SeaCoreErrorNone;
+
+	if (group->visible) {
+		if (group->mask.data)
+			maskCanvas(canvas, group);
+		memset(&merged, 0, sizeof(SeaCoreLayer));
+		merged.opacity = group->opacity;
+		merged.mode = group->mode;
+		merged.bitmap = *canvas;
+		error = SeaCoreCompositeLayer(&flattener->canvases[flattener->level - 1], &merged);
+	}
+	SeaCoreBitmapFree(canvas);
+	flattener->level--;
+
+	return error;
+}
+
+SeaCoreError SeaCoreFlattenerAdd(SeaCoreFlattener *flattener, const SeaCoreLayer *layer)
+{
+	SeaCoreLayer ungrouped;
+	SeaCoreError error;
+	int depth = MAX(layer->depth, 0);
+
+	if (depth > kMaxGroupDepth)
+		return SeaCoreErrorUnsupported;
+
+	// Enter the groups the layer is in, the groups themselves come after their layers
+	while (flattener->level < depth) {
+		flattener->level++;
+		error = SeaCoreBitmapCreate(&flattener->canvases[flattener->level], flattener->width, flattener->height, flattener->spp);
+		if (error)
+			return error;
+	}
+
+	// A stack that is out of order leaves groups as if they were normal groups
+	memset(&ungrouped, 0, sizeof(SeaCoreLayer));
+	ungrouped.opacity = 255;
+	ungrouped.visible = true;
+	while (flattener->level > depth + (layer->group ? 1 : 0)) {
+		if ((error = leaveGroup(flattener, &ungrouped)))
+			return error;
+	}
+
+	if (layer->group) {
+		if (flattener->level == depth + 1)
+			return leaveGroup(flattener, layer);
+		return SeaCoreErrorNone;
+	}
+
+	if (!layer->visible)
+		return SeaCoreErrorNone;
+
+	return SeaCoreCompositeLayer(&flattener->canvases[flattener->level], layer);
+}
+
+void SeaCoreFlattenerFinish(SeaCoreFlattener *flattener, SeaCoreBitmap *result)
+{
+	SeaCoreLayer ungrouped;
+
+	memset(&ungrouped, 0, sizeof(SeaCoreLayer));
+	ungrouped.opacity = 255;
+	ungrouped.visible = true;
+	while (flattener->level > 0) {
+		if (result)
+			leaveGroup(flattener, &ungrouped);
+		else
+			SeaCoreBitmapFree(&flattener->canvases[flattener->level--]);
+	}
+
+	if (result)
+		*result = flattener->canvases[0];
+	else
+		SeaCoreBitmapFree(&flattener->canvases[0]);
+}
+
+SeaCoreError SeaCoreDocumentFlatten(SeaCoreDocumentRef document, SeaCoreBitmap *result)
+{
+	SeaCoreFlattener flattener;
+	SeaCoreLayer layer;
+	SeaCoreError error;
+	bool hidden[kMaxGroupDepth + 1] = { false };
+	bool *shown;
+	int i, depth;
+
+	memset(result, 0, sizeof(SeaCoreBitmap));
+	shown = malloc(MAX(document->layerCount, 1) * sizeof(bool));
+	if (!shown)
+		return SeaCoreErrorMemory;
+
+	// Layers in hidden groups need not be composited at all
+	for (i = 0; i < document->layerCount; i++) {
+		depth = MIN(MAX(document->layers[i].depth, 0), kMaxGroupDepth);
+		shown[i] = document->layers[i].visible && !(depth > 0 && hidden[depth - 1]);
+		if (document->layers[i].group)
+			hidden[depth] = !shown[i];
+	}
+
+	error = SeaCoreFlattenerBegin(&flattener, document->width, document->height, document->spp);
+	for (i = document->layerCount - 1; i >= 0 && !error; i--) {
+		layer = document->layers[i];
+		layer.visible = shown[i];
+		error = SeaCoreFlattenerAdd(&flattener, &layer);
+	}
+	SeaCoreFlattenerFinish(&flattener, error ? NULL : result);
+	free(shown);
+
+	return error;
+}
@@ -0,0 +1,116 @@
+#include "SeaCorePrivate.h"
+
+SeaCoreDocumentRef SeaCoreDocumentCreate(int width, int height, int spp)
+{
+	SeaCoreDocumentRef document;
+
+	if (width <= 0 || height <= 0 || width > kMaxImageSize || height > kMaxImageSize || (spp != 2 && spp != 4))
+		return NULL;
+	document = calloc(1, sizeof(struct SeaCoreDocument));
+	if (!document)
+		return NULL;
+	document->width = width;
+	document->height = height;
+	document->spp = spp;
+
+	return document;
+}
+
+void SeaCoreLayerFree(SeaCoreLayer *layer)
+{
+	free(layer->name);
+	SeaCoreBitmapFree(&layer->bitmap);
+	SeaCoreBitmapFree(&layer->mask);
+	memset(layer, 0, sizeof(SeaCoreLayer));
+}
+
+void SeaCoreDocumentRelease(SeaCoreDocumentRef document)
+{
+	if (!document)
+		return;
+	for (int i = 0; i < document->layerCount; i++)
+		SeaCoreLayerFree(&document->layers[i]);
+	free(document->layers);
+	free(document);
+}
+
+int SeaCoreDocumentGetWidth(SeaCoreDocumentRef document)
+{
+	return document->width;
+}
+
+int SeaCoreDocumentGetHeight(SeaCoreDocumentRef document)
+{
+	return document->height;
+}
+
+int SeaCoreDocumentGetSpp(SeaCoreDocumentRef document)
+{
+	return document->spp;
+}
+
+int SeaCoreDocumentGetLayerCount(SeaCoreDocumentRef document)
+{
+	return document->layerCount;
+}
+
+SeaCoreLayer *SeaCoreDocumentGetLayer(SeaCoreDocumentRef document, int index)
+{
+	if (index < 0 || index >= document->layerCount)
+		return NULL;
+
+	return &document->layers[index];
+}
+
+// Makes room for one more layer
+static SeaCoreError growLayers(SeaCoreDocumentRef document)
+{
+	SeaCoreLayer *layers;
+	int capacity;
+
+	if (document->layerCount < document->layerCapacity)
+		return SeaCoreErrorNone;
+	capacity = MAX(document->layerCapacity * 2, 8);
+	layers = realloc(document->layers, capacity * sizeof(SeaCoreLayer));
+	if (!layers)
+		return SeaCoreErrorMemory;
+	document->layers = layers;
+	document->layerCapacity = capacity;
+
+	return SeaCoreErrorNone;
+}
+
+SeaCoreError SeaCoreDocumentAppendLayer(SeaCoreDocumentRef document, const SeaCoreLayer *layer)
+{
+	SeaCoreError error;
+
+	if ((error = growLayers(document)))
+		return error;
+	document->layers[document->layerCount++] = *layer;
+
+	return SeaCoreErrorNone;
+}
+
+SeaCoreLayer *SeaCoreDocumentAddLayer(SeaCoreDocumentRef document, const char *name, int x, int y, int width, int height)
+{
+	SeaCoreLayer layer;
+
+	memset(&layer, 0, sizeof(SeaCoreLayer));
+	layer.name = strdup(name ? name : "");
+	layer.x = x;
+	layer.y = y;
+	layer.opacity = 255;
+	layer.mode = XCF_NORMAL_MODE;
+	layer.visible = true;
+	if (!layer.name || SeaCoreBitmapCreate(&layer.bitmap, width, height, document->spp) || growLayers(document)) {
+		SeaCoreLayerFree(&layer);
+		return NULL;
+	}
+
+	// The new layer goes on top
+	memmove(&document->layers[1], &document->layers[0], document->layerCount * sizeof(SeaCoreLayer));
+	document->layers[0] = layer;
+	document->layerCount++;
+
+	return &document->layers[0];
+}
@@ -0,0 +1,135 @@
+#include "SeaCorePrivate.h"
+#include <png.h>
+#include <tiffio.h>
+
+// Copies a bitmap leaving out the alpha samples
+static unsigned char *stripAlpha(const SeaCoreBitmap *bitmap)
+{
+	size_t i, count = (size_t)bitmap->width * bitmap->height;
+	int colours = bitmap->spp - 1;
+	unsigned char *data = malloc(MAX(count * colours, 1));
+
+	if (data) {
+		for (i = 0; i < count; i++)
+			memcpy(data + i * colours, bitmap->data + i * bitmap->spp, colours);
+	}
+
+	return data;
+}
+
+SeaCoreError SeaCoreBitmapWritePNG(const SeaCoreBitmap *bitmap, const char *path)
+{
+	png_structp png;
+	png_infop info;
+	unsigned char *data;
+	FILE *file;
+	int spp, colourType;
+	volatile bool failed = false;
+
+	if ((bitmap->spp != 2 && bitmap->spp != 4) || bitmap->width <= 0 || bitmap->height <= 0)
+		return SeaCoreErrorArgument;
+
+	// Leave out the alpha channel where it is not needed
+	spp = bitmap->spp;
+	data = bitmap->data;
+	if (SeaCoreBitmapIsOpaque(bitmap)) {
+		spp--;
+		data = stripAlpha(bitmap);
+		if (!data)
+			return SeaCoreErrorMemory;
+	}
+	switch (spp) {
+		case 1: colourType = PNG_COLOR_TYPE_GRAY; break;
+		case 2: colourType = PNG_COLOR_TYPE_GRAY_ALPHA; break;
+		case 3: colourType = PNG_COLOR_TYPE_RGB; break;
+		default: colourType = PNG_COLOR_TYPE_RGB_ALPHA; break;
+	}
+
+	file = fopen(path, "wb");
+	png = file ? png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL) : NULL;
+	info = png ? png_create_info_struct(png) : NULL;
+	if (!info) {
+		failed = true;
+	}
+	else if (setjmp(png_jmpbuf(png))) {
+		failed = true;
+	}
+	else {
+		png_init_io(png, file);
+		png_set_IHDR(png, info, bitmap->width, bitmap->height, 8, colourType, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+		png_write_info(png, info);
+		for (int j = 0; j < bitmap->height; j++)
+			png_write_row(png, data + (size_t)j * bitmap->width * spp);
+		png_write_end(png, info);
+	}
+	png_destroy_write_struct(png ? &png : NULL, info ? &info : NULL);
+	if (file && fclose(file) != 0)
+		failed = true;
+	if (data != bitmap->data)
+		free(data);
+
+	return (failed || !file) ? SeaCoreErrorFile : SeaCoreErrorNone;
+}
+
+SeaCoreError SeaCoreBitmapWriteTIFF(const SeaCoreBitmap *bitmap, const char *path)
+{
+	unsigned char *data, *buf;
+	uint16 extra = EXTRASAMPLE_UNASSALPHA;
+	int spp, linebytes;
+	bool failed = false;
+	TIFF *tiff;
+
+	if ((bitmap->spp != 2 && bitmap->spp != 4) || bitmap->width <= 0 || bitmap->height <= 0)
+		return SeaCoreErrorArgument;
+
+	// Leave out the alpha channel where it is not needed
+	spp = bitmap->spp;
+	data = bitmap->data;
+	if (SeaCoreBitmapIsOpaque(bitmap)) {
+		spp--;
+		data = stripAlpha(bitmap);
+		if (!data)
+			return SeaCoreErrorMemory;
+	}
+
+	// Open the file for writing
+	tiff = TIFFOpen(path, "w");
+	if (!tiff) {
+		if (data != bitmap->data)
+			free(data);
+		return SeaCoreErrorFile;
+	}
+
+	// Write the data as Seashore's TIFF exporter does
+	linebytes = bitmap->width * spp;
+	TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, (uint32)bitmap->width);
+	TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, (uint32)bitmap->height);
+	TIFFSetField(tiff, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
+	TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, spp);
+	TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE, 8);
+	TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+	TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, (spp < 3) ? PHOTOMETRIC_MINISBLACK : PHOTOMETRIC_RGB);
+	if (spp == bitmap->spp)
+		TIFFSetField(tiff, TIFFTAG_EXTRASAMPLES, 1, &extra);
+	TIFFSetField(tiff, TIFFTAG_COMPRESSION, COMPRESSION_LZW);
+	TIFFSetField(tiff, TIFFTAG_PREDICTOR, PREDICTOR_HORIZONTAL);
+	TIFFSetField(tiff, TIFFTAG_SOFTWARE, "SeaCore");
+	TIFFSetField(tiff, TIFFTAG_ROWSPERSTRIP, (linebytes * bitmap->height > 8192) ? (8192 / linebytes + 1) : bitmap->height);
+
+	// The predictor works in place so each row is copied first
+	buf = malloc(MAX(TIFFScanlineSize(tiff), linebytes));
+	failed = (buf == NULL);
+	for (int i = 0; i < bitmap->height && !failed; i++) {
+		memcpy(buf, data + (size_t)i * linebytes, linebytes);
+		if (TIFFWriteScanline(tiff, buf, i, 0) < 0)
+			failed = true;
+	}
+
+	// Close the file
+	TIFFClose(tiff);
+	free(buf);
+	if (data != bitmap->data)
+		free(data);
+
+	return failed ? SeaCoreErrorFile : SeaCoreErrorNone;
+}
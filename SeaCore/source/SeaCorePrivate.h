@@ -0,0 +1,101 @@
+/*!
+	@header		SeaCorePrivate
+	@abstract	Declarations shared by the parts of SeaCore.
+	@discussion	N/A
+				<br><br>
+				<b>License:</b> GNU General Public License<br>
+				<b>Copyright:</b> N/A
+*/
+
+#import "Globals.h"
+#import "RLE.h"
+#import "StandardMerge.h"
+#include <GIMPCore.h>
+#include "SeaCore.h"
+
+/*!
+	@defined	kMaxGroupDepth
+	@discussion	Specifies the deepest groups may be nested.
+*/
+#define kMaxGroupDepth 32
+
+/*!
+	@struct		SeaCoreDocument
+	@discussion	The layers of a document, the first being the top of the stack.
+*/
+struct SeaCoreDocument {
+	int width, height, spp;
+	int layerCount, layerCapacity;
+	SeaCoreLayer *layers;
+};
+
+/*!
+	@typedef	SeaCoreFlattener
+	@discussion	Composites the layers of a document as they are given, from the
+				bottom of the stack up. A canvas is kept for the document and
+				for each group that has been entered but not yet finished.
+*/
+typedef struct {
+	int width, height, spp;
+	int level;
+	SeaCoreBitmap canvases[kMaxGroupDepth + 1];
+} SeaCoreFlattener;
+
+/*!
+	@function	SeaCoreFlattenerBegin
+	@discussion	Prepares to flatten a document.
+	@param		flattener
+				The flattener to prepare.
+	@param		width
+				The width of the document.
+	@param		height
+				The height of the document.
+	@param		spp
+				The samples per pixel of the document.
+	@result		Returns SeaCoreErrorNone upon success.
+*/
+SeaCoreError SeaCoreFlattenerBegin(SeaCoreFlattener *flattener, int width, int height, int spp);
+
+/*!
+	@function	SeaCoreFlattenerAdd
+	@discussion	Composites the next layer up the stack. Layers that are not
+				visible must still be given, so groups are entered and left in
+				the right places, but their bitmaps may be empty.
+	@param		flattener
+				The flattener.
+	@param		layer
+				The layer.
+	@result		Returns SeaCoreErrorNone upon success.
+*/
+SeaCoreError SeaCoreFlattenerAdd(SeaCoreFlattener *flattener, const SeaCoreLayer *layer);
+
+/*!
+	@function	SeaCoreFlattenerFinish
+	@discussion	Finishes flattening a document, freeing the flattener.
+	@param		flattener
+				The flattener.
+	@param		result
+				The bitmap to fill in with the flattened document, or NULL to
+				abandon the flattening.
+*/
+void SeaCoreFlattenerFinish(SeaCoreFlattener *flattener, SeaCoreBitmap *result);
+
+/*!
+	@function	SeaCoreLayerFree
+	@discussion	Frees the name, bitmap and mask of a layer.
+	@param		layer
+				The layer to free.
+*/
+void SeaCoreLayerFree(SeaCoreLayer *layer);
+
+/*!
+	@function	SeaCoreDocumentAppendLayer
+	@discussion	Adds a layer to the bottom of the stack, taking ownership of
+				its name, bitmap and mask.
+	@param		document
+				The document.
+	@param		layer
+				The layer to add.
+	@result		Returns SeaCoreErrorNone upon success.
+*/
+SeaCoreError SeaCoreDocumentAppendLayer(SeaCoreDocumentRef document, const SeaCoreLayer *layer);
@@ -0,0 +1,684 @@
+#include "SeaCorePrivate.h"
+#include <ctype.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+// The layer types of the GIMP, their order gives the number of channels
+static const int kChannelsForType[] = { 3, 4, 1, 2, 1, 2 };
+
+typedef struct {
+	const unsigned char *bytes;
+	size_t length;
+
+	// Set from the header
+	int version, pointerSize;
+	int width, height, type, spp;
+	int bpc;
+	bool linear;
+	XcfCompressionType compression;
+	int cmapLength;
+	unsigned char cmap[256 * 3];
+
+	// The offsets of the layers, top first
+	size_t *layerOffsets;
+	int layerCount;
+} XCFFile;
+
+typedef struct {
+	const XCFFile *file;
+	size_t position;
+	bool failed;
+} XCFCursor;
+
+typedef struct {
+	// The properties of the layer, without its pixels
+	SeaCoreLayer layer;
+	int width, height, type;
+	size_t hierarchy, mask;
+	bool applyMask;
+} XCFLayerInfo;
+
+static inline bool canRead(XCFCursor *cursor, size_t length)
+{
+	if (cursor->failed || cursor->position > cursor->file->length || cursor->file->length - cursor->position < length) {
+		cursor->failed = true;
+		return false;
+	}
+
+	return true;
+}
+
+static uint32_t readInt(XCFCursor *cursor)
+{
+	const unsigned char *ptr;
+
+	if (!canRead(cursor, 4))
+		return 0;
+	ptr = cursor->file->bytes + cursor->position;
+	cursor->position += 4;
+
+	return ((uint32_t)ptr[0] << 24) | ((uint32_t)ptr[1] << 16) | ((uint32_t)ptr[2] << 8) | ptr[3];
+}
+
+static float readFloat(XCFCursor *cursor)
+{
+	uint32_t bits = readInt(cursor);
+	float value;
+
+	memcpy(&value, &bits, sizeof(value));
+
+	return value;
+}
+
+// Offsets became 64-bit in version 11
+static size_t readOffset(XCFCursor *cursor)
+{
+	uint64_t offset = readInt(cursor);
+
+	if (cursor->file->pointerSize == 8)
+		offset = (offset << 32) | readInt(cursor);
+
+	return (offset > SIZE_MAX) ? SIZE_MAX : (size_t)offset;
+}
+
+static char *readString(XCFCursor *cursor)
+{
+	uint32_t length = readInt(cursor);
+	char *string;
+
+	if (!canRead(cursor, length))
+		return NULL;
+	string = malloc((size_t)length + 1);
+	if (string) {
+		memcpy(string, cursor->file->bytes + cursor->position, length);
+		string[length] = 0;
+	}
+	cursor->position += length;
+
+	return string;
+}
+
+// Converts the precision in the header to the size and encoding of the samples
+static SeaCoreError readPrecision(XCFFile *file, uint32_t precision)
+{
+	if (file->version == 4) {
+		if (precision > 2)
+			return SeaCoreErrorUnsupported;
+		file->bpc = 1 << precision;
+		file->linear = (precision == 2);
+	}
+	else {
+		// Integer precisions are 100 (8-bit), 200 (16-bit) and 300 (32-bit) for linear samples, then 50 and 75 more for gamma
+		if (precision < 100 || precision >= 400 || (precision % 100 != 0 && precision % 100 != 50 && precision % 100 != 75))
+			return SeaCoreErrorUnsupported;
+		file->bpc = 1 << (precision / 100 - 1);
+		file->linear = (precision % 100 == 0);
+	}
+
+	return SeaCoreErrorNone;
+}
+
+static SeaCoreError openXCF(XCFFile *file, const void *bytes, size_t length)
+{
+	XCFCursor cursor = { file, 14, false };
+	uint32_t propType, propSize, count;
+	size_t start, offset;
+	SeaCoreError error;
+
+	memset(file, 0, sizeof(XCFFile));
+	file->bytes = bytes;
+	file->length = length;
+
+	// Check the signature and version, "file" being version 0 and "v001" version 1
+	if (length < 14 || memcmp(bytes, "gimp xcf ", 9) != 0 || file->bytes[13] != 0)
+		return SeaCoreErrorFormat;
+	if (memcmp(file->bytes + 9, "file", 4) == 0)
+		file->version = 0;
+	else if (file->bytes[9] == 'v' && isdigit(file->bytes[10]) && isdigit(file->bytes[11]) && isdigit(file->bytes[12]))
+		file->version = (file->bytes[10] - '0') * 100 + (file->bytes[11] - '0') * 10 + (file->bytes[12] - '0');
+	else
+		return SeaCoreErrorFormat;
+	file->pointerSize = (file->version >= 11) ? 8 : 4;
+
+	file->width = readInt(&cursor);
+	file->height = readInt(&cursor);
+	file->type = readInt(&cursor);
+	file->bpc = 1;
+	if (file->version >= 4 && (error = readPrecision(file, readInt(&cursor))))
+		return error;
+	if (cursor.failed || file->width <= 0 || file->height <= 0 || file->type < XCF_RGB_IMAGE || file->type > XCF_INDEXED_IMAGE)
+		return SeaCoreErrorFormat;
+	if (file->width > kMaxImageSize || file->height > kMaxImageSize)
+		return SeaCoreErrorUnsupported;
+	file->spp = (file->type == XCF_GRAY_IMAGE) ? 2 : 4;
+
+	// Read the properties of the image
+	file->compression = COMPRESS_NONE;
+	do {
+		propType = readInt(&cursor);
+		propSize = readInt(&cursor);
+		start = cursor.position;
+		switch (propType) {
+			case PROP_COLORMAP:
+				// Version 0 files have the wrong size so skip only what is read
+				count = readInt(&cursor);
+				if (count > 256 || !canRead(&cursor, count * 3))
+					return SeaCoreErrorFormat;
+				memcpy(file->cmap, file->bytes + cursor.position, count * 3);
+				file->cmapLength = count;
+				propSize = 4 + count * 3;
+			break;
+			case PROP_COMPRESSION:
+				if (!canRead(&cursor, 1))
+					return SeaCoreErrorFormat;
+				file->compression = file->bytes[cursor.position];
+			break;
+		}
+		cursor.position = start;
+		if (!canRead(&cursor, propSize))
+			return SeaCoreErrorFormat;
+		cursor.position += propSize;
+	} while (propType != PROP_END);
+	if (file->compression != COMPRESS_NONE && file->compression != COMPRESS_RLE && file->compression != COMPRESS_ZLIB)
+		return SeaCoreErrorUnsupported;
+
+	// Then the layers, ending with a zero offset
+	while ((offset = readOffset(&cursor)) != 0 && !cursor.failed) {
+		if (file->layerCount % 64 == 0) {
+			size_t *offsets = realloc(file->layerOffsets, (file->layerCount + 64) * sizeof(size_t));
+			if (!offsets)
+				return SeaCoreErrorMemory;
+			file->layerOffsets = offsets;
+		}
+		file->layerOffsets[file->layerCount++] = offset;
+	}
+
+	return cursor.failed ? SeaCoreErrorFormat : SeaCoreErrorNone;
+}
+
+static void closeXCF(XCFFile *file)
+{
+	free(file->layerOffsets);
+	file->layerOffsets = NULL;
+}
+
+// Finds the nearest merge technique Seashore has for the modes added in the GIMP 2.10
+static int modeForGIMPMode(uint32_t mode)
+{
+	static const int modes[] = {
+		XCF_OVERLAY_MODE, XCF_HUE_MODE, XCF_SATURATION_MODE, XCF_COLOR_MODE, XCF_VALUE_MODE,
+		XCF_NORMAL_MODE, XCF_BEHIND_MODE, XCF_MULTIPLY_MODE, XCF_SCREEN_MODE, XCF_DIFFERENCE_MODE,
+		XCF_ADDITION_MODE, XCF_SUBTRACT_MODE, XCF_DARKEN_ONLY_MODE, XCF_LIGHTEN_ONLY_MODE, XCF_HUE_MODE,
+		XCF_SATURATION_MODE, XCF_COLOR_MODE, XCF_VALUE_MODE, XCF_DIVIDE_MODE, XCF_DODGE_MODE,
+		XCF_BURN_MODE, XCF_HARDLIGHT_MODE, XCF_SOFTLIGHT_MODE, XCF_GRAIN_EXTRACT_MODE, XCF_GRAIN_MERGE_MODE
+	};
+
+	if (mode <= XCF_GRAIN_MERGE_MODE)
+		return mode;
+	if (mode >= 23 && mode < 23 + sizeof(modes) / sizeof(modes[0]))
+		return modes[mode - 23];
+
+	return XCF_NORMAL_MODE;
+}
+
+static SeaCoreError readLayerInfo(const XCFFile *file, size_t offset, XCFLayerInfo *info)
+{
+	XCFCursor cursor = { file, offset, false };
+	uint32_t propType, propSize, opacity;
+	float floatOpacity;
+	size_t start;
+
+	memset(info, 0, sizeof(XCFLayerInfo));
+	info->layer.opacity = 255;
+	info->layer.visible = true;
+	info->applyMask = true;
+
+	info->width = readInt(&cursor);
+	info->height = readInt(&cursor);
+	info->type = readInt(&cursor);
+	info->layer.name = readString(&cursor);
+	if (cursor.failed || !info->layer.name)
+		return cursor.failed ? SeaCoreErrorFormat : SeaCoreErrorMemory;
+	if (info->width < 0 || info->height < 0 || info->type < 0 || info->type > 5 || (info->type >> 1) != file->type)
+		return SeaCoreErrorFormat;
+	if (info->width > kMaxImageSize || info->height > kMaxImageSize)
+		return SeaCoreErrorUnsupported;
+
+	do {
+		propType = readInt(&cursor);
+		propSize = readInt(&cursor);
+		start = cursor.position;
+		switch (propType) {
+			case PROP_OPACITY:
+				opacity = readInt(&cursor);
+				info->layer.opacity = MIN(opacity, 255);
+			break;
+			case PROP_FLOAT_OPACITY:
+				floatOpacity = readFloat(&cursor);
+				info->layer.opacity = (int)lroundf(MAX(0.0f, MIN(floatOpacity, 1.0f)) * 255.0f);
+			break;
+			case PROP_MODE:
+				info->layer.mode = modeForGIMPMode(readInt(&cursor));
+			break;
+			case PROP_VISIBLE:
+				info->layer.visible = readInt(&cursor) != 0;
+			break;
+			case PROP_APPLY_MASK:
+				info->applyMask = readInt(&cursor) != 0;
+			break;
+			case PROP_OFFSETS:
+				info->layer.x = (int32_t)readInt(&cursor);
+				info->layer.y = (int32_t)readInt(&cursor);
+			break;
+			case PROP_GROUP_ITEM:
+				info->layer.group = true;
+			break;
+			case PROP_ITEM_PATH:
+				// The path ends with the layer's own index
+				info->layer.depth = MAX((int)(propSize / 4) - 1, 0);
+			break;
+		}
+		cursor.position = start;
+		if (!canRead(&cursor, propSize))
+			return SeaCoreErrorFormat;
+		cursor.position += propSize;
+	} while (propType != PROP_END);
+
+	info->hierarchy = readOffset(&cursor);
+	info->mask = readOffset(&cursor);
+	if (cursor.failed)
+		return SeaCoreErrorFormat;
+	if (!info->applyMask)
+		info->mask = 0;
+
+	return SeaCoreErrorNone;
+}
+
+static pthread_once_t linearOnce = PTHREAD_ONCE_INIT;
+static unsigned char linearToGamma[65536];
+
+static void initLinearToGamma(void)
+{
+	double value;
+
+	for (int i = 0; i < 65536; i++) {
+		value = i / 65535.0;
+		value = (value <= 0.0031308) ? value * 12.92 : 1.055 * pow(value, 1.0 / 2.4) - 0.055;
+		linearToGamma[i] = (unsigned char)lround(MAX(0.0, MIN(value, 1.0)) * 255.0);
+	}
+}
+
+typedef struct {
+	const XCFFile *file;
+	int channels, destSpp;
+	bool indexed, colour;
+} PixelFormat;
+
+// Converts a tile of big-endian samples to the document's form
+static void convertTile(const PixelFormat *format, unsigned char *dest, int destWidth, const unsigned char *tile, int width, int height)
+{
+	const XCFFile *file = format->file;
+	int channels = format->channels, bpc = file->bpc, alpha = (channels == 2 || channels == 4), colours = channels - alpha;
+	unsigned char sample[4], *pixel;
+	const unsigned char *src = tile, *entry;
+	int i, j, k;
+
+	for (j = 0; j < height; j++) {
+		pixel = dest + (size_t)j * destWidth * format->destSpp;
+		for (i = 0; i < width; i++, src += channels * bpc, pixel += format->destSpp) {
+			// Keep the most significant byte, converting linear colours to gamma
+			for (k = 0; k < channels; k++) {
+				if (file->linear && k < colours && format->colour)
+					sample[k] = linearToGamma[(bpc == 1) ? src[k] * 257 : (src[k * bpc] << 8) | src[k * bpc + 1]];
+				else
+					sample[k] = src[k * bpc];
+			}
+			if (format->destSpp == 1) {
+				pixel[0] = sample[0];
+			}
+			else if (format->indexed) {
+				if (sample[0] < file->cmapLength) {
+					entry = &file->cmap[sample[0] * 3];
+					pixel[0] = entry[0];
+					pixel[1] = entry[1];
+					pixel[2] = entry[2];
+					pixel[3] = alpha ? sample[1] : 255;
+				}
+				else {
+					memset(pixel, 0, 4);
+				}
+			}
+			else {
+				memcpy(pixel, sample, colours);
+				pixel[format->destSpp - 1] = alpha ? sample[colours] : 255;
+			}
+		}
+	}
+}
+
+static SeaCoreError readTile(const XCFFile *file, size_t offset, unsigned char *tile, int width, int height, int bpp)
+{
+	size_t available, expected = (size_t)width * height * bpp;
+	const unsigned char *input;
+	z_stream stream;
+	int result;
+
+	if (offset >= file->length)
+		return SeaCoreErrorFormat;
+	input = file->bytes + offset;
+	available = file->length - offset;
+	switch (file->compression) {
+		case COMPRESS_NONE:
+			if (available < expected)
+				return SeaCoreErrorFormat;
+			memcpy(tile, input, expected);
+		break;
+		case COMPRESS_RLE:
+			if (!SeaRLEDecompress(tile, (unsigned char *)input, (int)MIN(available, INT_MAX), width, height, bpp))
+				return SeaCoreErrorFormat;
+		break;
+		case COMPRESS_ZLIB:
+			memset(&stream, 0, sizeof(stream));
+			if (inflateInit(&stream) != Z_OK)
+				return SeaCoreErrorMemory;
+			stream.next_in = (unsigned char *)input;
+			stream.avail_in = (uInt)MIN(available, UINT_MAX);
+			stream.next_out = tile;
+			stream.avail_out = (uInt)expected;
+			result = inflate(&stream, Z_FINISH);
+			inflateEnd(&stream);
+			if (result != Z_STREAM_END || stream.avail_out != 0)
+				return SeaCoreErrorFormat;
+		break;
+		default:
+			return SeaCoreErrorUnsupported;
+	}
+
+	return SeaCoreErrorNone;
+}
+
+// Reads the first level of a hierarchy in to a bitmap
+static SeaCoreError readHierarchy(const PixelFormat *format, size_t hierarchy, SeaCoreBitmap *bitmap)
+{
+	const XCFFile *file = format->file;
+	XCFCursor cursor = { file, hierarchy, false };
+	int width, height, bpp, tileWidth, tileHeight, x, y;
+	unsigned char *tile;
+	size_t level, offset;
+	SeaCoreError error = SeaCoreErrorNone;
+
+	width = readInt(&cursor);
+	height = readInt(&cursor);
+	bpp = readInt(&cursor);
+	level = readOffset(&cursor);
+	if (cursor.failed || width != bitmap->width || height != bitmap->height || bpp != format->channels * file->bpc)
+		return SeaCoreErrorFormat;
+	if (width == 0 || height == 0)
+		return SeaCoreErrorNone;
+
+	cursor.position = level;
+	width = readInt(&cursor);
+	height = readInt(&cursor);
+	if (cursor.failed || width != bitmap->width || height != bitmap->height)
+		return SeaCoreErrorFormat;
+
+	tile = malloc(XCF_TILE_WIDTH * XCF_TILE_HEIGHT * bpp);
+	if (!tile)
+		return SeaCoreErrorMemory;
+	for (y = 0; y < height && !error; y += XCF_TILE_HEIGHT) {
+		for (x = 0; x < width && !error; x += XCF_TILE_WIDTH) {
+			tileWidth = MIN(XCF_TILE_WIDTH, width - x);
+			tileHeight = MIN(XCF_TILE_HEIGHT, height - y);
+			offset = readOffset(&cursor);
+			if (cursor.failed || offset == 0)
+				error = SeaCoreErrorFormat;
+			else if (!(error = readTile(file, offset, tile, tileWidth, tileHeight, bpp)))
+				convertTile(format, bitmap->data + ((size_t)y * width + x) * bitmap->spp, width, tile, tileWidth, tileHeight);
+		}
+	}
+	free(tile);
+
+	return error;
+}
+
+// Reads a layer's mask, skipping the properties of the channel
+static SeaCoreError readMask(const XCFFile *file, const XCFLayerInfo *info, SeaCoreBitmap *mask)
+{
+	XCFCursor cursor = { file, info->mask, false };
+	PixelFormat format = { file, 1, 1, false, false };
+	uint32_t propType, propSize;
+	int width, height;
+	char *name;
+	SeaCoreError error;
+
+	width = readInt(&cursor);
+	height = readInt(&cursor);
+	name = readString(&cursor);
+	free(name);
+	do {
+		propType = readInt(&cursor);
+		propSize = readInt(&cursor);
+		if (canRead(&cursor, propSize))
+			cursor.position += propSize;
+	} while (propType != PROP_END && !cursor.failed);
+	if (cursor.failed || width != info->width || height != info->height)
+		return SeaCoreErrorFormat;
+
+	if ((error = SeaCoreBitmapCreate(mask, width, height, 1)))
+		return error;
+	error = readHierarchy(&format, readOffset(&cursor), mask);
+	if (cursor.failed)
+		error = SeaCoreErrorFormat;
+	if (error)
+		SeaCoreBitmapFree(mask);
+
+	return error;
+}
+
+// Reads the pixels and mask of a layer in to its bitmaps
+static SeaCoreError readLayerPixels(const XCFFile *file, XCFLayerInfo *info)
+{
+	PixelFormat format = { file, kChannelsForType[info->type], file->spp, file->type == XCF_INDEXED_IMAGE, file->type != XCF_INDEXED_IMAGE };
+	SeaCoreError error;
+
+	if (file->linear)
+		pthread_once(&linearOnce, initLinearToGamma);
+	if (!info->layer.group) {
+		if ((error = SeaCoreBitmapCreate(&info->layer.bitmap, info->width, info->height, file->spp)))
+			return error;
+		if ((error = readHierarchy(&format, info->hierarchy, &info->layer.bitmap)))
+			return error;
+	}
+	if (info->mask)
+		return readMask(file, info, &info->layer.mask);
+
+	return SeaCoreErrorNone;
+}
+
+// Reads the properties of every layer, top first
+static SeaCoreError readLayerInfos(const XCFFile *file, XCFLayerInfo **infos)
+{
+	SeaCoreError error = SeaCoreErrorNone;
+	int i;
+
+	*infos = calloc(MAX(file->layerCount, 1), sizeof(XCFLayerInfo));
+	if (!*infos)
+		return SeaCoreErrorMemory;
+	for (i = 0; i < file->layerCount && !error; i++)
+		error = readLayerInfo(file, file->layerOffsets[i], &(*infos)[i]);
+
+	return error;
+}
+
+static void freeLayerInfos(const XCFFile *file, XCFLayerInfo *infos)
+{
+	if (!infos)
+		return;
+	for (int i = 0; i < file->layerCount; i++)
+		SeaCoreLayerFree(&infos[i].layer);
+	free(infos);
+}
+
+// Hides the layers in hidden groups so they need not be read
+static void hideGroupedLayers(const XCFFile *file, XCFLayerInfo *infos)
+{
+	bool hidden[kMaxGroupDepth + 1] = { false };
+	int depth;
+
+	for (int i = 0; i < file->layerCount; i++) {
+		depth = MIN(infos[i].layer.depth, kMaxGroupDepth);
+		if (depth > 0 && hidden[depth - 1])
+			infos[i].layer.visible = false;
+		if (infos[i].layer.group)
+			hidden[depth] = !infos[i].layer.visible;
+	}
+}
+
+SeaCoreDocumentRef SeaCoreDocumentCreateWithXCFData(const void *bytes, size_t length, SeaCoreError *error)
+{
+	SeaCoreDocumentRef document = NULL;
+	XCFLayerInfo *infos = NULL;
+	XCFFile file;
+	SeaCoreError result;
+	int i;
+
+	if (!(result = openXCF(&file, bytes, length)) && !(result = readLayerInfos(&file, &infos))) {
+		document = SeaCoreDocumentCreate(file.width, file.height, file.spp);
+		if (!document)
+			result = SeaCoreErrorMemory;
+		for (i = 0; i < file.layerCount && !result; i++) {
+			if (!(result = readLayerPixels(&file, &infos[i])) && !(result = SeaCoreDocumentAppendLayer(document, &infos[i].layer)))
+				memset(&infos[i].layer, 0, sizeof(SeaCoreLayer));
+		}
+	}
+	freeLayerInfos(&file, infos);
+	closeXCF(&file);
+	if (result) {
+		SeaCoreDocumentRelease(document);
+		document = NULL;
+	}
+	if (error)
+		*error = result;
+
+	return document;
+}
+
+// Maps a file in to memory for reading
+static SeaCoreError mapFile(const char *path, void **bytes, size_t *length)
+{
+	struct stat info;
+	int fd;
+
+	*bytes = NULL;
+	*length = 0;
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return SeaCoreErrorFile;
+	if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+		close(fd);
+		return (info.st_size == 0) ? SeaCoreErrorFormat : SeaCoreErrorFile;
+	}
+	*length = (size_t)info.st_size;
+	*bytes = mmap(NULL, *length, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (*bytes == MAP_FAILED) {
+		*bytes = NULL;
+		return SeaCoreErrorFile;
+	}
+
+	return SeaCoreErrorNone;
+}
+
+static void unmapFile(void *bytes, size_t length)
+{
+	if (bytes)
+		munmap(bytes, length);
+}
+
+SeaCoreDocumentRef SeaCoreDocumentCreateWithXCF(const char *path, SeaCoreError *error)
+{
+	SeaCoreDocumentRef document = NULL;
+	SeaCoreError result;
+	void *bytes;
+	size_t length;
+
+	if (!(result = mapFile(path, &bytes, &length)))
+		document = SeaCoreDocumentCreateWithXCFData(bytes, length, &result);
+	unmapFile(bytes, length);
+	if (error)
+		*error = result;
+
+	return document;
+}
+
+SeaCoreError SeaCoreRenderXCF(const char *path, SeaCoreBitmap *result)
+{
+	SeaCoreFlattener flattener;
+	XCFLayerInfo *infos = NULL;
+	XCFFile file;
+	SeaCoreError error;
+	void *bytes;
+	size_t length;
+	int i;
+
+	memset(result, 0, sizeof(SeaCoreBitmap));
+	if ((error = mapFile(path, &bytes, &length)))
+		return error;
+	if (!(error = openXCF(&file, bytes, length)) && !(error = readLayerInfos(&file, &infos))) {
+		hideGroupedLayers(&file, infos);
+
+		// Read each layer only as it is composited, from the bottom up
+		error = SeaCoreFlattenerBegin(&flattener, file.width, file.height, file.spp);
+		for (i = file.layerCount - 1; i >= 0 && !error; i--) {
+			if (infos[i].layer.visible)
+				error = readLayerPixels(&file, &infos[i]);
+			if (!error)
+				error = SeaCoreFlattenerAdd(&flattener, &infos[i].layer);
+			SeaCoreBitmapFree(&infos[i].layer.bitmap);
+			SeaCoreBitmapFree(&infos[i].layer.mask);
+		}
+		SeaCoreFlattenerFinish(&flattener, error ? NULL : result);
+	}
+	freeLayerInfos(&file, infos);
+	closeXCF(&file);
+	unmapFile(bytes, length);
+
+	return error;
+}
+
+SeaCoreError SeaCoreRenderXCFMemory(const char *path, size_t *bytesNeeded)
+{
+	XCFLayerInfo *infos = NULL;
+	XCFFile file;
+	SeaCoreError error;
+	size_t canvas, layer, largest = 0;
+	void *bytes;
+	size_t length;
+	int i, depth = 0;
+
+	*bytesNeeded = 0;
+	if ((error = mapFile(path, &bytes, &length)))
+		return error;
+	if (!(error = openXCF(&file, bytes, length)) && !(error = readLayerInfos(&file, &infos))) {
+		// A canvas for the document and each level of groups, plus the largest layer and its mask
+		hideGroupedLayers(&file, infos);
+		canvas = (size_t)file.width * file.height * file.spp;
+		for (i = 0; i < file.layerCount; i++) {
+			if (!infos[i].layer.visible)
+				continue;
+			depth = MAX(depth, MIN(infos[i].layer.depth, kMaxGroupDepth));
+			layer = (size_t)infos[i].width * infos[i].height * (file.spp * !infos[i].layer.group + (infos[i].mask != 0));
+			largest = MAX(largest, layer);
+		}
+		*bytesNeeded = canvas * (depth + 1) + largest + XCF_TILE_WIDTH * XCF_TILE_HEIGHT * 4 * file.bpc;
+	}
+	freeLayerInfos(&file, infos);
+	closeXCF(&file);
+	unmapFile(bytes, length);
+
+	return error;
+}
@@ -0,0 +1,235 @@
+#include "SeaCorePrivate.h"
+
+typedef struct {
+	FILE *file;
+	bool failed;
+} XCFWriter;
+
+static void writeInt(XCFWriter *writer, uint32_t value)
+{
+	unsigned char bytes[4] = { value >> 24, (value >> 16) & 0xff, (value >> 8) & 0xff, value & 0xff };
+
+	if (fwrite(bytes, 4, 1, writer->file) != 1)
+		writer->failed = true;
+}
+
+static void writeProperty(XCFWriter *writer, XcfPropType type, int count, const uint32_t *values)
+{
+	writeInt(writer, type);
+	writeInt(writer, count * 4);
+	for (int i = 0; i < count; i++)
+		writeInt(writer, values[i]);
+}
+
+static void writeString(XCFWriter *writer, const char *string)
+{
+	size_t length = strlen(string) + 1;
+
+	writeInt(writer, (uint32_t)length);
+	if (fwrite(string, length, 1, writer->file) != 1)
+		writer->failed = true;
+}
+
+// Returns the position of the writer, which must fit in an offset of version 0
+static uint32_t tell(XCFWriter *writer)
+{
+	off_t position = ftello(writer->file);
+
+	if (position < 0 || position > UINT32_MAX) {
+		writer->failed = true;
+		return 0;
+	}
+
+	return (uint32_t)position;
+}
+
+// Writes values over those already written then returns to the end
+static void patchInts(XCFWriter *writer, uint32_t position, const uint32_t *values, int count)
+{
+	if (fseeko(writer->file, position, SEEK_SET) != 0)
+		writer->failed = true;
+	for (int i = 0; i < count; i++)
+		writeInt(writer, values[i]);
+	if (fseeko(writer->file, 0, SEEK_END) != 0)
+		writer->failed = true;
+}
+
+static void patchInt(XCFWriter *writer, uint32_t position, uint32_t value)
+{
+	patchInts(writer, position, &value, 1);
+}
+
+// Writes a hierarchy of a single level of RLE compressed tiles, returning its offset
+static uint32_t writeHierarchy(XCFWriter *writer, const SeaCoreBitmap *bitmap)
+{
+	int tilesAcross = (bitmap->width + XCF_TILE_WIDTH - 1) / XCF_TILE_WIDTH;
+	int tilesDown = (bitmap->height + XCF_TILE_HEIGHT - 1) / XCF_TILE_HEIGHT;
+	int spp = bitmap->spp, tileWidth, tileHeight, length, i, j, t = 0;
+	size_t tileSize = XCF_TILE_WIDTH * XCF_TILE_HEIGHT * spp;
+	uint32_t hierarchy, level, table, *offsets;
+	unsigned char *tile, *compressed;
+
+	hierarchy = tell(writer);
+	writeInt(writer, bitmap->width);
+	writeInt(writer, bitmap->height);
+	writeInt(writer, spp);
+	level = tell(writer) + 8;
+	writeInt(writer, level);
+	writeInt(writer, 0);
+
+	writeInt(writer, bitmap->width);
+	writeInt(writer, bitmap->height);
+	table = tell(writer);
+	for (i = 0; i <= tilesAcross * tilesDown; i++)
+		writeInt(writer, 0);
+
+	// The table is filled in once every tile has been written
+	tile = malloc(tileSize);
+	compressed = malloc(tileSize + 1 + (tileSize / 128) * 3);
+	offsets = malloc(tilesAcross * tilesDown * sizeof(uint32_t) + 1);
+	if (!tile || !compressed || !offsets)
+		writer->failed = true;
+	for (j = 0; j < tilesDown && !writer->failed; j++) {
+		for (i = 0; i < tilesAcross && !writer->failed; i++, t++) {
+			tileWidth = MIN(XCF_TILE_WIDTH, bitmap->width - i * XCF_TILE_WIDTH);
+			tileHeight = MIN(XCF_TILE_HEIGHT, bitmap->height - j * XCF_TILE_HEIGHT);
+			for (int y = 0; y < tileHeight; y++)
+				memcpy(tile + y * tileWidth * spp, bitmap->data + ((size_t)(j * XCF_TILE_HEIGHT + y) * bitmap->width + i * XCF_TILE_WIDTH) * spp, tileWidth * spp);
+			length = SeaRLECompress(compressed, tile, tileWidth, tileHeight, spp);
+			offsets[t] = tell(writer);
+			if (length <= 0 || fwrite(compressed, length, 1, writer->file) != 1)
+				writer->failed = true;
+		}
+	}
+	if (!writer->failed)
+		patchInts(writer, table, offsets, tilesAcross * tilesDown);
+	free(tile);
+	free(compressed);
+	free(offsets);
+
+	return hierarchy;
+}
+
+static uint32_t writeMask(XCFWriter *writer, const SeaCoreBitmap *mask)
+{
+	uint32_t channel = tell(writer), hierarchyOffset;
+
+	writeInt(writer, mask->width);
+	writeInt(writer, mask->height);
+	writeString(writer, "Layer Mask");
+	writeProperty(writer, PROP_END, 0, NULL);
+	hierarchyOffset = tell(writer);
+	writeInt(writer, 0);
+	patchInt(writer, hierarchyOffset, writeHierarchy(writer, mask));
+
+	return channel;
+}
+
+static void writeLayer(XCFWriter *writer, SeaCoreDocumentRef document, const SeaCoreLayer *layer, const uint32_t *path)
+{
+	SeaCoreBitmap placeholder = { 0, 0, document->spp, NULL };
+	const SeaCoreBitmap *bitmap = &layer->bitmap;
+	uint32_t values[2], pointers;
+
+	// A group is written as a transparent layer covering its mask, its contents come from the layers in it
+	if (layer->group) {
+		if (SeaCoreBitmapCreate(&placeholder, MAX(layer->mask.width, 1), MAX(layer->mask.height, 1), document->spp)) {
+			writer->failed = true;
+			return;
+		}
+		bitmap = &placeholder;
+	}
+
+	writeInt(writer, bitmap->width);
+	writeInt(writer, bitmap->height);
+	writeInt(writer, (document->spp == 2) ? 3 : 1);
+	writeString(writer, layer->name ? layer->name : "");
+
+	values[0] = MAX(0, MIN(layer->opacity, 255));
+	writeProperty(writer, PROP_OPACITY, 1, values);
+	values[0] = layer->visible;
+	writeProperty(writer, PROP_VISIBLE, 1, values);
+	values[0] = layer->x;
+	values[1] = layer->y;
+	writeProperty(writer, PROP_OFFSETS, 2, values);
+	values[0] = layer->mode;
+	writeProperty(writer, PROP_MODE, 1, values);
+	if (layer->mask.data) {
+		values[0] = 1;
+		writeProperty(writer, PROP_APPLY_MASK, 1, values);
+	}
+	if (layer->group)
+		writeProperty(writer, PROP_GROUP_ITEM, 0, NULL);
+	if (layer->depth > 0)
+		writeProperty(writer, PROP_ITEM_PATH, layer->depth + 1, path);
+	writeProperty(writer, PROP_END, 0, NULL);
+
+	pointers = tell(writer);
+	writeInt(writer, 0);
+	writeInt(writer, 0);
+	patchInt(writer, pointers, writeHierarchy(writer, bitmap));
+	if (layer->mask.data)
+		patchInt(writer, pointers + 4, writeMask(writer, &layer->mask));
+	SeaCoreBitmapFree(&placeholder);
+}
+
+SeaCoreError SeaCoreDocumentWriteXCF(SeaCoreDocumentRef document, const char *path)
+{
+	XCFWriter writer = { NULL, false };
+	uint32_t current[kMaxGroupDepth + 1], next[kMaxGroupDepth + 2] = { 0 }, table, value, *offsets;
+	bool groups = false;
+	int i, depth;
+
+	for (i = 0; i < document->layerCount; i++) {
+		const SeaCoreLayer *layer = &document->layers[i];
+		if (layer->depth < 0 || layer->depth > kMaxGroupDepth || (!layer->group && layer->bitmap.spp != document->spp) || (layer->mask.data && layer->mask.spp != 1))
+			return SeaCoreErrorArgument;
+		if (layer->mask.data && !layer->group && (layer->mask.width != layer->bitmap.width || layer->mask.height != layer->bitmap.height))
+			return SeaCoreErrorArgument;
+		groups = groups || layer->group || layer->depth > 0;
+	}
+
+	offsets = malloc(document->layerCount * sizeof(uint32_t) + 1);
+	if (!offsets)
+		return SeaCoreErrorMemory;
+	writer.file = fopen(path, "wb");
+	if (!writer.file) {
+		free(offsets);
+		return SeaCoreErrorFile;
+	}
+
+	// Groups need version 3, otherwise Seashore and older versions of the GIMP can read the file
+	if (fwrite(groups ? "gimp xcf v003" : "gimp xcf file", 14, 1, writer.file) != 1)
+		writer.failed = true;
+	writeInt(&writer, document->width);
+	writeInt(&writer, document->height);
+	writeInt(&writer, (document->spp == 2) ? XCF_GRAY_IMAGE : XCF_RGB_IMAGE);
+	writeInt(&writer, PROP_COMPRESSION);
+	writeInt(&writer, 1);
+	value = COMPRESS_RLE;
+	if (fputc(value, writer.file) == EOF)
+		writer.failed = true;
+	writeProperty(&writer, PROP_END, 0, NULL);
+
+	// The layers then the channels, each list ending with a zero
+	table = tell(&writer);
+	for (i = 0; i <= document->layerCount + 1; i++)
+		writeInt(&writer, 0);
+
+	for (i = 0; i < document->layerCount && !writer.failed; i++) {
+		// The path of a layer is its index within each group it is in
+		depth = document->layers[i].depth;
+		current[depth] = next[depth]++;
+		next[depth + 1] = 0;
+		offsets[i] = tell(&writer);
+		writeLayer(&writer, document, &document->layers[i], current);
+	}
+	if (!writer.failed)
+		patchInts(&writer, table, offsets, document->layerCount);
+	free(offsets);
+
+	if (fclose(writer.file) != 0)
+		writer.failed = true;
+
+	return writer.failed ? SeaCoreErrorFile : SeaCoreErrorNone;
+}
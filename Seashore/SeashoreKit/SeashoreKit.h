@@ -25,6 +25,7 @@ FOUNDATION_EXPORT const unsigned char SeashoreKitVersionString[];
 #import <SeashoreKit/SSKCIPlugin.h>
 #import <SeashoreKit/SeaMain.h>
 #import <SeashoreKit/Bitmap.h>
+#import <SeashoreKit/ColorLUT.h>
 #import <SeashoreKit/CenteringClipView.h>
 #import <SeashoreKit/ImageToolbarItem.h>
 #import <SeashoreKit/IndiciesKeeper.h>
@@ -46,6 +47,7 @@ FOUNDATION_EXPORT const unsigned char SeashoreKitVersionString[];
 #import <SeashoreKit/SeaToolbarItem.h>
 #import <SeashoreKit/SeaView.h>
 #import <SeashoreKit/SeaWarning.h>
+#import <SeashoreKit/SeaWhiteboardSnapshot.h>
 #import <SeashoreKit/SeaWindowContent.h>
 #import <SeashoreKit/TextureExporter.h>
 #import <SeashoreKit/Bucket.h>
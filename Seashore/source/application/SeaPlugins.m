@@ -2,6 +2,7 @@
 #import "SeaPlugins.h"
 #import "PluginClass.h"
 #import "SeaSelection.h"
+#import "SeaContent.h"
 #import "SeaHelpers.h"
 #import "SeaController.h"
 #import "SeaTools.h"
@@ -309,6 +310,10 @@ static BOOL checkRun(NSString *path, NSString *file)
 	if ([document locked])
 		return NO;
 	
+	// Never for 16-bit documents, the plug-ins work on 8-bit samples
+	if ([[document contents] bps] == 16)
+		return NO;
+	
 	// Never if we are told not to
 	if ([menuItem tag] >= 10000 && [menuItem tag] < 17500) {
 		if (![plugins[[menuItem tag] - 10000] validateMenuItem:menuItem])
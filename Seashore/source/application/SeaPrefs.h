@@ -146,6 +146,9 @@ typedef NS_ENUM(NSInteger, SeaGuideColor) {
 	// Stores the memory cache size
 	size_t memoryCacheSize;
 	
+	// The directory undo data is written to
+	NSString *scratchDirectory;
+	
 	// Whether textures should be used
 	BOOL useTextures;
 		
@@ -170,6 +173,9 @@ typedef NS_ENUM(NSInteger, SeaGuideColor) {
 	// Whether Core Image should be used for scaling/rotation
 	BOOL useCoreImage;
 	
+	// Whether 16-bit images should be opened as 16-bit documents
+	BOOL keepDeepImages;
+	
 	// The current selection colour
 	SeaGuideColor selectionColor;
 
@@ -461,6 +467,15 @@ typedef NS_ENUM(NSInteger, SeaGuideColor) {
 */
 @property (readonly) size_t memoryCacheSize;
 
+/*!
+	@property	scratchDirectory
+	@discussion	Returns the directory in which undo data and compressed layers
+				are kept once they have been written to disk. This is the
+				temporary directory unless another has been set in the defaults.
+	@result		Returns the path of the scratch directory.
+*/
+@property (readonly, copy) NSString *scratchDirectory;
+
 /*!
 	@property	warningLevel
 	@discussion	Returns the warning level. Only warnings with a priority less
@@ -671,6 +686,17 @@ typedef NS_ENUM(NSInteger, SeaGuideColor) {
 */
 - (BOOL)useCoreImage;
 
+/*!
+	@method		keepDeepImages
+	@discussion	Returns whether 16-bit images should be opened as 16-bit
+				documents rather than being resampled at 8 bits. There is no
+				interface for this yet, it is set with the keepDeepImages
+				default.
+	@result		Returns YES if 16-bit images should be kept at 16 bits, NO
+				otherwise.
+*/
+- (BOOL)keepDeepImages;
+
 /*!
 	@method		delayOverlay
 	@discussion	Returns whether the application of the overlay should be
@@ -80,6 +80,7 @@ CGDisplayErr GetMainDisplayDPI(CGFloat *horizontalDPI, CGFloat *verticalDPI)
 @synthesize runCount;
 @synthesize useCheckerboard;
 @synthesize memoryCacheSize;
+@synthesize scratchDirectory;
 @synthesize firstRun;
 //@synthesize mode;
 @synthesize guideColorIndex = guideColor;
@@ -144,6 +145,12 @@ CGDisplayErr GetMainDisplayDPI(CGFloat *horizontalDPI, CGFloat *verticalDPI)
 		memoryCacheSize = [defaults integerForKey:@"memoryCacheSize"];
 	if (memoryCacheSize < 128 || memoryCacheSize > 32768)
 		memoryCacheSize = 4096;
+	
+	// Get the scratch directory from preferences (if it still exists)
+	BOOL isDirectory = NO;
+	scratchDirectory = [defaults stringForKey:@"scratchDirectory"];
+	if (!scratchDirectory || ![gFileManager fileExistsAtPath:scratchDirectory isDirectory:&isDirectory] || !isDirectory)
+		scratchDirectory = NSTemporaryDirectory();
 
 	// Get the use of the checkerboard pattern
 	if ([defaults objectForKey:@"useCheckerboard"])
@@ -277,6 +284,12 @@ CGDisplayErr GetMainDisplayDPI(CGFloat *horizontalDPI, CGFloat *verticalDPI)
 		useCoreImage = [defaults boolForKey:@"useCoreImage"];
 	else
 		useCoreImage = YES;
+	
+	// Get the keepDeepImages
+	if ([defaults objectForKey:@"keepDeepImages"])
+		keepDeepImages = [defaults boolForKey:@"keepDeepImages"];
+	else
+		keepDeepImages = NO;
 		
 	// Get the main screen resolution
 	if (GetMainDisplayDPI(&xdpi, &ydpi)) {
@@ -353,6 +366,7 @@ CGDisplayErr GetMainDisplayDPI(CGFloat *horizontalDPI, CGFloat *verticalDPI)
 	[defaults setBool:checkForUpdates forKey:@"checkForUpdates"];
 	[defaults setBool:preciseCursor forKey:@"preciseCursor"];
 	[defaults setBool:useCoreImage forKey:@"useCoreImage"];
+	[defaults setBool:keepDeepImages forKey:@"keepDeepImages"];
 	[defaults setBool:transparentBackground forKey:@"transparentBackground"];
 	[defaults setBool:useCheckerboard forKey:@"useCheckerboard"];
 	[defaults setObject:[NSArchiver archivedDataWithRootObject:windowBackColor] forKey:@"windowBackColor"];
@@ -822,6 +836,11 @@ CGDisplayErr GetMainDisplayDPI(CGFloat *horizontalDPI, CGFloat *verticalDPI)
 	return useCoreImage;
 }
 
+- (BOOL)keepDeepImages
+{
+	return keepDeepImages;
+}
+
 - (BOOL)delayOverlay
 {
 	return NO;
@@ -472,6 +472,8 @@
 		case 240:
 		case 241:
 			[menuItem setState:[menuItem tag] == 240 + [(SeaContent *)contents type]];
+			if ([(SeaContent *)contents bps] == 16)
+				return NO;
 			break;
 		case 250:
 			if ([[contents activeLayer] hasAlpha])
@@ -493,6 +495,10 @@
 			if (!document.selection.active)
 				return NO;
 			break;
+		case 332:
+			if ([[contents activeLayer] bps] == 16)
+				return NO;
+			break;
 		case 320:
 		case 321:
 		case 322:
@@ -536,7 +542,7 @@
 			}
 			break;
 		case 380:
-			if (![[SeaController seaPlugins] hasLastEffect])
+			if (![[SeaController seaPlugins] hasLastEffect] || [(SeaContent *)contents bps] == 16)
 				return NO;
 			break;
 	}
@@ -34,6 +34,10 @@
 				The behaviour of the overlay (see SeaWhiteboard).
 	@field		spp
 				The samples per pixel to be used during compositing.
+	@field		bps
+				The bits per sample of the destination, either 8 or 16. When 16
+				the destination holds 16-bit samples, and 8-bit layers are
+				expanded as they are composited.
 */
 typedef struct {
 	BOOL forceNormal;
@@ -44,6 +48,7 @@ typedef struct {
 	int overlayOpacity;
 	BOOL overlayBehaviour;
 	int spp;
+	int bps;
 } CompositorOptions;
 
 @class SeaLayer;
@@ -86,9 +91,6 @@ NS_SWIFT_NAME(SeaCompositorProtocol)
 	__weak SeaContent *contents;
 	__weak SeaWhiteboard *whiteboard;
 #endif
-	
-	// The random table
-	int randomTable[RANDOM_TABLE_SIZE];
 }
 
 #if MAIN_COMPILE
@@ -133,7 +135,9 @@ NS_SWIFT_NAME(SeaCompositorProtocol)
 	@param		options
 				The options for compositing.
 	@param		destPtr
-				A pointer to the data the layer should be composited onto.
+				A pointer to the data the layer should be composited onto, this
+				holds 16-bit samples when the options' bps is 16. If NULL the
+				whiteboard's data (or deep data) is used.
 */
 - (void)compositeLayer:(SeaLayer *)layer withOptions:(CompositorOptions)options andData:(unsigned char *)destPtr;
 
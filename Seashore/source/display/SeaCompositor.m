@@ -15,15 +15,8 @@
 - (instancetype)initWithDocument:(id)doc
 {
 	if (self = [super init]) {
-		int i;
-		
 		// Remember the document we are compositing for
 		document = doc;
-		
-		// Work out the random table for the dissolve effect
-		srandom(RANDOM_SEED);
-		for (i = 0; i < 4096; i++)
-			randomTable[i] = random() & 0xffffffff;
 	}
 	
 	return self;
@@ -32,21 +25,239 @@
 - (instancetype)initWithContents:(SeaContent *)cont andWhiteboard:(SeaWhiteboard *)board
 {
 	if (self = [super init]) {
-		int i;
-		
 		// Remember the document we are compositing for
 		contents = cont;
 		whiteboard = board;
-		
-		// Work out the random table for the dissolve effect
-		srandom(RANDOM_SEED);
-		for (i = 0; i < 4096; i++)
-			randomTable[i] = (int)random();
 	}
 	return self;
 }
 #endif
 
+// Composites a layer at 16 bits, expanding the samples of 8-bit layers, the
+// overlay and the floating layer (if any) as they are read
+- (void)compositeDeepLayer:(SeaLayer *)layer withFloat:(SeaLayer *)floatingLayer options:(CompositorOptions)options andData:(uint16_t *)destPtr
+{
+	int lwidth = [layer width], lheight = [layer height], mode = [layer mode];
+	int lfwidth = [floatingLayer width], lfheight = [floatingLayer height];
+	int xfoff = [floatingLayer xoff], yfoff = [floatingLayer yoff];
+	int lbps = [layer bps], lfbps = [floatingLayer bps];
+#if MAIN_COMPILE
+	unsigned char *mask;
+	int opacity = [layer opacity];
+	int selectedChannel = [[document contents] selectedChannel];
+	int xoff = [layer xoff], yoff = [layer yoff], selectOpacity;
+	int t1;
+	IntPoint point, maskOffset, trueMaskOffset;
+	IntSize maskSize;
+	IntRect selectRect;
+#else
+	int opacity = [layer opacity], selectedChannel = [contents selectedChannel];
+	int xoff = [layer xoff], yoff = [layer yoff], selectOpacity;
+#endif
+	unsigned char *srcPtr, *floatPtr, *overlay, *replace;
+	int startX, startY, endX, endY;
+	int srcLoc, destLoc, floatLoc, tx, ty;
+	uint16_t tempSpace[4], tempSpace2[4], tempSpace3[4], overlaySpace[4];
+	BOOL insertOverlay, overlayOkay;
+	BOOL floating;
+	
+	// If the layer has an opacity of zero it does not need to be composited
+	if (opacity == 0)
+		return;
+	
+	// If the overlay has an opacity of zero it does not need to be inserted
+	if (options.overlayOpacity == 0)
+		insertOverlay = NO;
+	else
+		insertOverlay = options.insertOverlay;
+	
+#if MAIN_COMPILE
+	// Determine what is being copied
+	startX = MAX(options.rect.origin.x - xoff, (xoff < 0) ? -xoff : 0);
+	startY = MAX(options.rect.origin.y - yoff, (yoff < 0) ? -yoff : 0);
+	endX = MIN([[document contents] width] - xoff, lwidth);
+	endX = MIN(endX, options.rect.origin.x + options.rect.size.width - xoff);
+	endY = MIN([[document contents] height] - yoff, lheight);
+	endY = MIN(endY, options.rect.origin.y + options.rect.size.height - yoff);
+	
+	// Get some stuff we're going to use later
+	selectRect = [[document selection] localRect];
+	srcPtr = [layer data];
+	floatPtr = [floatingLayer data];
+	if (!destPtr) destPtr = [[document whiteboard] deepData];
+	overlay = [[document whiteboard] overlay];
+	replace = [[document whiteboard] replace];
+	mask = [[document selection] mask];
+	maskOffset = [[document selection] maskOffset];
+	trueMaskOffset = IntMakePoint(maskOffset.x - selectRect.origin.x, maskOffset.y -  selectRect.origin.y);
+	maskSize = [[document selection] maskSize];
+	floating = [layer isFloating];
+#else
+	// Determine what is being copied
+	startX = MAX(options.rect.origin.x - xoff, (xoff < 0) ? -xoff : 0);
+	startY = MAX(options.rect.origin.y - yoff, (yoff < 0) ? -yoff : 0);
+	endX = MIN([contents width] - xoff, lwidth);
+	endX = MIN(endX, options.rect.origin.x + options.rect.size.width - xoff);
+	endY = MIN([contents height] - yoff, lheight);
+	endY = MIN(endY, options.rect.origin.y + options.rect.size.height - yoff);
+	
+	// Get some stuff we're going to use later
+	srcPtr = [(SeaLayer *)layer data];
+	floatPtr = [floatingLayer data];
+	if (!destPtr) destPtr = [whiteboard deepData];
+	overlay = [whiteboard overlay];
+	replace = [whiteboard replace];
+	floating = [layer isFloating];
+#endif
+	
+	// Check what we are doing has a point
+	if (endX - startX <= 0) return;
+	if (endY - startY <= 0) return;
+	
+	// Go through each row
+	for (int j = startY; j < endY; j++) {
+	
+		// Go through each column
+		for (int i = startX; i < endX; i++) {
+			// Determine the location in memory of the pixel we are copying from and to
+			srcLoc = (j * lwidth + i) * options.spp;
+			destLoc = ((j + yoff - options.destRect.origin.y) * options.destRect.size.width + (i + xoff - options.destRect.origin.x)) * options.spp;
+			
+			// Prepare for overlay application
+			for (int k = 0; k < options.spp; k++)
+				tempSpace2[k] = (lbps == 16) ? ((uint16_t *)srcPtr)[srcLoc + k] : expand_sample(srcPtr[srcLoc + k]);
+			
+			if (floatingLayer) {
+				
+				// Insert floating layer
+				ty = yoff - yfoff + j;
+				tx = xoff - xfoff + i;
+				if (ty >= 0 && ty < lfheight && tx >= 0 && tx < lfwidth) {
+					floatLoc = (ty * lfwidth + tx) * options.spp;
+					for (int k = 0; k < options.spp; k++)
+						tempSpace3[k] = (lfbps == 16) ? ((uint16_t *)floatPtr)[floatLoc + k] : expand_sample(floatPtr[floatLoc + k]);
+					if (insertOverlay) {
+						switch (options.overlayBehaviour) {
+							case SeaOverlayBehaviourReplacing:
+							case SeaOverlayBehaviourMasking:
+								selectOpacity = replace[ty * lfwidth + tx];
+								break;
+								
+							default:
+								selectOpacity = options.overlayOpacity;
+								break;
+						}
+						if (selectOpacity > 0) {
+							for (int k = 0; k < options.spp; k++)
+								overlaySpace[k] = expand_sample(overlay[floatLoc + k]);
+							SeaPrimaryMerge16(options.spp, tempSpace3, 0, overlaySpace, 0, selectOpacity, YES);
+						}
+					}
+					if (selectedChannel == kAllChannels) {
+						SeaNormalMerge16(options.spp, tempSpace2, 0, tempSpace3, 0, 255);
+					} else if (selectedChannel == kPrimaryChannels) {
+						SeaPrimaryMerge16(options.spp, tempSpace2, 0, tempSpace3, 0, 255, YES);
+					} else if (selectedChannel == kAlphaChannel) {
+						SeaAlphaMerge16(options.spp, tempSpace2, 0, tempSpace3, 0, 255);
+					}
+				}
+				
+			} else if (insertOverlay) {
+				
+				// Check if we should apply the overlay for this pixel
+				overlayOkay = NO;
+				switch (options.overlayBehaviour) {
+					case SeaOverlayBehaviourReplacing:
+					case SeaOverlayBehaviourMasking:
+						selectOpacity = replace[j * lwidth + i];
+						break;
+						
+					default:
+						selectOpacity = options.overlayOpacity;
+						break;
+				}
+#if MAIN_COMPILE
+				if (options.useSelection) {
+					point.x = i;
+					point.y = j;
+					if (IntPointInRect(point, selectRect)) {
+						overlayOkay = YES;
+						if (mask && !floating)
+							selectOpacity = int_mult(selectOpacity, mask[(trueMaskOffset.y + point.y) * maskSize.width + (trueMaskOffset.x + point.x)], t1);
+					}
+				} else {
+					overlayOkay = YES;
+				}
+#else
+				overlayOkay = YES;
+#endif
+				
+				// Don't do anything if there's no point
+				if (selectOpacity == 0)
+					overlayOkay = NO;
+				
+				// Apply the overlay if we get the okay
+				if (overlayOkay) {
+					for (int k = 0; k < options.spp; k++)
+						overlaySpace[k] = expand_sample(overlay[srcLoc + k]);
+					if (selectedChannel == kAllChannels && !floating) {
+						switch (options.overlayBehaviour) {
+							case SeaOverlayBehaviourErasing:
+								SeaEraseMerge16(options.spp, tempSpace2, 0, overlaySpace, 0, selectOpacity);
+								break;
+								
+							case SeaOverlayBehaviourReplacing:
+								SeaReplaceMerge16(options.spp, tempSpace2, 0, overlaySpace, 0, selectOpacity);
+								break;
+								
+							default:
+								SeaSpecialMerge16(options.spp, tempSpace2, 0, overlaySpace, 0, selectOpacity);
+								break;
+						}
+					} else if (selectedChannel == kPrimaryChannels || floating) {
+						switch (options.overlayBehaviour) {
+							case SeaOverlayBehaviourReplacing:
+								SeaReplacePrimaryMerge16(options.spp, tempSpace2, 0, overlaySpace, 0, selectOpacity);
+								break;
+								
+							default:
+								SeaPrimaryMerge16(options.spp, tempSpace2, 0, overlaySpace, 0, selectOpacity, YES);
+								break;
+						}
+					} else if (selectedChannel == kAlphaChannel) {
+						switch (options.overlayBehaviour) {
+							case SeaOverlayBehaviourReplacing:
+								SeaReplaceAlphaMerge16(options.spp, tempSpace2, 0, overlaySpace, 0, selectOpacity);
+								break;
+								
+							default:
+								SeaAlphaMerge16(options.spp, tempSpace2, 0, overlaySpace, 0, selectOpacity);
+								break;
+						}
+					}
+				}
+			}
+			
+			// If the layer is going to use a compositing effect...
+			if (normal == NO && mode != XCF_NORMAL_MODE && options.forceNormal == NO) {
+				// Copy pixel from destination in to temporary memory
+				for (int k = 0; k < options.spp; k++)
+					tempSpace[k] = destPtr[destLoc + k];
+				
+				// Apply the appropriate effect using the source pixel
+				SeaSelectMerge16(mode, options.spp, tempSpace, 0, tempSpace2, 0, i + xoff, j + yoff);
+				
+				// Then merge the pixel in temporary memory with the destination pixel
+				SeaNormalMerge16(options.spp, destPtr, destLoc, tempSpace, 0, opacity);
+			} else {
+				// Then merge the pixel in temporary memory with the destination pixel
+				SeaNormalMerge16(options.spp, destPtr, destLoc, tempSpace2, 0, opacity);
+			}
+		}
+	}
+}
+
+
 - (void)compositeLayer:(SeaLayer *)layer withOptions:(CompositorOptions)options
 {
 	[self compositeLayer: layer withOptions: options andData: NULL];
@@ -75,6 +286,12 @@
 	BOOL insertOverlay, overlayOkay;
 	BOOL floating;
 
+	// Deep documents are composited at 16 bits
+	if (options.bps == 16) {
+		[self compositeDeepLayer:layer withFloat:NULL options:options andData:(uint16_t *)destPtr];
+		return;
+	}
+	
 	// If the layer has an opacity of zero it does not need to be composited
 	if (opacity == 0)
 		return;
@@ -134,13 +351,6 @@
 	// Go through each row
 	for (int j = startY; j < endY; j++) {
 	
-		// Disolving requires us to play with the random number generator
-		if (mode == XCF_DISSOLVE_MODE) {
-			srandom(randomTable[(j + yoff) % 4096]);
-			for (int k = 0; k < xoff; k++)
-				random();
-		}
-		
 		// Go through each column
 		for (int i = startX; i < endX; i++) {
 			// Determine the location in memory of the pixel we are copying from and to
@@ -235,7 +445,7 @@
 					tempSpace[k] = destPtr[destLoc + k];
 				
 				// Apply the appropriate effect using the source pixel
-				SeaSelectMerge(mode, options.spp, tempSpace, 0, tempSpace2, 0);
+				SeaSelectMerge(mode, options.spp, tempSpace, 0, tempSpace2, 0, i + xoff, j + yoff);
 				
 				// Then merge the pixel in temporary memory with the destination pixel
 				SeaNormalMerge(options.spp, destPtr, destLoc, tempSpace, 0, opacity);
@@ -273,6 +483,12 @@
 #endif
 	BOOL floating;
 	
+	// Deep documents are composited at 16 bits
+	if (options.bps == 16) {
+		[self compositeDeepLayer:layer withFloat:floatingLayer options:options andData:NULL];
+		return;
+	}
+	
 	// If the layer has an opacity of zero it does not need to be composited
 	if (opacity == 0)
 		return;
@@ -333,13 +549,6 @@
 	
 	// Go through each row
 	for (int j = startY; j < endY; j++) {
-		// Disolving requires us to play with the random number generator
-		if (mode == XCF_DISSOLVE_MODE) {
-			srandom(randomTable[(j + yoff) % 4096]);
-			for (int k = 0; k < xoff; k++)
-				random();
-		}
-		
 		// Go through each column
 		for (int i = startX; i < endX; i++) {
 			// Determine the location in memory of the pixel we are copying from and to
@@ -390,7 +599,7 @@
 					tempSpace[k] = destPtr[destLoc + k];
 				
 				// Apply the appropriate effect using the source pixel
-				SeaSelectMerge(mode, options.spp, tempSpace, 0, tempSpace2, 0);
+				SeaSelectMerge(mode, options.spp, tempSpace, 0, tempSpace2, 0, i + xoff, j + yoff);
 				
 				// Then merge the pixel in temporary memory with the destination pixel
 				SeaNormalMerge(options.spp, destPtr, destLoc, tempSpace, 0, opacity);
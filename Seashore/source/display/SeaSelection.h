@@ -63,11 +63,12 @@ NS_ASSUME_NONNULL_BEGIN
 	/// Used to determine if the selection is active
 	BOOL active;
 	
-	// Help present the user with a visual representation of the mask
-	int selectionColorIndex;
-	unsigned char *maskBitmap;
-	NSBitmapImageRep *maskBitmapRep;
-	NSImage *maskImage;
+	// The outline and coverage of the mask used to present it to the user (made when first needed)
+	NSBezierPath *maskOutline;
+	CGImageRef maskCoverage;
+	
+	/// Counts the changes made to the selection's mask and position
+	NSUInteger revision;
 	
 	// The point of the last copied selection and its size
 	IntPoint sel_point;
@@ -109,11 +110,35 @@ NS_ASSUME_NONNULL_BEGIN
 @property (readonly, nullable) unsigned char *mask NS_RETURNS_INNER_POINTER;
 
 /*!
-	@property	maskImage
-	@discussion	Returns an image of the mask in the current selection colour.
-				This is used so the selection can be represented to users.
+	@property	maskOutline
+	@discussion	Returns the boundary between the selected and unselected parts
+				of the mask as closed contours following the pixel edges, in the
+				mask's co-ordinates, counting pixels at least half selected as
+				selected. This is used to draw the marching ants around the
+				selection.
+	@result		Returns the outline or NULL if there is no mask.
+*/
+@property (readonly, nullable) NSBezierPath *maskOutline;
+
+/*!
+	@property	maskCoverage
+	@discussion	Returns an image mask over the mask itself, without copying it,
+				that paints the unselected parts of the mask by how unselected
+				they are. Drawn in the selection colour it tints feathered and
+				anti-aliased edges by their exact coverage.
+	@result		Returns the image mask or NULL if there is no mask.
+*/
+@property (readonly, nullable) CGImageRef maskCoverage CF_RETURNS_NOT_RETAINED;
+
+/*!
+	@property	revision
+	@discussion	Returns a number that changes whenever the selection's mask,
+				rectangle or position is changed (including when the mask is
+				changed in place), so results derived from the selection can be
+				cached against it.
+	@result		Returns the revision of the selection.
 */
-@property (readonly, strong) NSImage *maskImage;
+@property (readonly) NSUInteger revision;
 
 /*!
 	@property	maskOffset
@@ -204,6 +229,19 @@ NS_ASSUME_NONNULL_BEGIN
 */
 - (void)selectOverlay:(BOOL)destructively inRect:(IntRect)selectionRect mode:(SeaSelectMode)mode NS_SWIFT_NAME(selectOverlay(destructively:in:mode:));
 
+/*!
+	@method		selectMask:inRect:mode:
+	@discussion Selects the area given by a mask of the active layer.
+	@param		layerMask
+				The mask, one byte for each pixel of the active layer.
+	@param		selectionRect
+				The rectangle contianing the section of the mask to be
+				considered for selection.
+	@param		mode
+				The mode of the selection (see above).
+*/
+- (void)selectMask:(unsigned char *)layerMask inRect:(IntRect)selectionRect mode:(SeaSelectMode)mode NS_SWIFT_NAME(selectMask(_:in:mode:));
+
 /*!
 	@method		selectOpaque
 	@discussion	Selects the opaque parts of the active layer.
@@ -16,9 +16,92 @@
 #import "SeaFlip.h"
 #include <GIMPCore/GIMPCore.h>
 
+@interface SeaSelection ()
+- (void)selectAlphaOf:(unsigned char *)overlay spp:(int)spp destructively:(BOOL)destructively inRect:(IntRect)selectionRect mode:(SeaSelectMode)mode;
+- (void)discardMaskImages;
+@end
+
+// The directions the outline can take from a corner, clockwise on screen
+enum {
+	kOutlineRight,
+	kOutlineDown,
+	kOutlineLeft,
+	kOutlineUp
+};
+
+static inline BOOL maskCovers(const unsigned char *mask, int width, int height, int x, int y)
+{
+	return x >= 0 && y >= 0 && x < width && y < height && mask[y * width + x] >= 0x80;
+}
+
+// Whether the outline leaves a pixel corner in the given direction, keeping the selected pixels on its right
+static inline BOOL outlineLeaves(const unsigned char *mask, int width, int height, int x, int y, int direction)
+{
+	switch (direction) {
+		case kOutlineRight:
+			return maskCovers(mask, width, height, x, y) && !maskCovers(mask, width, height, x, y - 1);
+		case kOutlineDown:
+			return maskCovers(mask, width, height, x - 1, y) && !maskCovers(mask, width, height, x, y);
+		case kOutlineLeft:
+			return maskCovers(mask, width, height, x - 1, y - 1) && !maskCovers(mask, width, height, x - 1, y);
+		default:
+			return maskCovers(mask, width, height, x, y - 1) && !maskCovers(mask, width, height, x - 1, y - 1);
+	}
+}
+
+// Marches around the pixel corners of the mask, joining the edges between
+// selected and unselected pixels into closed contours (only the corners are
+// kept, so the path grows with the selection's perimeter rather than its area)
+static NSBezierPath *traceOutline(const unsigned char *mask, int width, int height)
+{
+	static const int dx[4] = { 1, 0, -1, 0 }, dy[4] = { 0, 1, 0, -1 };
+	static const int turns[3] = { 1, 0, 3 };
+	NSBezierPath *path = [NSBezierPath bezierPath];
+	unsigned char *visited;
+	int x, y, cx, cy, direction, next = kOutlineRight, t;
+	size_t corner;
+	
+	// Every contour has a rightward edge, so remember which have been traced
+	visited = calloc(((size_t)(width + 1) * (height + 1) + 7) / 8, 1);
+	for (y = 0; y <= height; y++) {
+		for (x = 0; x < width; x++) {
+			corner = (size_t)y * (width + 1) + x;
+			if ((visited[corner / 8] & (1 << (corner % 8))) || !outlineLeaves(mask, width, height, x, y, kOutlineRight))
+				continue;
+			
+			// Follow the contour back to where it started, turning right
+			// where there is a choice so diagonal pixels stay apart
+			[path moveToPoint:NSMakePoint(x, y)];
+			cx = x; cy = y;
+			direction = kOutlineRight;
+			do {
+				if (direction == kOutlineRight) {
+					corner = (size_t)cy * (width + 1) + cx;
+					visited[corner / 8] |= 1 << (corner % 8);
+				}
+				cx += dx[direction];
+				cy += dy[direction];
+				for (t = 0; t < 3; t++) {
+					next = (direction + turns[t]) % 4;
+					if (outlineLeaves(mask, width, height, cx, cy, next))
+						break;
+				}
+				if (next != direction)
+					[path lineToPoint:NSMakePoint(cx, cy)];
+				direction = next;
+			} while (cx != x || cy != y || direction != kOutlineRight);
+			[path closePath];
+		}
+	}
+	free(visited);
+	
+	return path;
+}
+
 @implementation SeaSelection
 @synthesize globalRect;
 @synthesize mask;
+@synthesize revision;
 @synthesize active;
 @synthesize selectionPoint = sel_point;
 
@@ -38,11 +121,9 @@
 
 - (void)dealloc
 {
+	[self discardMaskImages];
 	if (mask)
 		free(mask);
-	if (maskBitmap) {
-		free(maskBitmap);
-	}
 }
 
 - (BOOL)isFloating
@@ -50,27 +131,36 @@
 	return document.contents.activeLayer.floating;
 }
 
-- (NSImage *)maskImage
+- (NSBezierPath *)maskOutline
 {
-	unsigned char basePixel[3];
-	NSColor *selectionColor;
+	if (mask && !maskOutline)
+		maskOutline = traceOutline(mask, rect.size.width, rect.size.height);
 	
-	if (maskImage && selectionColorIndex != [[SeaController seaPrefs] selectionColorIndex]) {
-		selectionColor = [[SeaController seaPrefs] selectionColor:0.4];
-		basePixel[0] = round([selectionColor redComponent] * 255.0);
-		basePixel[1] = round([selectionColor greenComponent] * 255.0);
-		basePixel[2] = round([selectionColor blueComponent] * 255.0);
-		for (int i = 0; i < rect.size.width * rect.size.height; i++) {
-			maskBitmap[i * 4] = basePixel[0];
-			maskBitmap[i * 4 + 1] = basePixel[1];
-			maskBitmap[i * 4 + 2] = basePixel[2];
-		}
-		SeaPremultiplyBitmap(4, maskBitmap, maskBitmap, rect.size.width * rect.size.height);
-		selectionColorIndex = [[SeaController seaPrefs] selectionColorIndex];
+	return maskOutline;
+}
+
+- (CGImageRef)maskCoverage
+{
+	CGDataProviderRef provider;
+	
+	if (mask && !maskCoverage) {
+		// Image masks paint where their samples are low, so the mask serves as it is
+		provider = CGDataProviderCreateWithData(NULL, mask, (size_t)rect.size.width * rect.size.height, NULL);
+		maskCoverage = CGImageMaskCreate(rect.size.width, rect.size.height, 8, 8, rect.size.width, provider, NULL, false);
+		CGDataProviderRelease(provider);
 	}
-	[maskImage setFlipped:YES];
 	
-	return maskImage;
+	return maskCoverage;
+}
+
+- (void)discardMaskImages
+{
+	// The coverage refers to the mask so must go whenever the mask changes or is freed
+	maskOutline = NULL;
+	if (maskCoverage) {
+		CGImageRelease(maskCoverage);
+		maskCoverage = NULL;
+	}
 }
 
 - (IntPoint)maskOffset
@@ -105,31 +195,6 @@
 	return localRect;
 }
 
-- (void)updateMaskImage
-{
-	unsigned char basePixel[3];
-	NSColor *selectionColor;
-	
-	if (mask) {
-		selectionColorIndex = [[SeaController seaPrefs] selectionColorIndex];
-		selectionColor = [[SeaController seaPrefs] selectionColor:0.4];
-		maskBitmap = malloc(rect.size.width * rect.size.height * 4);
-		basePixel[0] = round([selectionColor redComponent] * 255.0);
-		basePixel[1] = round([selectionColor greenComponent] * 255.0);
-		basePixel[2] = round([selectionColor blueComponent] * 255.0);
-		for (int i = 0; i < rect.size.width * rect.size.height; i++) {
-			maskBitmap[i * 4] = basePixel[0];
-			maskBitmap[i * 4 + 1] = basePixel[1];
-			maskBitmap[i * 4 + 2] = basePixel[2];
-			maskBitmap[i * 4 + 3] = 0xFF - mask[i];
-		}
-		SeaPremultiplyBitmap(4, maskBitmap, maskBitmap, rect.size.width * rect.size.height);
-		maskBitmapRep = [[NSBitmapImageRep alloc] initWithBitmapDataPlanes:&maskBitmap pixelsWide:rect.size.width pixelsHigh:rect.size.height bitsPerSample:8 samplesPerPixel:4 hasAlpha:YES isPlanar:NO colorSpaceName:NSDeviceRGBColorSpace bytesPerRow:rect.size.width * 4 bitsPerPixel:8 * 4];
-		maskImage = [[NSImage alloc] init];
-		[maskImage addRepresentation:maskBitmapRep];
-	}
-}
-
 - (void)selectRect:(IntRect)selectionRect mode:(SeaSelectMode)mode
 {
 	SeaLayer *layer = [[document contents] activeLayer];
@@ -225,7 +290,8 @@
 		
 	// Free previous mask information 
 	if (mask) { free(mask); mask = NULL; }
-	if (maskBitmap) { free(maskBitmap); maskBitmap = NULL;  maskImage = NULL; }
+	[self discardMaskImages];
+	revision++;
 
 	// Commit the new stuff
 	rect.origin.x += [layer xoff];
@@ -235,7 +301,6 @@
 	if (active) {
 		mask = newMask;
 		[self trimSelection];
-		[self updateMaskImage];
 	} else {
 		free(newMask);
 	}
@@ -350,7 +415,8 @@
 		
 	// Free previous mask information 
 	if (mask) { free(mask); mask = NULL; }
-	if (maskBitmap) { free(maskBitmap); maskBitmap = NULL;  maskImage = NULL; }
+	[self discardMaskImages];
+	revision++;
 
 	// Commit the new stuff
 	rect.origin.x += [layer xoff];
@@ -360,7 +426,6 @@
 	if (active) {
 		mask = newMask;
 		[self trimSelection];
-		[self updateMaskImage];
 	} else {
 		free(newMask);
 	}
@@ -504,7 +569,8 @@
 		
 	// Free previous mask information 
 	if (mask) { free(mask); mask = NULL; }
-	if (maskBitmap) { free(maskBitmap); maskBitmap = NULL;  maskImage = NULL; }
+	[self discardMaskImages];
+	revision++;
 
 	// Commit the new stuff
 	rect.origin.x += [layer xoff];
@@ -514,7 +580,6 @@
 	if (active) {
 		mask = newMask;
 		[self trimSelection];
-		[self updateMaskImage];
 	} else {
 		free(newMask);
 	}
@@ -524,11 +589,20 @@
 }
 
 - (void)selectOverlay:(BOOL)destructively inRect:(IntRect)selectionRect mode:(SeaSelectMode)mode
+{
+	[self selectAlphaOf:[[document whiteboard] overlay] spp:[[document contents] spp] destructively:destructively inRect:selectionRect mode:mode];
+}
+
+- (void)selectMask:(unsigned char *)layerMask inRect:(IntRect)selectionRect mode:(SeaSelectMode)mode
+{
+	[self selectAlphaOf:layerMask spp:1 destructively:NO inRect:selectionRect mode:mode];
+}
+
+- (void)selectAlphaOf:(unsigned char *)overlay spp:(int)spp destructively:(BOOL)destructively inRect:(IntRect)selectionRect mode:(SeaSelectMode)mode
 {
 	SeaLayer *layer = [[document contents] activeLayer];
 	int width = [layer width], height = [layer height];
-	int spp = [[document contents] spp];
-	unsigned char *overlay, *newMask, oldMaskPoint, newMaskPoint;
+	unsigned char *newMask, oldMaskPoint, newMaskPoint;
 	IntRect newRect, oldRect;
 	int tempMask, tempMaskProduct;
 	
@@ -549,7 +623,6 @@
 	
 	newMask = malloc(rect.size.width * rect.size.height);
 	memset(newMask, 0x00, rect.size.width * rect.size.height);
-	overlay = [[document whiteboard] overlay];
 	for (int i = rect.origin.x; i < rect.size.width + rect.origin.x; i++) {
 		for (int j = rect.origin.y; j < rect.size.height + rect.origin.y; j++) {
 			if (mode) {
@@ -618,7 +691,8 @@
 	
 	// Free previous mask information 
 	if (mask) { free(mask); mask = NULL; }
-	if (maskBitmap) { free(maskBitmap); maskBitmap = NULL;  maskImage = NULL; }
+	[self discardMaskImages];
+	revision++;
 
 	// Commit the new stuff
 	rect.origin.x += [layer xoff];
@@ -628,7 +702,6 @@
 	if (active) {
 		mask = newMask;
 		[self trimSelection];
-		[self updateMaskImage];
 	} else {
 		free(newMask);
 	}
@@ -645,7 +718,8 @@
 
 	// Free previous mask information
 	if (mask) { free(mask); mask = NULL; }
-	if (maskBitmap) { free(maskBitmap); maskBitmap = NULL;  maskImage = NULL; }
+	[self discardMaskImages];
+	revision++;
 	
 	// Adjust the rectangle
 	rect = IntMakeRect([layer xoff], [layer yoff], [layer width], [layer height]);
@@ -656,11 +730,16 @@
 	
 	// Make the mask
 	mask = malloc(rect.size.width * rect.size.height);
-	for (int i = 0; i < rect.size.width * rect.size.height; i++) {
-		mask[i] = data[(i + 1) * spp - 1];
+	if ([layer bps] == 16) {
+		for (int i = 0; i < rect.size.width * rect.size.height; i++)
+			mask[i] = narrow_sample(((uint16_t *)data)[(i + 1) * spp - 1]);
+	}
+	else {
+		for (int i = 0; i < rect.size.width * rect.size.height; i++) {
+			mask[i] = data[(i + 1) * spp - 1];
+		}
 	}
 	[self trimSelection];
-	[self updateMaskImage];
 	
 	// Make the change
 	[[document helpers] selectionChanged];
@@ -679,6 +758,7 @@
 	rect.origin.y += [layer yoff];
 	globalRect.origin.x += [layer xoff];
 	globalRect.origin.y += [layer yoff];
+	revision++;
 	
 	// Make the change
 	[[document helpers] selectionChanged];
@@ -691,8 +771,10 @@
 	
 	layerRect = IntMakeRect([layer xoff], [layer yoff], [layer width], [layer height]);
 	globalRect = IntConstrainRect(rect, layerRect);
+	revision++;
 	if (globalRect.size.width == 0 || globalRect.size.height == 0) {
 		active = NO;
+		[self discardMaskImages];
 		if (mask) { free(mask); mask = NULL; }
 	}
 }
@@ -702,7 +784,8 @@
 	if (![self isFloating]) {
 		active = NO;
 		if (mask) { free(mask); mask = NULL; }
-		if (maskBitmap) { free(maskBitmap); maskBitmap = NULL;  maskImage = NULL; }
+		[self discardMaskImages];
+		revision++;
 		[[document helpers] selectionChanged];
 	}
 }
@@ -766,9 +849,9 @@
 	globalRect = rect;
 	if (rect.size.width > 0 && rect.size.height > 0) {
 		active = YES;
-		if (maskBitmap) { free(maskBitmap); maskBitmap = NULL;  maskImage = NULL; }
+		[self discardMaskImages];
+		revision++;
 		[self trimSelection];
-		[self updateMaskImage];
 	} else {
 		active = NO;
 	}
@@ -777,37 +860,14 @@
 
 - (void)flipSelection:(SeaFlipType)type
 {
-	unsigned char tmp;
-	int src, dest;
-	
 	// There's nothing to do if there's no mask
 	if (mask) {
 	
-		if (type == kHorizontalFlip) {
-			for (int i = 0; i < rect.size.width / 2; i++) {
-				for (int j = 0; j < rect.size.height; j++) {
-					src = j * rect.size.width + rect.size.width - i - 1;
-					dest = j * rect.size.width + i;
-					tmp = mask[dest];
-					mask[dest] = mask[src];
-					mask[src] = tmp;
-				}
-			}
-		} else {
-			for (int i = 0; i < rect.size.width; i++) {
-				for (int j = 0; j < rect.size.height / 2; j++) {
-					src = (rect.size.height - j - 1) * rect.size.width + i;
-					dest = j * rect.size.width + i;
-					tmp = mask[dest];
-					mask[dest] = mask[src];
-					mask[src] = tmp;
-				}
-			}
-		}
+		SeaFlipBitmap(1, mask, rect.size.width, rect.size.height, rect.size.width, type == kHorizontalFlip);
 		
-		if (maskBitmap) { free(maskBitmap); maskBitmap = NULL;  maskImage = NULL; }
+		[self discardMaskImages];
+		revision++;
 		[self trimSelection];
-		[self updateMaskImage];
 		[[document helpers] selectionChanged];
 
 	}
@@ -825,11 +885,14 @@
 	// Get the selected channel
 	selectedChannel = [[document contents] selectedChannel];
 	
-	// Copy the image data
+	// Copy the image data, narrowing the samples of 16-bit layers
 	destPtr = malloc(make_128(globalRect.size.width * globalRect.size.height * spp));
 	srcPtr = [layer data];
 	for (int i = 0; i < globalRect.size.height; i++) {
-		memcpy(&(destPtr[i * globalRect.size.width * spp]), &(srcPtr[((i + localRect.origin.y) * width + localRect.origin.x) * spp]), globalRect.size.width * spp); 
+		if ([layer bps] == 16)
+			SeaNarrowSamples(&(destPtr[i * globalRect.size.width * spp]), &(((uint16_t *)srcPtr)[((i + localRect.origin.y) * width + localRect.origin.x) * spp]), globalRect.size.width * spp);
+		else
+			memcpy(&(destPtr[i * globalRect.size.width * spp]), &(srcPtr[((i + localRect.origin.y) * width + localRect.origin.x) * spp]), globalRect.size.width * spp); 
 	}
 	
 	// Apply the mask
@@ -943,6 +1006,7 @@
 			memcpy(&(overlay[((localRect.origin.y + j) * width + (localRect.origin.x + i)) * spp]), &basePixel, spp);
 		}
 	}
+	[[document whiteboard] touchOverlay:localRect];
 	
 	// Apply the overlay
 	[[document helpers] applyOverlay];
@@ -954,6 +1018,7 @@
 	rect.origin.y += offset.y;
 	globalRect.origin.x += offset.x;
 	globalRect.origin.y += offset.y;
+	revision++;
 }
 
 - (void)scaleSelectionHorizontally:(float)xScale vertically:(float)yScale interpolation:(GimpInterpolationType)interpolation
@@ -1008,10 +1073,8 @@
 		// Substitute in the new stuff
 		rect = newRect;
 		[self readjustSelection];
-		if (mask) {
-			if (maskBitmap) { free(maskBitmap); maskBitmap = NULL;  maskImage = NULL; }
-			[self updateMaskImage];
-		}
+		[self discardMaskImages];
+		revision++;
 		[[document docView] setNeedsDisplay: YES];
 	}
 }
@@ -1079,6 +1142,7 @@
 			globalRect = rect;			
 			newMask = malloc(newWidth * newHeight);
 			memset(newMask, 0xFF, newWidth * newHeight);
+			[self discardMaskImages];
 			free(mask);
 			mask = newMask;
 		} else {
@@ -1095,6 +1159,7 @@
 				
 				// Finally make the change
 				rect = IntMakeRect(rect.origin.x + selectionLeft, rect.origin.y + selectionTop, newWidth, newHeight);
+				[self discardMaskImages];
 				free(mask);
 				mask = newMask;
 				globalRect = rect;
@@ -57,6 +57,9 @@ typedef NS_ENUM(int, SeaHandleType) {
 	// Is this a line draw? (sent to mouseDragged methods)
 	BOOL lineDraw;
 	
+	// Was the mouse down refused by a tool that cannot work in 16-bit documents?
+	BOOL toolRefused;
+	
 	// Is scrolling mode active?
 	BOOL scrollingMode;
 	
@@ -251,6 +254,15 @@ typedef NS_ENUM(int, SeaHandleType) {
 */
 - (void)drawDragHandles:(NSRect) rect type: (SeaHandleType)type;
 
+/*!
+ @method		drawMarchingAnts:
+ @discussion	Strokes the given path with the black and white dashes used for the
+				outlines of selections.
+ @param			path
+				The path to stroke, its line dash is changed.
+*/
+- (void)drawMarchingAnts:(NSBezierPath *)path;
+
 /*!
  @method		drawHandles:type:
  @discussion	Draws the proper type of resize of a drag handle onto the given point. 
@@ -286,10 +286,9 @@ static NSString*	SelectAlphaToolbarItemIdentifier = @"Select Alpha Toolbar Item
 	int curToolIndex = [tUtil tool];
 	IntRect imageRect = [[document whiteboard] imageRect];
 	int xres = [[document contents] xres], yres = [[document contents] yres];
-	CGFloat xResScale, yResScale;
+	CGFloat xResScale, yResScale, xReduction, yReduction;
+	BOOL zoomedOut;
 
-	// Get the correct image for displaying
-	image = [[document whiteboard] image];
 	srcRect = destRect = rect;
 	
 	// Set the background color
@@ -306,9 +305,6 @@ static NSString*	SelectAlphaToolbarItemIdentifier = @"Select Alpha Toolbar Item
 		[[NSBezierPath bezierPathWithRect:destRect] fill];
 	}
 	
-	// We want our image flipped
-	[image setFlipped:YES];
-	
 	// For non 72 dpi resolutions we must scale here
 	xResScale = yResScale = 1.0;
 	if (SeaScreenResolution.x != 0 && SeaScreenResolution.y != 0) {
@@ -334,9 +330,22 @@ static NSString*	SelectAlphaToolbarItemIdentifier = @"Select Alpha Toolbar Item
 	srcRect.origin.x -= imageRect.origin.x;
 	srcRect.origin.y -= imageRect.origin.y;
 	
+	// Get the correct image for displaying, when zoomed out this is a reduction of the whiteboard
+	zoomedOut = (srcRect.size.width > destRect.size.width);
+	image = [[document whiteboard] imageForScale:MIN(destRect.size.width / srcRect.size.width, destRect.size.height / srcRect.size.height)];
+	xReduction = [image size].width / imageRect.size.width;
+	yReduction = [image size].height / imageRect.size.height;
+	srcRect.origin.x *= xReduction;
+	srcRect.size.width *= xReduction;
+	srcRect.origin.y *= yReduction;
+	srcRect.size.height *= yReduction;
+	
+	// The image is shared so rather than flipping it measure from its bottom
+	srcRect.origin.y = [image size].height - srcRect.origin.y - srcRect.size.height;
+	
 	// Set interpolation (image smoothing) appropriately
 	if ([[SeaController seaPrefs] smartInterpolation]) {
-		if (srcRect.size.width > destRect.size.width || (SeaScreenResolution.x > 72 && (xres / 72.0) * zoom <= 4))
+		if (zoomedOut || (SeaScreenResolution.x > 72 && (xres / 72.0) * zoom <= 4))
 			[[NSGraphicsContext currentContext] setImageInterpolation:NSImageInterpolationHigh];
 		else
 			[[NSGraphicsContext currentContext] setImageInterpolation:NSImageInterpolationNone];
@@ -346,7 +355,7 @@ static NSString*	SelectAlphaToolbarItemIdentifier = @"Select Alpha Toolbar Item
 	}
 	
 	// Draw the image to screen
-	[image drawInRect:destRect fromRect:srcRect operation:NSCompositeSourceOver fraction:1.0];
+	[image drawInRect:destRect fromRect:srcRect operation:NSCompositeSourceOver fraction:1.0 respectFlipped:YES hints:nil];
 
 	// Clear out the old cursor rects
 	[self needsCursorsReset];
@@ -410,13 +419,17 @@ static NSString*	SelectAlphaToolbarItemIdentifier = @"Select Alpha Toolbar Item
 - (void)drawSelectBoundaries
 {
 	CGFloat xScale, yScale;
-	NSRect tempRect, srcRect;
+	NSRect tempRect;
 	IntRect selectRect, tempSelectRect;
 	int xoff, yoff, width, height, lwidth, lheight;
 	BOOL useSelection, special, intermediate;
 	int curToolIndex = (int)[(ToolboxUtility *)[(UtilitiesManager *)[SeaController utilitiesManager] toolboxUtilityFor:document] tool];
 	NSBezierPath *tempPath;
-	NSImage *maskImage;
+	NSAffineTransform *transform;
+	CGImageRef maskCoverage;
+	CGContextRef context;
+	IntPoint maskOffset;
+	IntSize maskSize;
 	int radius = 0;
 	CGFloat revCurveRadius, f;
 
@@ -470,13 +483,29 @@ static NSString*	SelectAlphaToolbarItemIdentifier = @"Select Alpha Toolbar Item
 		[tempPath setWindingRule:NSEvenOddWindingRule];
 		[tempPath fill];
 		
-		// Draw the mask image
-		maskImage = [[document selection] maskImage];
-		srcRect.origin = IntPointMakeNSPoint([[document selection] maskOffset]);
-		srcRect.size = IntSizeMakeNSSize(selectRect.size);
-		if (floor(NSAppKitVersionNumber) <= NSAppKitVersionNumber10_2)
-			srcRect.origin.y = [[document selection] maskSize].height - (srcRect.origin.y + srcRect.size.height);
-		[maskImage drawInRect:tempRect fromRect:srcRect operation:NSCompositeSourceOver fraction:0.4];
+		// Tint the unselected parts of the mask by their coverage and march the ants around its outline
+		maskCoverage = [[document selection] maskCoverage];
+		if (maskCoverage) {
+			maskOffset = [[document selection] maskOffset];
+			maskSize = [[document selection] maskSize];
+			[NSGraphicsContext saveGraphicsState];
+			[NSBezierPath clipRect:tempRect];
+			
+			// The view is flipped so the image is drawn upside down into it
+			context = [[NSGraphicsContext currentContext] graphicsPort];
+			CGContextSaveGState(context);
+			CGContextSetInterpolationQuality(context, kCGInterpolationNone);
+			CGContextTranslateCTM(context, (selectRect.origin.x - maskOffset.x) * xScale, (selectRect.origin.y - maskOffset.y + maskSize.height) * yScale);
+			CGContextScaleCTM(context, 1.0, -1.0);
+			CGContextDrawImage(context, CGRectMake(0, 0, maskSize.width * xScale, maskSize.height * yScale), maskCoverage);
+			CGContextRestoreGState(context);
+			
+			transform = [NSAffineTransform transform];
+			[transform scaleXBy:xScale yBy:yScale];
+			[transform translateXBy:selectRect.origin.x - maskOffset.x yBy:selectRect.origin.y - maskOffset.y];
+			[self drawMarchingAnts:[transform transformBezierPath:[[document selection] maskOutline]]];
+			[NSGraphicsContext restoreGraphicsState];
+		}
 
 		// If the currently selected tool is a selection tool, draw the handles
 		if(curToolIndex >= kFirstSelectionTool && curToolIndex <= kLastSelectionTool){
@@ -506,14 +535,7 @@ static NSString*	SelectAlphaToolbarItemIdentifier = @"Select Alpha Toolbar Item
 		tempRect.origin.x += xoff; tempRect.origin.y += yoff;
 		tempRect.origin.x *= xScale; tempRect.origin.y *= yScale; tempRect.size.width *= xScale; tempRect.size.height *= yScale; 
 		tempPath = [NSBezierPath bezierPathWithOvalInRect:tempRect];
-		CGFloat black[4] = {0,.5,2,3.5};
-		[[NSColor blackColor] set];
-		[tempPath setLineDash: black count: 4 phase: 0.0];
-		[tempPath stroke];
-		CGFloat white[4] = {0,3.5,2,.5};
-		[[NSColor whiteColor] set];
-		[tempPath setLineDash: white count: 4 phase: 0.0];
-		[tempPath stroke];
+		[self drawMarchingAnts:tempPath];
 	} else if (curToolIndex == kRectSelectTool && intermediate) {
 		// The rectangle tool is being dragged, so draw its marching ants
 		tempSelectRect = [(RectSelectTool *)[[document tools] currentTool] selectionRect];
@@ -549,14 +571,7 @@ static NSString*	SelectAlphaToolbarItemIdentifier = @"Select Alpha Toolbar Item
 		}
 		
 		// The marching ants themselves
-		CGFloat black[4] = {0,.5,2,3.5};
-		[[NSColor blackColor] set];
-		[tempPath setLineDash: black count: 4 phase: 0.0];
-		[tempPath stroke];
-		CGFloat white[4] = {0,3.5,2,.5};
-		[[NSColor whiteColor] set];
-		[tempPath setLineDash: white count: 4 phase: 0.0];
-		[tempPath stroke];
+		[self drawMarchingAnts:tempPath];
 	}else if((curToolIndex == kLassoTool || curToolIndex == kPolygonLassoTool) && intermediate){
 		// Finally, draw the marching ants for the lasso or polygon lasso tools
 		tempPath = [NSBezierPath bezierPath];
@@ -581,17 +596,23 @@ static NSString*	SelectAlphaToolbarItemIdentifier = @"Select Alpha Toolbar Item
 			[tempPath lineToPoint:NSMakePoint((thisPoint.x + xoff) * xScale , (thisPoint.y + yoff) * yScale )];
 		}
 		
-		CGFloat black[4] = {0,.5,2,3.5};
-		[[NSColor blackColor] set];
-		[tempPath setLineDash: black count: 4 phase: 0.0];
-		[tempPath stroke];
-		CGFloat white[4] = {0,3.5,2,.5};
-		[[NSColor whiteColor] set];
-		[tempPath setLineDash: white count: 4 phase: 0.0];
-		[tempPath stroke];
+		[self drawMarchingAnts:tempPath];
 	}
 }
 
+- (void)drawMarchingAnts:(NSBezierPath *)path
+{
+	CGFloat black[4] = {0,.5,2,3.5};
+	CGFloat white[4] = {0,3.5,2,.5};
+	
+	[[NSColor blackColor] set];
+	[path setLineDash: black count: 4 phase: 0.0];
+	[path stroke];
+	[[NSColor whiteColor] set];
+	[path setLineDash: white count: 4 phase: 0.0];
+	[path stroke];
+}
+
 - (void)drawDragHandles:(NSRect) rect type: (SeaHandleType)type
 {
 	rect.origin.x -= 1;
@@ -1046,6 +1067,13 @@ static NSString*	SelectAlphaToolbarItemIdentifier = @"Select Alpha Toolbar Item
 	// Get the current tool
 	curTool = [[document tools] currentTool];
 	
+	// Some tools cannot yet work in 16-bit documents
+	if ([[document contents] bps] == 16 && ![curTool acceptsDeepDocuments]) {
+		toolRefused = YES;
+		NSBeep();
+		return;
+	}
+	
 	// Calculate the localPoint and localActiveLayerPoint
 	mouseDownLoc = [theEvent locationInWindow];
 	globalPoint = [self convertPoint:[theEvent locationInWindow] fromView:NULL];
@@ -1123,6 +1151,10 @@ static NSString*	SelectAlphaToolbarItemIdentifier = @"Select Alpha Toolbar Item
 	NSClipView *view;
 	AbstractOptions *options = [[[SeaController utilitiesManager] optionsUtilityFor:document] currentOptions];
 	
+	// Ignore the drag if the tool refused the mouse down
+	if (toolRefused)
+		return;
+	
 	NSRect visRect = [(NSClipView *)[self superview] documentVisibleRect];
 	localPoint = [self convertPoint:[theEvent locationInWindow] fromView:NULL];
 	
@@ -1257,6 +1289,12 @@ static NSString*	SelectAlphaToolbarItemIdentifier = @"Select Alpha Toolbar Item
 	IntPoint localActiveLayerPoint;
 	AbstractOptions *options = [[[SeaController utilitiesManager] optionsUtilityFor:document] currentOptions];
 	
+	// Ignore the mouse up if the tool refused the mouse down
+	if (toolRefused) {
+		toolRefused = NO;
+		return;
+	}
+	
 	// Get xScale, yScale
 	xScale = [[document contents] xscale];
 	yScale = [[document contents] yscale];
@@ -3,15 +3,27 @@
 #ifdef SEASYSPLUGIN
 #import "Globals.h"
 #import "SeaCompositor.h"
+#import "SeaLayer.h"
+#import "ColorLUT.h"
+#import "SeaWhiteboardSnapshot.h"
 #else
 #import <SeashoreKit/Globals.h>
 #import <SeashoreKit/SeaCompositor.h>
+#import <SeashoreKit/SeaLayer.h>
+#import <SeashoreKit/ColorLUT.h>
+#import <SeashoreKit/SeaWhiteboardSnapshot.h>
 #endif
 
 #if MAIN_COMPILE
 @class SeaDocument;
 #endif
 
+/*!
+	@defined	kMaxMipLevels
+	@discussion	The maximum number of levels in the whiteboard's pyramid.
+*/
+#define kMaxMipLevels 16
+
 /*!
 	@enum		k...ChannelsView
 	@constant	kAllChannelsView
@@ -104,15 +116,47 @@ typedef NS_ENUM(int, SeaOverlayBehaviour) {
 	unsigned char *data;
 	unsigned char *altData;
 	
+	// The whiteboard's 16-bit data for 16-bit documents (NULL otherwise), layers
+	// are composited here and the result narrowed in to data for display
+	uint16_t *deepData;
+	
+	// The snapshots still sharing the whiteboard's data (held weakly)
+	NSHashTable<SeaWhiteboardSnapshot *> *snapshots;
+	
+	// Counts the updates made to the whiteboard's data
+	NSUInteger version;
+	
 	// The whiteboard's images
 	NSImage *image;
 	
+	// The reductions of the whiteboard's data used when zoomed out, each half
+	// the size of the one before (level zero is the data itself)
+	unsigned char *mipData[kMaxMipLevels];
+	int mipWidth[kMaxMipLevels], mipHeight[kMaxMipLevels];
+	int mipCount;
+	
+	// The images wrapping each reduction, kept alive between redraws
+	NSBitmapImageRep *mipReps[kMaxMipLevels];
+	NSImage *mipImages[kMaxMipLevels];
+	
 	// The overlay for the current layer
 	unsigned char *overlay;
 	
 	// The replace mask for the current layer
 	unsigned char *replace;
 	
+	// The bytes allocated for the overlay and replace mask (memory is kept
+	// between layers) and the layer size and samples they are laid out for
+	size_t overlayCapacity, replaceCapacity;
+	IntSize overlaySize;
+	int overlaySpp;
+	
+	// The epoch of each tile of the overlay, a tile having been written to since
+	// the overlay was last cleared when it holds the current epoch (everything
+	// outside those tiles is clear)
+	unsigned int *overlayTiles;
+	unsigned int overlayEpoch;
+	
 	// The behaviour of the overlay
 	SeaOverlayBehaviour overlayBehaviour;
 	
@@ -122,6 +166,9 @@ typedef NS_ENUM(int, SeaOverlayBehaviour) {
 	// The colour world for colour space conversions
 	ColorSyncTransformRef cw;
 	
+	// The colour world sampled for CMYK previews (built when first needed)
+	SeaColorLUTRef cmykLUT;
+	
 	// The whiteboard's samples per pixel
 	int spp;
 	
@@ -194,7 +241,8 @@ typedef NS_ENUM(int, SeaOverlayBehaviour) {
 
 /*!
 	@method		applyOverlay
-	@discussion	Applies and clears the overlay.
+	@discussion	Applies and clears the overlay, looking only at the tiles marked
+				by touchOverlay:.
 	@result		Returns a rectangle representing the changed content in the
 				document's co-ordinates. This rectangle can then be passed to
 				update:.
@@ -203,10 +251,22 @@ typedef NS_ENUM(int, SeaOverlayBehaviour) {
 
 /*!
 	@method		clearOverlay
-	@discussion	Clears the overlay without applying it.
+	@discussion	Clears the overlay without applying it. Only the tiles of the
+				overlay and replace mask marked by touchOverlay: are cleared.
 */
 - (void)clearOverlay;
 
+/*!
+	@method		touchOverlay:
+	@discussion	Marks part of the overlay and replace mask as written to, so it
+				is cleared when the overlay is next applied or cleared. Anything
+				writing to the overlay must mark what it writes, overlayChanged:
+				in SeaHelpers does so for the rectangle it is given.
+	@param		rect
+				The rectangle written to in the active layer's co-ordinates.
+*/
+- (void)touchOverlay:(IntRect)rect;
+
 /*!
 	@property	overlay
 	@discussion	Returns the bitmap data of the overlay.
@@ -337,6 +397,24 @@ typedef NS_ENUM(int, SeaOverlayBehaviour) {
 	@result		Returns an NSImage representing the whiteboard.
 */
 - (NSImage *)image;
+
+/*!
+	@method		imageForScale:
+	@discussion	Returns an image representing the whiteboard for drawing at the
+				given scale. When zoomed out this is the coarsest of a series of
+				box-filtered reductions of the whiteboard that still has at
+				least one pixel for every pixel drawn. The reductions are built
+				as they are first needed, kept up-to-date as the whiteboard is
+				updated and reused between redraws, so the image returned is
+				shared and must not be changed (not even flipped). Use image
+				for a full-resolution image of one's own.
+	@param		scale
+				The number of screen pixels drawn for each pixel of the
+				whiteboard.
+	@result		Returns an NSImage representing the whiteboard whose size,
+				relative to that of imageRect, gives the reduction used.
+*/
+- (NSImage *)imageForScale:(CGFloat)scale;
 #endif
 
 /*!
@@ -355,6 +433,16 @@ typedef NS_ENUM(int, SeaOverlayBehaviour) {
 */
 @property (readonly) unsigned char *data NS_RETURNS_INNER_POINTER;
 
+/*!
+	@method		snapshot
+	@discussion	Takes a snapshot of the whiteboard's data. This is cheap, the
+				snapshot shares the data and only copies the tiles later updates
+				write over, so it always reads back the merged image as it was
+				when taken.
+	@result		Returns the snapshot.
+*/
+- (SeaWhiteboardSnapshot *)snapshot;
+
 /*!
 	@property	altData
 	@discussion	Returns the alternate bitmap data for the whiteboard.
@@ -363,6 +451,16 @@ typedef NS_ENUM(int, SeaOverlayBehaviour) {
 */
 @property (readonly) unsigned char *altData NS_RETURNS_INNER_POINTER;
 
+/*!
+	@property	deepData
+	@discussion	Returns the 16-bit bitmap data for the whiteboard of a 16-bit
+				document. This is premultiplied like data, which holds the same
+				image narrowed to 8 bits.
+	@result		Returns a pointer to the 16-bit bitmap data for the whiteboard
+				or NULL if the document is not 16-bit.
+*/
+@property (readonly) uint16_t *deepData NS_RETURNS_INNER_POINTER;
+
 /*!
 	@property	displayProf
 	@discussion	Returns the current display profile.
@@ -24,6 +24,94 @@ extern BOOL useAltiVec;
 
 extern IntPoint SeaScreenResolution;
 
+// The number of pixels converted at a time for CMYK previews
+#define kCMYKRunLength 256
+
+// The overlay is tracked and cleared in square tiles of this many pixels a side
+#define kOverlayTileSize 64
+
+// Zeroes the tiles of the overlay and replace mask marked with the given epoch,
+// one memset a row for each run of marked tiles
+static void clearTiles(unsigned char *overlay, unsigned char *replace, IntSize size, int spp, const unsigned int *tiles, unsigned int epoch)
+{
+	int across = (size.width + kOverlayTileSize - 1) / kOverlayTileSize;
+	int down = (size.height + kOverlayTileSize - 1) / kOverlayTileSize;
+	
+	dispatch_apply(down, dispatch_get_global_queue(0, 0), ^(size_t row) {
+		const unsigned int *rowTiles = tiles + row * across;
+		int top = (int)row * kOverlayTileSize, bottom = MIN(top + kOverlayTileSize, size.height);
+		int first, last, left, right, j;
+		
+		for (first = 0; first < across; first = last + 1) {
+			if (rowTiles[first] != epoch) {
+				last = first;
+				continue;
+			}
+			for (last = first; last + 1 < across && rowTiles[last + 1] == epoch; last++);
+			left = first * kOverlayTileSize;
+			right = MIN((last + 1) * kOverlayTileSize, size.width);
+			for (j = top; j < bottom; j++) {
+				memset(overlay + ((size_t)j * size.width + left) * spp, 0, (size_t)(right - left) * spp);
+				memset(replace + (size_t)j * size.width + left, 0, right - left);
+			}
+		}
+	});
+}
+
+// Readies a buffer to hold length bytes, keeping its memory when it is a
+// suitable size (buffers are allocated in power-of-two size classes of at
+// least a page and a kept buffer must already be clear)
+static unsigned char *prepareBuffer(unsigned char *buffer, size_t *capacity, size_t length)
+{
+	if (buffer && length <= *capacity && length > *capacity / 4)
+		return buffer;
+	free(buffer);
+	for (*capacity = 4096; *capacity < length; *capacity <<= 1);
+	
+	return calloc(*capacity, 1);
+}
+
+// Applies one expanded pixel of the overlay to a 16-bit layer, much as
+// applyOverlay does for 8-bit layers
+static void applyDeepOverlay(int spp, uint16_t *srcPtr, int srcLoc, uint16_t *overlaySpace, int selectOpacity, SeaOverlayBehaviour behaviour, int selectedChannel, BOOL floating)
+{
+	if (selectedChannel == kAllChannels && !floating) {
+		switch (behaviour) {
+			case SeaOverlayBehaviourErasing:
+				SeaEraseMerge16(spp, srcPtr, srcLoc, overlaySpace, 0, selectOpacity);
+				break;
+				
+			case SeaOverlayBehaviourReplacing:
+				SeaReplaceMerge16(spp, srcPtr, srcLoc, overlaySpace, 0, selectOpacity);
+				break;
+				
+			default:
+				SeaSpecialMerge16(spp, srcPtr, srcLoc, overlaySpace, 0, selectOpacity);
+				break;
+		}
+	} else if (selectedChannel == kPrimaryChannels || floating) {
+		switch (behaviour) {
+			case SeaOverlayBehaviourReplacing:
+				SeaReplacePrimaryMerge16(spp, srcPtr, srcLoc, overlaySpace, 0, selectOpacity);
+				break;
+				
+			default:
+				SeaPrimaryMerge16(spp, srcPtr, srcLoc, overlaySpace, 0, selectOpacity, NO);
+				break;
+		}
+	} else if (selectedChannel == kAlphaChannel) {
+		switch (behaviour) {
+			case SeaOverlayBehaviourReplacing:
+				SeaReplaceAlphaMerge16(spp, srcPtr, srcLoc, overlaySpace, 0, selectOpacity);
+				break;
+				
+			default:
+				SeaAlphaMerge16(spp, srcPtr, srcLoc, overlaySpace, 0, selectOpacity);
+				break;
+		}
+	}
+}
+
 @implementation SeaWhiteboard
 @synthesize overlayBehaviour;
 @synthesize overlayOpacity;
@@ -32,13 +120,13 @@ extern IntPoint SeaScreenResolution;
 @synthesize replace;
 @synthesize data;
 @synthesize altData;
+@synthesize deepData;
 
 #if MAIN_COMPILE
 - (instancetype)initWithDocument:(id)doc
 {
 	if (self = [super init]) {
 		ColorSyncProfileRef destProf;
-		int layerWidth, layerHeight;
 		NSString *pluginPath;
 		NSBundle *bundle;
 		
@@ -47,7 +135,7 @@ extern IntPoint SeaScreenResolution;
 		
 		// Initialize the compostior
 		compositor = NULL;
-		if (useAltiVec) {
+		if (useAltiVec && [(SeaContent *)[document contents] bps] != 16) {
 			pluginPath = [[gMainBundle builtInPlugInsPath] stringByAppendingPathComponent:@"CompositorAV.bundle"];
 			if ([gFileManager fileExistsAtPath:pluginPath]) {
 				bundle = [NSBundle bundleWithPath:pluginPath];
@@ -63,8 +151,6 @@ extern IntPoint SeaScreenResolution;
 		// Record the width, height and use of greys
 		width = [(SeaContent *)[document contents] width];
 		height = [(SeaContent *)[document contents] height];
-		layerWidth = [[[document contents] activeLayer] width];
-		layerHeight = [[[document contents] activeLayer] height];
 		
 		// Record the samples per pixel used by the whiteboard
 		spp = [[document contents] spp];
@@ -75,10 +161,9 @@ extern IntPoint SeaScreenResolution;
 		
 		// Allocate the whiteboard data
 		data = malloc(make_128(width * height * spp));
-		overlay = malloc(make_128(layerWidth * layerHeight * spp));
-		memset(overlay, 0, layerWidth * layerHeight * spp);
-		replace = malloc(make_128(layerWidth * layerHeight));
-		memset(replace, 0, layerWidth * layerHeight);
+		if ([(SeaContent *)[document contents] bps] == 16)
+			deepData = malloc(make_128(width * height * spp * sizeof(uint16_t)));
+		[self prepareOverlay];
 		altData = NULL;
 		
 		// Create the colour world
@@ -112,7 +197,6 @@ extern IntPoint SeaScreenResolution;
 {
 	if (self = [super init]) {
 		ColorSyncProfileRef destProf;
-		int layerWidth, layerHeight;
 		
 		SeaScreenResolution = IntMakePoint(1024, 768);
 		// Remember the document we are representing
@@ -127,8 +211,6 @@ extern IntPoint SeaScreenResolution;
 		// Record the width, height and use of greys
 		width = [contents width];
 		height = [contents height];
-		layerWidth = [(SeaLayer *)[contents activeLayer] width];
-		layerHeight = [(SeaLayer *)[contents activeLayer] height];
 		
 		// Record the samples per pixel used by the whiteboard
 		spp = [contents spp];
@@ -139,10 +221,9 @@ extern IntPoint SeaScreenResolution;
 		
 		// Allocate the whiteboard data
 		data = malloc(make_128(width * height * spp));
-		overlay = malloc(make_128(layerWidth * layerHeight * spp));
-		memset(overlay, 0, layerWidth * layerHeight * spp);
-		replace = malloc(make_128(layerWidth * layerHeight));
-		memset(replace, 0, layerWidth * layerHeight);
+		if ([contents bps] == 16)
+			deepData = malloc(make_128(width * height * spp * sizeof(uint16_t)));
+		[self prepareOverlay];
 		altData = NULL;
 		
 		// Create the colour world
@@ -179,9 +260,15 @@ extern IntPoint SeaScreenResolution;
 	if (displayProf) CFRelease(displayProf);
 	if (cgDisplayProf) CGColorSpaceRelease(cgDisplayProf);
 	if (cw) CFRelease(cw);
+	SeaColorLUTRelease(cmykLUT);
+	[self detachSnapshots];
 	if (data) free(data);
+	if (deepData) free(deepData);
+	for (int i = 1; i < mipCount; i++)
+		free(mipData[i]);
 	if (overlay) free(overlay);
 	if (replace) free(replace);
+	if (overlayTiles) free(overlayTiles);
 	if (altData) free(altData);
 }
 
@@ -189,12 +276,13 @@ extern IntPoint SeaScreenResolution;
 {
 	SeaLayer *layer;
 	int leftOffset, rightOffset, topOffset, bottomOffset;
-	int k, srcLoc, selectedChannel;
-	int xoff, yoff;
+	int srcLoc, selectedChannel;
+	int xoff, yoff, across, down;
 	unsigned char *srcPtr;
+	uint16_t overlaySpace[4];
 	int lwidth, lheight, selectOpacity;
-	IntRect rect, selectRect;
-	BOOL overlayOkay, overlayReplacing;
+	IntRect rect, selectRect, tileRect;
+	BOOL overlayOkay, overlayReplacing, deep;
 	IntPoint maskOffset, trueMaskOffset;
 #if MAIN_COMPILE
 	IntSize maskSize;
@@ -215,6 +303,7 @@ extern IntPoint SeaScreenResolution;
 #endif
 	floating = layer.floating;
 	srcPtr = [layer data];
+	deep = ([layer bps] == 16);
 	lwidth = [layer width];
 	lheight = [layer height];
 	xoff = [layer xoff];
@@ -229,29 +318,37 @@ extern IntPoint SeaScreenResolution;
 #endif
 	overlayReplacing = (overlayBehaviour == SeaOverlayBehaviourReplacing);
 	
-	// Calculate offsets
+	// Calculate offsets, looking only at the tiles written to
 	leftOffset = lwidth + 1;
 	rightOffset = -1;
 	bottomOffset = -1;
 	topOffset = lheight + 1;
-	for (int j = 0; j < lheight; j++) {
-		for (int i = 0; i < lwidth; i++) {
-			if (overlayReplacing) {
-				if (replace[j * lwidth + i] != 0) {	
-					if (rightOffset < i + 1) rightOffset = i + 1;
-					if (topOffset > j) topOffset = j;
-					if (leftOffset > i) leftOffset = i;
-					if (bottomOffset < j + 1) bottomOffset = j + 1;
-				}
-				else {
-					overlay[(j * lwidth + i + 1) * spp - 1] = 0;
-				}
-			} else {
-				if (overlay[(j * lwidth + i + 1) * spp - 1] != 0) {
-					if (rightOffset < i + 1) rightOffset = i + 1;
-					if (topOffset > j) topOffset = j;
-					if (leftOffset > i) leftOffset = i;
-					if (bottomOffset < j + 1) bottomOffset = j + 1;
+	across = (lwidth + kOverlayTileSize - 1) / kOverlayTileSize;
+	down = (lheight + kOverlayTileSize - 1) / kOverlayTileSize;
+	for (int tile = 0; tile < across * down; tile++) {
+		if (overlayTiles[tile] != overlayEpoch)
+			continue;
+		tileRect = IntMakeRect((tile % across) * kOverlayTileSize, (tile / across) * kOverlayTileSize, kOverlayTileSize, kOverlayTileSize);
+		tileRect = IntConstrainRect(tileRect, IntMakeRect(0, 0, lwidth, lheight));
+		for (int j = tileRect.origin.y; j < tileRect.origin.y + tileRect.size.height; j++) {
+			for (int i = tileRect.origin.x; i < tileRect.origin.x + tileRect.size.width; i++) {
+				if (overlayReplacing) {
+					if (replace[j * lwidth + i] != 0) {	
+						if (rightOffset < i + 1) rightOffset = i + 1;
+						if (topOffset > j) topOffset = j;
+						if (leftOffset > i) leftOffset = i;
+						if (bottomOffset < j + 1) bottomOffset = j + 1;
+					}
+					else {
+						overlay[(j * lwidth + i + 1) * spp - 1] = 0;
+					}
+				} else {
+					if (overlay[(j * lwidth + i + 1) * spp - 1] != 0) {
+						if (rightOffset < i + 1) rightOffset = i + 1;
+						if (topOffset > j) topOffset = j;
+						if (leftOffset > i) leftOffset = i;
+						if (bottomOffset < j + 1) bottomOffset = j + 1;
+					}
 				}
 			}
 		}
@@ -259,7 +356,10 @@ extern IntPoint SeaScreenResolution;
 	
 	// If we didn't find any pixels, all of the offsets will be in their original
 	// state, but we only need to test one ...
-	if (leftOffset < 0) return IntMakeRect(0, 0, 0, 0);
+	if (rightOffset < 0) {
+		[self clearOverlayTiles];
+		return IntMakeRect(0, 0, 0, 0);
+	}
 	
 	// Create the rectangle
 	rect = IntMakeRect(leftOffset, topOffset, rightOffset - leftOffset, bottomOffset - topOffset);
@@ -308,8 +408,13 @@ extern IntPoint SeaScreenResolution;
 			if (selectOpacity == 0)
 				overlayOkay = NO;
 			
-			// Apply the overlay
-			if (overlayOkay) {
+			// Apply the overlay, expanding it for 16-bit layers
+			if (overlayOkay && deep) {
+				for (int k = 0; k < spp; k++)
+					overlaySpace[k] = expand_sample(overlay[srcLoc + k]);
+				applyDeepOverlay(spp, (uint16_t *)srcPtr, srcLoc, overlaySpace, selectOpacity, overlayBehaviour, selectedChannel, floating);
+			}
+			else if (overlayOkay) {
 				if (selectedChannel == kAllChannels && !floating) {
 					// For the general case
 					switch (overlayBehaviour) {
@@ -352,11 +457,6 @@ extern IntPoint SeaScreenResolution;
 				}
 			}
 			
-			// Clear the overlay
-			for (k = 0; k < spp; k++)
-				overlay[srcLoc + k] = 0;
-			replace[j * lwidth + i] = 0;
-			
 		}
 	}
 	
@@ -364,14 +464,52 @@ extern IntPoint SeaScreenResolution;
 	rect.origin.x += xoff;
 	rect.origin.y += yoff;
 	
-	// Reset the overlay's opacity and behaviour
-	overlayOpacity = 0;
-	overlayBehaviour = SeaOverlayBehaviourNormal;
+	// Clear the tiles written to and reset the overlay's opacity and behaviour
+	[self clearOverlay];
 	
 	return rect;
 }
 
 - (void)clearOverlay
+{
+	[self clearOverlayTiles];
+	overlayOpacity = 0;
+	overlayBehaviour = SeaOverlayBehaviourNormal;
+}
+
+- (void)clearOverlayTiles
+{
+	if (!overlayTiles)
+		return;
+	clearTiles(overlay, replace, overlaySize, overlaySpp, overlayTiles, overlayEpoch);
+	
+	// Moving to the next epoch unmarks every tile at once
+	if (++overlayEpoch == 0) {
+		memset(overlayTiles, 0, [self overlayTileCount] * sizeof(unsigned int));
+		overlayEpoch = 1;
+	}
+}
+
+- (size_t)overlayTileCount
+{
+	return (size_t)((overlaySize.width + kOverlayTileSize - 1) / kOverlayTileSize) * ((overlaySize.height + kOverlayTileSize - 1) / kOverlayTileSize);
+}
+
+- (void)touchOverlay:(IntRect)rect
+{
+	int across = (overlaySize.width + kOverlayTileSize - 1) / kOverlayTileSize;
+	int i, j;
+	
+	rect = IntConstrainRect(rect, IntMakeRect(0, 0, overlaySize.width, overlaySize.height));
+	if (!overlayTiles || rect.size.width <= 0 || rect.size.height <= 0)
+		return;
+	for (j = rect.origin.y / kOverlayTileSize; j <= (rect.origin.y + rect.size.height - 1) / kOverlayTileSize; j++) {
+		for (i = rect.origin.x / kOverlayTileSize; i <= (rect.origin.x + rect.size.width - 1) / kOverlayTileSize; i++)
+			overlayTiles[j * across + i] = overlayEpoch;
+	}
+}
+
+- (void)prepareOverlay
 {
 	SeaLayer *layer =
 #if MAIN_COMPILE
@@ -379,11 +517,19 @@ extern IntPoint SeaScreenResolution;
 #else
 	[contents activeLayer];
 #endif
-
-	memset(overlay, 0, [layer width] * [layer height] * spp);
-	memset(replace, 0, [layer width] * [layer height]);
-	overlayOpacity = 0;
-	overlayBehaviour = SeaOverlayBehaviourNormal;
+	size_t length = (size_t)[layer width] * [layer height];
+	
+	// Clear what the last layer touched so the memory can be kept
+	[self clearOverlayTiles];
+	overlay = prepareBuffer(overlay, &overlayCapacity, length * spp);
+	replace = prepareBuffer(replace, &replaceCapacity, length);
+	overlaySize = IntMakeSize([layer width], [layer height]);
+	overlaySpp = spp;
+	
+	// Lay the tiles out afresh for the layer
+	free(overlayTiles);
+	overlayTiles = calloc(MAX([self overlayTileCount], 1), sizeof(unsigned int));
+	overlayEpoch = 1;
 }
 
 - (BOOL)whiteboardIsLayerSpecific
@@ -418,31 +564,26 @@ extern IntPoint SeaScreenResolution;
 #endif
 	
 	// Revise the data
+	[self freeMipmaps];
+	[self detachSnapshots];
 	if (data)
 		free(data);
 	data = malloc(make_128(width * height * spp));
+	if (deepData)
+		free(deepData);
+	deepData = NULL;
+#if MAIN_COMPILE
+	if ([(SeaContent *)[document contents] bps] == 16)
+#else
+	if ([contents bps] == 16)
+#endif
+		deepData = malloc(make_128(width * height * spp * sizeof(uint16_t)));
 
 	// Adjust the alternate data as necessary
 	[self readjustAltData:NO];
 	
 	// Update the overlay
-	if (overlay) free(overlay);
-#if MAIN_COMPILE
-	overlay = malloc(make_128([(SeaLayer *)[[document contents] activeLayer] width] * [(SeaLayer *)[[document contents] activeLayer] height] * spp));
-	memset(overlay, 0, [(SeaLayer *)[[document contents] activeLayer] width] * [(SeaLayer *)[[document contents] activeLayer] height] * spp);
-#else
-	overlay = malloc(make_128([(SeaLayer *)[contents activeLayer] width] * [(SeaLayer *)[contents activeLayer] height] * spp));
-	memset(overlay, 0, [(SeaLayer *)[contents activeLayer] width] * [(SeaLayer *)[contents activeLayer] height] * spp);
-#endif
-	if (replace) free(replace);
-	
-#if MAIN_COMPILE
-	replace = malloc(make_128([(SeaLayer *)[[document contents] activeLayer] width] * [(SeaLayer *)[[document contents] activeLayer] height]));
-	memset(replace, 0, [(SeaLayer *)[[document contents] activeLayer] width] * [(SeaLayer *)[[document contents] activeLayer] height]);
-#else
-	replace = malloc(make_128([(SeaLayer *)[contents activeLayer] width] * [(SeaLayer *)[contents activeLayer] height]));
-	memset(replace, 0, [(SeaLayer *)[contents activeLayer] width] * [(SeaLayer *)[contents activeLayer] height]);
-#endif
+	[self prepareOverlay];
 
 	// Update ourselves
 	[self update];
@@ -454,24 +595,8 @@ extern IntPoint SeaScreenResolution;
 	[self readjustAltData:NO];
 	
 	// Update the overlay
-	if (overlay) free(overlay);
-#if MAIN_COMPILE
-	overlay = malloc(make_128([(SeaLayer *)[[document contents] activeLayer] width] * [(SeaLayer *)[[document contents] activeLayer] height] * spp));
-	memset(overlay, 0, [(SeaLayer *)[[document contents] activeLayer] width] * [(SeaLayer *)[[document contents] activeLayer] height] * spp);
-#else
-	overlay = malloc(make_128([(SeaLayer *)[contents activeLayer] width] * [(SeaLayer *)[contents activeLayer] height] * spp));
-	memset(overlay, 0, [(SeaLayer *)[contents activeLayer] width] * [(SeaLayer *)[contents activeLayer] height] * spp);
-#endif
-	
-	if (replace) free(replace);
-#if MAIN_COMPILE
-	replace = malloc(make_128([(SeaLayer *)[[document contents] activeLayer] width] * [(SeaLayer *)[[document contents] activeLayer] height]));
-	memset(replace, 0, [(SeaLayer *)[[document contents] activeLayer] width] * [(SeaLayer *)[[document contents] activeLayer] height]);
-#else
-	replace = malloc(make_128([(SeaLayer *)[contents activeLayer] width] * [(SeaLayer *)[contents activeLayer] height]));
-	memset(replace, 0, [(SeaLayer *)[contents activeLayer] width] * [(SeaLayer *)[contents activeLayer] height]);
-#endif
-	
+	[self prepareOverlay];
+
 	// Update ourselves
 	[self update];
 }
@@ -616,7 +741,7 @@ extern IntPoint SeaScreenResolution;
 	layerHeight = [layer height];
 	lxoff = [layer xoff];
 	lyoff = [layer yoff];
-	layerData = [layer data];
+	layerData = ([layer bps] == 16) ? [layer copyNarrowedData] : [layer data];
 	
 	// Determine the minor update rect
 	if (useUpdateRect) {
@@ -748,42 +873,34 @@ extern IntPoint SeaScreenResolution;
 			
 		}
 	}
+	
+	// Free any narrowed copy of the layer
+	if (layerData != [layer data])
+		free(layerData);
 }
 
 - (void)forcedCMYKUpdate:(IntRect)majorUpdateRect
 {
-	unsigned char *tempData;
-	int i;
-
-	// Define the source
-	if (useUpdateRect) {
-		for (i = 0; i < majorUpdateRect.size.height; i++) {
-		
-			// Define the source
-			tempData = malloc(majorUpdateRect.size.width * 3);
-			SeaStripAlphaToWhite(4, tempData, data + ((majorUpdateRect.origin.y + i) * width + majorUpdateRect.origin.x) * 4, majorUpdateRect.size.width);
-			
-			// Execute the conversion
-			ColorSyncTransformConvert(cw, majorUpdateRect.size.width, 1, (char *)altData + ((majorUpdateRect.origin.y + i) * width + majorUpdateRect.origin.x) * 4, kColorSync8BitInteger, kColorSyncAlphaNone | kColorSyncByteOrderDefault, majorUpdateRect.size.width * 4, tempData, kColorSync8BitInteger, kColorSyncAlphaNone | kColorSyncByteOrderDefault, majorUpdateRect.size.width * 3, NULL);
-			
-			// Clean up after ourselves
-			free(tempData);
-			
-		}
-	}
-	else {
+	IntRect rect = useUpdateRect ? majorUpdateRect : IntMakeRect(0, 0, width, height);
+	
+	// Sample the colour world once rather than converting on every refresh
+	if (!cmykLUT)
+		cmykLUT = SeaColorLUTCreateWithTransform(cw, 4);
 	
-		// Define the source
-		tempData = malloc(width * height * 3);
-		SeaStripAlphaToWhite(4, tempData, data, width * height);
+	// Convert the rows in parallel, a run at a time so the RGB stays on the stack
+	dispatch_apply(rect.size.height, dispatch_get_global_queue(0, 0), ^(size_t row) {
+		unsigned char tempData[kCMYKRunLength * 3];
+		int j = rect.origin.y + (int)row, i, count;
 		
-		// Execute the conversion
-		ColorSyncTransformConvert(cw, width, height, altData, kColorSync8BitInteger, kColorSyncAlphaNone | kColorSyncByteOrderDefault, width * 4, tempData, kColorSync8BitInteger, kColorSyncAlphaNone | kColorSyncByteOrderDefault, width * 3, NULL);
-
-		// Clean up after ourselves
-		free(tempData);
-
-	}
+		for (i = rect.origin.x; i < rect.origin.x + rect.size.width; i += kCMYKRunLength) {
+			count = MIN(kCMYKRunLength, rect.origin.x + rect.size.width - i);
+			SeaStripAlphaToWhite(4, tempData, data + (j * width + i) * 4, count);
+			if (cmykLUT)
+				SeaColorLUTApply(cmykLUT, altData + (j * width + i) * 4, tempData, count);
+			else
+				ColorSyncTransformConvert(cw, count, 1, altData + (j * width + i) * 4, kColorSync8BitInteger, kColorSyncAlphaNone | kColorSyncByteOrderDefault, count * 4, tempData, kColorSync8BitInteger, kColorSyncAlphaNone | kColorSyncByteOrderDefault, count * 3, NULL);
+		}
+	});
 }
 
 - (void)forcedUpdate
@@ -811,9 +928,19 @@ extern IntPoint SeaScreenResolution;
 	// Handle non-channel updates here
 	if (majorUpdateRect.size.width > 0 && majorUpdateRect.size.height > 0) {
 		
-		// Clear the whiteboard
-		for (i = 0; i < majorUpdateRect.size.height; i++)
-			memset(data + ((majorUpdateRect.origin.y + i) * width + majorUpdateRect.origin.x) * spp, 0, majorUpdateRect.size.width * spp);
+		// Let any snapshots keep what is about to be overwritten
+		[self preserveSnapshots:majorUpdateRect];
+		version++;
+		
+		// Clear the whiteboard, 16-bit documents are composited in to the deep data
+		if (deepData) {
+			for (i = 0; i < majorUpdateRect.size.height; i++)
+				memset(deepData + ((majorUpdateRect.origin.y + i) * width + majorUpdateRect.origin.x) * spp, 0, majorUpdateRect.size.width * spp * sizeof(uint16_t));
+		}
+		else {
+			for (i = 0; i < majorUpdateRect.size.height; i++)
+				memset(data + ((majorUpdateRect.origin.y + i) * width + majorUpdateRect.origin.x) * spp, 0, majorUpdateRect.size.width * spp);
+		}
 			
 		// Determine how many layers are visible
 		for (i = 0; count < 2 && i < layerCount; i++) {
@@ -828,6 +955,7 @@ extern IntPoint SeaScreenResolution;
 		
 		// Set the composting options
 		options.spp = spp;
+		options.bps = (deepData) ? 16 : 8;
 		options.forceNormal = (count == 1);
 		options.rect = majorUpdateRect;
 		options.destRect = IntMakeRect(0, 0, width, height);
@@ -877,6 +1005,14 @@ extern IntPoint SeaScreenResolution;
 	
 #endif
 		
+		// Narrow the composited rows for display
+		if (deepData) {
+			for (i = 0; i < majorUpdateRect.size.height; i++) {
+				NSInteger pos = ((majorUpdateRect.origin.y + i) * width + majorUpdateRect.origin.x) * spp;
+				SeaNarrowSamples(data + pos, deepData + pos, majorUpdateRect.size.width * spp);
+			}
+		}
+		
 	}
 	
 	// Handle channel updates here
@@ -888,6 +1024,99 @@ extern IntPoint SeaScreenResolution;
 	if (viewType == kCMYKPreviewView) {
 		[self forcedCMYKUpdate:majorUpdateRect];
 	}
+	
+	// Bring any reductions of the whiteboard up-to-date
+	if (mipCount > 0 && majorUpdateRect.size.width > 0 && majorUpdateRect.size.height > 0) {
+		[self updateMipmaps:majorUpdateRect];
+	}
+}
+
+- (SeaWhiteboardSnapshot *)snapshot
+{
+	SeaWhiteboardSnapshot *snapshot = [[SeaWhiteboardSnapshot alloc] initWithData:data width:width height:height spp:spp version:version];
+	
+	@synchronized (self) {
+		if (!snapshots)
+			snapshots = [NSHashTable weakObjectsHashTable];
+		[snapshots addObject:snapshot];
+	}
+	
+	return snapshot;
+}
+
+- (void)preserveSnapshots:(IntRect)rect
+{
+	@synchronized (self) {
+		for (SeaWhiteboardSnapshot *snapshot in snapshots)
+			[snapshot preserveRect:rect];
+	}
+}
+
+- (void)detachSnapshots
+{
+	@synchronized (self) {
+		for (SeaWhiteboardSnapshot *snapshot in snapshots)
+			[snapshot detach];
+		[snapshots removeAllObjects];
+	}
+}
+
+- (void)freeMipmaps
+{
+	for (int i = 0; i < mipCount; i++) {
+		if (i > 0) free(mipData[i]);
+		mipReps[i] = NULL;
+		mipImages[i] = NULL;
+	}
+	mipCount = 0;
+}
+
+- (void)wrapMipmap:(int)level
+{
+	mipReps[level] = [[NSBitmapImageRep alloc] initWithBitmapDataPlanes:&(mipData[level]) pixelsWide:mipWidth[level] pixelsHigh:mipHeight[level] bitsPerSample:8 samplesPerPixel:spp hasAlpha:YES isPlanar:NO colorSpaceName:(spp == 4) ? NSDeviceRGBColorSpace : NSDeviceWhiteColorSpace bytesPerRow:mipWidth[level] * spp bitsPerPixel:8 * spp];
+	mipImages[level] = [[NSImage alloc] initWithSize:NSMakeSize(mipWidth[level], mipHeight[level])];
+	[mipImages[level] setCacheMode:NSImageCacheNever];
+	[mipImages[level] addRepresentation:mipReps[level]];
+}
+
+- (void)buildMipmapsToLevel:(int)level
+{
+	// Level zero simply wraps the whiteboard's data
+	if (mipCount == 0) {
+		mipData[0] = data;
+		mipWidth[0] = width;
+		mipHeight[0] = height;
+		[self wrapMipmap:0];
+		mipCount = 1;
+	}
+	
+	// Each further level is a box-filtered halving of the one before
+	while (mipCount <= level) {
+		mipWidth[mipCount] = (mipWidth[mipCount - 1] + 1) / 2;
+		mipHeight[mipCount] = (mipHeight[mipCount - 1] + 1) / 2;
+		mipData[mipCount] = malloc(make_128(mipWidth[mipCount] * mipHeight[mipCount] * spp));
+		SeaBoxReduceBitmap(spp, mipData[mipCount], mipWidth[mipCount], mipHeight[mipCount], mipData[mipCount - 1], mipWidth[mipCount - 1], mipHeight[mipCount - 1], NO, IntMakeRect(0, 0, mipWidth[mipCount], mipHeight[mipCount]));
+		[self wrapMipmap:mipCount];
+		mipCount++;
+	}
+}
+
+- (void)updateMipmaps:(IntRect)rect
+{
+	int left, top, right, bottom;
+	
+	for (int level = 1; level < mipCount; level++) {
+		left = rect.origin.x * mipWidth[level] / mipWidth[level - 1];
+		top = rect.origin.y * mipHeight[level] / mipHeight[level - 1];
+		right = ((rect.origin.x + rect.size.width) * mipWidth[level] + mipWidth[level - 1] - 1) / mipWidth[level - 1];
+		bottom = ((rect.origin.y + rect.size.height) * mipHeight[level] + mipHeight[level - 1] - 1) / mipHeight[level - 1];
+		rect = IntConstrainRect(IntMakeRect(left, top, right - left, bottom - top), IntMakeRect(0, 0, mipWidth[level], mipHeight[level]));
+		SeaBoxReduceBitmap(spp, mipData[level], mipWidth[level], mipHeight[level], mipData[level - 1], mipWidth[level - 1], mipHeight[level - 1], NO, rect);
+	}
+	
+	// Asking for the bitmap data makes each representation discard any copy it has cached
+	for (int level = 0; level < mipCount; level++)
+		[mipReps[level] bitmapData];
 }
 
 - (void)update
@@ -952,6 +1181,8 @@ extern IntPoint SeaScreenResolution;
 {
 	if (cw)
 		CFRelease(cw);
+	SeaColorLUTRelease(cmykLUT);
+	cmykLUT = NULL;
 	if (displayProf)
 		CFRelease(displayProf);
 	if (cgDisplayProf)
@@ -1036,6 +1267,22 @@ extern IntPoint SeaScreenResolution;
 	
 	return image;
 }
+
+- (NSImage *)imageForScale:(CGFloat)scale
+{
+	int level = 0;
+	
+	// Channel-specific and CMYK views are never reduced
+	if (altData)
+		return [self image];
+	
+	// Find the coarsest level that still has a pixel for each one drawn
+	while (level + 1 < kMaxMipLevels && scale * (1 << (level + 1)) <= 1.0 && (width >> (level + 1)) > 0 && (height >> (level + 1)) > 0)
+		level++;
+	[self buildMipmapsToLevel:level];
+	
+	return mipImages[level];
+}
 #endif
 
 - (NSImage *)printableImage
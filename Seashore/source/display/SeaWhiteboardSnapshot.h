@@ -0,0 +1,119 @@
+#import <Foundation/Foundation.h>
+#ifdef SEASYSPLUGIN
+#import "Globals.h"
+#else
+#import <SeashoreKit/Globals.h>
+#endif
+
+/*!
+	@defined	kSnapshotTileSize
+	@discussion	The width and height of the tiles a snapshot copies when the
+				whiteboard is about to change them.
+*/
+#define kSnapshotTileSize 64
+
+/*!
+	@class		SeaWhiteboardSnapshot
+	@abstract	A consistent view of the whiteboard's merged image as it was at
+				one moment.
+	@discussion	Taking a snapshot copies nothing, it shares the whiteboard's
+				data until the whiteboard is about to write over part of it. The
+				whiteboard then asks the snapshot to preserve the affected tiles
+				first, so only the tiles that actually change are ever copied.
+				A snapshot may be read from any thread.
+				<br><br>
+				<b>License:</b> GNU General Public License<br>
+				<b>Copyright:</b> N/A
+*/
+@interface SeaWhiteboardSnapshot : NSObject {
+	// The whiteboard's data, shared until every tile has been preserved
+	unsigned char *data;
+
+	// The private copy of each tile or NULL if the tile is still shared
+	unsigned char **tiles;
+
+	// The number of tiles across and down
+	int tilesWide, tilesHigh;
+
+	// The size of the image
+	int width, height;
+
+	// The samples per pixel of the image
+	int spp;
+
+	// The version of the whiteboard the snapshot was taken of
+	NSUInteger version;
+}
+
+/*!
+	@method		initWithData:width:height:spp:version:
+	@discussion	Initializes a snapshot sharing the given whiteboard data. Only
+				the whiteboard should create snapshots (see
+				-[SeaWhiteboard snapshot]).
+	@param		inData
+				The whiteboard's data.
+	@param		inWidth
+				The width of the whiteboard.
+	@param		inHeight
+				The height of the whiteboard.
+	@param		inSpp
+				The samples per pixel of the whiteboard.
+	@param		inVersion
+				The whiteboard's current version.
+	@result		Returns instance upon success (or NULL otherwise).
+*/
+- (instancetype)initWithData:(unsigned char *)inData width:(int)inWidth height:(int)inHeight spp:(int)inSpp version:(NSUInteger)inVersion;
+
+/*!
+	@property	width
+	@discussion	The width of the snapshot.
+*/
+@property (readonly) int width;
+
+/*!
+	@property	height
+	@discussion	The height of the snapshot.
+*/
+@property (readonly) int height;
+
+/*!
+	@property	spp
+	@discussion	The samples per pixel of the snapshot.
+*/
+@property (readonly) int spp;
+
+/*!
+	@property	version
+	@discussion	The version of the whiteboard the snapshot was taken of, the
+				whiteboard's version changes with each update.
+*/
+@property (readonly) NSUInteger version;
+
+/*!
+	@method		preserveRect:
+	@discussion	Copies the still shared tiles touching the given rectangle, the
+				whiteboard calls this before writing to its data.
+	@param		rect
+				The rectangle about to be written to.
+*/
+- (void)preserveRect:(IntRect)rect;
+
+/*!
+	@method		detach
+	@discussion	Copies every still shared tile, the whiteboard calls this
+				before freeing its data.
+*/
+- (void)detach;
+
+/*!
+	@method		copyRect:toData:
+	@discussion	Copies part of the snapshot.
+	@param		rect
+				The rectangle to copy, which must lie within the snapshot.
+	@param		dest
+				The block of memory in which to place the pixels, which must
+				have room for the rectangle at the snapshot's samples per pixel.
+*/
+- (void)copyRect:(IntRect)rect toData:(unsigned char *)dest;
+
+@end
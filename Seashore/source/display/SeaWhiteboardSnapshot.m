@@ -0,0 +1,101 @@
+#import "SeaWhiteboardSnapshot.h"
+
+@implementation SeaWhiteboardSnapshot
+@synthesize width;
+@synthesize height;
+@synthesize spp;
+@synthesize version;
+
+- (instancetype)initWithData:(unsigned char *)inData width:(int)inWidth height:(int)inHeight spp:(int)inSpp version:(NSUInteger)inVersion
+{
+	if (self = [super init]) {
+		data = inData;
+		width = inWidth;
+		height = inHeight;
+		spp = inSpp;
+		version = inVersion;
+		tilesWide = (width + kSnapshotTileSize - 1) / kSnapshotTileSize;
+		tilesHigh = (height + kSnapshotTileSize - 1) / kSnapshotTileSize;
+		tiles = calloc(MAX(tilesWide * tilesHigh, 1), sizeof(unsigned char *));
+	}
+	return self;
+}
+
+- (void)dealloc
+{
+	for (int i = 0; i < tilesWide * tilesHigh; i++)
+		free(tiles[i]);
+	free(tiles);
+}
+
+// The rectangle covered by the given tile
+- (IntRect)tileRect:(int)tx y:(int)ty
+{
+	return IntConstrainRect(IntMakeRect(tx * kSnapshotTileSize, ty * kSnapshotTileSize, kSnapshotTileSize, kSnapshotTileSize), IntMakeRect(0, 0, width, height));
+}
+
+- (void)preserveRect:(IntRect)rect
+{
+	int tx, ty, j, left, right, top, bottom;
+	unsigned char *tile;
+	IntRect tileRect;
+
+	rect = IntConstrainRect(rect, IntMakeRect(0, 0, width, height));
+	if (rect.size.width <= 0 || rect.size.height <= 0)
+		return;
+	left = rect.origin.x / kSnapshotTileSize;
+	right = (rect.origin.x + rect.size.width - 1) / kSnapshotTileSize;
+	top = rect.origin.y / kSnapshotTileSize;
+	bottom = (rect.origin.y + rect.size.height - 1) / kSnapshotTileSize;
+
+	@synchronized (self) {
+		if (!data)
+			return;
+		for (ty = top; ty <= bottom; ty++) {
+			for (tx = left; tx <= right; tx++) {
+				if (tiles[ty * tilesWide + tx])
+					continue;
+				tileRect = [self tileRect:tx y:ty];
+				tile = malloc(tileRect.size.width * tileRect.size.height * spp);
+				for (j = 0; j < tileRect.size.height; j++)
+					memcpy(tile + j * tileRect.size.width * spp, data + ((tileRect.origin.y + j) * width + tileRect.origin.x) * spp, tileRect.size.width * spp);
+				tiles[ty * tilesWide + tx] = tile;
+			}
+		}
+	}
+}
+
+- (void)detach
+{
+	[self preserveRect:IntMakeRect(0, 0, width, height)];
+	@synchronized (self) {
+		data = NULL;
+	}
+}
+
+- (void)copyRect:(IntRect)rect toData:(unsigned char *)dest
+{
+	int i, j, tx, ty, tileWidth, length;
+	unsigned char *tile;
+
+	@synchronized (self) {
+		for (j = 0; j < rect.size.height; j++) {
+			ty = (rect.origin.y + j) / kSnapshotTileSize;
+			for (i = 0; i < rect.size.width; i += length) {
+				// Copy the part of the row that lies in this tile
+				tx = (rect.origin.x + i) / kSnapshotTileSize;
+				length = MIN((tx + 1) * kSnapshotTileSize - (rect.origin.x + i), rect.size.width - i);
+				tile = tiles[ty * tilesWide + tx];
+				if (tile) {
+					tileWidth = MIN(kSnapshotTileSize, width - tx * kSnapshotTileSize);
+					memcpy(dest + (j * rect.size.width + i) * spp, tile + (((rect.origin.y + j) % kSnapshotTileSize) * tileWidth + (rect.origin.x + i) % kSnapshotTileSize) * spp, length * spp);
+				}
+				else {
+					memcpy(dest + (j * rect.size.width + i) * spp, data + ((rect.origin.y + j) * width + rect.origin.x + i) * spp, length * spp);
+				}
+			}
+		}
+	}
+}
+
+@end
@@ -4,6 +4,7 @@
 #import "CocoaLayer.h"
 #import "SeaController.h"
 #import "SeaWarning.h"
+#import "SeaPrefs.h"
 #import "SeaDocumentController.h"
 
 @implementation CocoaContent
@@ -145,8 +146,11 @@
 		return nil;
 	}
 	
-	// Warn if 16-bit image
-	if ([imageRep bitsPerSample] == 16) {
+	// Keep 16-bit images at 16 bits if asked to, otherwise warn they are resampled
+	if ([imageRep bitsPerSample] == 16 && [[SeaController seaPrefs] keepDeepImages]) {
+		bps = 16;
+	}
+	else if ([imageRep bitsPerSample] == 16) {
 		[[SeaController seaWarning] addMessage:LOCALSTR(@"16-bit message", @"Seashore does not currently support the editing of 16-bit images. This image has been resampled at 8 bits to be imported.") forDocument:doc level:kHighImportance];
 	}
 	
@@ -171,7 +175,7 @@
 	exifData = [(NSBitmapImageRep*)imageRep valueForProperty:@"NSImageEXIFData"];
 	
 	// Create the layer
-	layer = [[CocoaLayer alloc] initWithImageRep:(NSBitmapImageRep*)imageRep document:doc spp:(type == XCF_RGB_IMAGE) ? 4 : 2];
+	layer = [[CocoaLayer alloc] initWithImageRep:(NSBitmapImageRep*)imageRep document:doc spp:(type == XCF_RGB_IMAGE) ? 4 : 2 bps:bps];
 	if (layer == NULL) {
 		return NULL;
 	}
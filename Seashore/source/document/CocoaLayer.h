@@ -34,6 +34,24 @@ NS_ASSUME_NONNULL_BEGIN
 */
 - (nullable instancetype)initWithImageRep:(NSBitmapImageRep *)imageRep document:(SeaDocument*)doc spp:(int)lspp;
 
+/*!
+	@method		initWithImageRep:document:spp:bps:
+	@discussion	Initializes an instance of this class with the given image
+				representation and document, keeping its samples at the given
+				depth.
+	@param		imageRep
+				The image representation with which to initialize this layer.
+	@param		doc
+				The document to be associated with this instance.
+	@param		lspp
+				The samples per pixel of the layer.
+	@param		lbps
+				The bits per sample of the layer, either 8 or 16. Only 16-bit
+				documents may hold 16-bit layers.
+	@result		Returns instance upon success (or NULL otherwise).
+*/
+- (nullable instancetype)initWithImageRep:(NSBitmapImageRep *)imageRep document:(SeaDocument*)doc spp:(int)lspp bps:(int)lbps;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -7,6 +7,11 @@
 @implementation CocoaLayer
 
 - (instancetype)initWithImageRep:(NSBitmapImageRep *)imageRep document:(SeaDocument*)doc spp:(int)lspp
+{
+	return [self initWithImageRep:imageRep document:doc spp:lspp bps:8];
+}
+
+- (instancetype)initWithImageRep:(NSBitmapImageRep *)imageRep document:(SeaDocument*)doc spp:(int)lspp bps:(int)lbps
 {
 	ColorSyncProfileRef cmProfileLoc = NULL;
 	
@@ -15,7 +20,7 @@
 		return nil;
 	
 	// Fill out variables
-	NSInteger bps = [imageRep bitsPerSample];
+	NSInteger sbps = [imageRep bitsPerSample];
 	NSInteger sspp = [imageRep samplesPerPixel];
 	unsigned char *srcPtr = [imageRep bitmapData];
 	NSBitmapFormat format = [imageRep bitmapFormat];
@@ -24,8 +29,9 @@
 	width = (int)[imageRep pixelsWide];
 	height = (int)[imageRep pixelsHigh];
 	
-	// Determine samples per pixel
+	// Determine samples per pixel and bits per sample
 	spp = lspp;
+	bps = lbps;
 
 	// Determine the color space
 	BMPColorSpace space = -1;
@@ -49,7 +55,7 @@
 	// Convert data to what we want
 	NSInteger bipp = [imageRep bitsPerPixel];
 	NSInteger bypr = [imageRep bytesPerRow];
-	data = SeaConvertBitmap(spp, (spp == 4) ? kRGBColorSpace : kGrayColorSpace, 8, srcPtr, width, height, sspp, bipp, bypr, space, cmProfileLoc, bps, (GIMPBitmapFormat)format);
+	data = SeaConvertBitmap(spp, (spp == 4) ? kRGBColorSpace : kGrayColorSpace, bps, srcPtr, width, height, sspp, bipp, bypr, space, cmProfileLoc, sbps, (GIMPBitmapFormat)format);
 	if (cmProfileLoc) {
 		CFRelease(cmProfileLoc);
 	}
@@ -61,13 +67,16 @@
 	// Check the alpha
 	hasAlpha = NO;
 	for (int i = 0; i < width * height; i++) {
-		if (data[(i + 1) * spp - 1] != 255)
+		if ((bps == 16) ? ((uint16_t *)data)[(i + 1) * spp - 1] != 65535 : data[(i + 1) * spp - 1] != 255)
 			hasAlpha = YES;
 	}
 	
 	// Unpremultiply the image if required
 	if (hasAlpha && !(format & NSAlphaNonpremultipliedBitmapFormat)) {
-		SeaUnpremultiplyBitmap(spp, data, data, width * height);
+		if (bps == 16)
+			SeaUnpremultiplyBitmap16(spp, (uint16_t *)data, (uint16_t *)data, width * height);
+		else
+			SeaUnpremultiplyBitmap(spp, data, data, width * height);
 	}
 		
 	return self;
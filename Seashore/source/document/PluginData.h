@@ -18,9 +18,81 @@
 				<b>Copyright:</b> N/A
 */
 
+/*!
+	@defined	kLuminanceHistogram
+	@discussion	The index of the luminance histogram within PluginStatistics,
+				the histograms before it are of the layer's samples.
+*/
+#define kLuminanceHistogram 4
+
+/*!
+	@struct		PluginStatistics
+	@discussion	Statistics of the active layer's pixels within the selection,
+				pixels outside the selection's mask are not counted.
+	@field		count
+				The number of pixels counted.
+	@field		histogram
+				The histograms of each sample (from zero to the document's
+				samples per pixel less one) and, at kLuminanceHistogram, of the
+				luminance taken as the mean of the primary channels.
+	@field		minimum
+				The smallest value in each histogram.
+	@field		maximum
+				The largest value in each histogram.
+	@field		mean
+				The mean value of each histogram.
+*/
+typedef struct {
+	unsigned int count;
+	unsigned int histogram[kLuminanceHistogram + 1][256];
+	unsigned char minimum[kLuminanceHistogram + 1];
+	unsigned char maximum[kLuminanceHistogram + 1];
+	float mean[kLuminanceHistogram + 1];
+} PluginStatistics;
+
+/*!
+	@typedef	PluginKernel
+	@discussion	A block run by PluginData over part of the selection, it may be
+				called on several threads at once.
+	@param		rect
+				The part of the selection to process, in the layer's
+				co-ordinates. The block may read the layer's data up to the
+				declared halo beyond this rectangle but must only write the
+				overlay within it.
+*/
+typedef void (^PluginKernel)(IntRect rect);
+
 @class SeaDocument;
+@class SeaLayer;
+@class SeaColorPipeline;
 
-@interface PluginData : NSObject
+@interface PluginData : NSObject {
+	//! The statistics last calculated
+	PluginStatistics statistics;
+	
+	//! What the statistics were calculated for
+	__weak SeaLayer *statisticsLayer;
+	NSUInteger statisticsRevision;
+	IntRect statisticsRect;
+	NSUInteger statisticsSelectionRevision;
+	BOOL statisticsMasked;
+	
+	//! Set when the running kernel should stop
+	volatile BOOL kernelCancelled;
+	
+	//! Set while the first, visible part of a progressive preview is drawn
+	BOOL progressive;
+	
+	//! The part of the selection drawn first and the rows skipped in it
+	IntRect progressiveRect;
+	int progressiveStep;
+	
+	//! The kernels run for the visible part, kept to refine the whole selection
+	NSMutableArray *refinements;
+	
+	//! The queue refining progressive previews
+	dispatch_queue_t previewQueue;
+}
 
 //! The document associated with this object
 @property (weak) IBOutlet SeaDocument *document;
@@ -98,6 +170,103 @@
 */
 @property (readonly) BOOL hasAlpha;
 
+/*!
+	@method		statistics
+	@discussion	Returns the histograms and other statistics of the active
+				layer within the selection. The statistics are calculated in
+				parallel and cached until the layer or the selection changes,
+				so they are cheap to ask for repeatedly.
+	@result		Returns a pointer to the statistics which remains valid until
+				the next call.
+*/
+- (const PluginStatistics *)statistics NS_RETURNS_INNER_POINTER;
+
+/*!
+	@method		percentile:ofHistogram:
+	@discussion	Returns the value below which the given fraction of the counted
+				pixels fall.
+	@param		fraction
+				The fraction of pixels (from 0.0 to 1.0).
+	@param		index
+				The histogram to consider (see PluginStatistics).
+	@result		Returns the value at the given percentile.
+*/
+- (int)percentile:(float)fraction ofHistogram:(int)index;
+
+/*!
+	@method		runKernel:halo:
+	@discussion	Runs a kernel over the selection in bands of rows, spreading the
+				bands across the available cores. When the overlay is replacing
+				the host also completes each band once the kernel returns,
+				marking its pixels in the replace mask and, unless all channels
+				are selected, making the overlay's alpha channel opaque. The
+				kernel need only produce the colour samples (and the alpha
+				samples when all channels are selected).
+	@param		kernel
+				The block to run over each band.
+	@param		halo
+				How far beyond its band the kernel reads, bands are kept tall
+				enough that the overlap read twice stays small.
+	@result		Returns YES if every band was processed, NO if the run was
+				cancelled.
+*/
+- (BOOL)runKernel:(PluginKernel)kernel halo:(int)halo;
+
+/*!
+	@method		runKernel:halo:skipRows:
+	@discussion	Runs a kernel over the selection in the same way as
+				runKernel:halo:, optionally drawing every row in the first step
+				of a progressive preview. Kernels whose cost does not shrink
+				with the height of their rectangle, such as those working on
+				whole blocks or rereading neighbouring rows, should not skip
+				rows.
+	@param		kernel
+				The block to run over each band.
+	@param		halo
+				How far beyond its band the kernel reads.
+	@param		skipRows
+				YES if rows the current zoom is too small to show may be
+				skipped while previewing, NO otherwise.
+	@result		Returns YES if every band was processed, NO if the run was
+				cancelled.
+*/
+- (BOOL)runKernel:(PluginKernel)kernel halo:(int)halo skipRows:(BOOL)skipRows;
+
+/*!
+	@method		runColumnKernel:halo:
+	@discussion	Runs a kernel over the selection in strips of columns, in the
+				same way as runKernel:halo:, for the vertical passes of
+				separable filters.
+	@param		kernel
+				The block to run over each strip.
+	@param		halo
+				How far beyond its strip the kernel reads.
+	@result		Returns YES if every strip was processed, NO if the run was
+				cancelled.
+*/
+- (BOOL)runColumnKernel:(PluginKernel)kernel halo:(int)halo;
+
+/*!
+	@method		runColorPipeline:
+	@discussion	Adjusts the selection from the layer's data into the overlay in
+				one pass through a colour pipeline, compiling the pipeline
+				first if needed. The overlay's opacity and behaviour should be
+				set beforehand as for any kernel.
+	@param		pipeline
+				The pipeline to apply.
+	@result		Returns YES if the whole selection was processed, NO if the run
+				was cancelled.
+*/
+- (BOOL)runColorPipeline:(SeaColorPipeline *)pipeline;
+
+/*!
+	@method		cancelKernel
+	@discussion	Stops the running kernel, bands that have already started are
+				finished but no more are begun. This may be called from any
+				thread, including from within the kernel itself.
+*/
+- (void)cancelKernel;
+
 /*!
 	@method		point:
 	@discussion	Returns the given point from the effect tool. Only valid
@@ -194,6 +363,28 @@
 */
 - (void)preview;
 
+/*!
+	@method		previewProgressively:
+	@discussion	Previews the plug-in changes in two steps so the preview keeps up
+				with the plug-in's controls. First the renderer is run with
+				kernels limited to the part of the selection in view, skipping
+				rows that the current zoom is too small to show, and the result
+				is shown at once. The kernels it ran are then run again in the
+				background, in the same order, over the whole selection at full
+				resolution and the view refreshed when they are done. Only the
+				kernels are rerun, so the renderer itself is only ever run on
+				the main thread. A refinement still running is cancelled by the
+				next preview, by changing the overlay's opacity or behaviour,
+				by running a kernel on the main thread or by cancel, while
+				apply waits for it to finish.
+	@param		renderer
+				The block producing the plug-in changes through runKernel:halo:,
+				runColumnKernel:halo: and runColorPipeline:. Kernels must take
+				any settings they need when they are created rather than read
+				them from the plug-in as they run.
+*/
+- (void)previewProgressively:(void (^)(void))renderer;
+
 /*!
 	@method		cancel
 	@discussion	Cancel the plug-in changes.
@@ -9,6 +9,26 @@
 #import "SeaPrefs.h"
 #import "EffectTool.h"
 #import "SeaTools.h"
+#import "SeaView.h"
+#import "ColorPipeline.h"
+
+// The fewest rows (or columns) given to a kernel at once
+#define kKernelMinBand 16
+
+// How a kernel is run, decided on the thread that asked for it
+typedef struct {
+	IntRect rect;
+	int halo, step, spp, width;
+	BOOL vertical, replacing, opaque;
+	unsigned char *overlay, *replace;
+} PluginPass;
+
+@interface PluginData ()
+- (BOOL)runKernel:(PluginKernel)kernel halo:(int)halo vertical:(BOOL)vertical skipRows:(BOOL)skipRows;
+- (BOOL)runKernel:(PluginKernel)kernel pass:(PluginPass)pass;
+- (IntRect)visibleRect;
+- (void)cancelPreview;
+@end
 
 @implementation PluginData
 @synthesize document;
@@ -69,6 +89,287 @@
 	return [[[document contents] activeLayer] hasAlpha];
 }
 
+- (const PluginStatistics *)statistics
+{
+	SeaLayer *layer = [[document contents] activeLayer];
+	SeaSelection *selection = document.selection;
+	IntRect rect = [self selection];
+	unsigned char *data = [layer data];
+	unsigned char *mask = (selection.active && !selection.floating) ? [selection mask] : NULL;
+	IntPoint maskOffset = [selection maskOffset];
+	IntSize maskSize = [selection maskSize];
+	int spp = [self spp], width = [layer width];
+	size_t chunks, rowsPerChunk;
+	unsigned int (*partials)[kLuminanceHistogram + 2][256];
+	unsigned long total;
+	
+	// Reuse the last statistics if nothing has changed
+	if (layer == statisticsLayer && [layer revision] == statisticsRevision && [selection revision] == statisticsSelectionRevision && (mask != NULL) == statisticsMasked && memcmp(&rect, &statisticsRect, sizeof(IntRect)) == 0)
+		return &statistics;
+	
+	// Each chunk of rows gets its own histograms (with a spare row for the count)
+	rowsPerChunk = MAX(16, rect.size.height / 64 + 1);
+	chunks = (rect.size.height + rowsPerChunk - 1) / rowsPerChunk;
+	partials = calloc(MAX(chunks, 1), sizeof(*partials));
+	dispatch_apply(chunks, dispatch_get_global_queue(0, 0), ^(size_t chunk) {
+		unsigned int (*partial)[256] = partials[chunk];
+		int top = rect.origin.y + (int)(chunk * rowsPerChunk);
+		int bottom = MIN(top + (int)rowsPerChunk, rect.origin.y + rect.size.height);
+		unsigned char *pixel;
+		int i, j, k, mid;
+		
+		for (j = top; j < bottom; j++) {
+			for (i = rect.origin.x; i < rect.origin.x + rect.size.width; i++) {
+				if (mask && mask[(maskOffset.y - rect.origin.y + j) * maskSize.width + (maskOffset.x - rect.origin.x + i)] == 0)
+					continue;
+				pixel = &(data[(j * width + i) * spp]);
+				mid = 0;
+				for (k = 0; k < spp; k++) {
+					partial[k][pixel[k]]++;
+					if (k < spp - 1)
+						mid += pixel[k];
+				}
+				partial[kLuminanceHistogram][mid / (spp - 1)]++;
+				partial[kLuminanceHistogram + 1][0]++;
+			}
+		}
+	});
+	
+	// Merge the partial histograms and derive the rest
+	memset(&statistics, 0, sizeof(statistics));
+	for (size_t chunk = 0; chunk < chunks; chunk++) {
+		for (int k = 0; k <= kLuminanceHistogram; k++) {
+			for (int i = 0; i < 256; i++)
+				statistics.histogram[k][i] += partials[chunk][k][i];
+		}
+		statistics.count += partials[chunk][kLuminanceHistogram + 1][0];
+	}
+	free(partials);
+	for (int k = 0; k <= kLuminanceHistogram; k++) {
+		statistics.minimum[k] = 255;
+		total = 0;
+		for (int i = 0; i < 256; i++) {
+			if (statistics.histogram[k][i]) {
+				statistics.minimum[k] = MIN(statistics.minimum[k], i);
+				statistics.maximum[k] = i;
+				total += (unsigned long)statistics.histogram[k][i] * i;
+			}
+		}
+		statistics.mean[k] = (statistics.count) ? (float)total / statistics.count : 0.0;
+	}
+	
+	// Remember what the statistics are for
+	statisticsLayer = layer;
+	statisticsRevision = [layer revision];
+	statisticsSelectionRevision = [selection revision];
+	statisticsMasked = (mask != NULL);
+	statisticsRect = rect;
+	
+	return &statistics;
+}
+
+- (int)percentile:(float)fraction ofHistogram:(int)index
+{
+	const PluginStatistics *stats = [self statistics];
+	unsigned long target = (unsigned long)(fraction * stats->count), sum = 0;
+	
+	for (int i = 0; i < 256; i++) {
+		sum += stats->histogram[index][i];
+		if (sum > target)
+			return i;
+	}
+	
+	return stats->maximum[index];
+}
+
+- (BOOL)runKernel:(PluginKernel)kernel halo:(int)halo vertical:(BOOL)vertical skipRows:(BOOL)skipRows
+{
+	PluginPass pass, full;
+	
+	pass.rect = [self selection];
+	pass.halo = halo;
+	pass.step = 1;
+	pass.spp = [self spp];
+	pass.width = [self width];
+	pass.vertical = vertical;
+	pass.replacing = ([self overlayBehaviour] == SeaOverlayBehaviourReplacing);
+	pass.opaque = ([self channel] != kAllChannels);
+	pass.overlay = [self overlay];
+	pass.replace = [self replace];
+	[[document whiteboard] touchOverlay:pass.rect];
+	
+	// Draw only what is in view for the first step of a progressive preview,
+	// keeping the kernel to refine the whole selection later, otherwise any
+	// refinement still running must stop before we begin
+	if (progressive) {
+		full = pass;
+		[refinements addObject:^BOOL{
+			return [self runKernel:kernel pass:full];
+		}];
+		pass.rect = IntConstrainRect(progressiveRect, pass.rect);
+		if (!vertical && skipRows)
+			pass.step = progressiveStep;
+	}
+	else if ([NSThread isMainThread]) {
+		[self cancelPreview];
+	}
+	
+	return [self runKernel:kernel pass:pass];
+}
+
+- (BOOL)runKernel:(PluginKernel)kernel pass:(PluginPass)pass
+{
+	IntRect rect = pass.rect;
+	unsigned char *overlay = pass.overlay, *replace = pass.replace;
+	int spp = pass.spp, width = pass.width, step = pass.step;
+	BOOL vertical = pass.vertical;
+	int extent, bandSize, bands;
+	
+	// Keep bands tall enough that rereading the halo costs little
+	extent = (vertical) ? rect.size.width : rect.size.height;
+	bandSize = MAX(MAX(kKernelMinBand, pass.halo * 4), extent / 64 + 1);
+	bands = (extent + bandSize - 1) / bandSize;
+	dispatch_apply(bands, dispatch_get_global_queue(0, 0), ^(size_t index) {
+		IntRect band = rect;
+		int i, j, k;
+		
+		if (kernelCancelled)
+			return;
+		if (vertical) {
+			band.origin.x += (int)index * bandSize;
+			band.size.width = MIN(bandSize, rect.origin.x + rect.size.width - band.origin.x);
+		}
+		else {
+			band.origin.y += (int)index * bandSize;
+			band.size.height = MIN(bandSize, rect.origin.y + rect.size.height - band.origin.y);
+		}
+		if (step > 1) {
+			// Run the kernel on every step-th row and repeat each over the rows skipped
+			for (j = band.origin.y; j < band.origin.y + band.size.height; j += step) {
+				kernel(IntMakeRect(band.origin.x, j, band.size.width, 1));
+				for (k = j + 1; k < MIN(j + step, band.origin.y + band.size.height); k++)
+					memcpy(&(overlay[(k * width + band.origin.x) * spp]), &(overlay[(j * width + band.origin.x) * spp]), band.size.width * spp);
+			}
+		}
+		else {
+			kernel(band);
+		}
+		
+		// Complete the band for the selected channels
+		if (pass.replacing) {
+			for (j = band.origin.y; j < band.origin.y + band.size.height; j++) {
+				memset(&(replace[j * width + band.origin.x]), 255, band.size.width);
+				if (pass.opaque) {
+					for (i = band.origin.x; i < band.origin.x + band.size.width; i++)
+						overlay[(j * width + i + 1) * spp - 1] = 255;
+				}
+			}
+		}
+	});
+	
+	return !kernelCancelled;
+}
+
+- (BOOL)runKernel:(PluginKernel)kernel halo:(int)halo
+{
+	return [self runKernel:kernel halo:halo vertical:NO skipRows:YES];
+}
+
+- (BOOL)runKernel:(PluginKernel)kernel halo:(int)halo skipRows:(BOOL)skipRows
+{
+	return [self runKernel:kernel halo:halo vertical:NO skipRows:skipRows];
+}
+
+- (BOOL)runColumnKernel:(PluginKernel)kernel halo:(int)halo
+{
+	return [self runKernel:kernel halo:halo vertical:YES skipRows:NO];
+}
+
+- (BOOL)runColorPipeline:(SeaColorPipeline *)pipeline
+{
+	unsigned char *data = [self data], *overlay = [self overlay];
+	int spp = [self spp], width = [self width];
+	SeaSelectedChannel channel = [self channel];
+	
+	[pipeline compileForSpp:spp];
+	return [self runKernel:^(IntRect rect) {
+		for (int j = rect.origin.y; j < rect.origin.y + rect.size.height; j++) {
+			int pos = (j * width + rect.origin.x) * spp;
+			[pipeline applyToData:&(overlay[pos]) fromData:&(data[pos]) length:rect.size.width spp:spp channel:channel];
+		}
+	} halo:0];
+}
+
+- (void)cancelKernel
+{
+	kernelCancelled = YES;
+}
+
+- (IntRect)visibleRect
+{
+	SeaContent *contents = [document contents];
+	SeaLayer *layer = [contents activeLayer];
+	NSRect visible = [[document docView] visibleRect];
+	CGFloat xscale = [contents xscale], yscale = [contents yscale];
+	IntRect rect;
+	
+	// Convert from the view's co-ordinates to the layer's
+	rect.origin.x = floor(NSMinX(visible) / xscale) - [layer xoff];
+	rect.origin.y = floor(NSMinY(visible) / yscale) - [layer yoff];
+	rect.size.width = ceil(NSWidth(visible) / xscale) + 1;
+	rect.size.height = ceil(NSHeight(visible) / yscale) + 1;
+	
+	return rect;
+}
+
+- (void)cancelPreview
+{
+	if (previewQueue) {
+		kernelCancelled = YES;
+		dispatch_sync(previewQueue, ^{});
+	}
+	kernelCancelled = NO;
+}
+
+- (void)previewProgressively:(void (^)(void))renderer
+{
+	IntRect visible, selection = [self selection];
+	CGFloat yscale = [[document contents] yscale];
+	NSArray *passes;
+	
+	[self cancelPreview];
+	if (!previewQueue)
+		previewQueue = dispatch_queue_create("com.seashore.PluginData.preview", DISPATCH_QUEUE_SERIAL);
+	
+	// Draw what is in view at the resolution it is seen
+	visible = IntConstrainRect([self visibleRect], selection);
+	progressiveRect = visible;
+	progressiveStep = (yscale < 1.0) ? MAX(1, (int)(1.0 / yscale)) : 1;
+	refinements = [NSMutableArray array];
+	progressive = YES;
+	renderer();
+	progressive = NO;
+	passes = refinements;
+	refinements = nil;
+	[[document helpers] overlayChanged:visible inThread:NO];
+	
+	// Then refine the whole selection unless that is what was drawn, only
+	// the kernels are rerun so the plug-in and whiteboard are left alone
+	if (progressiveStep == 1 && IntContainsRect(visible, selection))
+		return;
+	dispatch_async(previewQueue, ^{
+		for (BOOL (^pass)(void) in passes) {
+			if (kernelCancelled || !pass())
+				return;
+		}
+		if (kernelCancelled)
+			return;
+		dispatch_async(dispatch_get_main_queue(), ^{
+			[[document helpers] overlayChanged:selection inThread:NO];
+		});
+	});
+}
+
 - (IntPoint)point:(NSInteger)index;
 {
 	return [[[document tools] getTool:kEffectTool] point:index];
@@ -116,6 +417,8 @@
 
 - (void)setOverlayBehaviour:(SeaOverlayBehaviour)value
 {
+	if (!progressive && [NSThread isMainThread])
+		[self cancelPreview];
 	[[document whiteboard] setOverlayBehaviour:value];
 }
 
@@ -126,6 +429,8 @@
 
 - (void)setOverlayOpacity:(int)value
 {
+	if (!progressive && [NSThread isMainThread])
+		[self cancelPreview];
 	[[document whiteboard] setOverlayOpacity:value];
 }
 
@@ -146,6 +451,10 @@
 
 - (void)apply
 {
+	// Wait for any refinement so the full result is applied
+	if (previewQueue)
+		dispatch_sync(previewQueue, ^{});
+	[[document whiteboard] touchOverlay:[self selection]];
 	[[document helpers] applyOverlay];
 }
 
@@ -156,6 +465,7 @@
 
 - (void)cancel
 {
+	[self cancelPreview];
 	[[document whiteboard] clearOverlay];
 	[[document helpers] overlayChanged:[self selection] inThread:NO];
 }
@@ -57,6 +57,9 @@ typedef struct {
 	// The document's type
 	XcfImageType type;
 	
+	// The bits per sample of the document's deep layers (8 unless the document is 16-bit)
+	int bps;
+	
 	// The lost properties of the document
 	char *lostprops;
 	int lostprops_len;
@@ -204,6 +207,15 @@ typedef struct {
 */
 @property (readonly, getter=spp) int samplesPerPixel;
 
+/*!
+	@property	bps
+	@discussion	Returns the bits per sample of the document. New layers of a
+				16-bit document are 16-bit, though it may hold 8-bit layers as
+				well, and its whiteboard composites at 16 bits.
+	@result		Returns either 8 or 16.
+*/
+@property (readonly) int bps;
+
 /*!
 	@property	xres
 	@discussion	Returns the horizontal resolution of the document.
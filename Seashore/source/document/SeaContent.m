@@ -38,6 +38,9 @@ static NSString*	FloatAnchorToolbarItemIdentifier = @"Float/Anchor Toolbar Item
 static NSString*	DuplicateSelectionToolbarItemIdentifier = @"Duplicate Selection Toolbar Item Identifier";
 #endif
 
+/// The size of the tiles in which layers are merged
+#define kMergeTileSize 256
+
 @implementation SeaContent {
 #if MAIN_COMPILE
 	// The keeper we use to keep IndiciesRecords in memory
@@ -51,6 +54,7 @@ static NSString*	DuplicateSelectionToolbarItemIdentifier = @"Duplicate Selection
 @synthesize trueView;
 @synthesize activeLayerIndex;
 @synthesize type;
+@synthesize bps;
 @synthesize verticalResolution=yres;
 @synthesize horizontalResolution=xres;
 @synthesize height;
@@ -68,6 +72,7 @@ static NSString*	DuplicateSelectionToolbarItemIdentifier = @"Duplicate Selection
 	// Set the data members to reasonable values
 	xres = yres = 72;
 	height = width = type = 0;
+	bps = 8;
 	lostprops = NULL; lostprops_len = 0;
 	parasites = NULL; parasites_count = 0;
 	exifData = NULL;
@@ -214,6 +219,7 @@ static NSString*	DuplicateSelectionToolbarItemIdentifier = @"Duplicate Selection
 		// Set the data members to reasonable values
 		xres = yres = 72;
 		height = width = type = 0;
+		bps = 8;
 		lostprops = NULL; lostprops_len = 0;
 		parasites = NULL; parasites_count = 0;
 		exifData = NULL;
@@ -1217,6 +1223,7 @@ static NSString*	DuplicateSelectionToolbarItemIdentifier = @"Duplicate Selection
 		}
 	}
 	free(data);
+	[[document whiteboard] touchOverlay:IntMakeRect(dataRect.origin.x - layerRect.origin.x, dataRect.origin.y - layerRect.origin.y, dataRect.size.width, dataRect.size.height)];
 	
 	// Clear the selection
 	[[document selection] clearSelection];
@@ -1411,7 +1418,7 @@ static NSString*	DuplicateSelectionToolbarItemIdentifier = @"Duplicate Selection
 - (void)copyMerged
 {
 	id pboard = [NSPasteboard generalPasteboard];
-	int spp = [[document contents] spp], i , j, k, t1;
+	int spp = [[document contents] spp], i, t1;
 	NSBitmapImageRep *imageRep;
 	IntRect globalRect;
 	unsigned char *data = [(SeaWhiteboard *)[document whiteboard] data];
@@ -1423,23 +1430,10 @@ static NSString*	DuplicateSelectionToolbarItemIdentifier = @"Duplicate Selection
 		mask = [[document selection] mask];
 		globalRect = [[document selection] globalRect];
 		ndata = malloc(make_128(globalRect.size.width * globalRect.size.height * spp));
+		[[(SeaWhiteboard *)[document whiteboard] snapshot] copyRect:globalRect toData:ndata];
 		if (mask) {
-			for (j = globalRect.origin.y; j < globalRect.origin.y + globalRect.size.height; j++) {
-				for (i = globalRect.origin.x; i < globalRect.origin.x + globalRect.size.width; i++) {
-					for (k = 0; k < spp; k++) {
-						ndata[((j - globalRect.origin.y) * globalRect.size.width + (i - globalRect.origin.x)) * spp + k] =  int_mult(data[(j * width + i) * spp + k], mask[(j - globalRect.origin.y) * globalRect.size.width + (i - globalRect.origin.x)], t1);
-					}
-				}
-			}
-		}
-		else {
-			for (j = globalRect.origin.y; j < globalRect.origin.y + globalRect.size.height; j++) {
-				for (i = globalRect.origin.x; i < globalRect.origin.x + globalRect.size.width; i++) {
-					for (k = 0; k < spp; k++) {
-						ndata[((j - globalRect.origin.y) * globalRect.size.width + (i - globalRect.origin.x)) * spp + k] =  data[(j * width + i) * spp + k];
-					}
-				}
-			}
+			for (i = 0; i < globalRect.size.width * globalRect.size.height * spp; i++)
+				ndata[i] = int_mult(ndata[i], mask[i / spp], t1);
 		}
 	}
 	else {
@@ -1512,9 +1506,9 @@ static NSString*	DuplicateSelectionToolbarItemIdentifier = @"Duplicate Selection
 - (void)merge:(NSArray *)mergingLayers useRepresentation:(BOOL)useRepresenation withName:(NSString *)newName
 {
 	CompositorOptions options;
-	unsigned char *data;
+	unsigned char *data, *source = NULL;
 	SeaLayer *layer, *lostLayer, *tempLayer = [SeaLayer alloc];
-	int spp = [self spp];
+	int spp = [self spp], pixelSize = spp * (bps / 8);
 	BOOL indexFound = NO;
 	NSMutableArray *tempArray = [NSMutableArray array];
 	IntRect rect = IntMakeRect(0,0,0,0);
@@ -1541,8 +1535,11 @@ static NSString*	DuplicateSelectionToolbarItemIdentifier = @"Duplicate Selection
 	if(useRepresenation){
 		rect.size.width = width;
 		rect.size.height = height;
-		data = malloc(make_128(rect.size.width * rect.size.height * spp));
-		memcpy(data, [(NSBitmapImageRep*)[[[document whiteboard] image] representations][0] bitmapData], rect.size.width * rect.size.height * spp);
+		data = malloc(make_128(rect.size.width * rect.size.height * pixelSize));
+		if (bps == 16)
+			source = (unsigned char *)[(SeaWhiteboard *)[document whiteboard] deepData];
+		else
+			source = [(NSBitmapImageRep*)[[[document whiteboard] image] representations][0] bitmapData];
 		NSEnumerator *e = [layers objectEnumerator];
 		while(layer = [e nextObject]){
 			[ordering setValue: @([layers indexOfObject: layer]) forKey: [NSString stringWithFormat: @"%d" ,[layer uniqueLayerID]]];
@@ -1563,25 +1560,54 @@ static NSString*	DuplicateSelectionToolbarItemIdentifier = @"Duplicate Selection
 				[tempArray addObject:layer];
 			}
 		}
-		data = malloc(make_128(rect.size.width * rect.size.height * spp));
-		memset(data, 0, rect.size.width * rect.size.height * spp);
-		// Set the composting options
-		options.forceNormal = 0;
-		options.rect = rect;
-		options.destRect = rect;
-		options.insertOverlay = NO;
-		options.useSelection = NO;
-		options.overlayOpacity = 255;
-		options.overlayBehaviour = SeaOverlayBehaviourNormal;
-		options.spp = spp;
-
-		// Composite the linked layers
-		NSEnumerator *f = [mergingLayers reverseObjectEnumerator];
-		while(layer = [f nextObject])
-			[[[document whiteboard] compositor] compositeLayer:layer withOptions:options andData: data];
-	}
-	SeaUnpremultiplyBitmap(spp, data, data, rect.size.width * rect.size.height);
-	layer = [[SeaLayer alloc] initWithDocument:document rect:rect data:data spp:spp];
+		data = malloc(make_128(rect.size.width * rect.size.height * pixelSize));
+	}
+	
+	// Set the composting options
+	options.forceNormal = 0;
+	options.rect = rect;
+	options.destRect = rect;
+	options.insertOverlay = NO;
+	options.useSelection = NO;
+	options.overlayOpacity = 255;
+	options.overlayBehaviour = SeaOverlayBehaviourNormal;
+	options.spp = spp;
+	options.bps = bps;
+	
+	// Build the new layer a tile at a time, so each tile is composited and
+	// unpremultiplied while it is still in the cache
+	NSArray *compositingLayers = [[mergingLayers reverseObjectEnumerator] allObjects];
+	id<SeaCompositor> compositor = [[document whiteboard] compositor];
+	int tilesAcross = (rect.size.width + kMergeTileSize - 1) / kMergeTileSize;
+	int tilesDown = (rect.size.height + kMergeTileSize - 1) / kMergeTileSize;
+	dispatch_apply(tilesAcross * tilesDown, dispatch_get_global_queue(0, 0), ^(size_t index) {
+		CompositorOptions tileOptions = options;
+		IntRect tile = IntMakeRect(rect.origin.x + (int)(index % tilesAcross) * kMergeTileSize, rect.origin.y + (int)(index / tilesAcross) * kMergeTileSize, kMergeTileSize, kMergeTileSize);
+		int j, pos;
+		
+		tile = IntConstrainRect(tile, rect);
+		for (j = tile.origin.y - rect.origin.y; j < tile.origin.y - rect.origin.y + tile.size.height; j++) {
+			pos = (j * rect.size.width + tile.origin.x - rect.origin.x) * pixelSize;
+			if (source)
+				memcpy(&(data[pos]), &(source[pos]), tile.size.width * pixelSize);
+			else
+				memset(&(data[pos]), 0, tile.size.width * pixelSize);
+		}
+		if (!source) {
+			tileOptions.rect = tile;
+			for (SeaLayer *mergingLayer in compositingLayers)
+				[compositor compositeLayer:mergingLayer withOptions:tileOptions andData:data];
+		}
+		for (j = tile.origin.y - rect.origin.y; j < tile.origin.y - rect.origin.y + tile.size.height; j++) {
+			pos = (j * rect.size.width + tile.origin.x - rect.origin.x) * pixelSize;
+			if (bps == 16)
+				SeaUnpremultiplyBitmap16(spp, (uint16_t *)&(data[pos]), (uint16_t *)&(data[pos]), tile.size.width);
+			else
+				SeaUnpremultiplyBitmap(spp, &(data[pos]), &(data[pos]), tile.size.width);
+		}
+	});
+	layer = [[SeaLayer alloc] initWithDocument:document rect:rect data:data spp:spp bps:bps];
+	free(data);
 	[layer setName:[[NSString alloc] initWithString:newName]];
 
 	// Get rid of all the other layers
@@ -1659,14 +1685,16 @@ static NSString*	DuplicateSelectionToolbarItemIdentifier = @"Duplicate Selection
 - (unsigned char *)bitmapUnderneath:(IntRect)rect
 {
 	CompositorOptions options;
-	unsigned char *data;
+	unsigned char *data, *deepData = NULL;
 	SeaLayer *layer;
 	NSInteger i;
 	int spp = [self spp];
 	
-	// Create the replacement flat layer
+	// Create the replacement flat layer, 16-bit documents composite at 16 bits
 	data = malloc(make_128(rect.size.width * rect.size.height * spp));
 	memset(data, 0, rect.size.width * rect.size.height * spp);
+	if (bps == 16)
+		deepData = calloc(rect.size.width * rect.size.height * spp, sizeof(uint16_t));
 
 	// Set the composting options
 	options.forceNormal = 0;
@@ -1677,15 +1705,22 @@ static NSString*	DuplicateSelectionToolbarItemIdentifier = @"Duplicate Selection
 	options.overlayOpacity = 255;
 	options.overlayBehaviour = SeaOverlayBehaviourNormal;
 	options.spp = spp;
+	options.bps = bps;
 
 	// Composite the layers underneath
 	for (i = [layers count] - 1; i >= activeLayerIndex; i--) {
 		layer = layers[i];
 		if (layer.visible) {
-			[[[document whiteboard] compositor] compositeLayer:layer withOptions:options andData:data];
+			[[[document whiteboard] compositor] compositeLayer:layer withOptions:options andData:(deepData) ? deepData : data];
 		}
 	}
 	
+	// The callers only read 8-bit bitmaps
+	if (deepData) {
+		SeaNarrowSamples(data, (uint16_t *)deepData, rect.size.width * rect.size.height * spp);
+		free(deepData);
+	}
+	
 	return data;
 }
 
@@ -1744,8 +1779,8 @@ static NSString*	DuplicateSelectionToolbarItemIdentifier = @"Duplicate Selection
 	IndiciesRecord record;
 	id layer;
 	
-	// Do nothing if there is nothing to do
-	if (newType == type)
+	// Do nothing if there is nothing to do, the conversions are not made at 16 bits
+	if (newType == type || bps == 16)
 		return;
 	
 	// Make action undoable
@@ -154,7 +154,7 @@
 	
 	rect = [[document whiteboard] applyOverlay];
 	layer = [contents activeLayer];
-	[layer updateThumbnail];
+	[layer updateThumbnailInRect:IntMakeRect(rect.origin.x - [layer xoff], rect.origin.y - [layer yoff], rect.size.width, rect.size.height)];
 	[[document whiteboard] update:rect inThread:NO];
 	[[[SeaController utilitiesManager] pegasusUtilityFor:document] update:kPegasusUpdateLayerView];
 }
@@ -163,6 +163,7 @@
 {
 	SeaContent *contents = [document contents];
 	
+	[[document whiteboard] touchOverlay:rect];
 	rect.origin.x += [[contents activeLayer] xoff];
 	rect.origin.y += [[contents activeLayer] yoff];
 	[[document whiteboard] update:rect inThread:thread];
@@ -336,10 +337,10 @@
 	SeaLayer *layer;
 	
 	layer = [[document contents] layerAtIndex:index];
+	[layer updateThumbnailInRect:rect];
 	rect.origin.x += [layer xoff];
 	rect.origin.y += [layer yoff];
 	[(SeaWhiteboard *)[document whiteboard] update:rect inThread:NO];
-	[layer updateThumbnail];
 	[[[SeaController utilitiesManager] pegasusUtilityFor:document] update:kPegasusUpdateLayerView];
 }
 
@@ -47,6 +47,10 @@
 	//! (this should be the same as determined from the document's type)
 	int spp;
 	
+	//! The bits per sample in this layer, 16 for the deep layers of a 16-bit
+	//! document and otherwise 8
+	int bps;
+	
 	//! Is the layer visible?
 	BOOL visible;
 	
@@ -68,6 +72,14 @@
 	unsigned char *thumbData;
 	int thumbWidth, thumbHeight;
 	
+	//! The layer's premultiplied data box-filtered to a few times the size of
+	//! its thumbnail, so an edit only reduces the part of the layer it changed
+	unsigned char *reducedData;
+	int reducedWidth, reducedHeight;
+	
+	//! Counts the changes made to the layer's contents
+	NSUInteger revision;
+	
 	//! Stores whether or not the data is compressed
 	BOOL compressed;
 	unsigned int compressedLen;
@@ -137,6 +149,27 @@
 */
 - (instancetype)initWithDocument:(SeaDocument *)doc rect:(IntRect)lrect data:(unsigned char *)ldata spp:(int)lspp;
 
+/*!
+	@method		initWithDocument:rect:data:spp:bps:
+	@discussion	Initializes an instance of this class with the given bitmap data
+				of the given depth (the bitmap data is copied).
+	@param		doc
+				The document with which to initialize the instance.
+	@param		lrect
+				The rectangle with which to initialize the instance. This
+				determines the width, height and offsets of the layer.
+	@param		ldata
+				The block of memory containing the bitmap data, for 16-bit
+				layers this holds native-endian 16-bit samples.
+	@param		lspp
+				The samples per pixel of the layer.
+	@param		lbps
+				The bits per sample of the layer, either 8 or 16. Only 16-bit
+				documents may hold 16-bit layers.
+	@result		Returns instance upon success (or NULL otherwise).
+*/
+- (instancetype)initWithDocument:(SeaDocument *)doc rect:(IntRect)lrect data:(unsigned char *)ldata spp:(int)lspp bps:(int)lbps;
+
 /*!
 	@method		initWithDocument:layer:type:
 	@discussion	Initialize an instance of this class to mimic the contents of
@@ -233,6 +266,15 @@
 @property (readonly, getter=yoff) int yOffset;
 
 #if MAIN_COMPILE
+/*!
+	@property	revision
+	@discussion	Returns a number that changes whenever the layer's contents are
+				changed (as signalled by updating its thumbnail), so results
+				derived from the contents can be cached against it.
+	@result		Returns the revision of the layer's contents.
+*/
+@property (readonly) NSUInteger revision;
+
 /*!
 	@property	localRect
 	@discussion	For finding out where it is, simply a combination of the above values.
@@ -409,6 +451,34 @@
 */
 @property (readonly) unsigned char *data NS_RETURNS_INNER_POINTER;
 
+/*!
+	@property	bps
+	@discussion	Returns the bits per sample of the layer's bitmap data. This is
+				16 for the deep layers of a 16-bit document, whose data holds
+				native-endian 16-bit samples, and 8 otherwise.
+	@result		Returns either 8 or 16.
+*/
+@property (readonly) int bps;
+
+#if MAIN_COMPILE
+/*!
+	@method		copyNarrowedData
+	@discussion	Returns an 8-bit copy of the layer's bitmap data, narrowing the
+				samples of a 16-bit layer. This is for the code that only reads
+				8-bit bitmaps.
+	@result		Returns a block of memory width * height * spp bytes long that
+				the caller is responsible for freeing.
+*/
+- (unsigned char *)copyNarrowedData;
+
+/*!
+	@method		narrowSamples
+	@discussion	Converts a 16-bit layer to an 8-bit one, doing nothing for a
+				layer that is already 8-bit.
+*/
+- (void)narrowSamples;
+#endif
+
 /*!
 	@property	hasAlpha
 	@discussion	Returns whether or not the layer's alpha channel should be
@@ -519,11 +589,24 @@
 	@discussion	Updates the thumbnail so that it is up-to-date with the layer's
 				contents. This routine does not consider the overlay so it
 				should only be called after the overlay is applied to the layer.
-				Thumbnails are calculated by taking at most 2000  pixels that
-				are considered representative of the image.
+				Thumbnails are box-filtered from a small reduction of the layer
+				which is rebuilt in its entirety, if only part of the layer has
+				changed use updateThumbnailInRect: instead.
 */
 - (void)updateThumbnail;
 
+/*!
+	@method		updateThumbnailInRect:
+	@discussion	Updates the thumbnail so that it is up-to-date with the layer's
+				contents after the given rectangle of the layer has changed.
+				Only the part of the layer's reduction lying under the
+				rectangle is recomputed. This routine does not consider the overlay so it
+				should only be called after the overlay is applied to the layer.
+	@param		rect
+				The rectangle that has changed in the layer's co-ordinates.
+*/
+- (void)updateThumbnailInRect:(IntRect)rect;
+
 /*!
 	@method		TIFFRepresentation
 	@discussion	Returns a TIFF representation of the layer.
@@ -27,6 +27,7 @@
 @synthesize width;
 @synthesize height;
 @synthesize uniqueLayerID;
+@synthesize bps;
 
 #if MAIN_COMPILE
 - (instancetype)initWithDocument:(SeaDocument *)doc
@@ -34,7 +35,7 @@
 	// Set the data members to reasonable values
 	if (self = [super init]) {
 		opacity = 255;
-		spp = 4; visible = YES;
+		spp = 4; bps = 8; visible = YES;
 		hasAlpha = YES;
 		lostprops = NULL;
 		document = doc;
@@ -45,7 +46,7 @@
 		else
 			name = [[NSString alloc] initWithFormat:LOCALSTR(@"layer title", @"Layer %d"), uniqueLayerID];
 		oldNames = [[NSArray alloc] init];
-		undoFilePath = [[NSString alloc] initWithFormat:@"/tmp/seaundo-d%d-l%d", [document uniqueDocID], [self uniqueLayerID]];
+		undoFilePath = [[[SeaController seaPrefs] scratchDirectory] stringByAppendingPathComponent:[NSString stringWithFormat:@"seaundo-d%d-l%d", [document uniqueDocID], [self uniqueLayerID]]];
 		affinePlugin = [[SeaController seaPlugins] affinePlugin];
 	}
 	return self;
@@ -60,15 +61,16 @@
 	// Extract appropriate values of master
 	width = lwidth; height = lheight;
 	
-	// Get the appropriate samples per pixel
+	// Get the appropriate samples per pixel, new layers of a 16-bit document are deep
 	spp = lspp;
+	bps = ([(SeaContent *)[doc contents] bps] == 16) ? 16 : 8;
 	
-	// Create a representation in memory of the blank canvas
-	data = malloc(make_128(width * height * spp));
+	// Create a representation in memory of the blank canvas (all ones is 65535 too)
+	data = malloc(make_128(width * height * spp * (bps / 8)));
 	if (opaque)
-		memset(data, 255, width * height * spp);
+		memset(data, 255, width * height * spp * (bps / 8));
 	else
-		memset(data, 0, width * height * spp);
+		memset(data, 0, width * height * spp * (bps / 8));
 	
 	// Remember the alpha situation
 	hasAlpha = !opaque;
@@ -77,6 +79,11 @@
 }
 
 - (instancetype)initWithDocument:(SeaDocument*)doc rect:(IntRect)lrect data:(unsigned char *)ldata spp:(int)lspp
+{
+	return [self initWithDocument:doc rect:lrect data:ldata spp:lspp bps:8];
+}
+
+- (instancetype)initWithDocument:(SeaDocument*)doc rect:(IntRect)lrect data:(unsigned char *)ldata spp:(int)lspp bps:(int)lbps
 {
 	// Call the core initializer
 	if (![self initWithDocument:doc])
@@ -86,12 +93,13 @@
 	xoff = lrect.origin.x; yoff = lrect.origin.y;
 	width = lrect.size.width; height = lrect.size.height;
 	
-	// Get the appropriate samples per pixel
+	// Get the appropriate samples per pixel and bits per sample
 	spp = lspp;
+	bps = lbps;
 	
 	// Copy over the bitmap data
-	data = malloc(make_128(width * height * spp));
-	memcpy(data, ldata, width * height * spp);
+	data = malloc(make_128(width * height * spp * (bps / 8)));
+	memcpy(data, ldata, width * height * spp * (bps / 8));
 
 	// We should always have an alpha layer unless you turn it off
 	hasAlpha = YES;
@@ -110,8 +118,9 @@
 	height = [layer height];
 	mode = [layer mode];
 	spp = [[[layer document] contents] spp];
-	data = malloc(make_128(width * height * spp));
-	data = memcpy(data, [layer data], width * height * spp);
+	bps = [layer bps];
+	data = malloc(make_128(width * height * spp * (bps / 8)));
+	data = memcpy(data, [layer data], width * height * spp * (bps / 8));
 	xoff = [layer xoff];
 	yoff = [layer yoff];
 	visible = [layer isVisible];
@@ -121,6 +130,10 @@
 	// Assume we always have alpha
 	hasAlpha = YES;
 	
+	// Deep layers may only be kept by 16-bit documents of the same type
+	if (bps == 16 && ([(SeaContent *)[document contents] bps] != 16 || [(SeaContent *)[[layer document] contents] type] != [(SeaContent *)[document contents] type]))
+		[self narrowSamples];
+	
 	// Finally convert the bitmap to the correct type
 	[self convertFromType:[(SeaContent *)[[layer document] contents] type] to:[(SeaContent *)[document contents] type]];
 	
@@ -144,6 +157,7 @@
 		mode = 0;
 		opacity = 255;
 		spp = [[document contents] spp];
+		bps = 8;
 		visible = YES;
 		hasAlpha = YES;
 		compressed = NO;
@@ -155,7 +169,7 @@
 		seaLayerUndo = [[SeaLayerUndo alloc] initWithDocument:doc forLayer:self];
 		uniqueLayerID = [(SeaDocument *)doc uniqueFloatingLayerID];
 		name = NULL; oldNames = NULL;
-		undoFilePath = [NSTemporaryDirectory() stringByAppendingPathComponent:[NSString stringWithFormat:@"seaundo-d%d-l%d", [self uniqueLayerID], [document uniqueDocID]]];
+		undoFilePath = [[[SeaController seaPrefs] scratchDirectory] stringByAppendingPathComponent:[NSString stringWithFormat:@"seaundo-d%d-l%d", [self uniqueLayerID], [document uniqueDocID]]];
 	}
 	return self;
 }
@@ -169,6 +183,7 @@
 		height = width = mode = 0;
 		opacity = 255; xoff = yoff = 0;
 		spp = 4;
+		bps = 8;
 		srand(time(NULL) & 0x7FFFFFFF);
 		
 		uniqueLayerID = rand();
@@ -188,6 +203,7 @@
 {
 	if (data) free(data);
 	if (thumbData) free(thumbData);
+	if (reducedData) free(reducedData);
 #if MAIN_COMPILE
 	struct stat sb;
 	if (data == NULL) {
@@ -216,7 +232,7 @@
 			if (file != NULL) {
 				
 				// Write the image data to disk
-				fwrite(data, sizeof(char), width * height * spp, file);
+				fwrite(data, sizeof(char), width * height * spp * (bps / 8), file);
 				
 				// Close the memory cache
 				fclose(file);
@@ -228,8 +244,7 @@
 			}
 
 			// Get rid of the thumbnail
-			if (thumbData) free(thumbData);
-			thumbnail = NULL; thumbData = NULL;
+			[self invalidateThumbnail];
 		}
 	}
 }
@@ -242,7 +257,7 @@
 	if (data == NULL) {
 		
 		// Create space for the decompressed image data
-		data = malloc(make_128(width * height * spp));
+		data = malloc(make_128(width * height * spp * (bps / 8)));
 		
 		// Open a file for writing the image data
 		file = fopen([undoFilePath fileSystemRepresentation], "r");
@@ -251,7 +266,7 @@
 		if (file != NULL) {
 			
 			// Write the image data to disk
-			fread(data, sizeof(char), width * height * spp, file);
+			fread(data, sizeof(char), width * height * spp * (bps / 8), file);
 			
 			// Close the file
 			fclose(file);
@@ -280,6 +295,15 @@
 	yoff = newOffsets.y;
 }
 
+// The alpha of the given pixel on the 16-bit scale whatever the layer's depth
+static inline int alphaAt(unsigned char *data, int bps, int spp, int pos)
+{
+	if (bps == 16)
+		return ((uint16_t *)data)[pos * spp + (spp - 1)];
+	else
+		return expand_sample(data[pos * spp + (spp - 1)]);
+}
+
 - (void)trimLayer
 {
 	int left, right, top, bottom;
@@ -290,7 +314,7 @@
 	// Determine left content margin
 	for (int i = 0; i < width && left == -1; i++) {
 		for (int j = 0; j < height && left == -1; j++) {
-			if (data[j * width * spp + i * spp + (spp - 1)] != 0) {
+			if (alphaAt(data, bps, spp, j * width + i) != 0) {
 				left = i;
 			}
 		}
@@ -299,7 +323,7 @@
 	// Determine right content margin
 	for (int i = width - 1; i >= 0 && right == -1; i--) {
 		for (int j = 0; j < height && right == -1; j++) {
-			if (data[j * width * spp + i * spp + (spp - 1)] != 0) {
+			if (alphaAt(data, bps, spp, j * width + i) != 0) {
 				right = width - 1 - i;
 			}
 		}
@@ -308,7 +332,7 @@
 	// Determine top content margin
 	for (int j = 0; j < height && top == -1; j++) {
 		for (int i = 0; i < width && top == -1; i++) {
-			if (data[j * width * spp + i * spp + (spp - 1)] != 0) {
+			if (alphaAt(data, bps, spp, j * width + i) != 0) {
 				top = j;
 			}
 		}
@@ -317,7 +341,7 @@
 	// Determine bottom content margin
 	for (int j = height - 1; j >= 0 && bottom == -1; j--) {
 		for (int i = 0; i < width && bottom == -1; i++) {
-			if (data[j * width * spp + i * spp + (spp - 1)] != 0) {
+			if (alphaAt(data, bps, spp, j * width + i) != 0) {
 				bottom = height - 1 - j;
 			}
 		}
@@ -330,30 +354,14 @@
 
 - (void)flipHorizontally
 {
-	unsigned char temp[4];
-	
-	for (int j = 0; j < height; j++) {
-		for (int i = 0; i < width / 2; i++) {
-			memcpy(temp, &(data[(j * width + i) * spp]), spp);
-			memcpy(&(data[(j * width + i) * spp]), &(data[(j * width + (width - i - 1)) * spp]), spp);
-			memcpy(&(data[(j * width + (width - i - 1)) * spp]), temp, spp);
-		}
-	}
+	SeaFlipBitmap(spp * (bps / 8), data, width, height, width, YES);
 	
 	xoff = [(SeaContent *)[document contents] width] - xoff - width;
 }
 
 - (void)flipVertically
 {
-	unsigned char temp[4];
-	
-	for (int j = 0; j < height / 2; j++) {
-		for (int i = 0; i < width; i++) {
-			memcpy(temp, &(data[(j * width + i) * spp]), spp);
-			memcpy(&(data[(j * width + i) * spp]), &(data[((height - j - 1) * width + i) * spp]), spp);
-			memcpy(&(data[((height - j - 1) * width + i) * spp]), temp, spp);
-		}
-	}
+	SeaFlipBitmap(spp * (bps / 8), data, width, height, width, NO);
 	
 	yoff = [(SeaContent *)[document contents] height] - yoff - height;
 }
@@ -362,15 +370,9 @@
 {
 	int newWidth = height;
 	int newHeight = width;
-	unsigned char *newData = malloc(make_128(newWidth * newHeight * spp));
+	unsigned char *newData = malloc(make_128(newWidth * newHeight * spp * (bps / 8)));
 	
-	for (int j = 0; j < height; j++) {
-		for (int i = 0; i < width; i++) {
-			for (int k = 0; k < spp; k++) {
-				newData[((newHeight - i - 1) * newWidth + j) * spp + k] = data[(j * width + i) * spp + k]; 
-			}
-		}
-	}
+	SeaRotateBitmap(spp * (bps / 8), newData, data, width, height, NO);
 	free(data);
 	
 	int ox = [(SeaContent *)[document contents] width] - xoff - width;
@@ -382,21 +384,18 @@
 	
 	xoff = oy;
 	yoff = ox;
+	
+	// Destroy the thumbnail data
+	[self invalidateThumbnail];
 }
 
 - (void)rotateRight
 {
 	int newWidth = height;
 	int newHeight = width;
-	unsigned char *newData = malloc(make_128(newWidth * newHeight * spp));
+	unsigned char *newData = malloc(make_128(newWidth * newHeight * spp * (bps / 8)));
 	
-	for (int j = 0; j < height; j++) {
-		for (int i = 0; i < width; i++) {
-			for (int k = 0; k < spp; k++) {
-				newData[(i * newWidth + (newWidth - j - 1)) * spp + k] = data[(j * width + i) * spp + k]; 
-			}
-		}
-	}
+	SeaRotateBitmap(spp * (bps / 8), newData, data, width, height, YES);
 	free(data);
 	
 	int ox = xoff;
@@ -408,6 +407,9 @@
 	
 	xoff = oy;
 	yoff = ox;
+	
+	// Destroy the thumbnail data
+	[self invalidateThumbnail];
 }
 
 - (void)setCocoaRotation:(float)degrees interpolation:(int)interpolation withTrim:(BOOL)trim
@@ -538,8 +540,7 @@
 	width = newWidth; height = newHeight;
 	
 	// Destroy the thumbnail data
-	if (thumbData) free(thumbData);
-	thumbnail = NULL; thumbData = NULL;
+	[self invalidateThumbnail];
 	
 	// Make margin changes
 	if (trim) [self trimLayer];
@@ -576,6 +577,34 @@
 @synthesize data;
 @synthesize hasAlpha;
 
+#if MAIN_COMPILE
+- (unsigned char *)copyNarrowedData
+{
+	unsigned char *narrowData;
+	
+	narrowData = malloc(make_128(width * height * spp));
+	if (bps == 16)
+		SeaNarrowSamples(narrowData, (uint16_t *)data, width * height * spp);
+	else
+		memcpy(narrowData, data, width * height * spp);
+	
+	return narrowData;
+}
+
+- (void)narrowSamples
+{
+	if (bps != 16)
+		return;
+	
+	// The samples can be narrowed in place
+	SeaNarrowSamples(data, (uint16_t *)data, width * height * spp);
+	bps = 8;
+	
+	// Destroy the thumbnail data
+	[self invalidateThumbnail];
+}
+#endif
+
 #if MAIN_COMPILE
 - (void)toggleAlpha
 {
@@ -609,7 +638,7 @@
 	
 	if (hasAlpha) {
 		for (i = 0; i < width * height; i++) {
-			if (data[(i + 1) * spp - 1] != 255)
+			if (alphaAt(data, bps, spp, i) != 65535)
 				return NO;
 		}
 	}
@@ -644,6 +673,9 @@
 #endif
 
 @synthesize floating;
+#if MAIN_COMPILE
+@synthesize revision;
+#endif
 
 #if MAIN_COMPILE
 - (id)seaLayerUndo
@@ -694,37 +726,68 @@
 	return thumbnail;
 }
 
+- (void)invalidateThumbnail
+{
+	revision++;
+	if (thumbData) free(thumbData);
+	thumbnail = NULL; thumbData = NULL;
+	if (reducedData) free(reducedData);
+	reducedData = NULL;
+}
+
+- (void)buildReduction
+{
+	// Halve the size until the reduction is no more than four times the
+	// thumbnail's, smaller layers are reduced directly from their data
+	reducedWidth = width;
+	reducedHeight = height;
+	while (reducedWidth > thumbWidth * 4 || reducedHeight > thumbHeight * 4) {
+		reducedWidth = (reducedWidth + 1) / 2;
+		reducedHeight = (reducedHeight + 1) / 2;
+	}
+	if (reducedWidth == width && reducedHeight == height)
+		return;
+	reducedData = malloc(make_128(reducedWidth * reducedHeight * spp));
+	if (bps == 16)
+		SeaBoxReduceBitmap16(spp, reducedData, reducedWidth, reducedHeight, (uint16_t *)data, width, height, IntMakeRect(0, 0, reducedWidth, reducedHeight));
+	else
+		SeaBoxReduceBitmap(spp, reducedData, reducedWidth, reducedHeight, data, width, height, YES, IntMakeRect(0, 0, reducedWidth, reducedHeight));
+}
+
 - (void)updateThumbnail
 {
-	float horizStep, vertStep;
-	int i, j, k, temp;
-	int srcPos, destPos;
-	
-	if (thumbData) {
+	[self updateThumbnailInRect:IntMakeRect(0, 0, width, height)];
+}
+
+- (void)updateThumbnailInRect:(IntRect)rect
+{
+	int left, top, right, bottom;
 	
-		// Determine the thumbnail data
-		horizStep = (float)width / (float)thumbWidth;
-		vertStep = (float)height / (float)thumbHeight;
-		for (j = 0; j < thumbHeight; j++) {
-			for (i = 0; i < thumbWidth; i++) {
-				srcPos = ((int)(j * vertStep) * width + (int)(i * horizStep)) * spp;
-				destPos = (j * thumbWidth + i) * spp;
-				
-				if (data[srcPos + (spp - 1)] == 255) {
-					for (k = 0; k < spp; k++)
-						thumbData[destPos + k] = data[srcPos + k];
-				}
-				else if (data[srcPos + (spp - 1)] == 0) {
-					for (k = 0; k < spp; k++)
-						thumbData[destPos + k] = 0;
-				}
-				else {
-					for (k = 0; k < spp - 1; k++)
-						thumbData[destPos + k] = int_mult(data[srcPos + k], data[srcPos + (spp - 1)], temp);
-					thumbData[destPos + (spp - 1)] = data[srcPos + (spp - 1)];
-				}
-			}
+	revision++;
+	if (thumbData && data) {
+		
+		// Bring the reduction up-to-date beneath the changed rectangle
+		if (reducedData == NULL) {
+			[self buildReduction];
 		}
+		else {
+			left = rect.origin.x * reducedWidth / width;
+			top = rect.origin.y * reducedHeight / height;
+			right = ((rect.origin.x + rect.size.width) * reducedWidth + width - 1) / width;
+			bottom = ((rect.origin.y + rect.size.height) * reducedHeight + height - 1) / height;
+			if (bps == 16)
+				SeaBoxReduceBitmap16(spp, reducedData, reducedWidth, reducedHeight, (uint16_t *)data, width, height, IntMakeRect(left, top, right - left, bottom - top));
+			else
+				SeaBoxReduceBitmap(spp, reducedData, reducedWidth, reducedHeight, data, width, height, YES, IntMakeRect(left, top, right - left, bottom - top));
+		}
+		
+		// Determine the thumbnail data from the reduction
+		if (reducedData)
+			SeaBoxReduceBitmap(spp, thumbData, thumbWidth, thumbHeight, reducedData, reducedWidth, reducedHeight, NO, IntMakeRect(0, 0, thumbWidth, thumbHeight));
+		else if (bps == 16)
+			SeaBoxReduceBitmap16(spp, thumbData, thumbWidth, thumbHeight, (uint16_t *)data, width, height, IntMakeRect(0, 0, thumbWidth, thumbHeight));
+		else
+			SeaBoxReduceBitmap(spp, thumbData, thumbWidth, thumbHeight, data, width, height, YES, IntMakeRect(0, 0, thumbWidth, thumbHeight));
 		
 	}
 }
@@ -733,9 +796,12 @@
 {
 	NSBitmapImageRep *imageRep;
 	NSData *imageTIFFData;
-	unsigned char *pmImageData;
+	unsigned char *pmImageData, *srcData;
 	int i, j, tspp;
 	
+	// The representation is always 8-bit
+	srcData = (bps == 16) ? [self copyNarrowedData] : data;
+	
 	// Allocate room for the premultiplied image data
 	if (hasAlpha)
 		pmImageData = malloc(width * height * spp);
@@ -746,14 +812,14 @@
 	if (hasAlpha) {
 		
 		// Formulate the premultiplied data from the data
-		SeaPremultiplyBitmap(spp, pmImageData, data, width * height);
+		SeaPremultiplyBitmap(spp, pmImageData, srcData, width * height);
 	
 	} else {
 	
 		// Strip the alpha channel
 		for (i = 0; i < width * height; i++) {
 			for (j = 0; j < spp - 1; j++) {
-				pmImageData[i * (spp - 1) + j] = data[i * spp + j];
+				pmImageData[i * (spp - 1) + j] = srcData[i * spp + j];
 			}
 		}
 		
@@ -768,6 +834,8 @@
 	
 	// Release the representation and the image data
 	free(pmImageData);
+	if (srcData != data)
+		free(srcData);
 	
 	return imageTIFFData;
 }
@@ -776,26 +844,27 @@
 {
 	unsigned char *newImageData;
 	int i, j, k, destPos, srcPos, newWidth, newHeight;
+	int pixelSize = spp * (bps / 8);
 	
 	// Allocate an appropriate amount of memory for the new bitmap
 	newWidth = width + left + right;
 	newHeight = height + top + bottom;
-	newImageData = malloc(make_128(newWidth * newHeight * spp));
-	// do_128_clean(newImageData, make_128(newWidth * newHeight * spp));
+	newImageData = malloc(make_128(newWidth * newHeight * pixelSize));
+	// do_128_clean(newImageData, make_128(newWidth * newHeight * pixelSize));
 	
 	// Fill the new bitmap with the appropriate values
 	for (j = 0; j < newHeight; j++) {
 		for (i = 0; i < newWidth; i++) {
 			
-			destPos = (j * newWidth + i) * spp;
+			destPos = (j * newWidth + i) * pixelSize;
 			
 			if (i < left || i >= left + width || j < top || j >= top + height) {
-				if (!hasAlpha) { for (k = 0; k < spp; k++) newImageData[destPos + k] = 255; }
-				else { for (k = 0; k < spp; k++) newImageData[destPos + k] = 0; }
+				if (!hasAlpha) { for (k = 0; k < pixelSize; k++) newImageData[destPos + k] = 255; }
+				else { for (k = 0; k < pixelSize; k++) newImageData[destPos + k] = 0; }
 			}
 			else {
-				srcPos = ((j - top) * width + (i - left)) * spp;
-				for (k = 0; k < spp; k++)
+				srcPos = ((j - top) * width + (i - left)) * pixelSize;
+				for (k = 0; k < pixelSize; k++)
 					newImageData[destPos + k] = data[srcPos + k];
 			}
 			
@@ -809,8 +878,7 @@
 	xoff -= left; yoff -= top; 
 	
 	// Destroy the thumbnail data
-	if (thumbData) free(thumbData);
-	thumbnail = NULL; thumbData = NULL;
+	[self invalidateThumbnail];
 }
 
 
@@ -819,10 +887,13 @@
 	unsigned char *newData;
 		
 	// Allocate an appropriate amount of memory for the new bitmap
-	newData = malloc(make_128(newWidth * newHeight * spp));
+	newData = malloc(make_128(newWidth * newHeight * spp * (bps / 8)));
 	
-	// Do the scale
-	GCScalePixels(newData, newWidth, newHeight, data, width, height, interpolation, spp);
+	// Do the scale, GIMPCore only scales 8-bit pixels
+	if (bps == 16)
+		SeaScaleBitmap16(spp, (uint16_t *)newData, newWidth, newHeight, (uint16_t *)data, width, height, interpolation != GIMP_INTERPOLATION_NONE);
+	else
+		GCScalePixels(newData, newWidth, newHeight, data, width, height, interpolation, spp);
 	
 	// Replace the old bitmap with the new bitmap
 	free(data);
@@ -830,8 +901,7 @@
 	width = newWidth; height = newHeight;
 	
 	// Destroy the thumbnail data
-	if (thumbData) free(thumbData);
-	thumbnail = NULL; thumbData = NULL;
+	[self invalidateThumbnail];
 }
 
 
@@ -853,8 +923,7 @@
 	width = newWidth; height = newHeight;
 	
 	// Destroy the thumbnail data
-	if (thumbData) free(thumbData);
-	thumbnail = NULL; thumbData = NULL;
+	[self invalidateThumbnail];
 }
 
 
@@ -862,7 +931,7 @@
 {
 	// The issue here is it looks like we're not smart enough to pass anything
 	// to the affine plugin besides cubic, so if we're not cupbic we have to use cocoa
-	if (affinePlugin && [[SeaController seaPrefs] useCoreImage] && interpolation == GIMP_INTERPOLATION_CUBIC) {
+	if (affinePlugin && [[SeaController seaPrefs] useCoreImage] && interpolation == GIMP_INTERPOLATION_CUBIC && bps == 8) {
 		[self setCoreImageWidth:newWidth height:newHeight interpolation:interpolation];
 	}
 	else {
@@ -876,12 +945,14 @@
 	int i;
 	
 	// Destroy the thumbnail data
-	if (thumbData) free(thumbData);
-	thumbnail = NULL; thumbData = NULL;
+	[self invalidateThumbnail];
 
 	// Don't do anything if there is nothing to do
 	if (srcType == destType)
 		return;
+	
+	// The conversions are 8-bit only
+	[self narrowSamples];
 		
 	if (srcType == XCF_RGB_IMAGE && destType == XCF_GRAY_IMAGE) {
 		ColorSyncProfileRef srcProf, destProf;
@@ -35,7 +35,12 @@ typedef struct {
 /*!
 	@class		SeaLayerUndo
 	@abstract	Makes changes to the associated layer's pixels undoable.
-	@discussion	N/A
+	@discussion	Snapshots are gathered in a memory cache which, once full, is
+				handed to a background queue to be written to the scratch
+				directory while a fresh cache takes its place. The most recently
+				written cache is kept until the next is written and after an
+				undo the file most likely to be needed next is read in the
+				background, so undoing back and forth rarely waits on the disk.
 				<br><br>
 				<b>License:</b> GNU General Public License<br>
 				<b>Copyright:</b> Copyright (c) 2002 Mark Pazolli
@@ -61,6 +66,10 @@ typedef struct {
 	ssize_t memory_cache_pos;
 	size_t memory_cache_len;
 	
+	// The contents of one undo file kept in memory in case it is needed soon
+	unsigned char *prefetch_data;
+	int prefetch_file_number;
+	
 }
 
 // CREATION METHODS
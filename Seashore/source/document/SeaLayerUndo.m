@@ -12,6 +12,63 @@
 extern int tempFileCount;
 extern BOOL userWarnedOnDiskSpace;
 
+// The queue on which undo files are written, read and deleted
+static dispatch_queue_t undoQueue(void)
+{
+	static dispatch_queue_t queue;
+	static dispatch_once_t once;
+
+	dispatch_once(&once, ^{
+		queue = dispatch_queue_create("com.seashore.SeaLayerUndo.io", dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_UTILITY, 0));
+	});
+
+	return queue;
+}
+
+// The path of the given undo file
+static NSString *undoFilePath(int fileNo)
+{
+	return [[[SeaController seaPrefs] scratchDirectory] stringByAppendingPathComponent:[NSString stringWithFormat:@"seaundo-%d", fileNo]];
+}
+
+// Reads an undo file in its entirety, returning NULL on failure
+static unsigned char *readUndoFile(NSString *path)
+{
+	FILE *file;
+	struct stat sb;
+	unsigned char *data;
+
+	file = fopen([path fileSystemRepresentation], "r");
+	if (file == NULL) return NULL;
+	fstat(fileno(file), &sb);
+	data = malloc(MAX(sb.st_size, 1));
+	if (fread(data, sizeof(char), sb.st_size, file) != (size_t)sb.st_size) {
+		free(data);
+		data = NULL;
+	}
+	fclose(file);
+
+	return data;
+}
+
+// Deletes an undo file once any pending write to it has finished
+static void deleteUndoFile(NSString *path)
+{
+	dispatch_async(undoQueue(), ^{
+		unlink([path fileSystemRepresentation]);
+	});
+}
+
+// Frees a block of memory once any pending write from it has finished
+static void freeAfterWriting(unsigned char *data)
+{
+	if (data) {
+		dispatch_async(undoQueue(), ^{
+			free(data);
+		});
+	}
+}
+
 @implementation SeaLayerUndo
 
 - (instancetype)initWithDocument:(SeaDocument*)doc forLayer:(SeaLayer*)ilayer
@@ -31,6 +88,10 @@ extern BOOL userWarnedOnDiskSpace;
 	memory_cache_len = memoryCacheSize * 1024;
 	memory_cache = malloc(memory_cache_len);
 	memory_cache_pos = 0;
+	
+	// Nothing has been written to disk yet
+	prefetch_data = NULL;
+	prefetch_file_number = -2;
 }
 
 	return self;
@@ -38,29 +99,18 @@ extern BOOL userWarnedOnDiskSpace;
 
 - (void)dealloc
 {
-	struct stat sb;
-	char *tempFileName;
-	int i, j;
-	short oldFileNumber;
+	int i;
 	
 	// Free the disk cache
 	for (i = 0; i < records_len; i++) {
 		if (records[i].fileNumber >= 0) {
-			tempFileName = (char *)[[NSString stringWithFormat:@"/tmp/seaundo-%d", records[i].fileNumber] fileSystemRepresentation];
-			if (stat(tempFileName, &sb) == 0) {
-				oldFileNumber = records[i].fileNumber;
-				for (j = 0; j < records_len; j++) {
-					if (records[j].fileNumber == oldFileNumber) {
-						records[j].fileNumber = -2;
-					}
-				}
-				unlink(tempFileName);
-			}
+			[self forgetFile:records[i].fileNumber];
 		}
 	}
 	
 	// Free the memory cache
 	if (memory_cache) free(memory_cache);
+	freeAfterWriting(prefetch_data);
 	
 	// Free the record of the memory cache
 	if (records) free(records);
@@ -68,18 +118,29 @@ extern BOOL userWarnedOnDiskSpace;
 	// Call the super
 }
 
+// Marks every record in the given file as unavailable and deletes the file
+- (void)forgetFile:(int)fileNo
+{
+	int i;
+	
+	for (i = 0; i < records_len; i++) {
+		if (records[i].fileNumber == fileNo) {
+			records[i].fileNumber = -2;
+		}
+	}
+	deleteUndoFile(undoFilePath(fileNo));
+}
+
 - (BOOL)checkDiskSpace
 {
 	struct statfs fs;
 	struct stat sb;
-	char *tempFileName;
-	int i, j;
+	int i;
 	unsigned long spaceLeft;
-	short oldFileNumber;
 	BOOL badstate;
 	
 	// Determine the disk space remaining
-	statfs("/tmp", &fs);
+	statfs([[[SeaController seaPrefs] scratchDirectory] fileSystemRepresentation], &fs);
 	spaceLeft = ((unsigned long long)fs.f_bfree * (unsigned long long)fs.f_bsize) / ((unsigned long long)1024);
 	badstate = spaceLeft < (unsigned long)(50 * 1024) || spaceLeft < memoryCacheSize * (unsigned long)12;
 	if (badstate) {
@@ -96,17 +157,9 @@ extern BOOL userWarnedOnDiskSpace;
 		// And remove as many of *our* files as necessary to restore 50 MB of system disk space
 		for (i = 0; i < records_len && badstate; i++) {
 			if (records[i].fileNumber >= 0) {
-				oldFileNumber = records[i].fileNumber;
-				tempFileName = (char *)[[NSString stringWithFormat:@"/tmp/seaundo-%d", oldFileNumber] fileSystemRepresentation];
-				if (stat(tempFileName, &sb) == 0) {
-					for (j = 0; j < records_len; j++) {
-						if (records[j].fileNumber == oldFileNumber) {
-							records[j].fileNumber = -2;
-						}
-					}
+				if (stat([undoFilePath(records[i].fileNumber) fileSystemRepresentation], &sb) == 0)
 					spaceLeft += sb.st_size;
-					unlink(tempFileName);
-				}
+				[self forgetFile:records[i].fileNumber];
 			}
 			badstate = spaceLeft < (unsigned long)(50 * 1024) || spaceLeft < memoryCacheSize * (unsigned long)12;
 		}
@@ -122,7 +175,10 @@ extern BOOL userWarnedOnDiskSpace;
 
 - (void)writeMemoryCache
 {
-	FILE *file;
+	__weak SeaLayerUndo *weakSelf = self;
+	unsigned char *sealed;
+	NSString *path;
+	size_t length;
 	int fileNo, i;
 
 	// Check we actually have something to write to disk
@@ -135,13 +191,6 @@ extern BOOL userWarnedOnDiskSpace;
 			fileNo = tempFileCount;
 			tempFileCount++;
 			
-			// Open a file for writing the memory cache
-			file = fopen([[NSString stringWithFormat:@"/tmp/seaundo-%d", fileNo] fileSystemRepresentation], "w");
-			
-			// Write the memory cache
-			if (file != NULL) fwrite(memory_cache, sizeof(unsigned char), memory_cache_pos, file);
-			if (file == NULL) fileNo = -2;
-			
 			// Go through each record checking it if it has been written to disk
 			for (i = 0; i < records_len; i++) {
 				if (records[i].fileNumber == -1) {
@@ -150,11 +199,25 @@ extern BOOL userWarnedOnDiskSpace;
 				}
 			}
 			
-			// Close the file
-			fclose(file);
+			// Write the sealed memory cache in the background, if that fails forget its records
+			sealed = (unsigned char *)memory_cache;
+			length = memory_cache_pos;
+			path = undoFilePath(fileNo);
+			dispatch_async(undoQueue(), ^{
+				FILE *file = fopen([path fileSystemRepresentation], "w");
+				BOOL written = file != NULL && fwrite(sealed, sizeof(unsigned char), length, file) == length;
+				if (file != NULL) fclose(file);
+				if (!written) {
+					dispatch_async(dispatch_get_main_queue(), ^{
+						[weakSelf forgetFile:fileNo];
+					});
+				}
+			});
 			
-			// Free the memory cache
-			free(memory_cache);
+			// Keep the sealed memory cache in case it is needed again soon
+			freeAfterWriting(prefetch_data);
+			prefetch_data = sealed;
+			prefetch_file_number = fileNo;
 			memory_cache = NULL;
 			memory_cache_len = 0;
 			memory_cache_pos = 0;
@@ -177,37 +240,83 @@ extern BOOL userWarnedOnDiskSpace;
 	}		
 }
 
+// Reads the undo file most likely to be needed after the given record in the background
+- (void)prefetchBefore:(NSInteger)index
+{
+	__weak SeaLayerUndo *weakSelf = self;
+	NSString *path;
+	int fileNo = -2;
+	NSInteger i;
+	
+	// Undoing works backwards so look for the nearest earlier record on disk
+	for (i = index - 1; i >= 0 && fileNo < 0; i--)
+		fileNo = records[i].fileNumber;
+	if (fileNo < 0 || (prefetch_data && fileNo == prefetch_file_number)) return;
+	
+	path = undoFilePath(fileNo);
+	dispatch_async(undoQueue(), ^{
+		unsigned char *data = readUndoFile(path);
+		if (data == NULL) return;
+		dispatch_async(dispatch_get_main_queue(), ^{
+			[weakSelf receivePrefetch:data fileNumber:fileNo];
+		});
+	});
+}
+
+// Keeps the prefetched contents of an undo file unless they are no longer needed
+- (void)receivePrefetch:(unsigned char *)data fileNumber:(int)fileNo
+{
+	int i;
+	
+	for (i = 0; i < records_len; i++) {
+		if (records[i].fileNumber == fileNo) {
+			freeAfterWriting(prefetch_data);
+			prefetch_data = data;
+			prefetch_file_number = fileNo;
+			return;
+		}
+	}
+	free(data);
+}
+
 - (BOOL)loadMemoryCacheWithIndex:(NSInteger)index
 {
-	FILE *file;
-	struct stat sb;
-	int i, fileNo, spp;
-	const char *fileName;
+	__block unsigned char *loaded = NULL;
+	int i, fileNo, pixelSize;
+	NSString *path;
 	int *int_ptr;
 
 	// Set up variables
 	fileNo = records[index].fileNumber;
-	spp = [(SeaContent *)[document contents] spp];
+	pixelSize = [(SeaContent *)[document contents] spp] * [(SeaLayer *)layer bps] / 8;
 
 	// If the record is already in the memory cache succeed
 	if (fileNo == -1) return YES;
 	
 	// If the record has an undefined file attached to it fail
 	if (fileNo == -2) return NO;
-
+	
+	// Use the file's contents if we already have them, otherwise read them (after any pending write)
+	path = undoFilePath(fileNo);
+	if (prefetch_data && prefetch_file_number == fileNo) {
+		loaded = prefetch_data;
+		prefetch_data = NULL;
+		prefetch_file_number = -2;
+		dispatch_sync(undoQueue(), ^{});
+	}
+	else {
+		dispatch_sync(undoQueue(), ^{
+			loaded = readUndoFile(path);
+		});
+		if (loaded == NULL) return NO;
+	}
+	
 	// Otherwise write the current memory cache to disk
 	[self writeMemoryCache];
 	
-	// Open the file associated with this record
-	fileName = [[NSString stringWithFormat:@"/tmp/seaundo-%d", fileNo] fileSystemRepresentation];
-	file = fopen(fileName, "r");
-	if (file == NULL) return NO;
-	
-	// Read the whole file asssociated with this record into the memory cache
-	fstat(fileno(file), &sb);
-	memory_cache_len = sb.st_size;
-	memory_cache = malloc(memory_cache_len);
-	fread(memory_cache, sizeof(char), memory_cache_len, file);
+	// The file's contents become the memory cache
+	memory_cache = (char *)loaded;
+	memory_cache_len = 0;
 	memory_cache_pos = 0;
 	
 	// Go through each record looking for a matching file number and signal that record is now in memory
@@ -219,18 +328,19 @@ extern BOOL userWarnedOnDiskSpace;
 			records[i].fileNumber = -1;
 			int_ptr = (int *)&memory_cache[memory_cache_pos];
 			if (int_ptr[2] == -1)
-				memory_cache_pos += 3 * sizeof(int) + spp;
+				memory_cache_pos += 3 * sizeof(int) + pixelSize;
 			else
-				memory_cache_pos += 4 * sizeof(int) + int_ptr[2] * int_ptr[3] * spp;
+				memory_cache_pos += 4 * sizeof(int) + int_ptr[2] * int_ptr[3] * pixelSize;
 			
 		}
 	}
-	
-	// Close the file
-	fclose(file);
+	memory_cache_len = memory_cache_pos;
 	
 	// Delete the file (we have its contents in memory now)
-	unlink(fileName);
+	deleteUndoFile(path);
+	
+	// Get the next file ready while the user decides what to do
+	[self prefetchBefore:index];
 	
 	// Write debugging notices
 	#ifdef DEBUG
@@ -243,7 +353,7 @@ extern BOOL userWarnedOnDiskSpace;
 - (NSInteger)takeSnapshot:(IntRect)rect automatic:(BOOL)automatic
 {
 	unsigned char *data, *temp_ptr;
-	int i, width, rectSize, sectionSize, spp;
+	int i, width, rectSize, sectionSize, pixelSize;
 	int *int_ptr;
 	
 	// Check the rectangle is valid
@@ -252,8 +362,8 @@ extern BOOL userWarnedOnDiskSpace;
 	if (rect.size.height <= 0) return -1;
 	
 	// Set up variables
-	spp = [(SeaContent *)[document contents] spp];
-	sectionSize = rect.size.width * rect.size.height * spp;
+	pixelSize = [(SeaContent *)[document contents] spp] * [(SeaLayer *)layer bps] / 8;
+	sectionSize = rect.size.width * rect.size.height * pixelSize;
 	data = [(SeaLayer *)layer data];
 	width = [(SeaLayer *)layer width];
 	
@@ -291,8 +401,8 @@ extern BOOL userWarnedOnDiskSpace;
 		temp_ptr += rectSize;
 	}
 	for (i = 0; i < rect.size.height; i++) {
-		memcpy(temp_ptr, data + ((rect.origin.y + i) * width + rect.origin.x) * spp, rect.size.width * spp);
-		temp_ptr += rect.size.width * spp;
+		memcpy(temp_ptr, data + ((rect.origin.y + i) * width + rect.origin.x) * pixelSize, rect.size.width * pixelSize);
+		temp_ptr += rect.size.width * pixelSize;
 	}
 	records[records_len].fileNumber = -1;
 	records[records_len].data = (unsigned char*)memory_cache + memory_cache_pos;
@@ -318,7 +428,7 @@ extern BOOL userWarnedOnDiskSpace;
 {
 	IntRect rect;
 	unsigned char *data, *temp_ptr, *o_temp_ptr = NULL, *odata = NULL;
-	int i, width, recordDataSize = 0, spp, lindex;
+	int i, width, recordDataSize = 0, pixelSize, lindex;
 	int *int_ptr, *o_int_ptr = NULL;
 	
 	// Check the index is valid
@@ -337,7 +447,7 @@ extern BOOL userWarnedOnDiskSpace;
 	// Set-up variables
 	data = [(SeaLayer *)layer data];
 	width = [(SeaLayer *)layer width];
-	spp = [(SeaContent *)[document contents] spp];
+	pixelSize = [(SeaContent *)[document contents] spp] * [(SeaLayer *)layer bps] / 8;
 	lindex = [(SeaLayer *)layer index];
 	temp_ptr = records[index].data;
 	int_ptr = (int *)temp_ptr;
@@ -345,9 +455,9 @@ extern BOOL userWarnedOnDiskSpace;
 	// Set-up variables for old data
 	if (automatic) {
 		if (int_ptr[2] == -1)
-			recordDataSize = 3 * sizeof(int) + spp;
+			recordDataSize = 3 * sizeof(int) + pixelSize;
 		else
-			recordDataSize = 4 * sizeof(int) + int_ptr[2] * int_ptr[3] * spp;
+			recordDataSize = 4 * sizeof(int) + int_ptr[2] * int_ptr[3] * pixelSize;
 		odata = malloc(recordDataSize);
 		o_temp_ptr = odata;
 		o_int_ptr = (int *)o_temp_ptr;
@@ -385,15 +495,15 @@ extern BOOL userWarnedOnDiskSpace;
 	// Save the current image data
 	if (automatic) {
 		for (i = 0; i < rect.size.height; i++) {
-			memcpy(o_temp_ptr, data + ((rect.origin.y + i) * width + rect.origin.x) * spp, rect.size.width * spp);
-			o_temp_ptr += rect.size.width * spp;
+			memcpy(o_temp_ptr, data + ((rect.origin.y + i) * width + rect.origin.x) * pixelSize, rect.size.width * pixelSize);
+			o_temp_ptr += rect.size.width * pixelSize;
 		}
 	}
 	
 	// Replace the image data with that of the record
 	for (i = 0; i < rect.size.height; i++) {
-		memcpy(data + ((rect.origin.y + i) * width + rect.origin.x) * spp, temp_ptr, rect.size.width * spp);
-		temp_ptr += rect.size.width * spp;
+		memcpy(data + ((rect.origin.y + i) * width + rect.origin.x) * pixelSize, temp_ptr, rect.size.width * pixelSize);
+		temp_ptr += rect.size.width * pixelSize;
 	}
 		
 	// Call for an update
@@ -31,6 +31,10 @@
 	@field		maskToAlpha
 				<--- YES if the mask of a layer was composited to its alpha
 				channel, NO otherwise.
+	@field		reduction
+				--> The factor by which the layer's pixels are reduced as they
+				are read, 1 reads them at full size and 0 skips them entirely
+				so that only the headers and properties are read.
 */
 typedef struct {
 	unsigned char *cmap;
@@ -40,6 +44,7 @@ typedef struct {
 	BOOL active;
 	BOOL floating;
 	BOOL maskToAlpha;
+	int reduction;
 } SharedXCFInfo;
 
 /*!
@@ -108,6 +113,35 @@ typedef struct {
 	@result		Returns instance upon success (or NULL otherwise).
  */
 - (instancetype)initWithContentsOfFile:(NSString *)path;
+
+/*!
+	@method		initWithContentsOfFile:reduction:
+	@discussion	Initializes an instance of this class with the given XCF file
+				reduced in size by the given factor. Each pixel of the result is
+				the average of a grid of samples from a block of pixels in the
+				file and only the rows of tiles holding samples are
+				decompressed, making this much cheaper than a full read for
+				large files.
+	@param		path
+				The path of the XCF file with which to initalize this class.
+	@param		reduction
+				The factor (one or more) by which to reduce the width and
+				height of the document and its layers.
+	@result		Returns instance upon success (or NULL otherwise).
+ */
+- (instancetype)initWithContentsOfFile:(NSString *)path reduction:(int)reduction;
+
+/*!
+	@method		initWithHeadersOfFile:
+	@discussion	Initializes an instance of this class with the headers and
+				properties of the given XCF file without reading any pixels. The
+				layers of the resulting instance have no data and should only
+				be used for their dimensions, names and other properties.
+	@param		path
+				The path of the XCF file with which to initalize this class.
+	@result		Returns instance upon success (or NULL otherwise).
+ */
+- (instancetype)initWithHeadersOfFile:(NSString *)path;
 #endif
 
 @end
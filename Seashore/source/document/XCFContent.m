@@ -244,6 +244,7 @@ static inline void fix_endian_read(int *input, size_t size)
 	
 	// Provide the type for the layer
 	info.type = type;
+	info.reduction = 1;
 	
 	// Determine the offset for the next layer
 	i = 0;
@@ -323,7 +324,17 @@ static inline void fix_endian_read(int *input, size_t size)
 	return [self initWithDocument:doc contentsOfURL:[NSURL fileURLWithPath:path] error:NULL];
 }
 #else
-- (instancetype)initWithContentsOfFile:(NSString *)path;
+- (instancetype)initWithContentsOfFile:(NSString *)path
+{
+	return [self initWithContentsOfFile:path reduction:1];
+}
+
+- (instancetype)initWithHeadersOfFile:(NSString *)path
+{
+	return [self initWithContentsOfFile:path reduction:0];
+}
+
+- (instancetype)initWithContentsOfFile:(NSString *)path reduction:(int)reduction
 {
 	if (self = [super init]) {
 		SharedXCFInfo info;
@@ -360,8 +371,9 @@ static inline void fix_endian_read(int *input, size_t size)
 			return nil;
 		}
 		
-		// Provide the type for the layer
+		// Provide the type and pixel reduction for the layer
 		info.type = type;
+		info.reduction = reduction;
 		
 		// Determine the offset for the next layer
 		i = 0;
@@ -404,6 +416,12 @@ static inline void fix_endian_read(int *input, size_t size)
 			return NULL;
 		}
 		
+		// The layers have been read at a reduced size so the document must follow
+		if (reduction > 1) {
+			width = (width + reduction - 1) / reduction;
+			height = (height + reduction - 1) / reduction;
+		}
+		
 		// We don't support indexed images any more
 		if (type == XCF_INDEXED_IMAGE) {
 			type = XCF_RGB_IMAGE;
@@ -11,6 +11,70 @@ static inline void fix_endian_read(int *input, size_t size)
 	}
 }
 
+// Samples are spread this many pixels apart along each side of a block when reducing
+#define kReducedSampleSpacing 4
+
+// Reads the tile at the file's current position into interleaved tile data, only
+// the rows flagged are certain to be read
+static BOOL read_tile(FILE *file, unsigned char *tileData, int tileWidth, int tileHeight, int bpp, XcfCompressionType compression, const unsigned char *rows)
+{
+	int expectedSize = tileWidth * tileHeight * bpp;
+	unsigned char *srcData;
+	size_t srcSize;
+	BOOL success;
+	
+	switch (compression) {
+		case COMPRESS_NONE:
+			return (fread(tileData, sizeof(char), expectedSize, file) == expectedSize);
+		case COMPRESS_RLE:
+			srcData = malloc(expectedSize * 1.3 + 1);
+			srcSize = fread(srcData, sizeof(char), expectedSize * 1.3 + 1, file);
+			success = SeaRLEDecompressRows(tileData, srcData, (int)srcSize, tileWidth, tileHeight, bpp, rows);
+			free(srcData);
+			return success;
+		default:
+			NSLog(@"xcf: compression format %i unsupported for reduced reads", compression);
+			return NO;
+	}
+}
+
+// Flags the positions sampled along a side when reducing by the given factor, the
+// samples are spread over each block or, where a block spans several tiles, over
+// the tile holding its centre so the others need not be read
+static unsigned char *sample_positions(int total, int factor, int tileLength)
+{
+	unsigned char *sampled = calloc(total, 1);
+	int blockStart, blockLength, centre, start, length, samples, m;
+	
+	for (blockStart = 0; blockStart < total; blockStart += factor) {
+		blockLength = MIN(factor, total - blockStart);
+		start = blockStart;
+		length = blockLength;
+		if (blockLength > tileLength) {
+			centre = blockStart + blockLength / 2;
+			start = MAX(blockStart, centre - centre % tileLength);
+			length = MIN(blockStart + blockLength, centre - centre % tileLength + tileLength) - start;
+		}
+		samples = MAX(1, length / kReducedSampleSpacing);
+		for (m = 0; m < samples; m++)
+			sampled[start + (2 * m + 1) * length / (2 * samples)] = 1;
+	}
+	
+	return sampled;
+}
+
+// Returns whether any position of the span is sampled
+static inline BOOL span_sampled(const unsigned char *sampled, int start, int length)
+{
+	return memchr(sampled + start, 1, length) != NULL;
+}
+
+// Divides an offset by the given factor rounding towards negative infinity
+static inline int reduce_offset(int offset, int factor)
+{
+	return (offset >= 0) ? offset / factor : -((-offset + factor - 1) / factor);
+}
+
 - (BOOL)readHeader:(FILE *)file
 {
 	char nameString[256];
@@ -482,9 +546,248 @@ static inline void fix_endian_read(int *input, size_t size)
 	return YES;
 }
 
+- (unsigned char *)readReducedPixels:(FILE *)file sharedInfo:(SharedXCFInfo *)info
+{
+	int factor = info->reduction, levelFactor = factor;
+	int reducedWidth = (width + factor - 1) / factor, reducedHeight = (height + factor - 1) / factor;
+	int levelWidth = width, levelHeight = height, level = 0, levelCount = 0;
+	int tilesPerRow, whichTile = 0, i, j, k, x, y, curColor, srcSPP, destSPP, sumSPP;
+	int tileWidth, tileHeight, tileOffset, srcLoc, sumLoc;
+	long levelOffsets[16], oldOffset;
+	unsigned char *cmap = info->cmap;
+	unsigned char *tileData, *totalData, *sampledColumns, *sampledRows;
+	unsigned char pixel[4];
+	uint64_t *sums, alpha, count;
+	BOOL finished;
+	
+	// Read the hierarchy and the offsets of all of its levels
+	fread(tempIntString, sizeof(int), 3, file);
+	fix_endian_read(tempIntString, 3);
+	srcSPP = tempIntString[2];
+	do {
+		fread(tempIntString, sizeof(int), 1, file);
+		fix_endian_read(tempIntString, 1);
+		if (tempIntString[0] != 0)
+			levelOffsets[levelCount++] = tempIntString[0];
+	} while (tempIntString[0] != 0 && levelCount < 16 && !ferror(file));
+	if (levelCount == 0 || ferror(file))
+		return NULL;
+	
+	// Use a stored level if the file has one of exactly the reduced size (GIMP leaves them empty)
+	for (k = 1; k < levelCount; k++) {
+		if ((1 << k) == factor) {
+			fseek(file, levelOffsets[k], SEEK_SET);
+			fread(tempIntString, sizeof(int), 3, file);
+			fix_endian_read(tempIntString, 3);
+			if (tempIntString[0] == reducedWidth && tempIntString[1] == reducedHeight && tempIntString[2] != 0) {
+				level = k;
+				levelFactor = 1;
+				levelWidth = reducedWidth;
+				levelHeight = reducedHeight;
+			}
+		}
+	}
+	fseek(file, levelOffsets[level], SEEK_SET);
+	oldOffset = ftell(file) + 2 * sizeof(int);
+	tilesPerRow = (levelWidth + XCF_TILE_WIDTH - 1) / XCF_TILE_WIDTH;
+	
+	// Determine the target samples per pixel
+	if (info->type == XCF_INDEXED_IMAGE || info->type == XCF_RGB_IMAGE)
+		destSPP = 4;
+	else
+		destSPP = 2;
+	sumSPP = destSPP + 1;
+	
+	// Allocate memory for loading
+	tileData = malloc(XCF_TILE_HEIGHT * XCF_TILE_WIDTH * srcSPP);
+	sums = calloc(reducedWidth * reducedHeight * sumSPP, sizeof(uint64_t));
+	sampledColumns = sample_positions(levelWidth, levelFactor, XCF_TILE_WIDTH);
+	sampledRows = sample_positions(levelHeight, levelFactor, XCF_TILE_HEIGHT);
+	
+	do {
+		
+		// Read the offset of the next tile
+		fseek(file, oldOffset, SEEK_SET);
+		fread(tempIntString, sizeof(int), 1, file);
+		fix_endian_read(tempIntString, 1);
+		oldOffset = ftell(file);
+		tileOffset = tempIntString[0];
+		finished = (tileOffset == 0);
+		
+		// If we have another tile...
+		if (!finished) {
+			
+			// Determine the tile's position, width and height
+			x = (whichTile % tilesPerRow) * XCF_TILE_WIDTH;
+			y = (whichTile / tilesPerRow) * XCF_TILE_HEIGHT;
+			tileWidth = MIN(XCF_TILE_WIDTH, levelWidth - x);
+			tileHeight = MIN(XCF_TILE_HEIGHT, levelHeight - y);
+			whichTile++;
+			
+			// Only decompress the sampled rows of those tiles which hold samples
+			if (!span_sampled(sampledColumns, x, tileWidth) || !span_sampled(sampledRows, y, tileHeight))
+				continue;
+			fseek(file, tileOffset, SEEK_SET);
+			if (!read_tile(file, tileData, tileWidth, tileHeight, srcSPP, info->compression, sampledRows + y)) {
+				NSLog(@"Decompression failed (reduced pixels)");
+				free(tileData); free(sums); free(sampledColumns); free(sampledRows);
+				return NULL;
+			}
+			
+			// Accumulate alpha-weighted sums of the samples for the blocks
+			for (j = 0; j < tileHeight; j++) {
+				if (!sampledRows[y + j])
+					continue;
+				for (i = 0; i < tileWidth; i++) {
+					if (!sampledColumns[x + i])
+						continue;
+					srcLoc = (i + j * tileWidth) * srcSPP;
+					sumLoc = ((x + i) / levelFactor + ((y + j) / levelFactor) * reducedWidth) * sumSPP;
+					
+					// There is a different transfer mechanism for indexed and non-indexed formats
+					switch (info->type) {
+						case XCF_GRAY_IMAGE:
+						case XCF_RGB_IMAGE:
+							for (k = 0; k < srcSPP; k++)
+								pixel[k] = tileData[srcLoc + k];
+							if (srcSPP + 1 == destSPP)
+								pixel[srcSPP] = 255;
+						break;
+						case XCF_INDEXED_IMAGE:
+							curColor = (int)tileData[srcLoc];
+							if (curColor < info->cmap_len - 1) {
+								for (k = 0; k < 3; k++)
+									pixel[k] = cmap[curColor * 3 + k];
+								pixel[3] = 255;
+							}
+							else {
+								for (k = 0; k < 4; k++)
+									pixel[k] = 0;
+							}
+						break;
+					}
+					
+					for (k = 0; k < destSPP - 1; k++)
+						sums[sumLoc + k] += pixel[k] * pixel[destSPP - 1];
+					sums[sumLoc + destSPP - 1] += pixel[destSPP - 1];
+					sums[sumLoc + destSPP]++;
+				}
+			}
+			
+		}
+		
+	} while (!finished && !ferror(file));
+	
+	// If we've had a problem fail
+	free(tileData); free(sampledColumns); free(sampledRows);
+	if (ferror(file)) {
+		free(sums);
+		return NULL;
+	}
+	
+	// Resolve the sums into the reduced pixels
+	totalData = malloc(make_128(reducedWidth * reducedHeight * destSPP));
+	for (i = 0; i < reducedWidth * reducedHeight; i++) {
+		alpha = sums[i * sumSPP + destSPP - 1];
+		count = sums[i * sumSPP + destSPP];
+		for (k = 0; k < destSPP - 1; k++)
+			totalData[i * destSPP + k] = (alpha) ? sums[i * sumSPP + k] / alpha : 0;
+		totalData[i * destSPP + destSPP - 1] = (count) ? alpha / count : 0;
+	}
+	free(sums);
+	spp = destSPP;
+	
+	return totalData;
+}
+
+- (BOOL)readReducedMaskPixels:(FILE *)file toData:(unsigned char *)totalData sharedInfo:(SharedXCFInfo *)info
+{
+	int factor = info->reduction;
+	int reducedWidth = (width + factor - 1) / factor, reducedHeight = (height + factor - 1) / factor;
+	int tilesPerRow = (width + XCF_TILE_WIDTH - 1) / XCF_TILE_WIDTH;
+	int whichTile = 0, i, j, x, y, tileWidth, tileHeight, tileOffset, sumLoc;
+	long oldOffset;
+	unsigned char *tileData, *sampledColumns, *sampledRows;
+	uint64_t *sums;
+	BOOL finished;
+	
+	// We have no use for the mask's header information (we assume its reasonable)
+	if (![self skipMaskHeader:file])
+		return NO;
+	
+	// Prepare to load tile-by-tile
+	oldOffset = ftell(file) + 2 * sizeof(int);
+	tileData = malloc(XCF_TILE_HEIGHT * XCF_TILE_WIDTH);
+	sums = calloc(reducedWidth * reducedHeight * 2, sizeof(uint64_t));
+	sampledColumns = sample_positions(width, factor, XCF_TILE_WIDTH);
+	sampledRows = sample_positions(height, factor, XCF_TILE_HEIGHT);
+	
+	do {
+		
+		// Read the offset of the next tile
+		fseek(file, oldOffset, SEEK_SET);
+		fread(tempIntString, sizeof(int), 1, file);
+		fix_endian_read(tempIntString, 1);
+		oldOffset = ftell(file);
+		tileOffset = tempIntString[0];
+		finished = (tileOffset == 0);
+		
+		// If we have another tile...
+		if (!finished) {
+			
+			// Determine the tile's position, width and height
+			x = (whichTile % tilesPerRow) * XCF_TILE_WIDTH;
+			y = (whichTile / tilesPerRow) * XCF_TILE_HEIGHT;
+			tileWidth = MIN(XCF_TILE_WIDTH, width - x);
+			tileHeight = MIN(XCF_TILE_HEIGHT, height - y);
+			whichTile++;
+			
+			// Only decompress the sampled rows of those tiles which hold samples
+			if (!span_sampled(sampledColumns, x, tileWidth) || !span_sampled(sampledRows, y, tileHeight))
+				continue;
+			fseek(file, tileOffset, SEEK_SET);
+			if (!read_tile(file, tileData, tileWidth, tileHeight, 1, info->compression, sampledRows + y)) {
+				NSLog(@"Decompression failed (reduced mask)");
+				free(tileData); free(sums); free(totalData); free(sampledColumns); free(sampledRows);
+				return NO;
+			}
+			
+			// Accumulate sums of the samples for the blocks
+			for (j = 0; j < tileHeight; j++) {
+				if (!sampledRows[y + j])
+					continue;
+				for (i = 0; i < tileWidth; i++) {
+					if (!sampledColumns[x + i])
+						continue;
+					sumLoc = ((x + i) / factor + ((y + j) / factor) * reducedWidth) * 2;
+					sums[sumLoc] += tileData[i + j * tileWidth];
+					sums[sumLoc + 1]++;
+				}
+			}
+			
+		}
+		
+	} while (!finished && !ferror(file));
+	
+	// If we've had a problem fail
+	free(tileData); free(sampledColumns); free(sampledRows);
+	if (ferror(file)) {
+		free(sums); free(totalData);
+		return NO;
+	}
+	
+	// Overwrite any existing alpha channel with the averages
+	for (i = 0; i < reducedWidth * reducedHeight; i++)
+		totalData[(i + 1) * spp - 1] = (sums[i * 2 + 1]) ? sums[i * 2] / sums[i * 2 + 1] : 0;
+	free(sums);
+	
+	return YES;
+}
+
 - (BOOL)readBody:(FILE *)file sharedInfo:(SharedXCFInfo *)info
 {
 	int maskOffset, pixelsOffset;
+	int factor = info->reduction;
 	
 	// Determine relevant file positions
 	fread(tempIntString, sizeof(int), 2, file);
@@ -496,8 +799,24 @@ static inline void fix_endian_read(int *input, size_t size)
 	// NSLog(@"Layer Pixels Present At: %d", pixelsOffset);
 	// NSLog(@"Mask Present At: %d", maskOffset);
 	
+	// If only the headers are wanted settle for the hierarchy's samples per pixel
+	if (factor == 0) {
+		fread(tempIntString, sizeof(int), 3, file);
+		fix_endian_read(tempIntString, 3);
+		if (ferror(file))
+			return NO;
+		spp = (info->type == XCF_INDEXED_IMAGE || info->type == XCF_RGB_IMAGE) ? 4 : 2;
+		hasAlpha = (tempIntString[2] == 2 || tempIntString[2] == 4) || maskOffset != 0;
+		info->maskToAlpha = (maskOffset != 0);
+		data = NULL;
+		return YES;
+	}
+	
 	// Read in the image data
-	data = [self readPixels:file sharedInfo:info];
+	if (factor > 1)
+		data = [self readReducedPixels:file sharedInfo:info];
+	else
+		data = [self readPixels:file sharedInfo:info];
 	
 	// If we've had a problem fail
 	if (data == NULL)
@@ -507,7 +826,13 @@ static inline void fix_endian_read(int *input, size_t size)
 	if (maskOffset != 0) {
 		info->maskToAlpha = YES;
 		fseek(file, maskOffset, SEEK_SET);
-		if (![self readMaskPixels:file toData:data sharedInfo:info]) {
+		if (factor > 1) {
+			if (![self readReducedMaskPixels:file toData:data sharedInfo:info]) {
+				data = NULL;
+				return NO;
+			}
+		}
+		else if (![self readMaskPixels:file toData:data sharedInfo:info]) {
 			return NO;
 		}
 	}
@@ -515,6 +840,14 @@ static inline void fix_endian_read(int *input, size_t size)
 		info->maskToAlpha = NO;
 	}
 	
+	// Adopt the reduced geometry
+	if (factor > 1) {
+		width = (width + factor - 1) / factor;
+		height = (height + factor - 1) / factor;
+		xoff = reduce_offset(xoff, factor);
+		yoff = reduce_offset(yoff, factor);
+	}
+	
 	return YES;
 }
 
@@ -593,11 +926,13 @@ static inline void fix_endian_read(int *input, size_t size)
 			return nil;
 		}
 		
-		// Check the alpha
-		hasAlpha = NO;
-		for (int i = 0; i < width * height; i++) {
-			if (data[(i + 1) * spp - 1] != 255)
-				hasAlpha = YES;
+		// Check the alpha (when reading headers alone this was settled by the body)
+		if (data) {
+			hasAlpha = NO;
+			for (int i = 0; i < width * height; i++) {
+				if (data[(i + 1) * spp - 1] != 255)
+					hasAlpha = YES;
+			}
 		}
 	}
 	return self;
@@ -305,7 +305,8 @@ static inline void fix_endian_write(int *input, int size)
 	// Allocate memory for the tile data, point to the total data
 	tileData = malloc(XCF_TILE_HEIGHT * XCF_TILE_WIDTH * spp);
 	compressedTileData = malloc(XCF_TILE_HEIGHT * XCF_TILE_WIDTH * spp * 1.3 + 1);
-	totalData = [(SeaLayer *)layer data];
+	// This format version holds 8-bit pixels, so 16-bit layers are narrowed
+	totalData = ([(SeaLayer *)layer bps] == 16) ? [(SeaLayer *)layer copyNarrowedData] : [(SeaLayer *)layer data];
 	
 	// Write in our default tile height and width
 	tempIntString[0] = width;
@@ -363,6 +364,8 @@ static inline void fix_endian_write(int *input, int size)
 	// Free memory we've assigned to ourselves
 	free(tileData);
 	free(compressedTileData);
+	if (totalData != [(SeaLayer *)layer data])
+		free(totalData);
 	
 	// Check for any problems
 	if (ferror(file))
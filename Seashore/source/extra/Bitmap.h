@@ -87,7 +87,8 @@ extern unsigned char *convertBitmap(int dspp, BMPColorSpace dspace, int dbps, un
 	@param		dspace
 				The colour space of the desired bitmap.
 	@param		dbps
-				The bits per sample of the desired bitmap.
+				The bits per sample of the desired bitmap, either 8 or 16 (in
+				which case the samples are native-endian unsigned shorts).
 	@param		ibitmap
 				The original bitmap.
 	@param		width
@@ -140,6 +141,7 @@ extern void SeaStripAlphaToWhite(NSInteger spp, unsigned char *output, unsigned
 	@discussion	Given a bitmap this function premultiplies the primary channels
 				and places the result in the output. The output and input can 
 				both point to the same block of memory.
+				Large bitmaps are split between several threads.
 	@param		spp
 				The samples per pixel of the original bitmap.
 	@param		destPtr
@@ -157,6 +159,7 @@ extern void SeaPremultiplyBitmap(NSInteger spp, unsigned char *destPtr, unsigned
 				premultiplication of the primary channels and places the result
 				in the output. The output and input can  both point to the same
 				block of memory.
+				Large bitmaps are split between several threads.
 	@param		spp
 				The samples per pixel of the original bitmap.
 	@param		destPtr
@@ -168,6 +171,62 @@ extern void SeaPremultiplyBitmap(NSInteger spp, unsigned char *destPtr, unsigned
 */
 extern void SeaUnpremultiplyBitmap(NSInteger spp, unsigned char *destPtr, unsigned char *srcPtr, NSInteger length) NS_SWIFT_NAME(unpremultiplyBitmap(samplesPerPixel:destination:source:length:));
 
+/*!
+	@function	SeaPremultiplyBitmap16
+	@discussion	The 16-bit counterpart of SeaPremultiplyBitmap.
+	@param		spp
+				The samples per pixel of the original bitmap.
+	@param		destPtr
+				The block of memory in which to place the premultiplied bitmap.
+	@param		srcPtr
+				The block of memory containing the original bitmap.
+	@param		length
+				The length of the bitmap in terms of pixels (not bytes).
+*/
+extern void SeaPremultiplyBitmap16(NSInteger spp, uint16_t *destPtr, uint16_t *srcPtr, NSInteger length) NS_SWIFT_NAME(premultiplyBitmap16(samplesPerPixel:destination:source:length:));
+
+/*!
+	@function	SeaUnpremultiplyBitmap16
+	@discussion	The 16-bit counterpart of SeaUnpremultiplyBitmap.
+	@param		spp
+				The samples per pixel of the original bitmap.
+	@param		destPtr
+				The block of memory in which to place the unpremultiplied
+				bitmap.
+	@param		srcPtr
+				The block of memory containing the original bitmap.
+	@param		length
+				The length of the bitmap in terms of pixels (not bytes).
+*/
+extern void SeaUnpremultiplyBitmap16(NSInteger spp, uint16_t *destPtr, uint16_t *srcPtr, NSInteger length) NS_SWIFT_NAME(unpremultiplyBitmap16(samplesPerPixel:destination:source:length:));
+
+/*!
+	@function	SeaExpandSamples
+	@discussion	Widens 8-bit samples to 16 bits. The output may begin at the
+				same address as the input provided it is large enough to hold
+				the widened samples.
+	@param		destPtr
+				The block of memory in which to place the 16-bit samples.
+	@param		srcPtr
+				The block of memory containing the 8-bit samples.
+	@param		count
+				The number of samples (not pixels).
+*/
+extern void SeaExpandSamples(uint16_t *destPtr, unsigned char *srcPtr, NSInteger count) NS_SWIFT_NAME(expandSamples(destination:source:count:));
+
+/*!
+	@function	SeaNarrowSamples
+	@discussion	Rounds 16-bit samples to the nearest 8-bit ones. The output and
+				input can both point to the same block of memory.
+	@param		destPtr
+				The block of memory in which to place the 8-bit samples.
+	@param		srcPtr
+				The block of memory containing the 16-bit samples.
+	@param		count
+				The number of samples (not pixels).
+*/
+extern void SeaNarrowSamples(unsigned char *destPtr, uint16_t *srcPtr, NSInteger count) NS_SWIFT_NAME(narrowSamples(destination:source:count:));
+
 /*!
 	@function	SeaAveragedComponentValue
 	@discussion	Given a point on the bitmap this function finds the average
@@ -192,6 +251,136 @@ extern void SeaUnpremultiplyBitmap(NSInteger spp, unsigned char *destPtr, unsign
 extern unsigned char SeaAveragedComponentValue(int spp, unsigned char *data, int width, int height, int component, int radius, IntPoint where) NS_SWIFT_NAME(averagedComponentValue(samplesPerPixel:data:width:height:component:radius:centerPoint:));
 
 
+/*!
+	@function	SeaBoxReduceBitmap
+	@discussion	Reduces a bitmap to a smaller size by averaging the box of
+				source pixels that falls under each destination pixel. The
+				result is premultiplied, so it can be reduced again without
+				colour bleeding from transparent pixels, but the source is
+				premultiplied as it is read only if requested. Only the pixels
+				of the destination rectangle are computed which allows an edited
+				region to be brought up-to-date without recomputing the rest.
+	@param		spp
+				The samples per pixel of both bitmaps.
+	@param		dest
+				The block of memory in which to place the reduced bitmap.
+	@param		destWidth
+				The width of the reduced bitmap.
+	@param		destHeight
+				The height of the reduced bitmap.
+	@param		src
+				The block of memory containing the original bitmap.
+	@param		srcWidth
+				The width of the original bitmap (at least destWidth).
+	@param		srcHeight
+				The height of the original bitmap (at least destHeight).
+	@param		premultiply
+				YES if the original bitmap is not already premultiplied, NO
+				otherwise.
+	@param		destRect
+				The rectangle of the reduced bitmap to compute.
+*/
+extern void SeaBoxReduceBitmap(int spp, unsigned char *dest, int destWidth, int destHeight, unsigned char *src, int srcWidth, int srcHeight, BOOL premultiply, IntRect destRect) NS_SWIFT_NAME(boxReduceBitmap(samplesPerPixel:destination:destinationWidth:destinationHeight:source:sourceWidth:sourceHeight:premultiply:destinationRect:));
+
+/*!
+	@function	SeaBoxReduceBitmap16
+	@discussion	Reduces a 16-bit bitmap that is not premultiplied to a smaller
+				8-bit one in the same way as SeaBoxReduceBitmap, the samples
+				being premultiplied and averaged at 16 bits before they are
+				rounded.
+	@param		spp
+				The samples per pixel of both bitmaps.
+	@param		dest
+				The block of memory in which to place the reduced bitmap.
+	@param		destWidth
+				The width of the reduced bitmap.
+	@param		destHeight
+				The height of the reduced bitmap.
+	@param		src
+				The block of memory containing the original bitmap.
+	@param		srcWidth
+				The width of the original bitmap (at least destWidth).
+	@param		srcHeight
+				The height of the original bitmap (at least destHeight).
+	@param		destRect
+				The rectangle of the reduced bitmap to compute.
+*/
+extern void SeaBoxReduceBitmap16(int spp, unsigned char *dest, int destWidth, int destHeight, uint16_t *src, int srcWidth, int srcHeight, IntRect destRect) NS_SWIFT_NAME(boxReduceBitmap16(samplesPerPixel:destination:destinationWidth:destinationHeight:source:sourceWidth:sourceHeight:destinationRect:));
+
+/*!
+	@function	SeaFlipBitmap
+	@discussion	Flips part of a bitmap in place, either horizontally or
+				vertically. The rows are divided between the available
+				processors.
+	@param		spp
+				The bytes per pixel of the bitmap, which is the samples per
+				pixel for 8-bit bitmaps and twice that for 16-bit ones.
+	@param		data
+				The first pixel of the part of the bitmap to flip.
+	@param		width
+				The width of the part to flip.
+	@param		height
+				The height of the part to flip.
+	@param		rowLength
+				The number of pixels from the start of one row of the bitmap to
+				the start of the next (at least width).
+	@param		horizontal
+				YES to mirror the left and right, NO to mirror the top and
+				bottom.
+*/
+extern void SeaFlipBitmap(int spp, unsigned char *data, int width, int height, int rowLength, BOOL horizontal) NS_SWIFT_NAME(flipBitmap(samplesPerPixel:data:width:height:rowLength:horizontal:));
+
+/*!
+	@function	SeaRotateBitmap
+	@discussion	Rotates a bitmap by 90 degrees. The bitmap is worked on in
+				small square tiles, so the reads and the writes both stay within
+				the cache, and the tiles are divided between the available
+				processors.
+	@param		spp
+				The bytes per pixel of both bitmaps, which is the samples per
+				pixel for 8-bit bitmaps and twice that for 16-bit ones.
+	@param		dest
+				The block of memory in which to place the rotated bitmap, which
+				is height pixels wide and width pixels high. It must not overlap
+				the original bitmap.
+	@param		src
+				The block of memory containing the original bitmap.
+	@param		width
+				The width of the original bitmap.
+	@param		height
+				The height of the original bitmap.
+	@param		clockwise
+				YES to rotate to the right, NO to rotate to the left.
+*/
+extern void SeaRotateBitmap(int spp, unsigned char *dest, unsigned char *src, int width, int height, BOOL clockwise) NS_SWIFT_NAME(rotateBitmap(samplesPerPixel:destination:source:width:height:clockwise:));
+
+/*!
+	@function	SeaScaleBitmap16
+	@discussion	Scales a 16-bit bitmap that is not premultiplied. Each pixel is
+				made from the original pixels about it with a triangle filter,
+				widened when reducing so every original pixel counts, and the
+				pixels are premultiplied while they are filtered so transparent
+				pixels do not bleed into their neighbours. The rows are divided
+				between the available processors.
+	@param		spp
+				The samples per pixel of both bitmaps.
+	@param		dest
+				The block of memory in which to place the scaled bitmap.
+	@param		destWidth
+				The width of the scaled bitmap.
+	@param		destHeight
+				The height of the scaled bitmap.
+	@param		src
+				The block of memory containing the original bitmap.
+	@param		srcWidth
+				The width of the original bitmap.
+	@param		srcHeight
+				The height of the original bitmap.
+	@param		smooth
+				YES to filter the original pixels, NO to take the nearest one.
+*/
+extern void SeaScaleBitmap16(int spp, uint16_t *dest, int destWidth, int destHeight, uint16_t *src, int srcWidth, int srcHeight, BOOL smooth) NS_SWIFT_NAME(scaleBitmap16(samplesPerPixel:destination:destinationWidth:destinationHeight:source:sourceWidth:sourceHeight:smooth:));
+
 /*!
 	@function	OpenDisplayProfile
 	@discussion	Returns the ColorSync profile for the default display.
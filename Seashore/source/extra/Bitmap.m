@@ -77,11 +77,11 @@ static inline void rotate_bytes(unsigned char *data, size_t pos1, size_t pos2)
 	data[pos2] = tmp;
 }
 
-static void covertBitmapColorSyncProfile(unsigned char *dbitmap, NSInteger dspp, BMPColorSpace dspace, unsigned char *ibitmap, NSInteger width, NSInteger height, NSInteger ispp, BMPColorSpace ispace, NSInteger ibps, ColorSyncProfileRef iprofile)
+static void covertBitmapColorSyncProfile(unsigned char *dbitmap, NSInteger dspp, BMPColorSpace dspace, NSInteger dbps, unsigned char *ibitmap, NSInteger width, NSInteger height, NSInteger ispp, BMPColorSpace ispace, NSInteger ibps, ColorSyncProfileRef iprofile)
 {
 	ColorSyncDataDepth srcDepth = 0;
-	ColorSyncDataDepth dstDepth = kColorSync8BitInteger;
-	ColorSyncDataLayout dstLayout = kColorSyncAlphaLast | kColorSyncByteOrderDefault;
+	ColorSyncDataDepth dstDepth = (dbps == 16) ? kColorSync16BitInteger : kColorSync8BitInteger;
+	ColorSyncDataLayout dstLayout = kColorSyncAlphaLast | ((dbps == 16) ? ((MSB == 0) ? kColorSyncByteOrder16Big : kColorSyncByteOrder16Little) : kColorSyncByteOrderDefault);
 	ColorSyncDataLayout srcLayout = 0;
 	ColorSyncProfileRef destProf = NULL;
 	size_t srcBytesPerRow = 0;
@@ -136,12 +136,12 @@ static void covertBitmapColorSyncProfile(unsigned char *dbitmap, NSInteger dspp,
 		case kGrayColorSpace:
 		case kInvertedGrayColorSpace:
 			destProf = ColorSyncProfileCreateWithName(kColorSyncGenericGrayProfile);
-			dstBytesPerRow = width * 2;
+			dstBytesPerRow = width * 2 * (dbps / 8);
 			break;
 			
 		case kRGBColorSpace:
 			destProf = ColorSyncProfileCreateWithName(kColorSyncSRGBProfile);
-			dstBytesPerRow = width * 4;
+			dstBytesPerRow = width * 4 * (dbps / 8);
 			break;
 			
 		default:
@@ -175,6 +175,12 @@ static void covertBitmapColorSyncProfile(unsigned char *dbitmap, NSInteger dspp,
 	RGB -> Gray
 */
 
+// Rounds a 16-bit sample to the nearest 8-bit one rather than dropping its low byte
+static inline unsigned char reduceSample(unsigned char *sample)
+{
+	return ((sample[MSB] << 8 | sample[LSB]) * 255 + 32895) >> 16;
+}
+
 static void covertBitmapNoColorSync(unsigned char *dbitmap, NSInteger dspp, BMPColorSpace dspace, unsigned char *ibitmap, NSInteger width, NSInteger height, NSInteger ispp, BMPColorSpace ispace, NSInteger ibps)
 {
 	if (ispace == kGrayColorSpace && dspace == kGrayColorSpace) {
@@ -189,7 +195,7 @@ static void covertBitmapNoColorSync(unsigned char *dbitmap, NSInteger dspp, BMPC
 		} else if (ibps == 16) {
 			for (int i = 0; i < width * height; i++) {
 				for (int j = 0; j < ispp; j++) {
-					dbitmap[i * 2 + j] = ibitmap[i * ispp * 2 + j * 2 + MSB];
+					dbitmap[i * 2 + j] = reduceSample(&ibitmap[i * ispp * 2 + j * 2]);
 				}
 			}
 		}
@@ -205,7 +211,7 @@ static void covertBitmapNoColorSync(unsigned char *dbitmap, NSInteger dspp, BMPC
 		} else if (ibps == 16) {
 			for (int i = 0; i < width * height; i++) {
 				for (int j = 0; j < ispp; j++) {
-					dbitmap[i * 4 + j] = ibitmap[i * ispp * 2 + j * 2 + MSB];
+					dbitmap[i * 4 + j] = reduceSample(&ibitmap[i * ispp * 2 + j * 2]);
 				}
 			}
 		}
@@ -217,8 +223,8 @@ static void covertBitmapNoColorSync(unsigned char *dbitmap, NSInteger dspp, BMPC
 			}
 		} else if (ibps == 16) {
 			for (int i = 0; i < width * height; i++) {
-				dbitmap[i * 4] = dbitmap[i * 4 + 1] = dbitmap[i * 4 + 2] = ibitmap[i * ispp * 2 + MSB];
-				if (ispp == 2) dbitmap[i * 4 + 3] = ibitmap[i * 4 + 2 + MSB];
+				dbitmap[i * 4] = dbitmap[i * 4 + 1] = dbitmap[i * 4 + 2] = reduceSample(&ibitmap[i * ispp * 2]);
+				if (ispp == 2) dbitmap[i * 4 + 3] = reduceSample(&ibitmap[i * 4 + 2]);
 			}
 		}
 	} else if (ispace == kRGBColorSpace && dspace == kGrayColorSpace) {
@@ -229,13 +235,41 @@ static void covertBitmapNoColorSync(unsigned char *dbitmap, NSInteger dspp, BMPC
 			}
 		} else if (ibps == 16) {
 			for (int i = 0; i < width * height; i++) {
-				dbitmap[i * 2] = ((int)ibitmap[i * ispp * 2 + MSB] + (int)ibitmap[i * ispp * 2 + 2 + MSB] + (int)ibitmap[i * ispp * 2 + 4 + MSB]) / 3;
-				if (ispp == 4) dbitmap[i * 2 + 1] = ibitmap[i * 8 + 6 + MSB];
+				dbitmap[i * 2] = ((int)reduceSample(&ibitmap[i * ispp * 2]) + (int)reduceSample(&ibitmap[i * ispp * 2 + 2]) + (int)reduceSample(&ibitmap[i * ispp * 2 + 4])) / 3;
+				if (ispp == 4) dbitmap[i * 2 + 1] = reduceSample(&ibitmap[i * 8 + 6]);
 			}
 		}
 	}
 }
 
+// Reads a sample of a bitmap as a 16-bit sample whatever the bitmap's depth
+static inline uint16_t deepSample(unsigned char *bitmap, NSInteger bps, NSInteger index)
+{
+	if (bps == 16)
+		return bitmap[index * 2 + MSB] << 8 | bitmap[index * 2 + LSB];
+	
+	return expand_sample(bitmap[index]);
+}
+
+// Converts between the grey and RGB colour spaces keeping 16 bits a sample
+static void covertBitmapNoColorSync16(uint16_t *dbitmap, NSInteger dspp, BMPColorSpace dspace, unsigned char *ibitmap, NSInteger width, NSInteger height, NSInteger ispp, BMPColorSpace ispace, NSInteger ibps)
+{
+	BOOL ialpha = (ispace == kRGBColorSpace) ? (ispp == 4) : (ispp == 2);
+	
+	for (NSInteger i = 0; i < width * height; i++) {
+		if (ispace == dspace) {
+			for (NSInteger k = 0; k < dspp - 1; k++)
+				dbitmap[i * dspp + k] = deepSample(ibitmap, ibps, i * ispp + k);
+		} else if (dspace == kRGBColorSpace) {
+			dbitmap[i * 4] = dbitmap[i * 4 + 1] = dbitmap[i * 4 + 2] = deepSample(ibitmap, ibps, i * ispp);
+		} else {
+			dbitmap[i * 2] = ((int)deepSample(ibitmap, ibps, i * ispp) + (int)deepSample(ibitmap, ibps, i * ispp + 1) + (int)deepSample(ibitmap, ibps, i * ispp + 2)) / 3;
+		}
+		if (ialpha)
+			dbitmap[(i + 1) * dspp - 1] = deepSample(ibitmap, ibps, (i + 1) * ispp - 1);
+	}
+}
+
 unsigned char *SeaConvertBitmap(NSInteger dspp, BMPColorSpace dspace, NSInteger dbps, unsigned char *ibitmap, NSInteger width, NSInteger height, NSInteger ispp, NSInteger ibipp, NSInteger ibypr, BMPColorSpace ispace, ColorSyncProfileRef iprofile, NSInteger ibps, GIMPBitmapFormat iformat)
 {
 	PtrRecord ptrs;
@@ -252,7 +286,7 @@ unsigned char *SeaConvertBitmap(NSInteger dspp, BMPColorSpace dspace, NSInteger
 	
 	// Point out conversions that are not possible
 	fail = NULL;
-	if (dbps != 8) fail = @"Only converts to 8 bps";
+	if (dbps != 8 && dbps != 16) fail = @"Only converts to 8 or 16 bps";
 	if (dspace == kCMYKColorSpace) fail = @"Cannot convert to CMYK color space";
 	if (dspace == kInvertedGrayColorSpace) fail = @"Cannot convert to inverted gray color space";
 	if (dspace == kRGBColorSpace && dspp != 4) fail = @"Can only convert to 4 spp for RGB color space";
@@ -354,20 +388,27 @@ unsigned char *SeaConvertBitmap(NSInteger dspp, BMPColorSpace dspace, NSInteger
 	// Convert colour space
 	if (iprofile || ispace == kCMYKColorSpace) {
 		pbitmap = getPtr(ptrs);
-		bitmap = mallocPtr(&ptrs, width * height * dspp);
-		covertBitmapColorSyncProfile(bitmap, dspp, dspace, pbitmap, width, height, ispp, ispace, ibps, iprofile);
+		bitmap = mallocPtr(&ptrs, width * height * dspp * (dbps / 8));
+		covertBitmapColorSyncProfile(bitmap, dspp, dspace, dbps, pbitmap, width, height, ispp, ispace, ibps, iprofile);
+	} else if (dbps == 16) {
+		pbitmap = getPtr(ptrs);
+		bitmap = mallocPtr(&ptrs, width * height * dspp * 2);
+		covertBitmapNoColorSync16((uint16_t *)bitmap, dspp, dspace, pbitmap, width, height, ispp, ispace, ibps);
 	} else {
 		pbitmap = getPtr(ptrs);
 		bitmap = mallocPtr(&ptrs, width * height * dspp);
 		covertBitmapNoColorSync(bitmap, dspp, dspace, pbitmap, width, height, ispp, ispace, ibps);
 	}
 	
-	// Add in alpha (not 16-bit friendly)
+	// Add in alpha
 	s_hasalpha = (ispace == kRGBColorSpace && ispp == 4) || (ispace == kGrayColorSpace && ispp == 2);
 	if (!s_hasalpha) {
+		pbitmap = getPtr(ptrs);
 		for (int i = 0; i < width * height; i++) {
-			pbitmap = getPtr(ptrs);
-			pbitmap[(i + 1) * dspp - 1] = 255;
+			if (dbps == 16)
+				((uint16_t *)pbitmap)[(i + 1) * dspp - 1] = 65535;
+			else
+				pbitmap[(i + 1) * dspp - 1] = 255;
 		}
 	}
 	
@@ -410,55 +451,484 @@ void SeaStripAlphaToWhite(NSInteger spp, unsigned char *output, unsigned char *i
 	} 
 }
 
+// Pixels are worked through in blocks so runs of opaque or clear pixels can be skipped
+#define kPremultiplyBlock 32
+
+// Large bitmaps are split in to chunks of this many pixels for each thread
+#define kPremultiplyChunk 65536
+
+// The fixed-point (16.16) reciprocal of each alpha, rounded up so that the
+// results are exactly rounded
+static unsigned int unpremultiplyTable[256];
+
+static inline BOOL blockIsUniform(const NSInteger spp, unsigned char *output, unsigned char *input, NSInteger count)
+{
+	unsigned char all = 255, any = 0;
+	
+	for (NSInteger i = 0; i < count; i++) {
+		all &= input[i * spp + spp - 1];
+		any |= input[i * spp + spp - 1];
+	}
+	if (all == 255) {
+		if (output != input)
+			memcpy(output, input, count * spp);
+		return YES;
+	}
+	if (any == 0) {
+		memset(output, 0, count * spp);
+		return YES;
+	}
+	
+	return NO;
+}
+
+static inline void premultiplyBlock(const NSInteger spp, unsigned char *output, unsigned char *input, NSInteger count)
+{
+	unsigned char alpha;
+	int temp;
+	
+	if (blockIsUniform(spp, output, input, count))
+		return;
+	for (NSInteger i = 0; i < count; i++) {
+		alpha = input[i * spp + spp - 1];
+		for (NSInteger k = 0; k < spp - 1; k++)
+			output[i * spp + k] = int_mult(input[i * spp + k], alpha, temp);
+		output[i * spp + spp - 1] = alpha;
+	}
+}
+
+static inline void unpremultiplyBlock(const NSInteger spp, unsigned char *output, unsigned char *input, NSInteger count)
+{
+	unsigned int reciprocal, value;
+	unsigned char alpha;
+	
+	if (blockIsUniform(spp, output, input, count))
+		return;
+	for (NSInteger i = 0; i < count; i++) {
+		alpha = input[i * spp + spp - 1];
+		reciprocal = unpremultiplyTable[alpha];
+		for (NSInteger k = 0; k < spp - 1; k++) {
+			value = (input[i * spp + k] * reciprocal + 32768) >> 16;
+			output[i * spp + k] = MIN(value, 255);
+		}
+		output[i * spp + spp - 1] = alpha;
+	}
+}
+
+static void premultiplyRun(NSInteger spp, unsigned char *output, unsigned char *input, NSInteger length, BOOL reverse)
+{
+	NSInteger count;
+	
+	// Give the compiler constant sample counts for the usual cases
+	for (NSInteger i = 0; i < length; i += kPremultiplyBlock) {
+		count = MIN(kPremultiplyBlock, length - i);
+		switch (spp) {
+			case 2:
+				if (reverse) unpremultiplyBlock(2, &(output[i * 2]), &(input[i * 2]), count);
+				else premultiplyBlock(2, &(output[i * 2]), &(input[i * 2]), count);
+			break;
+			case 4:
+				if (reverse) unpremultiplyBlock(4, &(output[i * 4]), &(input[i * 4]), count);
+				else premultiplyBlock(4, &(output[i * 4]), &(input[i * 4]), count);
+			break;
+			default:
+				if (reverse) unpremultiplyBlock(spp, &(output[i * spp]), &(input[i * spp]), count);
+				else premultiplyBlock(spp, &(output[i * spp]), &(input[i * spp]), count);
+			break;
+		}
+	}
+}
+
+static void premultiplyBitmap(NSInteger spp, unsigned char *output, unsigned char *input, NSInteger length, BOOL reverse)
+{
+	NSInteger chunks = (length + kPremultiplyChunk - 1) / kPremultiplyChunk;
+	
+	if (chunks <= 1) {
+		premultiplyRun(spp, output, input, length, reverse);
+	}
+	else {
+		dispatch_apply(chunks, dispatch_get_global_queue(0, 0), ^(size_t chunk) {
+			NSInteger start = chunk * kPremultiplyChunk;
+			premultiplyRun(spp, &(output[start * spp]), &(input[start * spp]), MIN(kPremultiplyChunk, length - start), reverse);
+		});
+	}
+}
+
 void SeaPremultiplyBitmap(NSInteger spp, unsigned char *output, unsigned char *input, NSInteger length)
 {
-	NSInteger alphaPos, temp;
+	premultiplyBitmap(spp, output, input, length, NO);
+}
+
+void SeaUnpremultiplyBitmap(NSInteger spp, unsigned char *output, unsigned char *input, NSInteger length)
+{
+	static dispatch_once_t once;
+	
+	dispatch_once(&once, ^{
+		for (int alpha = 1; alpha < 256; alpha++)
+			unpremultiplyTable[alpha] = ((255u << 16) + alpha - 1) / alpha;
+	});
+	premultiplyBitmap(spp, output, input, length, YES);
+}
+
+// Premultiplies or unpremultiplies a run of 16-bit pixels
+static void premultiplyRun16(NSInteger spp, uint16_t *output, uint16_t *input, NSInteger length, BOOL reverse)
+{
+	uint32_t alpha, value, temp;
 	
 	for (NSInteger i = 0; i < length; i++) {
-		alphaPos = (i + 1) * spp - 1;
-		if (input[alphaPos] == 255) {
-			for (NSInteger j = 0; j < spp; j++)
-				output[i * spp + j] = input[i * spp + j];
+		alpha = input[i * spp + spp - 1];
+		if (alpha == 65535 || alpha == 0) {
+			for (NSInteger k = 0; k < spp - 1; k++)
+				output[i * spp + k] = (alpha) ? input[i * spp + k] : 0;
+		}
+		else if (reverse) {
+			for (NSInteger k = 0; k < spp - 1; k++) {
+				value = ((uint64_t)input[i * spp + k] * 65535 + alpha / 2) / alpha;
+				output[i * spp + k] = MIN(value, 65535);
+			}
 		}
 		else {
-			if (input[alphaPos] != 0) {
-				for (NSInteger j = 0; j < spp - 1; j++)
-					output[i * spp + j] = int_mult(input[i * spp + j], input[alphaPos], temp);
-				output[alphaPos] = input[alphaPos];
+			for (NSInteger k = 0; k < spp - 1; k++)
+				output[i * spp + k] = int_mult16(input[i * spp + k], alpha, temp);
+		}
+		output[i * spp + spp - 1] = alpha;
+	}
+}
+
+static void premultiplyBitmap16(NSInteger spp, uint16_t *output, uint16_t *input, NSInteger length, BOOL reverse)
+{
+	NSInteger chunks = (length + kPremultiplyChunk - 1) / kPremultiplyChunk;
+	
+	dispatch_apply(chunks, dispatch_get_global_queue(0, 0), ^(size_t chunk) {
+		NSInteger start = chunk * kPremultiplyChunk;
+		premultiplyRun16(spp, &(output[start * spp]), &(input[start * spp]), MIN(kPremultiplyChunk, length - start), reverse);
+	});
+}
+
+void SeaPremultiplyBitmap16(NSInteger spp, uint16_t *output, uint16_t *input, NSInteger length)
+{
+	premultiplyBitmap16(spp, output, input, length, NO);
+}
+
+void SeaUnpremultiplyBitmap16(NSInteger spp, uint16_t *output, uint16_t *input, NSInteger length)
+{
+	premultiplyBitmap16(spp, output, input, length, YES);
+}
+
+void SeaExpandSamples(uint16_t *output, unsigned char *input, NSInteger count)
+{
+	// Work backwards so the output can begin where the input does
+	for (NSInteger i = count - 1; i >= 0; i--)
+		output[i] = expand_sample(input[i]);
+}
+
+void SeaNarrowSamples(unsigned char *output, uint16_t *input, NSInteger count)
+{
+	for (NSInteger i = 0; i < count; i++)
+		output[i] = narrow_sample(input[i]);
+}
+
+void SeaBoxReduceBitmap(int spp, unsigned char *dest, int destWidth, int destHeight, unsigned char *src, int srcWidth, int srcHeight, BOOL premultiply, IntRect destRect)
+{
+	int left = MAX(destRect.origin.x, 0), top = MAX(destRect.origin.y, 0);
+	int right = MIN(destRect.origin.x + destRect.size.width, destWidth);
+	int bottom = MIN(destRect.origin.y + destRect.size.height, destHeight);
+	
+	dispatch_apply(MAX(bottom - top, 0), dispatch_get_global_queue(0, 0), ^(size_t row) {
+		int j = top + (int)row;
+		int y0 = (int)((long)j * srcHeight / destHeight), y1 = (int)((long)(j + 1) * srcHeight / destHeight);
+		int x0, x1, i, x, y, k, alpha, count, temp;
+		int totals[4];
+		unsigned char *pixel;
+		
+		for (i = left; i < right; i++) {
+			x0 = (int)((long)i * srcWidth / destWidth);
+			x1 = (int)((long)(i + 1) * srcWidth / destWidth);
+			for (k = 0; k < spp; k++)
+				totals[k] = 0;
+			for (y = y0; y < y1; y++) {
+				for (x = x0; x < x1; x++) {
+					pixel = &(src[(y * srcWidth + x) * spp]);
+					alpha = pixel[spp - 1];
+					for (k = 0; k < spp - 1; k++)
+						totals[k] += (premultiply) ? int_mult(pixel[k], alpha, temp) : pixel[k];
+					totals[spp - 1] += alpha;
+				}
 			}
-			else {
-				for (NSInteger j = 0; j < spp; j++)
-					output[i * spp + j] = 0;
+			count = (x1 - x0) * (y1 - y0);
+			for (k = 0; k < spp; k++)
+				dest[(j * destWidth + i) * spp + k] = (count) ? (totals[k] + count / 2) / count : 0;
+		}
+	});
+}
+
+void SeaBoxReduceBitmap16(int spp, unsigned char *dest, int destWidth, int destHeight, uint16_t *src, int srcWidth, int srcHeight, IntRect destRect)
+{
+	int left = MAX(destRect.origin.x, 0), top = MAX(destRect.origin.y, 0);
+	int right = MIN(destRect.origin.x + destRect.size.width, destWidth);
+	int bottom = MIN(destRect.origin.y + destRect.size.height, destHeight);
+	
+	dispatch_apply(MAX(bottom - top, 0), dispatch_get_global_queue(0, 0), ^(size_t row) {
+		int j = top + (int)row;
+		int y0 = (int)((long)j * srcHeight / destHeight), y1 = (int)((long)(j + 1) * srcHeight / destHeight);
+		int x0, x1, i, x, y, k, count;
+		uint32_t alpha, temp;
+		uint64_t totals[4];
+		uint16_t *pixel;
+		
+		for (i = left; i < right; i++) {
+			x0 = (int)((long)i * srcWidth / destWidth);
+			x1 = (int)((long)(i + 1) * srcWidth / destWidth);
+			for (k = 0; k < spp; k++)
+				totals[k] = 0;
+			for (y = y0; y < y1; y++) {
+				for (x = x0; x < x1; x++) {
+					pixel = &(src[(y * srcWidth + x) * spp]);
+					alpha = pixel[spp - 1];
+					for (k = 0; k < spp - 1; k++)
+						totals[k] += int_mult16(pixel[k], alpha, temp);
+					totals[spp - 1] += alpha;
+				}
 			}
+			count = (x1 - x0) * (y1 - y0);
+			for (k = 0; k < spp; k++)
+				dest[(j * destWidth + i) * spp + k] = (count) ? narrow_sample((totals[k] + count / 2) / count) : 0;
 		}
+	});
+}
+
+// The width and height of the tiles bitmaps are rotated in
+#define kRotateTileSize 32
+
+// The number of bytes of rows given to each processor when flipping
+#define kFlipChunk 65536
+
+// Reverses the order of the pixels in a row
+static inline void reverseRow(const int spp, unsigned char *row, int width)
+{
+	unsigned char *left = row, *right = row + (width - 1) * spp, temp[8];
+	
+	for (; left < right; left += spp, right -= spp) {
+		memcpy(temp, left, spp);
+		memcpy(left, right, spp);
+		memcpy(right, temp, spp);
 	}
 }
 
-void SeaUnpremultiplyBitmap(NSInteger spp, unsigned char *output, unsigned char *input, NSInteger length)
+// Exchanges the contents of two rows
+static inline void swapRows(unsigned char *first, unsigned char *second, size_t length)
 {
-	NSInteger i, j, alphaPos, newValue;
-	double alphaRatio;
+	unsigned char temp[1024];
+	size_t count;
 	
-	for (i = 0; i < length; i++) {
-		alphaPos = (i + 1) * spp - 1;
-		if (input[alphaPos] == 255) {
-			for (j = 0; j < spp; j++)
-				output[i * spp + j] = input[i * spp + j];
-		} else {
-			if (input[alphaPos] != 0) {
-				alphaRatio = 255.0 / input[alphaPos];
-				for (j = 0; j < spp - 1; j++) {
-					newValue = 0.5 + input[i * spp + j] * alphaRatio;
-					newValue = MIN(newValue, 255);
-					output[i * spp + j] = newValue;
+	for (size_t i = 0; i < length; i += count) {
+		count = MIN(sizeof(temp), length - i);
+		memcpy(temp, first + i, count);
+		memcpy(first + i, second + i, count);
+		memcpy(second + i, temp, count);
+	}
+}
+
+void SeaFlipBitmap(int spp, unsigned char *data, int width, int height, int rowLength, BOOL horizontal)
+{
+	size_t rowBytes = (size_t)rowLength * spp;
+	int rows = horizontal ? height : height / 2;
+	int rowsPerChunk = (int)MAX(kFlipChunk / MAX(width * spp, 1), 1);
+	
+	if (width <= 0 || rows <= 0)
+		return;
+	dispatch_apply((rows + rowsPerChunk - 1) / rowsPerChunk, dispatch_get_global_queue(0, 0), ^(size_t chunk) {
+		int j, end = MIN((int)(chunk + 1) * rowsPerChunk, rows);
+		
+		for (j = (int)chunk * rowsPerChunk; j < end; j++) {
+			if (horizontal) {
+				// Give the compiler a constant pixel size for the usual cases
+				switch (spp) {
+					case 1:
+						reverseRow(1, data + j * rowBytes, width);
+					break;
+					case 2:
+						reverseRow(2, data + j * rowBytes, width);
+					break;
+					case 4:
+						reverseRow(4, data + j * rowBytes, width);
+					break;
+					case 8:
+						reverseRow(8, data + j * rowBytes, width);
+					break;
+					default:
+						reverseRow(spp, data + j * rowBytes, width);
+					break;
 				}
-				output[alphaPos] = input[alphaPos];
-			} else {
-				for (j = 0; j < spp; j++)
-					output[i * spp + j] = 0;
 			}
+			else {
+				swapRows(data + j * rowBytes, data + (height - j - 1) * rowBytes, (size_t)width * spp);
+			}
+		}
+	});
+}
+
+// Rotates the pixels of one tile of the original bitmap
+static inline void rotateTile(const int spp, unsigned char *dest, const unsigned char *src, int width, int height, IntRect tile, BOOL clockwise)
+{
+	int i, j, top = tile.origin.y, bottom = tile.origin.y + tile.size.height;
+	const unsigned char *srcPixel;
+	unsigned char *destPixel;
+	ptrdiff_t step;
+	
+	// Each column of the tile becomes a row of the rotated bitmap
+	for (i = tile.origin.x; i < tile.origin.x + tile.size.width; i++) {
+		srcPixel = src + ((size_t)top * width + i) * spp;
+		if (clockwise) {
+			destPixel = dest + ((size_t)i * height + (height - top - 1)) * spp;
+			step = -spp;
+		}
+		else {
+			destPixel = dest + ((size_t)(width - i - 1) * height + top) * spp;
+			step = spp;
+		}
+		for (j = top; j < bottom; j++) {
+			memcpy(destPixel, srcPixel, spp);
+			srcPixel += (size_t)width * spp;
+			destPixel += step;
+		}
+	}
+}
+
+void SeaRotateBitmap(int spp, unsigned char *dest, unsigned char *src, int width, int height, BOOL clockwise)
+{
+	int tilesDown = (height + kRotateTileSize - 1) / kRotateTileSize;
+	
+	// Each processor takes a band of tiles at a time
+	dispatch_apply(MAX(tilesDown, 0), dispatch_get_global_queue(0, 0), ^(size_t band) {
+		IntRect tile;
+		
+		tile.origin.y = (int)band * kRotateTileSize;
+		tile.size.height = MIN(kRotateTileSize, height - tile.origin.y);
+		for (tile.origin.x = 0; tile.origin.x < width; tile.origin.x += kRotateTileSize) {
+			tile.size.width = MIN(kRotateTileSize, width - tile.origin.x);
+			
+			// Give the compiler a constant pixel size for the usual cases
+			switch (spp) {
+				case 1:
+					rotateTile(1, dest, src, width, height, tile, clockwise);
+				break;
+				case 2:
+					rotateTile(2, dest, src, width, height, tile, clockwise);
+				break;
+				case 4:
+					rotateTile(4, dest, src, width, height, tile, clockwise);
+				break;
+				case 8:
+					rotateTile(8, dest, src, width, height, tile, clockwise);
+				break;
+				default:
+					rotateTile(spp, dest, src, width, height, tile, clockwise);
+				break;
+			}
+		}
+	});
+}
+
+// The pixels of the original a pixel of a scaled bitmap is made from
+typedef struct {
+	int first, count;
+	float *weights;
+} ScaleContribution;
+
+// Works out the contributions to each pixel of a scaled row or column, using a
+// triangle filter that is widened when reducing so every original pixel counts
+static ScaleContribution *scaleContributions(int srcLength, int destLength, BOOL smooth, float **weights)
+{
+	float scale = (float)destLength / (float)srcLength;
+	float support = (scale < 1.0f) ? 1.0f / scale : 1.0f;
+	int span = (int)ceilf(support) * 2 + 1;
+	ScaleContribution *contributions = malloc(destLength * sizeof(ScaleContribution));
+	float centre, total;
+	int i, n, first, last;
+	
+	*weights = malloc((size_t)destLength * span * sizeof(float));
+	for (i = 0; i < destLength; i++) {
+		centre = ((float)i + 0.5f) / scale - 0.5f;
+		contributions[i].weights = *weights + (size_t)i * span;
+		first = MAX((int)ceilf(centre - support), 0);
+		last = MIN((int)floorf(centre + support), srcLength - 1);
+		total = 0.0f;
+		if (smooth) {
+			for (n = 0; n <= last - first; n++) {
+				contributions[i].weights[n] = 1.0f - fabsf((float)(first + n) - centre) / support;
+				total += contributions[i].weights[n];
+			}
+		}
+		if (total > 0.0f) {
+			contributions[i].first = first;
+			contributions[i].count = last - first + 1;
+			for (n = 0; n < contributions[i].count; n++)
+				contributions[i].weights[n] /= total;
+		}
+		else {
+			// Without smoothing each pixel is the original pixel it falls on
+			contributions[i].first = MIN(MAX((int)floorf(centre + 0.5f), 0), srcLength - 1);
+			contributions[i].count = 1;
+			contributions[i].weights[0] = 1.0f;
 		}
 	}
+	
+	return contributions;
+}
+
+void SeaScaleBitmap16(int spp, uint16_t *dest, int destWidth, int destHeight, uint16_t *src, int srcWidth, int srcHeight, BOOL smooth)
+{
+	float *horizontalWeights, *verticalWeights;
+	ScaleContribution *horizontal = scaleContributions(srcWidth, destWidth, smooth, &horizontalWeights);
+	ScaleContribution *vertical = scaleContributions(srcHeight, destHeight, smooth, &verticalWeights);
+	float *rows = malloc((size_t)destWidth * srcHeight * spp * sizeof(float));
+	
+	// Scale each row across, premultiplying the original as it is read
+	dispatch_apply(srcHeight, dispatch_get_global_queue(0, 0), ^(size_t j) {
+		uint16_t *pixel;
+		float *row = rows + j * destWidth * spp, weight;
+		int i, n, k;
+		
+		for (i = 0; i < destWidth; i++) {
+			for (k = 0; k < spp; k++)
+				row[i * spp + k] = 0.0f;
+			for (n = 0; n < horizontal[i].count; n++) {
+				pixel = src + (j * srcWidth + horizontal[i].first + n) * spp;
+				weight = horizontal[i].weights[n];
+				for (k = 0; k < spp - 1; k++)
+					row[i * spp + k] += weight * pixel[spp - 1] * pixel[k];
+				row[i * spp + spp - 1] += weight * pixel[spp - 1];
+			}
+		}
+	});
+	
+	// Then each column down, unpremultiplying as the result is written
+	dispatch_apply(destHeight, dispatch_get_global_queue(0, 0), ^(size_t j) {
+		float totals[4], weight;
+		float *pixel;
+		int i, n, k;
+		
+		for (i = 0; i < destWidth; i++) {
+			for (k = 0; k < spp; k++)
+				totals[k] = 0.0f;
+			for (n = 0; n < vertical[j].count; n++) {
+				pixel = rows + ((size_t)(vertical[j].first + n) * destWidth + i) * spp;
+				weight = vertical[j].weights[n];
+				for (k = 0; k < spp; k++)
+					totals[k] += weight * pixel[k];
+			}
+			for (k = 0; k < spp - 1; k++)
+				dest[(j * destWidth + i) * spp + k] = (totals[spp - 1] > 0.0f) ? MIN(totals[k] / totals[spp - 1] + 0.5f, 65535.0f) : 0;
+			dest[(j * destWidth + i) * spp + spp - 1] = MIN(totals[spp - 1] + 0.5f, 65535.0f);
+		}
+	});
+	
+	free(rows);
+	free(horizontal);
+	free(horizontalWeights);
+	free(vertical);
+	free(verticalWeights);
 }
 
 unsigned char SeaAveragedComponentValue(int spp, unsigned char *data, int width, int height, int component, int radius, IntPoint where)
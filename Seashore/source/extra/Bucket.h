@@ -48,7 +48,9 @@ __BEGIN_DECLS
 				Pixels will only be replaced if their channel(s) are within this
 				tolerance of the seed point. A tolerance of 255 indicates that
 				all pixels should be replaced in the given rectangle (bucketFill
-				works much faster on such calls).
+				works much faster on such calls). Each seed is filled whatever
+				its colour and neighbours are filled if they are within the
+				tolerance of any seed.
 	@param		channel
 				The channel(s) to use in determining whether a pixel meets the
 				above condition.
@@ -57,6 +59,80 @@ __BEGIN_DECLS
 */
 IntRect SeaBucketFill(int spp, IntRect rect, unsigned char *overlay, unsigned char *data, int width, int height, IntPoint seeds[], int numSeeds, unsigned char *fillColor, int tolerance, int channel);
 
+/*!
+	@function	SeaBucketFillMask
+	@discussion	Given a seed point marks all neighbouring pixels of similar
+				colours in a mask, as the magic wand does before making a
+				selection. The rules for which pixels are filled are those of
+				SeaBucketFill.
+	@param		spp
+				The samples per pixel of the bitmap.
+	@param		rect
+				The largest region of the bitmap to fill (must lie entirely
+				within bitmap).
+	@param		mask
+				The block of memory containing the mask, one byte for each pixel
+				of the bitmap. Filled pixels are set to 255 and others are left
+				alone, so the mask should be cleared beforehand.
+	@param		data
+				The block of memory containing the bitmap data.
+	@param		width
+				The width of both the bitmap and mask.
+	@param		height
+				The height of both the bitmap and mask.
+	@param		seeds
+				The seed points at which to begin filling.
+	@param		numSeeds
+				The number of seed points in the array.
+	@param		tolerance
+				Pixels will only be marked if their channel(s) are within this
+				tolerance of a seed point.
+	@param		channel
+				The channel(s) to use in determining whether a pixel meets the
+				above condition.
+	@result		Returns the smallest possible IntRect including all marked
+				pixels.
+*/
+IntRect SeaBucketFillMask(int spp, IntRect rect, unsigned char *mask, unsigned char *data, int width, int height, IntPoint seeds[], int numSeeds, int tolerance, int channel);
+
+/*!
+	@function	SeaColorMask
+	@discussion	Marks every pixel in the rectangle whose colour is close to that
+				of a seed point, whether or not it touches the seed. Pixels
+				within the tolerance are fully marked and the marking then
+				fades out linearly, so the mask has soft edges.
+	@param		spp
+				The samples per pixel of the bitmap.
+	@param		rect
+				The region of the bitmap to consider (must lie entirely within
+				bitmap).
+	@param		mask
+				The block of memory containing the mask, one byte for each pixel
+				of the bitmap. Every pixel of the rectangle is written.
+	@param		data
+				The block of memory containing the bitmap data.
+	@param		width
+				The width of both the bitmap and mask.
+	@param		height
+				The height of both the bitmap and mask.
+	@param		seeds
+				The points whose colours are to be matched.
+	@param		numSeeds
+				The number of seed points in the array.
+	@param		tolerance
+				Pixels are fully marked if their channel(s) are within this
+				tolerance of a seed point's.
+	@param		softness
+				The distance beyond the tolerance over which the marking fades
+				out, zero for a hard edge.
+	@param		channel
+				The channel(s) to use in determining the distance between
+				colours.
+	@result		Returns the smallest possible IntRect including all marked
+				pixels.
+*/
+IntRect SeaColorMask(int spp, IntRect rect, unsigned char *mask, unsigned char *data, int width, int height, IntPoint seeds[], int numSeeds, int tolerance, int softness, int channel);
+
 /*!
 	@function	SeaTextureFill
 	@discussion	Given a bitmap, this function fills the bitmap with the given
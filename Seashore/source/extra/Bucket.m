@@ -2,178 +2,349 @@
 
 #define kStackSizeIncrement 2500
 
-static BOOL shouldFill(unsigned char *overlay, unsigned char *data, IntPoint seeds[], int numSeeds, IntPoint point, int width, int spp, int tolerance, int channel)
+typedef struct {
+	int spp, width, channel;
+	IntRect rect;
+	unsigned char *data;
+	
+	// Exactly one of these is the target, the overlay also needs a visited bitmap
+	unsigned char *overlay, *mask, *visited;
+	unsigned char *fillColor;
+	
+	// The acceptable range of each sample for each distinct seed colour
+	int numRanges;
+	unsigned char (*lower)[4], (*upper)[4];
+} FillContext;
+
+static inline BOOL colorMatches(FillContext *ctx, unsigned char *pixel)
 {
-	int seedIndex;
+	int spp = ctx->spp, k, r;
+	BOOL inside;
 	
-	for(seedIndex = 0; seedIndex < numSeeds; seedIndex++){
-		
-		IntPoint seed = seeds[seedIndex];
-		BOOL outsideTolerance = NO;
-		int i, j, temp;
-		
-		i = point.x;
-		j = point.y;
-		
-		if (overlay[(width * j + i + 1) * spp - 1] > 0){
-			outsideTolerance = YES;
-			continue;
-		}
-		
-		if (channel == kAllChannels) {
-			for (int k = spp - 1; k >= 0; k--) {
-				temp = abs((int)data[(width * j + i) * spp + k] - (int)data[(width * seed.y + seed.x) * spp + k]);
-				if (temp > tolerance){
-					outsideTolerance = YES;
-					break;
-				}
-				if (k == spp - 1 && data[(width * j + i) * spp + k] == 0)
+	for (r = 0; r < ctx->numRanges; r++) {
+		unsigned char *lower = ctx->lower[r], *upper = ctx->upper[r];
+		switch (ctx->channel) {
+			case kAllChannels:
+				if (pixel[spp - 1] < lower[spp - 1] || pixel[spp - 1] > upper[spp - 1])
+					continue;
+				// Transparent pixels match whatever their colour
+				if (pixel[spp - 1] == 0)
 					return YES;
-			}
-		} else if (channel == kPrimaryChannels) {
-			for (int k = 0; k < spp - 1; k++) {
-				temp = abs((int)data[(width * j + i) * spp + k] - (int)data[(width * seed.y + seed.x) * spp + k]);
-				if (temp > tolerance){
-					outsideTolerance = YES;
-					break;
-				}
-			}
-		} else if (channel == kAlphaChannel) {
-			temp = abs((int)data[(width * j + i + 1) * spp - 1] - (int)data[(width * seed.y + seed.x + 1) * spp - 1]);
-			if (temp > tolerance){
-				outsideTolerance = YES;
-			}
-		
-		}
-		
-		if (!outsideTolerance) {
-			return YES;
+				// Fall through to check the colour
+			case kPrimaryChannels:
+				inside = YES;
+				for (k = 0; k < spp - 1 && inside; k++)
+					inside = (pixel[k] >= lower[k] && pixel[k] <= upper[k]);
+				if (inside)
+					return YES;
+			break;
+			case kAlphaChannel:
+				if (pixel[spp - 1] >= lower[spp - 1] && pixel[spp - 1] <= upper[spp - 1])
+					return YES;
+			break;
 		}
 	}
 	
 	return NO;
 }
 
-IntRect SeaBucketFill(int spp, IntRect rect, unsigned char *overlay, unsigned char *data, int width, int height, IntPoint seeds[], int numSeeds, unsigned char *fillColor, int tolerance, int channel)
+static inline BOOL shouldFill(FillContext *ctx, int x, int y)
 {
-	// We know at the very least that this point is in the rect
-	IntRect result = IntMakeRect(seeds[0].x, seeds[0].y, 1, 1);
-
-	for(int seedIndex = 0; seedIndex < numSeeds; seedIndex++){
-		IntPoint point, newPoint, seed = seeds[seedIndex];
-		IntPoint *stack;
-		int stackSize, stackPos, k;
-		int minLeft = seed.x, maxRight = seed.x, minTop = seed.y, maxBottom = seed.y;
-		int i, j;
-		unsigned char firstPixel[4];
-		int origTolerance = tolerance;
+	int pos = y * ctx->width + x;
+	int bit = (y - ctx->rect.origin.y) * ctx->rect.size.width + (x - ctx->rect.origin.x);
+	
+	if (ctx->mask) {
+		if (ctx->mask[pos])
+			return NO;
+	}
+	else {
+		// Already filled, or the overlay was already in use here
+		if (ctx->visited[bit >> 3] & (1 << (bit & 7)))
+			return NO;
+		if (ctx->overlay[(pos + 1) * ctx->spp - 1] != 0)
+			return NO;
+	}
+	
+	return colorMatches(ctx, &(ctx->data[pos * ctx->spp]));
+}
 
-		// If the overlay alread contains this point, then our work is already done
-		BOOL visited = YES;
-		for (int k = 0; k < spp; k++){
-			// Compare to see if the fill exists at this point in the overlay
-			if(overlay[(seed.y * width + seed.x) * spp + k] != fillColor[k]){
-				visited = NO;
-			}
+static inline void fillSpan(FillContext *ctx, int left, int right, int y)
+{
+	int pos = y * ctx->width, bit, x;
+	
+	if (ctx->mask) {
+		memset(&(ctx->mask[pos + left]), 255, right - left + 1);
+	}
+	else {
+		for (x = left; x <= right; x++) {
+			memcpy(&(ctx->overlay[(pos + x) * ctx->spp]), ctx->fillColor, ctx->spp);
+			bit = (y - ctx->rect.origin.y) * ctx->rect.size.width + (x - ctx->rect.origin.x);
+			ctx->visited[bit >> 3] |= (1 << (bit & 7));
 		}
-		if (visited) {
-			// We have in fact already filled this point so there's no reason 
-			// to do another bucket fill from this point
+	}
+}
+
+static IntRect scanlineFill(FillContext *ctx, IntPoint seeds[], int numSeeds, int tolerance)
+{
+	IntRect rect = ctx->rect;
+	int rectRight = rect.origin.x + rect.size.width - 1, rectBottom = rect.origin.y + rect.size.height - 1;
+	int minLeft = INT_MAX, maxRight = INT_MIN, minTop = INT_MAX, maxBottom = INT_MIN;
+	int stackSize = kStackSizeIncrement, stackPos = 0;
+	IntPoint *stack, point;
+	int left, right, x, y, k, r, seedIndex;
+	unsigned char *seedPixel;
+	BOOL inRun;
+	
+	// Work out the acceptable range of each sample once for each distinct seed colour
+	ctx->lower = malloc(numSeeds * sizeof(*ctx->lower));
+	ctx->upper = malloc(numSeeds * sizeof(*ctx->upper));
+	ctx->numRanges = 0;
+	for (seedIndex = 0; seedIndex < numSeeds; seedIndex++) {
+		if (!IntPointInRect(seeds[seedIndex], rect))
 			continue;
+		seedPixel = &(ctx->data[(seeds[seedIndex].y * ctx->width + seeds[seedIndex].x) * ctx->spp]);
+		for (r = 0; r < ctx->numRanges; r++) {
+			for (k = 0; k < ctx->spp && ctx->lower[r][k] == MAX(seedPixel[k] - tolerance, 0) && ctx->upper[r][k] == MIN(seedPixel[k] + tolerance, 255); k++);
+			if (k == ctx->spp) break;
 		}
-
-		if (!IntContainsRect(IntMakeRect(0, 0, width, height), rect)) NSLog(@"Bad rectangle passed to textureFill()");
-		if (fillColor[spp - 1] == 0) return IntMakeRect(0, 0, 0, 0);
-		
-		if (tolerance > 0 && tolerance < 255) {
-			tolerance = 255;
-			memcpy(firstPixel, data, spp);
-			for (j = rect.origin.y; j < rect.origin.y + rect.size.height && tolerance != origTolerance; j++) {
-				for	(i = rect.origin.x; i < rect.origin.x + rect.size.width; i++) {
-					if (memcmp(firstPixel, &data[(j * width + i) * spp], spp) != 0) {
-						tolerance = origTolerance;
-						break;
-					}
-				}
-			}
+		if (r < ctx->numRanges)
+			continue;
+		for (k = 0; k < ctx->spp; k++) {
+			ctx->lower[ctx->numRanges][k] = MAX(seedPixel[k] - tolerance, 0);
+			ctx->upper[ctx->numRanges][k] = MIN(seedPixel[k] + tolerance, 255);
 		}
+		ctx->numRanges++;
+	}
+	
+	// Each seed is filled whether or not it matches (unless already filled)
+	stack = malloc(sizeof(IntPoint) * stackSize);
+	for (seedIndex = 0; seedIndex < numSeeds; seedIndex++) {
+		point = seeds[seedIndex];
+		if (!IntPointInRect(point, rect))
+			continue;
+		if (ctx->mask ? ctx->mask[point.y * ctx->width + point.x] != 0 : !memcmp(&(ctx->overlay[(point.y * ctx->width + point.x) * ctx->spp]), ctx->fillColor, ctx->spp))
+			continue;
+		stack[stackPos++] = point;
 		
-		if (tolerance < 0) {
-			result = IntMakeRect(0, 0, 0, 0);
-		} else if (tolerance >= 255) {
-			for (j = rect.origin.y; j < rect.origin.y + rect.size.height; j++) {
-				for	(i = rect.origin.x; i < rect.origin.x + rect.size.width; i++) {
-					memcpy(&(overlay[(j * width + i) * spp]), fillColor, spp);
-				}
-			}
+		while (stackPos > 0) {
+			point = stack[--stackPos];
+			y = point.y;
 			
-			result = rect;
-		} else {
-			stack = malloc(sizeof(IntPoint) * kStackSizeIncrement);
-			stackSize = kStackSizeIncrement;
-			stackPos = 0;
-			point = seed;
-			do {
-				if (stackPos == stackSize) {
-					stackSize += kStackSizeIncrement;
-					stack = realloc(stack, sizeof(IntPoint) * stackSize);
-				}
-				
-				if (overlay[(point.y * width + point.x) * spp + spp - 1] == 0)  {
-					for (k = 0; k < spp; k++)
-						overlay[(point.y * width + point.x) * spp + k] = fillColor[k];
-				}
-				
-				newPoint = point;
-				newPoint.y++;
-				if (IntPointInRect(newPoint, rect) && shouldFill(overlay, data, seeds, numSeeds, newPoint, width, spp, tolerance, channel)) {
-					stack[stackPos] = point;
-					stackPos++;
-					point = newPoint;
-					if (point.y > maxBottom) maxBottom = point.y;
-				} else {
-					newPoint = point;
-					newPoint.y--;
-					if (IntPointInRect(newPoint, rect) && shouldFill(overlay, data, seeds, numSeeds, newPoint, width, spp, tolerance, channel)) {
-						stack[stackPos] = point;
-						stackPos++;
-						point = newPoint;
-						if (point.y < minTop) minTop = point.y;
-					} else {
-						newPoint = point;
-						newPoint.x++;
-						if (IntPointInRect(newPoint, rect) && shouldFill(overlay, data, seeds, numSeeds, newPoint, width, spp, tolerance, channel)) {
-							stack[stackPos] = point;
-							stackPos++;
-							point = newPoint;
-							if (point.x > maxRight)
-								maxRight = point.x;
-						} else {
-							newPoint = point;
-							newPoint.x--;
-							if (IntPointInRect(newPoint, rect) && shouldFill(overlay, data, seeds, numSeeds, newPoint, width, spp, tolerance, channel)) {
-								stack[stackPos] = point;
-								stackPos++;
-								point = newPoint;
-								if (point.x < minLeft) minLeft = point.x;
-							} else {
-								stackPos--;
-								if (stackPos > -1)
-									point = stack[stackPos];
+			// Find the run about the point
+			left = right = point.x;
+			while (left > rect.origin.x && shouldFill(ctx, left - 1, y))
+				left--;
+			while (right < rectRight && shouldFill(ctx, right + 1, y))
+				right++;
+			fillSpan(ctx, left, right, y);
+			minLeft = MIN(minLeft, left); maxRight = MAX(maxRight, right);
+			minTop = MIN(minTop, y); maxBottom = MAX(maxBottom, y);
+			
+			// Push the start of each run above and below
+			for (int dy = -1; dy <= 1; dy += 2) {
+				if (y + dy < rect.origin.y || y + dy > rectBottom)
+					continue;
+				inRun = NO;
+				for (x = left; x <= right; x++) {
+					if (shouldFill(ctx, x, y + dy)) {
+						if (!inRun) {
+							if (stackPos == stackSize) {
+								stackSize += kStackSizeIncrement;
+								stack = realloc(stack, sizeof(IntPoint) * stackSize);
 							}
+							stack[stackPos++] = IntMakePoint(x, y + dy);
+							inRun = YES;
 						}
 					}
+					else {
+						inRun = NO;
+					}
 				}
-			} while (stackPos > -1);
-			
-			free(stack);
-			result = IntSumRects(result, IntMakeRect(minLeft, minTop, maxRight - minLeft + 1, maxBottom - minTop + 1));
+			}
+		}
+	}
+	
+	free(stack);
+	free(ctx->lower);
+	free(ctx->upper);
+	
+	if (minLeft > maxRight)
+		return IntMakeRect(0, 0, 0, 0);
+	
+	return IntMakeRect(minLeft, minTop, maxRight - minLeft + 1, maxBottom - minTop + 1);
+}
+
+IntRect SeaBucketFill(int spp, IntRect rect, unsigned char *overlay, unsigned char *data, int width, int height, IntPoint seeds[], int numSeeds, unsigned char *fillColor, int tolerance, int channel)
+{
+	FillContext ctx;
+	IntRect result;
+	
+#ifdef __OBJC__
+	if (!IntContainsRect(IntMakeRect(0, 0, width, height), rect)) NSLog(@"Bad rectangle passed to textureFill()");
+#endif
+	if (fillColor[spp - 1] == 0 || tolerance < 0)
+		return IntMakeRect(0, 0, 0, 0);
+	
+	// Everything in the rectangle is to be filled
+	if (tolerance >= 255) {
+		for (int j = rect.origin.y; j < rect.origin.y + rect.size.height; j++) {
+			for (int i = rect.origin.x; i < rect.origin.x + rect.size.width; i++) {
+				memcpy(&(overlay[(j * width + i) * spp]), fillColor, spp);
+			}
 		}
+		return rect;
 	}
 	
+	ctx.spp = spp; ctx.width = width; ctx.channel = channel;
+	ctx.rect = rect;
+	ctx.data = data;
+	ctx.overlay = overlay;
+	ctx.mask = NULL;
+	ctx.visited = calloc((rect.size.width * rect.size.height + 7) / 8, 1);
+	ctx.fillColor = fillColor;
+	result = scanlineFill(&ctx, seeds, numSeeds, tolerance);
+	free(ctx.visited);
+	
 	return result;
 }
 
+IntRect SeaBucketFillMask(int spp, IntRect rect, unsigned char *mask, unsigned char *data, int width, int height, IntPoint seeds[], int numSeeds, int tolerance, int channel)
+{
+	FillContext ctx;
+	
+#ifdef __OBJC__
+	if (!IntContainsRect(IntMakeRect(0, 0, width, height), rect)) NSLog(@"Bad rectangle passed to SeaBucketFillMask()");
+#endif
+	if (tolerance < 0)
+		return IntMakeRect(0, 0, 0, 0);
+	
+	// Everything in the rectangle is to be filled
+	if (tolerance >= 255) {
+		for (int j = rect.origin.y; j < rect.origin.y + rect.size.height; j++)
+			memset(&(mask[j * width + rect.origin.x]), 255, rect.size.width);
+		return rect;
+	}
+	
+	ctx.spp = spp; ctx.width = width; ctx.channel = channel;
+	ctx.rect = rect;
+	ctx.data = data;
+	ctx.overlay = NULL;
+	ctx.mask = mask;
+	ctx.visited = NULL;
+	ctx.fillColor = NULL;
+	
+	return scanlineFill(&ctx, seeds, numSeeds, tolerance);
+}
+
+static inline int colorDistance(unsigned char *pixel, unsigned char *color, int spp, int channel)
+{
+	int alphaDistance = abs((int)pixel[spp - 1] - (int)color[spp - 1]), distance = 0, k;
+	
+	switch (channel) {
+		case kAllChannels:
+			// Transparent pixels are as close as their alpha whatever their colour
+			if (pixel[spp - 1] == 0)
+				return alphaDistance;
+			distance = alphaDistance;
+			// Fall through to add the colour
+		case kPrimaryChannels:
+			for (k = 0; k < spp - 1; k++)
+				distance = MAX(distance, abs((int)pixel[k] - (int)color[k]));
+			return distance;
+		case kAlphaChannel:
+			return alphaDistance;
+	}
+	
+	return distance;
+}
+
+typedef struct {
+	int spp, width, channel, numColors;
+	IntRect rect;
+	unsigned char *data, *mask, *weight;
+	unsigned char (*colors)[4];
+	int *rowLeft, *rowRight;
+} MaskContext;
+
+static void maskRow(void *context, size_t row)
+{
+	MaskContext *ctx = context;
+	int y = ctx->rect.origin.y + (int)row, left = INT_MAX, right = INT_MIN, best, i, c;
+	unsigned char *pixel = &(ctx->data[(y * ctx->width + ctx->rect.origin.x) * ctx->spp]);
+	unsigned char *dest = &(ctx->mask[y * ctx->width + ctx->rect.origin.x]);
+	
+	for (i = 0; i < ctx->rect.size.width; i++, pixel += ctx->spp) {
+		best = 0;
+		for (c = 0; c < ctx->numColors && best < 255; c++)
+			best = MAX(best, ctx->weight[colorDistance(pixel, ctx->colors[c], ctx->spp, ctx->channel)]);
+		dest[i] = best;
+		if (best) {
+			left = MIN(left, i);
+			right = i;
+		}
+	}
+	ctx->rowLeft[row] = left;
+	ctx->rowRight[row] = right;
+}
+
+IntRect SeaColorMask(int spp, IntRect rect, unsigned char *mask, unsigned char *data, int width, int height, IntPoint seeds[], int numSeeds, int tolerance, int softness, int channel)
+{
+	unsigned char weights[256], (*colors)[4];
+	int *rowLeft, *rowRight, numColors = 0, seedIndex, c, d, j;
+	int minLeft = INT_MAX, maxRight = INT_MIN, minTop = INT_MAX, maxBottom = INT_MIN;
+	
+#ifdef __OBJC__
+	if (!IntContainsRect(IntMakeRect(0, 0, width, height), rect)) NSLog(@"Bad rectangle passed to SeaColorMask()");
+#endif
+	if (tolerance < 0 || rect.size.width <= 0 || rect.size.height <= 0)
+		return IntMakeRect(0, 0, 0, 0);
+	
+	// Full strength within the tolerance then fading out linearly over the softness
+	softness = MAX(softness, 0);
+	for (d = 0; d < 256; d++) {
+		if (d <= tolerance)
+			weights[d] = 255;
+		else if (d < tolerance + softness)
+			weights[d] = 255 * (tolerance + softness - d) / softness;
+		else
+			weights[d] = 0;
+	}
+	
+	// Collect the distinct colours to match
+	colors = malloc(numSeeds * sizeof(*colors));
+	for (seedIndex = 0; seedIndex < numSeeds; seedIndex++) {
+		if (!IntPointInRect(seeds[seedIndex], IntMakeRect(0, 0, width, height)))
+			continue;
+		unsigned char *seedPixel = &(data[(seeds[seedIndex].y * width + seeds[seedIndex].x) * spp]);
+		for (c = 0; c < numColors && memcmp(colors[c], seedPixel, spp); c++);
+		if (c == numColors)
+			memcpy(colors[numColors++], seedPixel, spp);
+	}
+	
+	// Each row is independent so they are worked through in parallel
+	rowLeft = malloc(rect.size.height * sizeof(int));
+	rowRight = malloc(rect.size.height * sizeof(int));
+	MaskContext ctx = { spp, width, channel, numColors, rect, data, mask, weights, colors, rowLeft, rowRight };
+	dispatch_apply_f(rect.size.height, dispatch_get_global_queue(0, 0), &ctx, maskRow);
+	
+	for (j = 0; j < rect.size.height; j++) {
+		if (rowLeft[j] <= rowRight[j]) {
+			minLeft = MIN(minLeft, rowLeft[j]);
+			maxRight = MAX(maxRight, rowRight[j]);
+			minTop = MIN(minTop, j);
+			maxBottom = j;
+		}
+	}
+	free(rowLeft);
+	free(rowRight);
+	free(colors);
+	
+	if (minLeft > maxRight)
+		return IntMakeRect(0, 0, 0, 0);
+	
+	return IntMakeRect(rect.origin.x + minLeft, rect.origin.y + minTop, maxRight - minLeft + 1, maxBottom - minTop + 1);
+}
+
 void SeaTextureFill(int spp, IntRect rect, unsigned char *data, int width, int height, unsigned char *texture, int textureWidth, int textureHeight)
 {
 	for (int j = rect.origin.y; j < rect.size.height + rect.origin.y; j++) {
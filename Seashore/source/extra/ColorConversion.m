@@ -87,7 +87,8 @@ void SeaHSVtoRGB(int *hue, int *saturation, int *value)
 		double q = v * (1.0 - (s * f));
 		double t = v * (1.0 - (s * (1.0 - f)));
 
-		switch ((int)h) {
+		// A hue of 255 lies at the same point on the circle as zero
+		switch ((int)h % 6) {
 			case 0:
 				*hue = v * 255;
 				*saturation = t * 255;
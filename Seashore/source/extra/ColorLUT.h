@@ -0,0 +1,142 @@
+/*!
+	@header		ColorLUT
+	@abstract	Contains functions for converting colours through a sampled
+				three-dimensional lookup table.
+	@discussion	A colour transform is sampled once on a regular grid of RGB
+				values, after which pixels are converted by tetrahedral
+				interpolation between the eight surrounding samples. This is
+				much faster than calling ColorSync for each refresh and the
+				table may be shared between threads.
+				<br><br>
+				<b>License:</b> GNU General Public License<br>
+				<b>Copyright:</b> N/A
+*/
+
+#import <Cocoa/Cocoa.h>
+#ifdef SEASYSPLUGIN
+#import "Globals.h"
+#else
+#import <SeashoreKit/Globals.h>
+#endif
+
+__BEGIN_DECLS
+
+/*!
+	@defined	kColorLUTGridSize
+	@discussion	The number of samples taken along each axis of the table.
+*/
+#define kColorLUTGridSize 33
+
+/*!
+	@defined	kColorLUTMaxOutputs
+	@discussion	The greatest number of channels a table may produce.
+*/
+#define kColorLUTMaxOutputs 4
+
+/*!
+	@typedef	SeaColorLUTRef
+	@discussion	An opaque reference to a sampled colour transform.
+*/
+typedef struct SeaColorLUT *SeaColorLUTRef;
+
+/*!
+	@typedef	SeaColorLUTFunction
+	@discussion	A function that converts an RGB colour, used to fill a table.
+	@param		rgb
+				The red, green and blue components of the colour, each between
+				0.0 and 1.0.
+	@param		output
+				The converted colour's components, each between 0.0 and 1.0.
+	@param		info
+				The pointer given when the table was created.
+*/
+typedef void (*SeaColorLUTFunction)(const float *rgb, float *output, void *info);
+
+/*!
+	@function	SeaColorLUTCreateWithFunction
+	@discussion	Creates a table by sampling a function.
+	@param		outputs
+				The number of channels the function produces (at most
+				kColorLUTMaxOutputs).
+	@param		function
+				The function to sample.
+	@param		info
+				A pointer passed on to the function.
+	@result		Returns the new table which should be released with
+				SeaColorLUTRelease, or NULL if it could not be created.
+*/
+SeaColorLUTRef SeaColorLUTCreateWithFunction(int outputs, SeaColorLUTFunction function, void *info);
+
+/*!
+	@function	SeaColorLUTCreateWithTransform
+	@discussion	Creates a table by sampling a ColorSync transform from RGB.
+	@param		transform
+				The transform to sample.
+	@param		outputs
+				The number of channels the transform produces (at most
+				kColorLUTMaxOutputs).
+	@result		Returns the new table which should be released with
+				SeaColorLUTRelease, or NULL if it could not be created.
+*/
+SeaColorLUTRef SeaColorLUTCreateWithTransform(ColorSyncTransformRef transform, int outputs);
+
+/*!
+	@function	SeaColorLUTCreateWithSamples
+	@discussion	Creates a table from samples already taken at the points given
+				by SeaColorLUTGetGrid.
+	@param		outputs
+				The number of channels in each sample (at most
+				kColorLUTMaxOutputs).
+	@param		samples
+				The samples, each between 0.0 and 1.0, in the order of the
+				grid's points.
+	@result		Returns the new table which should be released with
+				SeaColorLUTRelease, or NULL if it could not be created.
+*/
+SeaColorLUTRef SeaColorLUTCreateWithSamples(int outputs, const float *samples);
+
+/*!
+	@function	SeaColorLUTGetGrid
+	@discussion	Fills in the RGB colours at which a table is sampled, red
+				varying slowest and blue fastest.
+	@param		rgb
+				The block of memory in which to place the colours, which must
+				have room for three floats for each of the kColorLUTGridSize
+				cubed points.
+*/
+void SeaColorLUTGetGrid(float *rgb);
+
+/*!
+	@function	SeaColorLUTRelease
+	@discussion	Frees a table.
+	@param		lut
+				The table to free (may be NULL).
+*/
+void SeaColorLUTRelease(SeaColorLUTRef lut);
+
+/*!
+	@function	SeaColorLUTOutputs
+	@param		lut
+				The table.
+	@result		Returns the number of channels produced by the table.
+*/
+int SeaColorLUTOutputs(SeaColorLUTRef lut);
+
+/*!
+	@function	SeaColorLUTApply
+	@discussion	Converts a run of RGB pixels through the table. This function
+				is safe to call from several threads at once.
+	@param		lut
+				The table to use.
+	@param		output
+				The block of memory in which to place the converted pixels, each
+				with as many samples as the table produces.
+	@param		input
+				The block of memory containing the RGB pixels, three samples
+				each.
+	@param		length
+				The number of pixels to convert.
+*/
+void SeaColorLUTApply(SeaColorLUTRef lut, unsigned char *output, unsigned char *input, NSInteger length);
+
+__END_DECLS
@@ -0,0 +1,210 @@
+#import "ColorLUT.h"
+
+#define kGridLast (kColorLUTGridSize - 1)
+
+struct SeaColorLUT {
+	// The number of channels produced
+	int outputs;
+
+	// The samples as 16-bit values, blue varying fastest
+	unsigned short *table;
+
+	// The distance in the table between neighbouring red, green and blue samples
+	int redStride, greenStride, blueStride;
+};
+
+// For each 8-bit value the grid cell containing it and the position within it (out of 256)
+static unsigned char cellOf[256];
+static unsigned short fractionOf[256];
+
+static void buildCellTables(void)
+{
+	static dispatch_once_t once;
+
+	dispatch_once(&once, ^{
+		for (int value = 0; value < 256; value++) {
+			int position = value * kGridLast * 256 / 255;
+			int cell = MIN(position >> 8, kGridLast - 1);
+			cellOf[value] = cell;
+			fractionOf[value] = position - cell * 256;
+		}
+	});
+}
+
+static SeaColorLUTRef allocLUT(int outputs)
+{
+	SeaColorLUTRef lut;
+
+	if (outputs < 1 || outputs > kColorLUTMaxOutputs)
+		return NULL;
+	buildCellTables();
+	lut = malloc(sizeof(struct SeaColorLUT));
+	lut->outputs = outputs;
+	lut->table = malloc(kColorLUTGridSize * kColorLUTGridSize * kColorLUTGridSize * outputs * sizeof(unsigned short));
+	lut->blueStride = outputs;
+	lut->greenStride = kColorLUTGridSize * lut->blueStride;
+	lut->redStride = kColorLUTGridSize * lut->greenStride;
+
+	return lut;
+}
+
+static inline unsigned short sampleOf(float value)
+{
+	return (unsigned short)(MAX(0.0f, MIN(value, 1.0f)) * 65535.0f + 0.5f);
+}
+
+SeaColorLUTRef SeaColorLUTCreateWithFunction(int outputs, SeaColorLUTFunction function, void *info)
+{
+	SeaColorLUTRef lut = allocLUT(outputs);
+	float rgb[3], output[kColorLUTMaxOutputs];
+	unsigned short *entry;
+
+	if (!lut)
+		return NULL;
+	entry = lut->table;
+	for (int r = 0; r < kColorLUTGridSize; r++) {
+		for (int g = 0; g < kColorLUTGridSize; g++) {
+			for (int b = 0; b < kColorLUTGridSize; b++) {
+				rgb[0] = (float)r / kGridLast;
+				rgb[1] = (float)g / kGridLast;
+				rgb[2] = (float)b / kGridLast;
+				function(rgb, output, info);
+				for (int k = 0; k < outputs; k++)
+					*entry++ = sampleOf(output[k]);
+			}
+		}
+	}
+
+	return lut;
+}
+
+SeaColorLUTRef SeaColorLUTCreateWithSamples(int outputs, const float *samples)
+{
+	SeaColorLUTRef lut = allocLUT(outputs);
+	int count = kColorLUTGridSize * kColorLUTGridSize * kColorLUTGridSize;
+
+	if (!lut)
+		return NULL;
+	for (int i = 0; i < count * outputs; i++)
+		lut->table[i] = sampleOf(samples[i]);
+
+	return lut;
+}
+
+void SeaColorLUTGetGrid(float *rgb)
+{
+	for (int r = 0; r < kColorLUTGridSize; r++) {
+		for (int g = 0; g < kColorLUTGridSize; g++) {
+			for (int b = 0; b < kColorLUTGridSize; b++, rgb += 3) {
+				rgb[0] = (float)r / kGridLast;
+				rgb[1] = (float)g / kGridLast;
+				rgb[2] = (float)b / kGridLast;
+			}
+		}
+	}
+}
+
+SeaColorLUTRef SeaColorLUTCreateWithTransform(ColorSyncTransformRef transform, int outputs)
+{
+	SeaColorLUTRef lut;
+	int count = kColorLUTGridSize * kColorLUTGridSize * kColorLUTGridSize;
+	float *grid, *converted;
+
+	if (!transform || outputs < 1 || outputs > kColorLUTMaxOutputs)
+		return NULL;
+
+	// Convert the whole grid in one call
+	grid = malloc(count * 3 * sizeof(float));
+	converted = malloc(count * outputs * sizeof(float));
+	SeaColorLUTGetGrid(grid);
+	if (ColorSyncTransformConvert(transform, count, 1, converted, kColorSync32BitFloat, kColorSyncAlphaNone | kColorSyncByteOrderDefault, count * outputs * sizeof(float), grid, kColorSync32BitFloat, kColorSyncAlphaNone | kColorSyncByteOrderDefault, count * 3 * sizeof(float), NULL))
+		lut = SeaColorLUTCreateWithSamples(outputs, converted);
+	else
+		lut = NULL;
+	free(grid);
+	free(converted);
+
+	return lut;
+}
+
+void SeaColorLUTRelease(SeaColorLUTRef lut)
+{
+	if (lut) {
+		free(lut->table);
+		free(lut);
+	}
+}
+
+int SeaColorLUTOutputs(SeaColorLUTRef lut)
+{
+	return lut->outputs;
+}
+
+static inline void applyLUT(const int outputs, SeaColorLUTRef lut, unsigned char *output, unsigned char *input, NSInteger length)
+{
+	int redStride = lut->redStride, greenStride = lut->greenStride, blueStride = lut->blueStride;
+	int fr, fg, fb, first, second, third, k;
+	unsigned short *c000, *c1, *c2, *c111;
+	unsigned int value;
+
+	for (NSInteger i = 0; i < length; i++, input += 3, output += outputs) {
+		fr = fractionOf[input[0]];
+		fg = fractionOf[input[1]];
+		fb = fractionOf[input[2]];
+		c000 = lut->table + cellOf[input[0]] * redStride + cellOf[input[1]] * greenStride + cellOf[input[2]] * blueStride;
+		c111 = c000 + redStride + greenStride + blueStride;
+
+		// Pick the tetrahedron containing the point, walking from c000 to c111
+		// along the axes in order of decreasing fraction
+		if (fr >= fg) {
+			if (fg >= fb) {
+				c1 = c000 + redStride; c2 = c1 + greenStride;
+				first = fr; second = fg; third = fb;
+			}
+			else if (fr >= fb) {
+				c1 = c000 + redStride; c2 = c1 + blueStride;
+				first = fr; second = fb; third = fg;
+			}
+			else {
+				c1 = c000 + blueStride; c2 = c1 + redStride;
+				first = fb; second = fr; third = fg;
+			}
+		}
+		else {
+			if (fr >= fb) {
+				c1 = c000 + greenStride; c2 = c1 + redStride;
+				first = fg; second = fr; third = fb;
+			}
+			else if (fg >= fb) {
+				c1 = c000 + greenStride; c2 = c1 + blueStride;
+				first = fg; second = fb; third = fr;
+			}
+			else {
+				c1 = c000 + blueStride; c2 = c1 + greenStride;
+				first = fb; second = fg; third = fr;
+			}
+		}
+
+		// Blend the four corners then scale the 16-bit result down to 8 bits
+		for (k = 0; k < outputs; k++) {
+			value = (256 - first) * c000[k] + (first - second) * c1[k] + (second - third) * c2[k] + third * c111[k];
+			output[k] = (value / 256 * 255 + 32767) / 65535;
+		}
+	}
+}
+
+void SeaColorLUTApply(SeaColorLUTRef lut, unsigned char *output, unsigned char *input, NSInteger length)
+{
+	// Give the compiler a constant channel count for the usual cases
+	switch (lut->outputs) {
+		case 3:
+			applyLUT(3, lut, output, input, length);
+		break;
+		case 4:
+			applyLUT(4, lut, output, input, length);
+		break;
+		default:
+			applyLUT(lut->outputs, lut, output, input, length);
+		break;
+	}
+}
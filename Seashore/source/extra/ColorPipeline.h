@@ -0,0 +1,123 @@
+#import <Cocoa/Cocoa.h>
+#ifdef SEASYSPLUGIN
+#import "Globals.h"
+#import "ColorLUT.h"
+#else
+#import <SeashoreKit/Globals.h>
+#import <SeashoreKit/ColorLUT.h>
+#endif
+
+/*!
+	@typedef	SeaColorCurve
+	@discussion	A block that adjusts one sample, used for a curve applied to
+				each colour channel alike.
+	@param		value
+				The sample (from 0 to 255).
+	@result		Returns the adjusted sample, which is clamped to between 0 and
+				255.
+*/
+typedef int (^SeaColorCurve)(int value);
+
+/*!
+	@typedef	SeaColorFunction
+	@discussion	A block that converts an RGB colour.
+	@param		rgb
+				The red, green and blue components of the colour, each between
+				0.0 and 1.0.
+	@param		output
+				The converted red, green and blue components, which are clamped
+				to between 0.0 and 1.0.
+*/
+typedef void (^SeaColorFunction)(const float *rgb, float *output);
+
+/*!
+	@class		SeaColorPipeline
+	@abstract	A chain of point adjustments applied to pixels in a single pass.
+	@discussion	Adjustments are added in the order they are to be applied then
+				the whole chain is compiled into at most three lookups. The
+				curves before the first colour mixing adjustment are merged
+				into one table, as are the curves after the last. Everything in
+				between is either a single matrix, which is applied directly, or
+				is sampled into one three-dimensional table (see ColorLUT). A
+				chain of curves alone becomes a single table, which is also
+				used for greyscale images and the alpha channel.
+				<br><br>
+				Once compiled, a pipeline may be applied from several threads at
+				once and kept to apply again, so a preview and the final
+				application share the same tables.
+				<br><br>
+				<b>License:</b> GNU General Public License<br>
+				<b>Copyright:</b> N/A
+*/
+@interface SeaColorPipeline : NSObject
+
+/*!
+	@method		addCurve:
+	@discussion	Adds a curve applied to each colour channel alike. The curve is
+				sampled immediately.
+	@param		curve
+				The curve to add.
+*/
+- (void)addCurve:(SeaColorCurve)curve;
+
+/*!
+	@method		addMatrix:
+	@discussion	Adds a linear mix of the colour channels.
+	@param		matrix
+				Twelve values, each row of four giving the red, green and blue
+				weights and an offset for one output channel (all in units
+				where 1.0 is the full range of a sample).
+*/
+- (void)addMatrix:(const float *)matrix;
+
+/*!
+	@method		addFunction:
+	@discussion	Adds an arbitrary conversion of RGB colours. The function is
+				only called while the pipeline is compiled.
+	@param		function
+				The function to add.
+*/
+- (void)addFunction:(SeaColorFunction)function;
+
+/*!
+	@method		addTransform:
+	@discussion	Adds a ColorSync transform from RGB to RGB. The transform is
+				retained until the pipeline is freed, a NULL transform is
+				ignored.
+	@param		transform
+				The transform to add.
+*/
+- (void)addTransform:(ColorSyncTransformRef)transform;
+
+/*!
+	@method		compileForSpp:
+	@discussion	Builds the tables needed to apply the pipeline to pixels with
+				the given samples per pixel, doing nothing if they have already
+				been built. No more adjustments may be added afterwards.
+	@param		spp
+				The samples per pixel of the pixels to be adjusted.
+*/
+- (void)compileForSpp:(int)spp;
+
+/*!
+	@method		applyToData:fromData:length:spp:channel:
+	@discussion	Adjusts a run of pixels. The pipeline must have been compiled
+				for the given samples per pixel. This method is safe to call
+				from several threads at once.
+	@param		output
+				The block of memory in which to place the adjusted pixels.
+	@param		input
+				The block of memory containing the pixels to adjust.
+	@param		length
+				The number of pixels to adjust.
+	@param		spp
+				The samples per pixel of both blocks.
+	@param		channel
+				The selected channels. The alpha samples are copied when all
+				channels are selected and left alone when only the primary
+				channels are. When the alpha channel is selected the adjusted
+				alpha is placed in every colour sample instead.
+*/
+- (void)applyToData:(unsigned char *)output fromData:(unsigned char *)input length:(NSInteger)length spp:(int)spp channel:(SeaSelectedChannel)channel;
+
+@end
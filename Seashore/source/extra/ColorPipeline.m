@@ -0,0 +1,313 @@
+#import "ColorPipeline.h"
+
+// The number of pixels run through a three-dimensional table at a time
+#define kPipelineChunk 256
+
+// The fixed-point precision of a directly applied matrix
+#define kMatrixShift 12
+
+typedef NS_ENUM(int, SeaColorOpKind) {
+	SeaColorOpCurve,
+	SeaColorOpMatrix,
+	SeaColorOpFunction,
+	SeaColorOpTransform
+};
+
+typedef struct {
+	SeaColorOpKind kind;
+
+	// The sampled curve (for curves)
+	unsigned char curve[256];
+
+	// The rows of the mix (for matrices)
+	float matrix[12];
+
+	// The index of the function or transform in objects
+	NSUInteger object;
+} SeaColorOp;
+
+typedef NS_ENUM(int, SeaColorMiddle) {
+	SeaColorMiddleNone,
+	SeaColorMiddleMatrix,
+	SeaColorMiddleLUT
+};
+
+@implementation SeaColorPipeline {
+	// The adjustments in the order they are applied
+	SeaColorOp *ops;
+	int opCount;
+
+	// The functions and transforms the adjustments refer to
+	NSMutableArray *objects;
+
+	// Set once the tables for each kind of pixel have been built
+	BOOL greyCompiled, colourCompiled;
+
+	// The whole chain applied to equal red, green and blue samples
+	unsigned char grey[256];
+
+	// The curves applied before and after the middle of the chain
+	unsigned char before[256], after[256];
+
+	// How the middle of the chain is applied
+	SeaColorMiddle middle;
+	int fixedMatrix[12];
+	SeaColorLUTRef lut;
+}
+
+- (instancetype)init
+{
+	if (self = [super init]) {
+		objects = [NSMutableArray array];
+	}
+	return self;
+}
+
+- (void)dealloc
+{
+	free(ops);
+	SeaColorLUTRelease(lut);
+}
+
+- (SeaColorOp *)newOp:(SeaColorOpKind)kind
+{
+	NSAssert(!greyCompiled && !colourCompiled, @"adjustments added to a compiled pipeline");
+	ops = realloc(ops, (opCount + 1) * sizeof(SeaColorOp));
+	ops[opCount].kind = kind;
+	ops[opCount].object = [objects count];
+	return &ops[opCount++];
+}
+
+- (void)addCurve:(SeaColorCurve)curve
+{
+	SeaColorOp *op = [self newOp:SeaColorOpCurve];
+
+	for (int i = 0; i < 256; i++)
+		op->curve[i] = MAX(0, MIN(curve(i), 255));
+}
+
+- (void)addMatrix:(const float *)matrix
+{
+	SeaColorOp *op = [self newOp:SeaColorOpMatrix];
+
+	memcpy(op->matrix, matrix, sizeof(op->matrix));
+}
+
+- (void)addFunction:(SeaColorFunction)function
+{
+	[self newOp:SeaColorOpFunction];
+	[objects addObject:[function copy]];
+}
+
+- (void)addTransform:(ColorSyncTransformRef)transform
+{
+	if (!transform)
+		return;
+	[self newOp:SeaColorOpTransform];
+	[objects addObject:(__bridge id)transform];
+}
+
+static inline float clampUnit(float value)
+{
+	return MAX(0.0f, MIN(value, 1.0f));
+}
+
+// Looks up a curve at the nearest sample, as if its input were stored in 8 bits
+static inline float curveAt(const unsigned char *curve, float value)
+{
+	return curve[(int)(clampUnit(value) * 255.0f + 0.5f)] / 255.0f;
+}
+
+// Runs RGB points through part of the chain in floating point
+- (void)evaluateFrom:(int)first to:(int)last points:(float *)points count:(NSInteger)count
+{
+	float output[3], *converted;
+	NSInteger i;
+
+	for (int o = first; o <= last; o++) {
+		SeaColorOp *op = &ops[o];
+		switch (op->kind) {
+			case SeaColorOpCurve:
+				for (i = 0; i < count * 3; i++)
+					points[i] = curveAt(op->curve, points[i]);
+			break;
+			case SeaColorOpMatrix:
+				for (i = 0; i < count; i++) {
+					float *rgb = points + i * 3;
+					for (int k = 0; k < 3; k++)
+						output[k] = clampUnit(op->matrix[k * 4] * rgb[0] + op->matrix[k * 4 + 1] * rgb[1] + op->matrix[k * 4 + 2] * rgb[2] + op->matrix[k * 4 + 3]);
+					memcpy(rgb, output, sizeof(output));
+				}
+			break;
+			case SeaColorOpFunction: {
+				SeaColorFunction function = objects[op->object];
+				for (i = 0; i < count; i++) {
+					float *rgb = points + i * 3;
+					function(rgb, output);
+					for (int k = 0; k < 3; k++)
+						rgb[k] = clampUnit(output[k]);
+				}
+			}
+			break;
+			case SeaColorOpTransform: {
+				// Convert every point in one call, leaving them alone on failure
+				ColorSyncTransformRef transform = (__bridge ColorSyncTransformRef)objects[op->object];
+				converted = malloc(count * 3 * sizeof(float));
+				if (ColorSyncTransformConvert(transform, count, 1, converted, kColorSync32BitFloat, kColorSyncAlphaNone | kColorSyncByteOrderDefault, count * 3 * sizeof(float), points, kColorSync32BitFloat, kColorSyncAlphaNone | kColorSyncByteOrderDefault, count * 3 * sizeof(float), NULL)) {
+					for (i = 0; i < count * 3; i++)
+						points[i] = clampUnit(converted[i]);
+				}
+				free(converted);
+			}
+			break;
+		}
+	}
+}
+
+// Merges a run of curves into one table
+- (void)mergeCurvesFrom:(int)first to:(int)last into:(unsigned char *)curve
+{
+	for (int i = 0; i < 256; i++) {
+		int value = i;
+		for (int o = first; o <= last; o++)
+			value = ops[o].curve[value];
+		curve[i] = value;
+	}
+}
+
+- (void)compileGrey
+{
+	float points[256 * 3];
+
+	for (int i = 0; i < 256 * 3; i++)
+		points[i] = (i / 3) / 255.0f;
+	[self evaluateFrom:0 to:opCount - 1 points:points count:256];
+	for (int i = 0; i < 256; i++)
+		grey[i] = (unsigned char)(points[i * 3] * 255.0f + 0.5f);
+	greyCompiled = YES;
+}
+
+- (void)compileColour
+{
+	int first = 0, last = opCount - 1, count;
+	float *samples;
+
+	// Find the part of the chain that mixes channels
+	while (first < opCount && ops[first].kind == SeaColorOpCurve)
+		first++;
+	while (last >= first && ops[last].kind == SeaColorOpCurve)
+		last--;
+
+	[self mergeCurvesFrom:0 to:first - 1 into:before];
+	[self mergeCurvesFrom:last + 1 to:opCount - 1 into:after];
+	if (first > last) {
+		middle = SeaColorMiddleNone;
+	}
+	else if (first == last && ops[first].kind == SeaColorOpMatrix) {
+		// A lone matrix is cheaper to apply than to look up
+		middle = SeaColorMiddleMatrix;
+		for (int i = 0; i < 12; i++)
+			fixedMatrix[i] = (int)lroundf(ops[first].matrix[i] * ((i % 4 == 3) ? 255.0f : 1.0f) * (1 << kMatrixShift));
+	}
+	else {
+		count = kColorLUTGridSize * kColorLUTGridSize * kColorLUTGridSize;
+		samples = malloc(count * 3 * sizeof(float));
+		SeaColorLUTGetGrid(samples);
+		[self evaluateFrom:first to:last points:samples count:count];
+		lut = SeaColorLUTCreateWithSamples(3, samples);
+		free(samples);
+		middle = SeaColorMiddleLUT;
+	}
+	colourCompiled = YES;
+}
+
+- (void)compileForSpp:(int)spp
+{
+	@synchronized (self) {
+		if (!greyCompiled)
+			[self compileGrey];
+		if (spp == 4 && !colourCompiled)
+			[self compileColour];
+	}
+}
+
+static inline unsigned char applyRow(const int *row, int r, int g, int b)
+{
+	int value = row[0] * r + row[1] * g + row[2] * b + row[3] + (1 << (kMatrixShift - 1));
+
+	return (value <= 0) ? 0 : MIN(value >> kMatrixShift, 255);
+}
+
+- (void)applyColourTo:(unsigned char *)output from:(unsigned char *)input length:(NSInteger)length copyAlpha:(BOOL)copyAlpha
+{
+	unsigned char rgb[kPipelineChunk * 3], converted[kPipelineChunk * 3];
+	int r, g, b, chunk;
+	NSInteger i, done;
+
+	switch (middle) {
+		case SeaColorMiddleNone:
+			for (i = 0; i < length; i++, input += 4, output += 4) {
+				output[0] = before[input[0]];
+				output[1] = before[input[1]];
+				output[2] = before[input[2]];
+				if (copyAlpha)
+					output[3] = input[3];
+			}
+		break;
+		case SeaColorMiddleMatrix:
+			for (i = 0; i < length; i++, input += 4, output += 4) {
+				r = before[input[0]];
+				g = before[input[1]];
+				b = before[input[2]];
+				output[0] = after[applyRow(fixedMatrix, r, g, b)];
+				output[1] = after[applyRow(fixedMatrix + 4, r, g, b)];
+				output[2] = after[applyRow(fixedMatrix + 8, r, g, b)];
+				if (copyAlpha)
+					output[3] = input[3];
+			}
+		break;
+		case SeaColorMiddleLUT:
+			for (done = 0; done < length; done += chunk) {
+				chunk = (int)MIN(length - done, kPipelineChunk);
+				for (i = 0; i < chunk; i++) {
+					rgb[i * 3] = before[input[(done + i) * 4]];
+					rgb[i * 3 + 1] = before[input[(done + i) * 4 + 1]];
+					rgb[i * 3 + 2] = before[input[(done + i) * 4 + 2]];
+				}
+				SeaColorLUTApply(lut, converted, rgb, chunk);
+				for (i = 0; i < chunk; i++) {
+					output[(done + i) * 4] = after[converted[i * 3]];
+					output[(done + i) * 4 + 1] = after[converted[i * 3 + 1]];
+					output[(done + i) * 4 + 2] = after[converted[i * 3 + 2]];
+					if (copyAlpha)
+						output[(done + i) * 4 + 3] = input[(done + i) * 4 + 3];
+				}
+			}
+		break;
+	}
+}
+
+- (void)applyToData:(unsigned char *)output fromData:(unsigned char *)input length:(NSInteger)length spp:(int)spp channel:(SeaSelectedChannel)channel
+{
+	NSInteger i;
+	int k;
+
+	if (channel == kAlphaChannel) {
+		// Show the adjusted alpha in the colour samples
+		for (i = 0; i < length; i++)
+			memset(output + i * spp, grey[input[(i + 1) * spp - 1]], spp - 1);
+	}
+	else if (spp == 4) {
+		[self applyColourTo:output from:input length:length copyAlpha:channel == kAllChannels];
+	}
+	else {
+		for (i = 0; i < length; i++, input += spp, output += spp) {
+			for (k = 0; k < spp - 1; k++)
+				output[k] = grey[input[k]];
+			if (channel == kAllChannels)
+				output[spp - 1] = input[spp - 1];
+		}
+	}
+}
+
+@end
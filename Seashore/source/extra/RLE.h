@@ -37,6 +37,35 @@ __BEGIN_DECLS
 */
 BOOL SeaRLEDecompress(unsigned char *output, unsigned char *input, int inputLength, int width, int height, int spp);
 
+/*!
+	@function	SeaRLEDecompressRows
+	@discussion	Decompresses only the given rows of a tile compressed with RLE,
+				stepping over the items in other rows without expanding them.
+				This is used when only some rows are sampled, as for reduced
+				reads of large images.
+	@param		output
+				The block of memory in which to place the decompressed data,
+				should be at least width * height * spp bytes long. The rows
+				not asked for are left untouched.
+	@param		input
+				The block of memory containing the compressed tile.
+	@param		inputLength
+				The length of the input block of memory, this may or may not
+				exceed the length of the compressed data but prevents buffer
+				overflow.
+	@param		width
+				The width of the tile.
+	@param		height
+				The height of the tile.
+	@param		spp
+				The samples per pixel of the tile.
+	@param		rows
+				An array of height flags, a row is decompressed when its flag
+				is non-zero.
+	@result		Returns a YES upon success, NO otherwise.
+*/
+BOOL SeaRLEDecompressRows(unsigned char *output, unsigned char *input, int inputLength, int width, int height, int spp, const unsigned char *rows);
+
 /*!
 	@function	SeaRLECompress
 	@discussion	Compresses a given tile with RLE.
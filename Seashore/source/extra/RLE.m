@@ -1,265 +1,315 @@
 #import "RLE.h"
 
-BOOL SeaRLEDecompress(unsigned char *output, unsigned char *input, int inputLength, int width, int height, int spp)
+// Tiles up to this many bytes are worked on with planar scratch space on the stack
+#define kRLEStackScratch (64 * 64 * 4)
+
+// The longest run either kind of item may describe
+#define kRLEMaxRun 32768
+
+static const uint64_t kOnes = 0x0101010101010101ULL;
+static const uint64_t kHighs = 0x8080808080808080ULL;
+
+static inline uint64_t load64(const unsigned char *ptr)
 {
-	unsigned char *destData;
-	unsigned char *srcData = input;
-	unsigned char *srcDataLimit = input + inputLength;
-	unsigned char value;
-	unsigned short tmp_short;
-	int length;
-  	int destRemaining, i, j;
-
-	// Select sample to focus on
-	for (i = 0; i < spp; i++) {
-		
-		// Make note of the amount of work we've got to do
-		destRemaining = width * height;
-		
-		// Move into position for current sample
-		destData = output + i;
-		
-		// While we've still got work to do
-		while (destRemaining > 0) {
-		
-			if (srcData > srcDataLimit)
-				return NO;
-			
-			// Get the length
-			length = (int)srcData[0];
-			srcData += 1;
-			
-			// Two cases we either have unique items or repeated items...
-			if (length >= 128) {
-			
-				// UNIQUE ITEMS
-				
-				// Invert the length so it is between 1 and 128
-				length = 255 - (length - 1);
-				
-				// If the number is 128, we are being told that the next two bytes represent a short signifying length
-				if (length == 128) {
-					if (srcData >= srcDataLimit)
-						return NO;
-					tmp_short = ((unsigned short *)srcData)[0];
-					tmp_short = ntohs(tmp_short);
-					length = tmp_short;
-					srcData += 2;
-				}
-				
-				// Now take the length off our workload
-				destRemaining -= (int)length;
-				
-				if (destRemaining < 0)
-					return NO;
-				if (&srcData[length - 1] >= srcDataLimit)
-					return NO;
-				
-				// Now repeatedly copy for as long as necessary 
-				for (j = 0; j < length; j++) {
-					destData[0] = srcData[0];
-					srcData += 1;
-					destData += spp;
-				}
-				
+	uint64_t value;
+
+	memcpy(&value, ptr, sizeof(value));
+
+	return value;
+}
+
+// Whether any of the eight bytes is zero
+static inline BOOL hasZeroByte(uint64_t value)
+{
+	return ((value - kOnes) & ~value & kHighs) != 0;
+}
+
+static inline int readLength(const unsigned char *ptr)
+{
+	return (ptr[0] << 8) | ptr[1];
+}
+
+static inline void writeLength(unsigned char *ptr, int length)
+{
+	ptr[0] = (length >> 8) & 0xff;
+	ptr[1] = length & 0xff;
+}
+
+// Splits interleaved samples in to one plane for each sample
+static void deinterleave(unsigned char *planes, const unsigned char *input, int count, int spp)
+{
+	int i, k;
+
+	switch (spp) {
+		case 2:
+			for (i = 0; i < count; i++) {
+				planes[i] = input[i * 2];
+				planes[count + i] = input[i * 2 + 1];
 			}
-			else {
-				
-				// REPEATED ITEMS
-				
-				// Add 1 to the length so it is between 1 and 128
-				length += 1;
-				
-				// If the number is 128, we are being told that the next two bytes represent a short signifying length
-				if (length == 128) {
-					if (srcData >= srcDataLimit)
-						return NO;
-					tmp_short = ((unsigned short *)srcData)[0];
-					tmp_short = ntohs(tmp_short);
-					length = tmp_short;
-					srcData += 2;
-				}
-				
-				// Now take the length off our workload
-				destRemaining -= (int)length;
-				
-				if (destRemaining < 0)
-					return NO;
-				
-				// Store the value to be repeated
-				value = srcData[0];
-				srcData += 1;
-				
-				// Now repeatedly copy for as long as necessary 
-				for (j = 0; j < length; j++) {
-					destData[0] = value;
-					destData += spp;
-				}
-				
+		break;
+		case 4:
+			for (i = 0; i < count; i++) {
+				planes[i] = input[i * 4];
+				planes[count + i] = input[i * 4 + 1];
+				planes[count * 2 + i] = input[i * 4 + 2];
+				planes[count * 3 + i] = input[i * 4 + 3];
 			}
-			
+		break;
+		default:
+			for (k = 0; k < spp; k++)
+				for (i = 0; i < count; i++)
+					planes[count * k + i] = input[i * spp + k];
+		break;
+	}
+}
+
+// Joins one plane for each sample back in to interleaved samples, the planes
+// being stride bytes apart
+static void interleave(unsigned char *output, const unsigned char *planes, int count, int stride, int spp)
+{
+	int i, k;
+
+	switch (spp) {
+		case 2:
+			for (i = 0; i < count; i++) {
+				output[i * 2] = planes[i];
+				output[i * 2 + 1] = planes[stride + i];
+			}
+		break;
+		case 4:
+			for (i = 0; i < count; i++) {
+				output[i * 4] = planes[i];
+				output[i * 4 + 1] = planes[stride + i];
+				output[i * 4 + 2] = planes[stride * 2 + i];
+				output[i * 4 + 3] = planes[stride * 3 + i];
+			}
+		break;
+		default:
+			for (k = 0; k < spp; k++)
+				for (i = 0; i < count; i++)
+					output[i * spp + k] = planes[stride * k + i];
+		break;
+	}
+}
+
+// Reads the header of the next item, returning the first byte after it or NULL
+// on failure (unique items are followed by their bytes, repeated items by one)
+static inline const unsigned char *readItem(const unsigned char *srcData, const unsigned char *srcDataLimit, int remaining, int *length, BOOL *unique)
+{
+	if (srcData >= srcDataLimit)
+		return NULL;
+	*length = *srcData++;
+	*unique = (*length >= 128);
+
+	// A length of 128 is followed by the real length
+	*length = (*unique) ? 256 - *length : *length + 1;
+	if (*length == 128) {
+		if (srcDataLimit - srcData < 2)
+			return NULL;
+		*length = readLength(srcData);
+		srcData += 2;
+	}
+	if (*length > remaining || srcDataLimit - srcData < ((*unique) ? *length : 1))
+		return NULL;
+
+	return srcData;
+}
+
+// Decompresses a single plane, returning the first unused byte of input or NULL on failure
+static const unsigned char *decompressPlane(unsigned char *plane, int count, const unsigned char *srcData, const unsigned char *srcDataLimit)
+{
+	int length;
+	BOOL unique;
+
+	while (count > 0) {
+		srcData = readItem(srcData, srcDataLimit, count, &length, &unique);
+		if (!srcData)
+			return NULL;
+		if (unique) {
+			memcpy(plane, srcData, length);
+			srcData += length;
+		}
+		else {
+			memset(plane, *srcData++, length);
 		}
-		
-    }
+		plane += length;
+		count -= length;
+	}
 
-	return YES;
+	return srcData;
 }
 
+// Decompresses the given rows of a single plane, items elsewhere are only stepped over
+static const unsigned char *decompressPlaneRows(unsigned char *plane, int width, int height, const unsigned char *rows, const unsigned char *srcData, const unsigned char *srcDataLimit)
+{
+	int count = width * height, position = 0, length, row, start, end;
+	BOOL unique;
 
-int SeaRLECompress(unsigned char *output, unsigned char *input, int width, int height, int spp)
+	while (position < count) {
+		srcData = readItem(srcData, srcDataLimit, count - position, &length, &unique);
+		if (!srcData)
+			return NULL;
+		for (row = position / width; row * width < position + length; row++) {
+			if (!rows[row])
+				continue;
+			start = MAX(position, row * width);
+			end = MIN(position + length, (row + 1) * width);
+			if (unique)
+				memcpy(plane + start, srcData + (start - position), end - start);
+			else
+				memset(plane + start, *srcData, end - start);
+		}
+		srcData += (unique) ? length : 1;
+		position += length;
+	}
+
+	return srcData;
+}
+
+BOOL SeaRLEDecompress(unsigned char *output, unsigned char *input, int inputLength, int width, int height, int spp)
+{
+	unsigned char stackScratch[kRLEStackScratch], *planes;
+	const unsigned char *srcData = input, *srcDataLimit = input + inputLength;
+	int count = width * height, i;
+
+	// A single sample needs no interleaving
+	if (spp == 1)
+		return decompressPlane(output, count, srcData, srcDataLimit) != NULL;
+
+	planes = (count * spp <= kRLEStackScratch) ? stackScratch : malloc(count * spp);
+	for (i = 0; i < spp && srcData; i++)
+		srcData = decompressPlane(planes + count * i, count, srcData, srcDataLimit);
+	if (srcData)
+		interleave(output, planes, count, count, spp);
+	if (planes != stackScratch)
+		free(planes);
+
+	return srcData != NULL;
+}
+
+BOOL SeaRLEDecompressRows(unsigned char *output, unsigned char *input, int inputLength, int width, int height, int spp, const unsigned char *rows)
+{
+	unsigned char stackScratch[kRLEStackScratch], *planes;
+	const unsigned char *srcData = input, *srcDataLimit = input + inputLength;
+	int count = width * height, i, j;
+
+	// A single sample needs no interleaving
+	if (spp == 1)
+		return decompressPlaneRows(output, width, height, rows, srcData, srcDataLimit) != NULL;
+
+	planes = (count * spp <= kRLEStackScratch) ? stackScratch : malloc(count * spp);
+	for (i = 0; i < spp && srcData; i++)
+		srcData = decompressPlaneRows(planes + count * i, width, height, rows, srcData, srcDataLimit);
+	if (srcData) {
+		for (j = 0; j < height; j++) {
+			if (rows[j])
+				interleave(output + j * width * spp, planes + j * width, width, count, spp);
+		}
+	}
+	if (planes != stackScratch)
+		free(planes);
+
+	return srcData != NULL;
+}
+
+// The length of the run of bytes matching the first
+static inline int repeatLength(const unsigned char *plane, int remaining)
+{
+	uint64_t pattern = plane[0] * kOnes;
+	int length = 1, limit = MIN(remaining, kRLEMaxRun);
+
+	while (length + 8 <= limit && load64(plane + length) == pattern)
+		length += 8;
+	while (length < limit && plane[length] == plane[0])
+		length++;
+
+	return length;
+}
+
+// The length of the run of bytes up to the first that begins three of a kind
+static inline int uniqueLength(const unsigned char *plane, int remaining)
+{
+	int length = 1, limit = MIN(remaining, kRLEMaxRun);
+	uint64_t first, second, third;
+
+	while (length < limit) {
+		// Check eight positions at once while there are ten bytes to compare
+		if (length + 10 <= remaining && length + 8 <= limit) {
+			first = load64(plane + length);
+			second = load64(plane + length + 1);
+			third = load64(plane + length + 2);
+			if (!hasZeroByte((first ^ second) | (second ^ third))) {
+				length += 8;
+				continue;
+			}
+		}
+		if (remaining - length > 2 && plane[length] == plane[length + 1] && plane[length] == plane[length + 2])
+			break;
+		length++;
+	}
+
+	return length;
+}
+
+// Compresses a single plane, returning the number of bytes written
+static int compressPlane(unsigned char *destData, const unsigned char *plane, int count)
 {
-	int state, length, last, i, j;
-	int srcRemaining;
-	unsigned char *destData = output;
-	unsigned char *srcData;
-	int destLength = 0;
-	BOOL hold = NO;
-	unsigned short write_length;
-	unsigned short *destShortData;
-	
-	// Select sample to focus on
-	for (i = 0; i < spp; i++) {
-	
-		// Reset values
-		state = length = 0;
-		last = -1;
-		
-		// Make note of the amount of work we've got to do
-		srcRemaining = width * height;
-		
-		// Move into position for current sample
-		srcData = input + i;
-		
-		// While we've still got work to do
-		while (srcRemaining > 0) {
-			
-			switch (state) {
-				case 0:
-					
-					// REPEATED ITEMS
-					
-					// If we have the longest run possible, are out of data or have come to the end of our repeating run...
-					if (length == 32768 || srcRemaining - length <= 0 || (length > 1 && last != *srcData)) {
-						
-						// If we have a run of 128 or more...
-						if (length >= 128) {
-						
-							// Place a symbol to indicate a run of 128 or more
-							destData[destLength] = 127;
-							
-							// Write the actual run size as a short in the next two bytes
-							write_length = length;
-							write_length = htons(write_length);
-							destShortData = (unsigned short *)(destData + destLength + 1);
-							destShortData[0] = write_length;
-							
-							// Write the repeating item in the fourth byte
-							destData[destLength + 3] = last;
-							
-							// Move forward 4 bytes
-							destLength += 4;
-							
-						}
-						else {
-							
-							// Write the size of the run in the first byte (for the sake of neatness we typically count a run of 1 as a unique item)
-							if (length == 1)
-								destData[destLength] = 255 - (length - 1);
-							else
-								destData[destLength] = length - 1;
-							
-							// And the repeating item in the second
-							destData[destLength + 1] = last;
-						
-							// Move forward 2 bytes
-							destLength += 2;
-
-						}
-							
-						// Take the length of our workload
-						srcRemaining -= length;
-						
-						// Reset the length
-						length = 0;
-						
-					}
-					else {
-						
-						// If our run is only 1 item in length switch to the next state (don't advance)
-						if (length == 1 && (last != *srcData)) {
-							hold = YES;
-							state = 1;
-						}
-					
-					}
-				
-				break;
-				case 1:
-				
-					// UNIQUE ITEMS
-				
-					// Start advancing again
-					hold = NO;
-					
-					// If we have the longest run possible, are out of data or have a repeating item...
-					if (length == 32768 || srcRemaining - length <= 0 || (srcRemaining - length > 2 && *srcData == srcData[spp] && *srcData == srcData[spp * 2])) {
-					
-						// After we finish, go back to state 0
-						state = 0;
-						
-						// If we have a run of 128 or more...
-						if (length >= 128) {
-						
-							// Place a symbol to indicate a run of 128 or more
-							destData[destLength] = 255 - 127;
-							
-							// Write the actual run size as a short in the next two bytes
-							write_length = length;
-							write_length = htons(write_length);
-							destShortData = (unsigned short *)(destData + destLength + 1);
-							destShortData[0] = write_length;
-							
-							// Move forward 3 bytes
-							destLength += 3;
-
-						}
-						else {
-						
-							// Write the size of the run in the first byte
-							destData[destLength] = 255 - (length - 1);
-							
-							// Move forward 1 byte
-							destLength += 1;
-
-						}
-
-						// Write each of the non-matching bytes
-						srcData = srcData - length * spp;
-						for (j = 0; j < length; j++) {
-							destData[destLength] = *srcData;
-							destLength += 1;
-							srcData += spp;
-						}
-
-						// Take the length of our workload
-						srcRemaining -= length;
-						
-						// Reset the length
-						length = 0;
-					}
-				
-				break;
+	int destLength = 0, length, i = 0;
+
+	while (i < count) {
+		length = repeatLength(plane + i, count - i);
+
+		if (length > 1 || i + 1 == count) {
+			// REPEATED ITEMS (a lone final item is written as a unique item of one)
+			if (length >= 128) {
+				destData[destLength] = 127;
+				writeLength(destData + destLength + 1, length);
+				destData[destLength + 3] = plane[i];
+				destLength += 4;
+			}
+			else {
+				destData[destLength] = (length == 1) ? 255 : length - 1;
+				destData[destLength + 1] = plane[i];
+				destLength += 2;
+			}
+		}
+		else {
+			// UNIQUE ITEMS
+			length = uniqueLength(plane + i, count - i);
+			if (length >= 128) {
+				destData[destLength] = 255 - 127;
+				writeLength(destData + destLength + 1, length);
+				destLength += 3;
 			}
-			
-			// If there is still data remaining, remember the last piece and move to the next  
-			if (srcRemaining > 0 && !hold) {
-				last = *srcData;
-				length++;
-				srcData += spp;
+			else {
+				destData[destLength] = 255 - (length - 1);
+				destLength += 1;
 			}
+			memcpy(destData + destLength, plane + i, length);
+			destLength += length;
 		}
-	
+
+		i += length;
 	}
-	
+
+	return destLength;
+}
+
+int SeaRLECompress(unsigned char *output, unsigned char *input, int width, int height, int spp)
+{
+	unsigned char stackScratch[kRLEStackScratch], *planes;
+	int count = width * height, destLength = 0, i;
+
+	// A single sample needs no deinterleaving
+	if (spp == 1)
+		return compressPlane(output, input, count);
+
+	planes = (count * spp <= kRLEStackScratch) ? stackScratch : malloc(count * spp);
+	deinterleave(planes, input, count, spp);
+	for (i = 0; i < spp; i++)
+		destLength += compressPlane(output + destLength, planes + count * i, count);
+	if (planes != stackScratch)
+		free(planes);
+
 	return destLength;
 }
@@ -26,11 +26,29 @@ __BEGIN_DECLS
 #define RANDOM_SEED      314159265
 
 /*!
-	@defined	RANDOM_TABLE_SIZE
-	@discussion	The size of the table to be used with the dissolve merge
-				technique.
+	@function	SeaDissolveNoise
+	@discussion	Returns the noise used by the dissolve merge technique at a
+				given point. The value depends only on its arguments so pixels
+				may be merged in any order and on any thread.
+	@param		seed
+				The seed for the noise, usually RANDOM_SEED.
+	@param		x
+				The x co-ordinate of the pixel in the document.
+	@param		y
+				The y co-ordinate of the pixel in the document.
+	@result		Returns a value between 0 and 255 inclusive.
 */
-#define RANDOM_TABLE_SIZE  4096
+static inline unsigned char SeaDissolveNoise(unsigned int seed, int x, int y)
+{
+	// A PCG style mix of the co-ordinates, see https://www.pcg-random.org
+	uint32_t state = seed ^ ((uint32_t)x * 0x9E3779B1u) ^ ((uint32_t)y * 0x85EBCA77u);
+	
+	state = state * 747796405u + 2891336453u;
+	state = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+	state = (state >> 22u) ^ state;
+	
+	return state & 0xff;
+}
 
 /*!
 	@function	SeaReplaceMerge
@@ -222,13 +240,6 @@ extern void SeaBlendPixel(int spp, unsigned char *destPtr, int destLoc, unsigned
 	@function	SeaSelectMerge
 	@discussion	Given two pixels in two bitmaps composites the source pixel on
 				to the destination pixel using the selected merge technique.
-				Note for \c XCF_DISSOLVE_MODE you must call 
-	\code 
-	srandom(randomTable[y % RANDOM_TABLE_SIZE]);
-	for (k = 0; k < x; k++) 
-		random();\endcode
-				for the merge to
-				work correctly.
 	@param		choice
 				The selected merge technique (see Constants documentation).
 	@param		spp
@@ -243,7 +254,193 @@ extern void SeaBlendPixel(int spp, unsigned char *destPtr, int destLoc, unsigned
 				composited.
 	@param		srcLoc
 				The position in that block of the pixel.
+	@param		x
+				The x co-ordinate of the pixel in the document, which seeds
+				\c XCF_DISSOLVE_MODE.
+	@param		y
+				The y co-ordinate of the pixel in the document.
 */
-extern void SeaSelectMerge(XcfLayerMode choice, int spp, unsigned char *destPtr, int destLoc, unsigned char *srcPtr, int srcLoc);
+extern void SeaSelectMerge(XcfLayerMode choice, int spp, unsigned char *destPtr, int destLoc, unsigned char *srcPtr, int srcLoc, int x, int y);
+
+/*!
+	@function	SeaReplaceMerge16
+	@discussion	The 16-bit counterpart of SeaReplaceMerge. The 8-bit
+				functions remain the fast path for ordinary documents.
+	@param		spp
+				The samples per pixel of the bitmaps (can be 2 or 4).
+	@param		destPtr
+				The block of 16-bit samples containing the destination pixel.
+	@param		destLoc
+				The position in that block of the pixel, in samples.
+	@param		srcPtr
+				The block of 16-bit samples containing the source pixel.
+	@param		srcLoc
+				The position in that block of the pixel, in samples.
+	@param		srcOpacity
+				The opacity with which the source pixel should be merged
+				(between 0 and 255 inclusive).
+*/
+extern void SeaReplaceMerge16(int spp, uint16_t *destPtr, int destLoc, uint16_t *srcPtr, int srcLoc, int srcOpacity);
+
+/*!
+	@function	SeaReplacePrimaryMerge16
+	@discussion	The 16-bit counterpart of SeaReplacePrimaryMerge.
+	@param		spp
+				The samples per pixel of the bitmaps (can be 2 or 4).
+	@param		destPtr
+				The block of 16-bit samples containing the destination pixel.
+	@param		destLoc
+				The position in that block of the pixel, in samples.
+	@param		srcPtr
+				The block of 16-bit samples containing the source pixel.
+	@param		srcLoc
+				The position in that block of the pixel, in samples.
+	@param		srcOpacity
+				The opacity with which the source pixel should be merged
+				(between 0 and 255 inclusive).
+*/
+extern void SeaReplacePrimaryMerge16(int spp, uint16_t *destPtr, int destLoc, uint16_t *srcPtr, int srcLoc, int srcOpacity);
+
+/*!
+	@function	SeaReplaceAlphaMerge16
+	@discussion	The 16-bit counterpart of SeaReplaceAlphaMerge.
+	@param		spp
+				The samples per pixel of the bitmaps (can be 2 or 4).
+	@param		destPtr
+				The block of 16-bit samples containing the destination pixel.
+	@param		destLoc
+				The position in that block of the pixel, in samples.
+	@param		srcPtr
+				The block of 16-bit samples containing the source pixel.
+	@param		srcLoc
+				The position in that block of the pixel, in samples.
+	@param		srcOpacity
+				The opacity with which the source pixel should be merged
+				(between 0 and 255 inclusive).
+*/
+extern void SeaReplaceAlphaMerge16(int spp, uint16_t *destPtr, int destLoc, uint16_t *srcPtr, int srcLoc, int srcOpacity);
+
+/*!
+	@function	SeaSpecialMerge16
+	@discussion	The 16-bit counterpart of SeaSpecialMerge.
+	@param		spp
+				The samples per pixel of the bitmaps (can be 2 or 4).
+	@param		destPtr
+				The block of 16-bit samples containing the destination pixel.
+	@param		destLoc
+				The position in that block of the pixel, in samples.
+	@param		srcPtr
+				The block of 16-bit samples containing the source pixel.
+	@param		srcLoc
+				The position in that block of the pixel, in samples.
+	@param		srcOpacity
+				The opacity with which the source pixel should be merged
+				(between 0 and 255 inclusive).
+*/
+extern void SeaSpecialMerge16(int spp, uint16_t *destPtr, int destLoc, uint16_t *srcPtr, int srcLoc, int srcOpacity);
+
+/*!
+	@function	SeaNormalMerge16
+	@discussion	The 16-bit counterpart of SeaNormalMerge.
+	@param		spp
+				The samples per pixel of the bitmaps (can be 2 or 4).
+	@param		destPtr
+				The block of 16-bit samples containing the destination pixel.
+	@param		destLoc
+				The position in that block of the pixel, in samples.
+	@param		srcPtr
+				The block of 16-bit samples containing the source pixel.
+	@param		srcLoc
+				The position in that block of the pixel, in samples.
+	@param		srcOpacity
+				The opacity with which the source pixel should be merged
+				(between 0 and 255 inclusive).
+*/
+extern void SeaNormalMerge16(int spp, uint16_t *destPtr, int destLoc, uint16_t *srcPtr, int srcLoc, int srcOpacity);
+
+/*!
+	@function	SeaEraseMerge16
+	@discussion	The 16-bit counterpart of SeaEraseMerge.
+	@param		spp
+				The samples per pixel of the bitmaps (can be 2 or 4).
+	@param		destPtr
+				The block of 16-bit samples containing the destination pixel.
+	@param		destLoc
+				The position in that block of the pixel, in samples.
+	@param		srcPtr
+				The block of 16-bit samples containing the source pixel.
+	@param		srcLoc
+				The position in that block of the pixel, in samples.
+	@param		srcOpacity
+				The opacity with which the source pixel should be merged
+				(between 0 and 255 inclusive).
+*/
+extern void SeaEraseMerge16(int spp, uint16_t *destPtr, int destLoc, uint16_t *srcPtr, int srcLoc, int srcOpacity);
+
+/*!
+	@function	SeaPrimaryMerge16
+	@discussion	The 16-bit counterpart of SeaPrimaryMerge.
+	@param		spp
+				The samples per pixel of the bitmaps (can be 2 or 4).
+	@param		destPtr
+				The block of 16-bit samples containing the destination pixel.
+	@param		destLoc
+				The position in that block of the pixel, in samples.
+	@param		srcPtr
+				The block of 16-bit samples containing the source pixel.
+	@param		srcLoc
+				The position in that block of the pixel, in samples.
+	@param		srcOpacity
+				The opacity with which the source pixel should be merged
+				(between 0 and 255 inclusive).
+	@param		lazy
+				YES if merges to destination pixel whose alpha is zero should be
+				skipped, NO otherwise.
+*/
+extern void SeaPrimaryMerge16(int spp, uint16_t *destPtr, int destLoc, uint16_t *srcPtr, int srcLoc, int srcOpacity, BOOL lazy);
+
+/*!
+	@function	SeaAlphaMerge16
+	@discussion	The 16-bit counterpart of SeaAlphaMerge.
+	@param		spp
+				The samples per pixel of the bitmaps (can be 2 or 4).
+	@param		destPtr
+				The block of 16-bit samples containing the destination pixel.
+	@param		destLoc
+				The position in that block of the pixel, in samples.
+	@param		srcPtr
+				The block of 16-bit samples containing the source pixel.
+	@param		srcLoc
+				The position in that block of the pixel, in samples.
+	@param		srcOpacity
+				The opacity with which the source pixel should be merged
+				(between 0 and 255 inclusive).
+*/
+extern void SeaAlphaMerge16(int spp, uint16_t *destPtr, int destLoc, uint16_t *srcPtr, int srcLoc, int srcOpacity);
+
+/*!
+	@function	SeaSelectMerge16
+	@discussion	The 16-bit counterpart of SeaSelectMerge. Every mode works at
+				the full precision of the samples, the hue, saturation, value
+				and colour modes converting through floating point.
+	@param		choice
+				The selected merge technique (see Constants documentation).
+	@param		spp
+				The samples per pixel of the bitmaps (can be 2 or 4).
+	@param		destPtr
+				The block of 16-bit samples containing the destination pixel.
+	@param		destLoc
+				The position in that block of the pixel, in samples.
+	@param		srcPtr
+				The block of 16-bit samples containing the source pixel.
+	@param		srcLoc
+				The position in that block of the pixel, in samples.
+	@param		x
+				The x co-ordinate of the pixel in the document, which seeds
+				\c XCF_DISSOLVE_MODE.
+	@param		y
+				The y co-ordinate of the pixel in the document.
+*/
+extern void SeaSelectMerge16(XcfLayerMode choice, int spp, uint16_t *destPtr, int destLoc, uint16_t *srcPtr, int srcLoc, int x, int y);
 
 __END_DECLS
@@ -1,5 +1,6 @@
 #import "StandardMerge.h"
 #import "ColorConversion.h"
+#include <math.h>
 
 #define alphaPos (spp - 1)
 
@@ -157,7 +158,7 @@ void SeaBlendPixel(int spp, unsigned char *destPtr, int destLoc, unsigned char *
 	}
 }
 
-static void dissolveMerge(int spp, unsigned char *destPtr, int destLoc, unsigned char *srcPtr, int srcLoc)
+static void dissolveMerge(int spp, unsigned char *destPtr, int destLoc, unsigned char *srcPtr, int srcLoc, int x, int y)
 {
 	int randVal;
 	
@@ -166,7 +167,7 @@ static void dissolveMerge(int spp, unsigned char *destPtr, int destLoc, unsigned
 	for (int k = 0; k < alphaPos; k++)
 		destPtr[destLoc + k] = srcPtr[srcLoc + k];
 
-	randVal = (random() & 0xff);
+	randVal = SeaDissolveNoise(RANDOM_SEED, x, y);
 	destPtr[destLoc + alphaPos] = (randVal > alpha) ? 0 : alpha;
 }
 
@@ -458,11 +459,11 @@ static void grainMergeMerge(int spp, unsigned char *destPtr, int destLoc, unsign
 	destPtr[destLoc + alphaPos] = MIN(srcPtr[srcLoc + alphaPos], destPtr[destLoc + alphaPos]);
 }
 
-void SeaSelectMerge(XcfLayerMode choice, int spp, unsigned char *destPtr, int destLoc, unsigned char *srcPtr, int srcLoc)
+void SeaSelectMerge(XcfLayerMode choice, int spp, unsigned char *destPtr, int destLoc, unsigned char *srcPtr, int srcLoc, int x, int y)
 {
 	switch (choice) {
 		case XCF_DISSOLVE_MODE:
-			dissolveMerge(spp, destPtr, destLoc, srcPtr, srcLoc);
+			dissolveMerge(spp, destPtr, destLoc, srcPtr, srcLoc, x, y);
 			break;
 		case XCF_MULTIPLY_MODE:
 			multiplyMerge(spp, destPtr, destLoc, srcPtr, srcLoc);
@@ -523,8 +524,382 @@ void SeaSelectMerge(XcfLayerMode choice, int spp, unsigned char *destPtr, int de
 			break;
 		default:
 			SeaNormalMerge(spp, destPtr, destLoc, srcPtr, srcLoc, 255);
+#ifdef __OBJC__
 			NSLog(@"Unknown mode passed to selectMerge(%i)", choice);
+#endif
 			break;
 	}
 }
 
+
+// The 16-bit kernels follow the 8-bit ones above, which stay the fast path for
+// ordinary documents, but opacities are still given between 0 and 255
+
+#define kMaxSample16 65535
+
+// Widens an opacity between 0 and 255 to the range of a 16-bit sample
+#define opacity16(x) ((unsigned int)(x) * 257)
+
+// Scales the product of two 16-bit values (which may exceed 32 bits) back to a sample
+static inline uint32_t scale16(uint64_t product)
+{
+	return (uint32_t)((product + kMaxSample16 / 2) / kMaxSample16);
+}
+
+static inline uint16_t clamp16(int64_t value)
+{
+	return (uint16_t)MAX(0, MIN(kMaxSample16, value));
+}
+
+void SeaSpecialMerge16(int spp, uint16_t *destPtr, int destLoc, uint16_t *srcPtr, int srcLoc, int srcOpacity)
+{
+	uint32_t multi, alpha, t1, t2;
+	
+	if (srcPtr[srcLoc + alphaPos] == 0 || srcOpacity <= 0)
+		return;
+	
+	if (srcOpacity < 255)
+		alpha = int_mult16(srcPtr[srcLoc + alphaPos], opacity16(srcOpacity), t1);
+	else
+		alpha = srcPtr[srcLoc + alphaPos];
+	
+	if (alpha + destPtr[destLoc + alphaPos] < kMaxSample16)
+		multi = (uint32_t)(((double)alpha / ((double)alpha + (double)destPtr[destLoc + alphaPos])) * 65535.0);
+	else
+		multi = alpha;
+	for (int k = 0; k < spp - 1; k++) {
+		destPtr[destLoc + k] = int_mult16(srcPtr[srcLoc + k], multi, t1) + int_mult16(destPtr[destLoc + k], kMaxSample16 - multi, t2);
+	}
+	destPtr[destLoc + alphaPos] += int_mult16(kMaxSample16 - destPtr[destLoc + alphaPos], alpha, t1);
+}
+
+void SeaReplaceMerge16(int spp, uint16_t *destPtr, int destLoc, uint16_t *srcPtr, int srcLoc, int srcOpacity)
+{
+	uint32_t t1, t2, opacity = opacity16(srcOpacity);
+	
+	if (srcOpacity == 0)
+		return;
+	
+	if (srcOpacity == 255) {
+		memcpy(&(destPtr[destLoc]), &(srcPtr[srcLoc]), spp * sizeof(uint16_t));
+	} else {
+		for (int k = 0; k < spp; k++)
+			destPtr[destLoc + k] = int_mult16(destPtr[destLoc + k], kMaxSample16 - opacity, t1) + int_mult16(srcPtr[srcLoc + k], opacity, t2);
+	}
+}
+
+void SeaReplacePrimaryMerge16(int spp, uint16_t *destPtr, int destLoc, uint16_t *srcPtr, int srcLoc, int srcOpacity)
+{
+	uint32_t t1, t2, opacity = opacity16(srcOpacity);
+	
+	if (srcOpacity == 0)
+		return;
+	
+	if (srcOpacity == 255) {
+		memcpy(&(destPtr[destLoc]), &(srcPtr[srcLoc]), (spp - 1) * sizeof(uint16_t));
+	} else {
+		for (int k = 0; k < spp - 1; k++)
+			destPtr[destLoc + k] = int_mult16(destPtr[destLoc + k], kMaxSample16 - opacity, t1) + int_mult16(srcPtr[srcLoc + k], opacity, t2);
+	}
+}
+
+void SeaReplaceAlphaMerge16(int spp, uint16_t *destPtr, int destLoc, uint16_t *srcPtr, int srcLoc, int srcOpacity)
+{
+	uint32_t t1, t2, opacity = opacity16(srcOpacity);
+	
+	if (srcOpacity == 0)
+		return;
+	
+	if (srcOpacity == 255) {
+		destPtr[destLoc + spp - 1] = srcPtr[srcLoc];
+	} else {
+		destPtr[destLoc + spp - 1] = int_mult16(destPtr[destLoc + spp - 1], kMaxSample16 - opacity, t1) + int_mult16(srcPtr[srcLoc], opacity, t2);
+	}
+}
+
+void SeaNormalMerge16(int spp, uint16_t *destPtr, int destLoc, uint16_t *srcPtr, int srcLoc, int srcOpacity)
+{
+	uint32_t alpha, t1, t2;
+	
+	alpha = int_mult16(srcPtr[srcLoc + alphaPos], opacity16(srcOpacity), t1);
+	if (alpha == 0)
+		return;
+	
+	if (alpha == kMaxSample16) {
+		for (int k = 0; k < alphaPos; k++)
+			destPtr[destLoc + k] = srcPtr[srcLoc + k];
+		destPtr[destLoc + alphaPos] = kMaxSample16;
+	} else {
+		for (int k = 0; k < alphaPos; k++)
+			destPtr[destLoc + k] = int_mult16(srcPtr[srcLoc + k], alpha, t1) + int_mult16(destPtr[destLoc + k], kMaxSample16 - alpha, t2);
+		destPtr[destLoc + alphaPos] = alpha + int_mult16(kMaxSample16 - alpha, destPtr[destLoc + alphaPos], t1);
+	}
+}
+
+void SeaEraseMerge16(int spp, uint16_t *destPtr, int destLoc, uint16_t *srcPtr, int srcLoc, int srcOpacity)
+{
+	uint32_t alpha, t1;
+	
+	if (destPtr[destLoc + alphaPos] == 0 || srcPtr[srcLoc + alphaPos] == 0 || srcOpacity <= 0)
+		return;
+	
+	if (srcOpacity < 255)
+		alpha = kMaxSample16 - int_mult16(srcPtr[srcLoc + alphaPos], opacity16(srcOpacity), t1);
+	else
+		alpha = kMaxSample16 - srcPtr[srcLoc + alphaPos];
+	
+	destPtr[destLoc + alphaPos] = int_mult16(destPtr[destLoc + alphaPos], alpha, t1);
+}
+
+void SeaPrimaryMerge16(int spp, uint16_t *destPtr, int destLoc, uint16_t *srcPtr, int srcLoc, int srcOpacity, BOOL lazy)
+{
+	uint16_t oldAlpha;
+	
+	oldAlpha = destPtr[destLoc + alphaPos];
+	if ((lazy && oldAlpha == 0) || srcOpacity == 0)
+		return;
+	
+	destPtr[destLoc + alphaPos] = kMaxSample16;
+	SeaNormalMerge16(spp, destPtr, destLoc, srcPtr, srcLoc, srcOpacity);
+	destPtr[destLoc + alphaPos] = oldAlpha;
+}
+
+void SeaAlphaMerge16(int spp, uint16_t *destPtr, int destLoc, uint16_t *srcPtr, int srcLoc, int srcOpacity)
+{
+	uint16_t tempDest[2], tempSrc[2];
+	
+	if (srcOpacity == 0)
+		return;
+	
+	tempDest[0] = destPtr[destLoc + alphaPos];
+	tempDest[1] = kMaxSample16;
+	tempSrc[0] = srcPtr[srcLoc];
+	tempSrc[1] = srcPtr[srcLoc + alphaPos];
+	
+	SeaNormalMerge16(2, tempDest, 0, tempSrc, 0, srcOpacity);
+	
+	destPtr[destLoc + alphaPos] = tempDest[0];
+}
+
+// The hue, saturation, value and colour modes work in doubles between 0 and 1,
+// with the hue going once around the circle over that range
+
+static void rgbToHSV(double *red, double *green, double *blue)
+{
+	double r = *red, g = *green, b = *blue;
+	double max = MAX(r, MAX(g, b)), min = MIN(r, MIN(g, b)), delta = max - min, h = 0.0;
+	
+	if (delta > 0.0) {
+		if (r == max)
+			h = (g - b) / delta;
+		else if (g == max)
+			h = 2.0 + (b - r) / delta;
+		else
+			h = 4.0 + (r - g) / delta;
+		h /= 6.0;
+		if (h < 0.0)
+			h += 1.0;
+	}
+	
+	*red = h;
+	*green = (max > 0.0) ? delta / max : 0.0;
+	*blue = max;
+}
+
+static void hsvToRGB(double *hue, double *saturation, double *value)
+{
+	double h = *hue * 6.0, s = *saturation, v = *value;
+	double f, p, q, t;
+	
+	if (s == 0.0) {
+		*hue = *saturation = v;
+		return;
+	}
+	f = h - floor(h);
+	p = v * (1.0 - s);
+	q = v * (1.0 - s * f);
+	t = v * (1.0 - s * (1.0 - f));
+	
+	// A hue of one lies at the same point on the circle as zero
+	switch ((int)h % 6) {
+		case 0: *hue = v; *saturation = t; *value = p; break;
+		case 1: *hue = q; *saturation = v; *value = p; break;
+		case 2: *hue = p; *saturation = v; *value = t; break;
+		case 3: *hue = p; *saturation = q; *value = v; break;
+		case 4: *hue = t; *saturation = p; *value = v; break;
+		default: *hue = v; *saturation = p; *value = q; break;
+	}
+}
+
+static void rgbToHLS(double *red, double *green, double *blue)
+{
+	double r = *red, g = *green, b = *blue;
+	double max = MAX(r, MAX(g, b)), min = MIN(r, MIN(g, b)), delta = max - min;
+	double l = (max + min) / 2.0, h = 0.0, s = 0.0;
+	
+	if (delta > 0.0) {
+		s = (l < 0.5) ? delta / (max + min) : delta / (2.0 - max - min);
+		if (r == max)
+			h = (g - b) / delta;
+		else if (g == max)
+			h = 2.0 + (b - r) / delta;
+		else
+			h = 4.0 + (r - g) / delta;
+		h /= 6.0;
+		if (h < 0.0)
+			h += 1.0;
+	}
+	
+	*red = h;
+	*green = l;
+	*blue = s;
+}
+
+static double hlsValue(double m1, double m2, double hue)
+{
+	hue -= floor(hue);
+	if (hue < 1.0 / 6.0)
+		return m1 + (m2 - m1) * hue * 6.0;
+	if (hue < 0.5)
+		return m2;
+	if (hue < 2.0 / 3.0)
+		return m1 + (m2 - m1) * (2.0 / 3.0 - hue) * 6.0;
+	return m1;
+}
+
+static void hlsToRGB(double *hue, double *lightness, double *saturation)
+{
+	double h = *hue, l = *lightness, s = *saturation, m1, m2;
+	
+	if (s == 0.0) {
+		*hue = *saturation = l;
+		return;
+	}
+	m2 = (l < 0.5) ? l * (1.0 + s) : l + s - l * s;
+	m1 = 2.0 * l - m2;
+	*hue = hlsValue(m1, m2, h + 1.0 / 3.0);
+	*lightness = hlsValue(m1, m2, h);
+	*saturation = hlsValue(m1, m2, h - 1.0 / 3.0);
+}
+
+static void componentMerge16(XcfLayerMode choice, int spp, uint16_t *destPtr, int destLoc, uint16_t *srcPtr, int srcLoc)
+{
+	double dest[3], src[3];
+	int k;
+	
+	if (spp <= 2) {
+		SeaNormalMerge16(spp, destPtr, destLoc, srcPtr, srcLoc, 255);
+		return;
+	}
+	
+	for (k = 0; k < 3; k++) {
+		dest[k] = destPtr[destLoc + k] / 65535.0;
+		src[k] = srcPtr[srcLoc + k] / 65535.0;
+	}
+	if (choice == XCF_COLOR_MODE) {
+		rgbToHLS(&dest[0], &dest[1], &dest[2]);
+		rgbToHLS(&src[0], &src[1], &src[2]);
+		dest[0] = src[0];
+		dest[2] = src[2];
+		hlsToRGB(&dest[0], &dest[1], &dest[2]);
+	} else {
+		rgbToHSV(&dest[0], &dest[1], &dest[2]);
+		rgbToHSV(&src[0], &src[1], &src[2]);
+		k = (choice == XCF_HUE_MODE) ? 0 : (choice == XCF_SATURATION_MODE) ? 1 : 2;
+		dest[k] = src[k];
+		hsvToRGB(&dest[0], &dest[1], &dest[2]);
+	}
+	for (k = 0; k < 3; k++)
+		destPtr[destLoc + k] = clamp16(lround(dest[k] * 65535.0));
+	
+	destPtr[destLoc + alphaPos] = MIN(srcPtr[srcLoc + alphaPos], destPtr[destLoc + alphaPos]);
+}
+
+void SeaSelectMerge16(XcfLayerMode choice, int spp, uint16_t *destPtr, int destLoc, uint16_t *srcPtr, int srcLoc, int x, int y)
+{
+	uint32_t t1, t2, tM, tS;
+	int64_t temp;
+	int k;
+	
+	switch (choice) {
+		case XCF_DISSOLVE_MODE:
+			for (k = 0; k < alphaPos; k++)
+				destPtr[destLoc + k] = srcPtr[srcLoc + k];
+			destPtr[destLoc + alphaPos] = (SeaDissolveNoise(RANDOM_SEED, x, y) * 257 > srcPtr[srcLoc + alphaPos]) ? 0 : srcPtr[srcLoc + alphaPos];
+			return;
+		case XCF_HUE_MODE:
+		case XCF_SATURATION_MODE:
+		case XCF_VALUE_MODE:
+		case XCF_COLOR_MODE:
+			componentMerge16(choice, spp, destPtr, destLoc, srcPtr, srcLoc);
+			return;
+		default:
+			break;
+	}
+	
+	for (k = 0; k < alphaPos; k++) {
+		uint32_t s = srcPtr[srcLoc + k], d = destPtr[destLoc + k];
+		
+		switch (choice) {
+			case XCF_MULTIPLY_MODE:
+				destPtr[destLoc + k] = int_mult16(s, d, t1);
+				break;
+			case XCF_SCREEN_MODE:
+				destPtr[destLoc + k] = kMaxSample16 - int_mult16(kMaxSample16 - s, kMaxSample16 - d, t1);
+				break;
+			case XCF_OVERLAY_MODE:
+				destPtr[destLoc + k] = scale16((uint64_t)d * (d + scale16((uint64_t)2 * s * (kMaxSample16 - d))));
+				break;
+			case XCF_DIFFERENCE_MODE:
+				destPtr[destLoc + k] = (s > d) ? s - d : d - s;
+				break;
+			case XCF_ADDITION_MODE:
+				destPtr[destLoc + k] = MIN(s + d, kMaxSample16);
+				break;
+			case XCF_SUBTRACT_MODE:
+				destPtr[destLoc + k] = (d > s) ? d - s : 0;
+				break;
+			case XCF_DARKEN_ONLY_MODE:
+				destPtr[destLoc + k] = MIN(s, d);
+				break;
+			case XCF_LIGHTEN_ONLY_MODE:
+				destPtr[destLoc + k] = MAX(s, d);
+				break;
+			case XCF_DIVIDE_MODE:
+				destPtr[destLoc + k] = clamp16(((int64_t)d << 16) / (1 + s));
+				break;
+			case XCF_DODGE_MODE:
+				destPtr[destLoc + k] = clamp16(((int64_t)d << 16) / (65536 - s));
+				break;
+			case XCF_BURN_MODE:
+				destPtr[destLoc + k] = clamp16(kMaxSample16 - ((int64_t)(kMaxSample16 - d) << 16) / (s + 1));
+				break;
+			case XCF_HARDLIGHT_MODE:
+				if (s > 32768)
+					temp = kMaxSample16 - (((int64_t)(kMaxSample16 - d) * (kMaxSample16 - ((s - 32768) << 1))) >> 16);
+				else
+					temp = ((int64_t)d * (s << 1)) >> 16;
+				destPtr[destLoc + k] = clamp16(temp);
+				break;
+			case XCF_SOFTLIGHT_MODE:
+				tM = int_mult16(d, s, t1);
+				tS = kMaxSample16 - int_mult16(kMaxSample16 - d, kMaxSample16 - s, t1);
+				destPtr[destLoc + k] = int_mult16(kMaxSample16 - d, tM, t1) + int_mult16(d, tS, t2);
+				break;
+			case XCF_GRAIN_EXTRACT_MODE:
+				destPtr[destLoc + k] = clamp16((int64_t)d - s + 32768);
+				break;
+			case XCF_GRAIN_MERGE_MODE:
+				destPtr[destLoc + k] = clamp16((int64_t)d + s - 32768);
+				break;
+			default:
+				SeaNormalMerge16(spp, destPtr, destLoc, srcPtr, srcLoc, 255);
+#ifdef __OBJC__
+				NSLog(@"Unknown mode passed to selectMerge16(%i)", choice);
+#endif
+				return;
+		}
+	}
+	
+	destPtr[destLoc + alphaPos] = MIN(srcPtr[srcLoc + alphaPos], destPtr[destLoc + alphaPos]);
+}
@@ -17,6 +17,7 @@
 	NSImage *image;
 	SeaLayer *layer;
 	NSInteger value;
+	int lbps;
 	// NSPoint centerPoint;
 	
 	// Open the image
@@ -50,13 +51,14 @@
 		return NO;
 	}
 		
-	// Warn if 16-bit image
-	if ([imageRep bitsPerSample] == 16) {
+	// 16-bit images keep their depth in 16-bit documents, otherwise warn they are resampled
+	lbps = ([imageRep bitsPerSample] == 16 && [(SeaContent *)[doc contents] bps] == 16) ? 16 : 8;
+	if ([imageRep bitsPerSample] == 16 && lbps != 16) {
 		[[SeaController seaWarning] addMessage:LOCALSTR(@"16-bit message", @"Seashore does not currently support the editing of 16-bit images. This image has been resampled at 8 bits to be imported.") forDocument: doc level:kHighImportance];
 	}
 		
 	// Create the layer
-	layer = [[CocoaLayer alloc] initWithImageRep:imageRep document:doc spp:[[doc contents] spp]];
+	layer = [[CocoaLayer alloc] initWithImageRep:imageRep document:doc spp:[[doc contents] spp] bps:lbps];
 	if (layer == NULL) {
 		return NO;
 	}
@@ -142,6 +142,7 @@ static inline void fix_endian_read(int *input, size_t size)
 	
 	// Provide the type for the layer
 	info.type = type;
+	info.reduction = 1;
 	
 	// Determine the offset for the next layer
 	i = 0;
@@ -36,7 +36,16 @@ typedef NS_ENUM(int, XcfPropType) {
 	PROP_PARASITES             = 21,
 	PROP_UNIT                  = 22,
 	PROP_PATHS                 = 23,
-	PROP_USER_UNIT             = 24
+	PROP_USER_UNIT             = 24,
+	PROP_VECTORS               = 25,
+	PROP_TEXT_LAYER_FLAGS      = 26,
+	PROP_OLD_SAMPLE_POINTS     = 27,
+	PROP_LOCK_CONTENT          = 28,
+	PROP_GROUP_ITEM            = 29,
+	PROP_ITEM_PATH             = 30,
+	PROP_GROUP_ITEM_FLAGS      = 31,
+	PROP_LOCK_POSITION         = 32,
+	PROP_FLOAT_OPACITY         = 33
 };
 
 /*!
@@ -51,7 +60,7 @@ typedef NS_ENUM(int, XcfCompressionType) {
 	COMPRESS_NONE              =  0,
 	//! Indicates compression through run-length encoding is used.
 	COMPRESS_RLE               =  1,
-	COMPRESS_ZLIB              =  2,  /**< unused */
+	COMPRESS_ZLIB              =  2,  /**< only read by SeaCore */
 	COMPRESS_FRACTAL           =  3   /**< unused */
 };
 
@@ -45,6 +45,29 @@
 */
 #define int_mult(a,b,t)  ((t) = (a) * (b) + 0x80, ((((t) >> 8) + (t)) >> 8))
 
+/*!
+	@defined	int_mult16(a, b, t)
+	@discussion	A macro that when given two 16-bit samples determines the
+				product of the two. The returned value is scaled so it is
+				between 0 and 65535. The temporary must be an unsigned 32-bit
+				integer so the product cannot overflow.
+*/
+#define int_mult16(a,b,t)  ((t) = (uint32_t)(a) * (b) + 0x8000, ((((t) >> 16) + (t)) >> 16))
+
+/*!
+	@defined	expand_sample(x)
+	@discussion	A macro that when given an 8-bit sample returns the 16-bit
+				sample representing the same value (so 255 becomes 65535).
+*/
+#define expand_sample(x) ((uint16_t)((x) * 257))
+
+/*!
+	@defined	narrow_sample(x)
+	@discussion	A macro that when given a 16-bit sample returns the nearest
+				8-bit sample, rounding rather than dropping the low byte.
+*/
+#define narrow_sample(x) ((unsigned char)(((uint32_t)(x) * 255 + 32895) >> 16))
+
 /*!
 	@defined	make_128(x)
 	@discussion	A macro that ensures its integer argument is greater than its
@@ -21,6 +21,7 @@
 - (void)floatingHorizontalFlip;
 - (void)floatingVerticalFlip;
 - (void)standardFlip:(SeaFlipType)type;
+- (void)deepFlip:(SeaFlipType)type;
 
 /*!
 	@method		simpleFlipOf:width:height:spp:type:
@@ -5,7 +5,10 @@
 #import "SeaWhiteboard.h"
 #import "SeaSelection.h"
 #import "SeaLayer.h"
+#import "Bitmap.h"
 #import "SeaSelection.h"
+#import "SeaLayerUndo.h"
+#import "StandardMerge.h"
 
 @implementation SeaFlip
 
@@ -30,28 +33,7 @@
 
 - (void)simpleFlipOf:(unsigned char*)data width:(int)width height:(int)height spp:(int)spp type:(SeaFlipType)type
 {
-	// Do the correct flip
-	if (type == kHorizontalFlip) {
-		for (int i = 0; i < width / 2; i++) {
-			for (int j = 0; j < height; j++) {
-				for (int k = 0; k < spp; k++) {
-					unsigned char temp = data[(j * width + i) * spp + k];
-					data[(j * width + i) * spp + k] = data[(j * width + (width - i - 1)) * spp + k];
-					data[(j * width + (width - i - 1)) * spp + k] = temp;
-				}
-			}
-		}
-	} else {
-		for (int i = 0; i < width; i++) {
-			for (int j = 0; j < height / 2; j++) {
-				for (int k = 0; k < spp; k++) {
-					unsigned char temp = data[(j * width + i) * spp + k];
-					data[(j * width + i) * spp + k] = data[((height - j - 1) * width + i) * spp + k];
-					data[((height - j - 1) * width + i) * spp + k] = temp;
-				}
-			}
-		}
-	}
+	SeaFlipBitmap(spp, data, width, height, width, type == kHorizontalFlip);
 }
 
 - (void)floatingHorizontalFlip
@@ -67,8 +49,8 @@
 - (void)standardFlip:(SeaFlipType)type
 {
 	unsigned char *overlay, *data, *replace, *edata = NULL;
-	int i, j, k, width, height, spp;
-	int src, dest;
+	int j, width, height, spp;
+	int dest;
 	IntRect rect;
 	BOOL complex;
 	
@@ -88,50 +70,22 @@
 	// Erase selection if it is complex
 	if (complex) {
 		edata = malloc(rect.size.width * rect.size.height * spp);
-		for (i = 0; i < rect.size.width; i++) {
-			for (j = 0; j < rect.size.height; j++) {
-				memcpy(&(edata[(j * rect.size.width + i) * spp]), &(data[((j + rect.origin.y) * width +  (i + rect.origin.x)) * spp]), spp);
-			}
-		}
+		for (j = 0; j < rect.size.height; j++)
+			memcpy(&(edata[j * rect.size.width * spp]), &(data[((j + rect.origin.y) * width + rect.origin.x) * spp]), rect.size.width * spp);
 		[[document selection] deleteSelection];
 	}
 	
-	// Do the correct flip
-	if (type == kHorizontalFlip) {
-		for (i = 0; i < rect.size.width; i++) {
-			for (j = 0; j < rect.size.height; j++) {
-				replace[(j + rect.origin.y) * width + (i + rect.origin.x)] = 255;
-				if (complex)
-					src = (j * rect.size.width + (rect.size.width - i - 1)) * spp;
-				else
-					src = ((j + rect.origin.y) * width + ((rect.size.width - i - 1) + rect.origin.x)) * spp;
-				dest =((j + rect.origin.y) * width + (i + rect.origin.x)) * spp;
-				for (k = 0; k < spp; k++) {
-					if (complex)
-						overlay[dest + k] = edata[src + k];
-					else
-						overlay[dest + k] = data[src + k];
-				}
-			}
-		}
-	} else {
-		for (i = 0; i < rect.size.width; i++) {
-			for (j = 0; j < rect.size.height; j++) {
-				replace[(j + rect.origin.y) * width + (i + rect.origin.x)] = 255;
-				if (complex)
-					src = ((rect.size.height - j - 1) * rect.size.width + i) * spp;
-				else
-					src = (((rect.size.height - j - 1) + rect.origin.y) * width + (i + rect.origin.x)) * spp;
-				dest =((j + rect.origin.y) * width + (i + rect.origin.x)) * spp;
-				for (k = 0; k < spp; k++) {
-					if (complex)
-						overlay[dest + k] = edata[src + k];
-					else
-						overlay[dest + k] = data[src + k];
-				}
-			}
-		}
+	// Copy the pixels to the overlay and flip them there
+	for (j = 0; j < rect.size.height; j++) {
+		dest = ((j + rect.origin.y) * width + rect.origin.x) * spp;
+		if (complex)
+			memcpy(&(overlay[dest]), &(edata[j * rect.size.width * spp]), rect.size.width * spp);
+		else
+			memcpy(&(overlay[dest]), &(data[dest]), rect.size.width * spp);
+		memset(&(replace[(j + rect.origin.y) * width + rect.origin.x]), 255, rect.size.width);
 	}
+	SeaFlipBitmap(spp, &(overlay[(rect.origin.y * width + rect.origin.x) * spp]), rect.size.width, rect.size.height, width, type == kHorizontalFlip);
+	[[document whiteboard] touchOverlay:rect];
 	
 	// Free used memory
 	if (complex) free(edata);
@@ -145,10 +99,76 @@
 	[(SeaHelpers *)[document helpers] applyOverlay];	
 }
 
+- (void)deepFlip:(SeaFlipType)type
+{
+	SeaLayer *layer = [[document contents] activeLayer];
+	uint16_t *data, *edata;
+	unsigned char *mask;
+	int i, j, width, height, spp, selectOpacity;
+	IntRect rect, selectRect;
+	IntPoint maskOffset;
+	IntSize maskSize;
+	
+	// Fill out variables, 16-bit layers are flipped in place since the overlay
+	// would narrow their samples
+	data = (uint16_t *)[layer data];
+	width = [layer width];
+	height = [layer height];
+	spp = [[document contents] spp];
+	if (document.selection.active)
+		rect = [[document selection] localRect];
+	else
+		rect = IntMakeRect(0, 0, width, height);
+	
+	if (document.selection.active && [[document selection] mask]) {
+		
+		// Keep the selected pixels flipped and erase the selection
+		edata = malloc(rect.size.width * rect.size.height * spp * sizeof(uint16_t));
+		for (j = 0; j < rect.size.height; j++)
+			memcpy(&(edata[j * rect.size.width * spp]), &(data[((j + rect.origin.y) * width + rect.origin.x) * spp]), rect.size.width * spp * sizeof(uint16_t));
+		SeaFlipBitmap(spp * 2, (unsigned char *)edata, rect.size.width, rect.size.height, rect.size.width, type == kHorizontalFlip);
+		[[document selection] deleteSelection];
+		
+		// Flip the selection
+		[[document selection] flipSelection:type];
+		
+		// Replace the pixels where the flipped selection's mask allows
+		[[layer seaLayerUndo] takeSnapshot:rect automatic:YES];
+		selectRect = [[document selection] localRect];
+		mask = [[document selection] mask];
+		maskOffset = [[document selection] maskOffset];
+		maskSize = [[document selection] maskSize];
+		for (j = rect.origin.y; j < rect.origin.y + rect.size.height; j++) {
+			for (i = rect.origin.x; i < rect.origin.x + rect.size.width; i++) {
+				if (!IntPointInRect(IntMakePoint(i, j), selectRect))
+					continue;
+				selectOpacity = mask[(maskOffset.y - selectRect.origin.y + j) * maskSize.width + (maskOffset.x - selectRect.origin.x + i)];
+				if (selectOpacity > 0)
+					SeaReplaceMerge16(spp, data, (j * width + i) * spp, edata, ((j - rect.origin.y) * rect.size.width + (i - rect.origin.x)) * spp, selectOpacity);
+			}
+		}
+		free(edata);
+		
+	}
+	else {
+		
+		// Flip the pixels and the selection
+		[[layer seaLayerUndo] takeSnapshot:rect automatic:YES];
+		SeaFlipBitmap(spp * 2, (unsigned char *)&(data[(rect.origin.y * width + rect.origin.x) * spp]), rect.size.width, rect.size.height, width, type == kHorizontalFlip);
+		[[document selection] flipSelection:type];
+		
+	}
+	
+	// Reflect the changes
+	[[document helpers] layerContentsChanged:kActiveLayer];
+}
+
 - (void)run:(SeaFlipType)type
 {
 	if (document.contents.activeLayer.floating)
 		[self floatingFlip:type];
+	else if (document.contents.activeLayer.bps == 16)
+		[self deepFlip:type];
 	else
 		[self standardFlip:type];	
 }
@@ -35,7 +35,7 @@
 	int spp = [[document contents] spp];
 	unsigned char *data;
 	int i, j, k;
-	id layer;
+	id layer = NULL;
 	
 	// Start out with invalid content borders
 	contentLeft = contentRight = contentTop = contentBottom =  -1;
@@ -48,7 +48,7 @@
 	}
 	else {
 		layer = [[document contents] layerAtIndex:workingIndex];
-		data = [(SeaLayer *)layer data];
+		data = ([(SeaLayer *)layer bps] == 16) ? [(SeaLayer *)layer copyNarrowedData] : [(SeaLayer *)layer data];
 		width = [(SeaLayer *)layer width];
 		height = [(SeaLayer *)layer height];
 	}
@@ -100,6 +100,10 @@
 			}
 		}
 	}
+	
+	// Free any narrowed copy of the layer
+	if (layer && data != [(SeaLayer *)layer data])
+		free(data);
 }
 
 - (void)run:(BOOL)global
@@ -94,6 +94,12 @@ static inline CGFloat mod_float(CGFloat value, CGFloat divisor)
 	SeaLayer *activeLayer = [contents activeLayer];
 	RotationUndoRecord undoRecord;
 	
+	// Neither rotation can work on 16-bit layers
+	if ([activeLayer bps] == 16) {
+		NSBeep();
+		return;
+	}
+	
 	// Only rotate
 	if (degrees > 0)
 		degrees = 360 - mod_float(degrees, 360);
@@ -19,6 +19,12 @@
 	
 	/// A slider for the density of the wand sampling
 	IBOutlet NSSlider *intervalsSlider;
+	
+	/// A checkbox indicating whether only pixels touching the click are selected
+	IBOutlet NSButton *contiguousCheckbox;
+	
+	/// A slider for the soft edge of non-contiguous selections
+	IBOutlet NSSlider *softnessSlider;
 }
 
 /*!
@@ -50,6 +56,22 @@
 */
 @property (readonly) int numIntervals;
 
+/*!
+	@property	contiguous
+	@discussion	Returns whether the wand selects only the region touching the
+				click, or every pixel of a similar colour in the layer.
+	@result		Returns YES if the selection should be contiguous, NO otherwise.
+*/
+@property (readonly) BOOL contiguous;
+
+/*!
+	@property	softness
+	@discussion	Returns the distance beyond the tolerance over which a
+				non-contiguous selection fades out.
+	@result		Returns an integer indicating the softness.
+*/
+@property (readonly) int softness;
+
 /*!
 	@method		shutdown
 	@discussion	Saves current options upon shutdown.
@@ -31,6 +31,21 @@
 		value = [defaults integerForKey:@"wand intervals"];
 		[intervalsSlider setIntegerValue: value];
 	}
+	
+	if ([defaults objectForKey:@"wand contiguous"] == NULL)
+		[contiguousCheckbox setState:NSOnState];
+	else
+		[contiguousCheckbox setState:[defaults boolForKey:@"wand contiguous"] ? NSOnState : NSOffState];
+	
+	if ([defaults objectForKey:@"wand softness"] == NULL) {
+		[softnessSlider setIntValue:0];
+	}
+	else {
+		value = [defaults integerForKey:@"wand softness"];
+		if (value < 0 || value > 64)
+			value = 0;
+		[softnessSlider setIntegerValue:value];
+	}
 }
 
 - (IBAction)toleranceSliderChanged:(id)sender
@@ -48,11 +63,23 @@
 	return [intervalsSlider intValue];
 }
 
+- (BOOL)contiguous
+{
+	return [contiguousCheckbox state] == NSOnState;
+}
+
+- (int)softness
+{
+	return [softnessSlider intValue];
+}
+
 - (void)shutdown
 {
 	NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
 	[defaults setInteger:[toleranceSlider intValue] forKey:@"wand tolerance"];
 	[defaults setInteger:[intervalsSlider intValue] forKey:@"wand intervals"];
+	[defaults setBool:[contiguousCheckbox state] == NSOnState forKey:@"wand contiguous"];
+	[defaults setInteger:[softnessSlider intValue] forKey:@"wand softness"];
 }
 
 @end
@@ -75,6 +75,16 @@ NS_ASSUME_NONNULL_BEGIN
 */
 @property (readonly) BOOL foregroundIsTexture;
 
+/*!
+	@property	acceptsDeepDocuments
+	@discussion	Returns whether or not this tool can be used in 16-bit
+				documents. Tools that read the 8-bit samples of layers directly
+				cannot be.
+	@result		Returns YES if the tool can be used in 16-bit documents, NO
+				otherwise. The implementation in this class always returns YES.
+*/
+@property (readonly) BOOL acceptsDeepDocuments;
+
 /*!
 	@method		mouseDownAt:withEvent:
 	@discussion	Handles mouse down events.
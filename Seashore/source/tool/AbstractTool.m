@@ -43,6 +43,11 @@
 	return [options useTextures];
 }
 
+- (BOOL)acceptsDeepDocuments
+{
+	return YES;
+}
+
 - (void)mouseDownAt:(IntPoint)where withEvent:(NSEvent *)event
 {
 }
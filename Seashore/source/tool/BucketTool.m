@@ -25,6 +25,11 @@
 	return kBucketTool;
 }
 
+- (BOOL)acceptsDeepDocuments
+{
+	return NO;
+}
+
 - (instancetype)init
 {
 	self = [super init];
@@ -164,6 +169,7 @@
 	}
 	
 	// Do the update
+	[[document whiteboard] touchOverlay:rect];
 	if (delay)
 		[[document helpers] overlayChanged:rect inThread:NO];
 	else
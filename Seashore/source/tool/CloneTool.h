@@ -25,6 +25,7 @@ typedef struct {
 #define kMaxBTPoints 16384
 
 @class SeaLayer;
+@class SeaWhiteboardSnapshot;
 
 /*!
 	@class		CloneTool
@@ -98,8 +99,8 @@ typedef struct {
 	// YES if the merged data should be used, NO otherwise
 	BOOL sourceMerged;
 	
-	// The merged data from which the clone tool is working (only allocated between mouse clicks)
-	unsigned char *mergedData;
+	// The snapshot of the merged data from which the clone tool is working (only taken between mouse clicks)
+	SeaWhiteboardSnapshot *mergedSnapshot;
 }
 
 /*!
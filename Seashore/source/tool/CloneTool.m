@@ -33,6 +33,11 @@
 	return kCloneTool;
 }
 
+- (BOOL)acceptsDeepDocuments
+{
+	return NO;
+}
+
 - (BOOL)acceptsLineDraws
 {
 	return NO;
@@ -124,11 +129,8 @@
 	SeaBrush *curBrush = [[[SeaController utilitiesManager] brushUtilityFor:document] activeBrush];
 	NSPoint curPoint = IntPointMakeNSPoint(where), temp;
 	IntRect rect;
-	int spp = [[document contents] spp];
 	int pressure = 255; // [options pressureValue:event];
 	BOOL ignoreFirstTouch;
-	unsigned char *sourceData;
-	int sourceWidth, sourceHeight;
 	IntPoint spt;
 	CGFloat xScale, yScale;
 	int modifier = [options modifier];
@@ -162,23 +164,8 @@
 	}
 	else if (sourceSet) {
 		
-		// Find the source
-		if (sourceMerged) {
-			sourceWidth = [[document contents] width];
-			sourceHeight = [[document contents] height];
-			if (mergedData) {
-				free(mergedData);
-				mergedData = NULL;
-			}
-			mergedData = malloc(make_128(sourceWidth * sourceHeight * spp));
-			memcpy(mergedData, [[document whiteboard] data], sourceWidth * sourceHeight * spp);
-			sourceData = mergedData;
-		}
-		else {
-			sourceData = [sourceLayer data];
-			sourceWidth = [sourceLayer width];
-			sourceHeight = [sourceLayer height];
-		}
+		// Find the source (the snapshot only copies what the stroke later changes)
+		mergedSnapshot = sourceMerged ? [[document whiteboard] snapshot] : NULL;
 		
 		// Determine whether operation should continue
 		startPoint.x = where.x;
@@ -211,7 +198,7 @@
 			if (!isErasing) {
 				spt.x = sourcePoint.x + (rect.origin.x - startPoint.x) - 1;
 				spt.y = sourcePoint.y + (rect.origin.y - startPoint.y) - 1;
-				SeaCloneFill(spp, rect, [[document whiteboard] overlay], [[document whiteboard] replace], [layer width], [layer height], sourceData, sourceWidth, sourceHeight, spt);
+				[self cloneFill:rect onLayer:layer from:spt];
 			}
 			[[document helpers] overlayChanged:rect inThread:YES];
 		}
@@ -234,6 +221,26 @@
 	}
 }
 
+- (void)cloneFill:(IntRect)rect onLayer:(SeaLayer *)layer from:(IntPoint)spt
+{
+	SeaWhiteboard *whiteboard = [document whiteboard];
+	int spp = [[document contents] spp];
+	IntRect sourceRect;
+	unsigned char *sourceData;
+	
+	if (mergedSnapshot) {
+		// Copy out just the part of the snapshot under the brush
+		sourceRect = IntConstrainRect(IntMakeRect(spt.x, spt.y, rect.size.width, rect.size.height), IntMakeRect(0, 0, [mergedSnapshot width], [mergedSnapshot height]));
+		sourceData = malloc(make_128(MAX(sourceRect.size.width * sourceRect.size.height, 1) * spp));
+		[mergedSnapshot copyRect:sourceRect toData:sourceData];
+		SeaCloneFill(spp, rect, [whiteboard overlay], [whiteboard replace], [layer width], [layer height], sourceData, sourceRect.size.width, sourceRect.size.height, IntMakePoint(spt.x - sourceRect.origin.x, spt.y - sourceRect.origin.y));
+		free(sourceData);
+	}
+	else {
+		SeaCloneFill(spp, rect, [whiteboard overlay], [whiteboard replace], [layer width], [layer height], [sourceLayer data], [sourceLayer width], [sourceLayer height], spt);
+	}
+}
+
 - (void)drawThread:(id)object
 {
 	@autoreleasepool {
@@ -248,13 +255,11 @@
 		double stFactor, stOffset;
 		double t0, dt, tn, t;
 		double total, initial;
-		int n, num_points, spp;
+		int n, num_points;
 		IntRect rect, trect, bigRect;
 		NSPoint temp;
 		int pressure, origPressure;
 		NSDate *lastDate;
-		unsigned char *sourceData;
-		int sourceWidth, sourceHeight;
 		IntPoint spt;
 		
 		// Set-up variables
@@ -266,19 +271,8 @@
 		brushHeight = [curBrush fakeHeight];
 		activeTexture = [[[SeaController utilitiesManager] textureUtilityFor:document] activeTexture];
 		brushSpacing = (double)[[[SeaController utilitiesManager] brushUtilityFor:document] spacing] / 100.0;
-		spp = [[document contents] spp];
 		bigRect = IntMakeRect(0, 0, 0, 0);
 		lastDate = [NSDate date];
-		if (sourceMerged) {
-			sourceData = mergedData;
-			sourceWidth = [[document contents] width];
-			sourceHeight = [[document contents] height];
-		}
-		else {
-			sourceData = [sourceLayer data];
-			sourceWidth = [sourceLayer width];
-			sourceHeight = [sourceLayer height];
-		}
 		
 		// While we are not done...
 		do {
@@ -405,7 +399,7 @@
 						if (!isErasing) {
 							spt.x = sourcePoint.x + (rect.origin.x - startPoint.x) - 1;
 							spt.y = sourcePoint.y + (rect.origin.y - startPoint.y) - 1;
-							SeaCloneFill(spp, rect, [[document whiteboard] overlay], [[document whiteboard] replace], [(SeaLayer *)layer width], [(SeaLayer *)layer height], sourceData, sourceWidth, sourceHeight, spt);
+							[self cloneFill:rect onLayer:layer from:spt];
 						}
 						if (bigRect.size.width == 0) {
 							bigRect = rect;
@@ -535,11 +529,8 @@
 		
 	}
 	
-	// Free merged data
-	if (mergedData) {
-		free(mergedData);
-		mergedData = NULL;
-	}
+	// Release the merged snapshot
+	mergedSnapshot = NULL;
 }
 
 - (void)unset
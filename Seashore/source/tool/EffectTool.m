@@ -17,6 +17,11 @@
 	return kEffectTool;
 }
 
+- (BOOL)acceptsDeepDocuments
+{
+	return NO;
+}
+
 - (instancetype)init
 {
 	if(self = [super init]) {
@@ -20,6 +20,11 @@
 	return kEyedropTool;
 }
 
+- (BOOL)acceptsDeepDocuments
+{
+	return NO;
+}
+
 - (void)mouseUpAt:(IntPoint)where withEvent:(NSEvent *)event
 {
 	ToolboxUtility *toolboxUtility = [[SeaController utilitiesManager] toolboxUtilityFor:document];
@@ -95,6 +95,7 @@
 	
 	// Draw the gradient
 	GCFillGradient([[document whiteboard] overlay], [[contents activeLayer] width], [[contents activeLayer] height], rect, [contents spp], info, NULL);
+	[[document whiteboard] touchOverlay:rect];
 	
 	// Apply the changes
 	[[document helpers] applyOverlay];
@@ -164,6 +164,7 @@
 		GCDrawPolygon(fakeOverlay, fakeWidth, fakeHeight, gimpPoints, pos, spp);
 		// Scale region to the actual size of the overlay
 		GCScalePixels(overlay, width, height, fakeOverlay, fakeWidth, fakeHeight, interpolation, spp);
+		[[document whiteboard] touchOverlay:IntMakeRect(0, 0, width, height)];
 	
 		// Then select it
 		[[document selection] selectOverlay:YES inRect:rect mode:[options selectionMode]];	
@@ -21,6 +21,11 @@
 	return kSmudgeTool;
 }
 
+- (BOOL)acceptsDeepDocuments
+{
+	return NO;
+}
+
 - (BOOL)useMouseCoalescing
 {
 	return NO;
@@ -25,6 +25,11 @@ NSFont *gNewFont;
 	return kTextTool;
 }
 
+- (BOOL)acceptsDeepDocuments
+{
+	return NO;
+}
+
 - (instancetype)init
 {
 	if(self = [super init]) {
@@ -191,6 +196,7 @@ NSFont *gNewFont;
 	if ([options allowFringe]) {
 	}
 	free(initData);
+	[[document whiteboard] touchOverlay:IntMakeRect(pos.x, pos.y, fontSize.width, fontSize.height)];
 	
 	return IntMakeRect(pos.x, pos.y, fontSize.width, fontSize.height);
 }
@@ -18,6 +18,11 @@
 	return kWandTool;
 }
 
+- (BOOL)acceptsDeepDocuments
+{
+	return NO;
+}
+
 - (void)mouseDownAt:(IntPoint)where withEvent:(NSEvent *)event
 {
 	[super mouseDownAt:where withEvent:event];
@@ -46,9 +51,8 @@
 
 	if(![super isMovingOrScaling]){
 		SeaLayer *layer = [[document contents] activeLayer];
-		int tolerance, width = [layer width], height = [layer height], spp = [[document contents] spp], k;
-		unsigned char *overlay = [[document whiteboard] overlay], *data = [layer data];
-		unsigned char basePixel[4];
+		int tolerance, width = [layer width], height = [layer height], spp = [[document contents] spp];
+		unsigned char *fillMask, *data = [layer data];
 		IntRect rect;
 			
 		// Check for a valid click
@@ -58,10 +62,7 @@
 			if([options selectionMode] == kDefaultMode || [options selectionMode] == kForceNewMode)
 				[[document selection] clearSelection];
 				
-			// Fill the region to be selected
-			for (k = 0; k < spp - 1; k++)
-				basePixel[k] = 0;
-			basePixel[spp - 1] = 255;
+			// Mark the region to be selected
 			tolerance = [(WandOptions*)options tolerance];
 			int mode = [options selectionMode];
 			int intervals = [options numIntervals];
@@ -77,11 +78,16 @@
 				seeds[seedIndex] = IntMakePoint(x, y);				
 			}
 				
-			rect = SeaBucketFill(spp, IntMakeRect(0, 0, width, height), overlay, data, width, height, seeds, intervals + 1, basePixel, tolerance, [[document contents] selectedChannel]);
+			fillMask = calloc(width * height, 1);
+			if ([(WandOptions*)options contiguous])
+				rect = SeaBucketFillMask(spp, IntMakeRect(0, 0, width, height), fillMask, data, width, height, seeds, intervals + 1, tolerance, [[document contents] selectedChannel]);
+			else
+				rect = SeaColorMask(spp, IntMakeRect(0, 0, width, height), fillMask, data, width, height, seeds, intervals + 1, tolerance, [(WandOptions*)options softness], [[document contents] selectedChannel]);
 			free(seeds);
 			
 			// Then select it
-			[[document selection] selectOverlay:YES inRect:rect mode: mode];			
+			[[document selection] selectMask:fillMask inRect:rect mode:mode];
+			free(fillMask);
 		}
 		intermediate = NO;
 
@@ -2,62 +2,100 @@
 /* Vladimir Kolmogorov (vnk@cs.cornell.edu), 2001. */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include "graph.h"
 
 Graph::Graph(void (*err_function)(const char *))
 {
 	error_function = err_function;
-	node_block = new Block<node>(NODE_BLOCK_SIZE, error_function);
-	arc_block  = new Block<arc>(NODE_BLOCK_SIZE, error_function);
+	nodes = NULL;
+	node_count = node_max = 0;
+	arcs = NULL;
+	arc_count = arc_max = 0;
 	flow = 0;
 }
 
 Graph::~Graph()
 {
-	delete node_block;
-	delete arc_block;
+	release();
 }
 
-Graph::node_id Graph::add_node()
+void Graph::error(const char *message)
 {
-	node *i = node_block -> New();
+	if (error_function) (*error_function)(message);
+	exit(1);
+}
+
+void Graph::reset(int new_node_count, int new_arc_count)
+{
+	int i;
 
-	i -> first = NULL;
-	i -> tr_cap = 0;
+	/* grow the arrays only when they are too small */
+	if (new_node_count > node_max)
+	{
+		free(nodes);
+		nodes = (node *) malloc(new_node_count * sizeof(node));
+		if (!nodes) error("Not enough memory!");
+		node_max = new_node_count;
+	}
+	if (new_arc_count > arc_max)
+	{
+		free(arcs);
+		arcs = (arc *) malloc(new_arc_count * sizeof(arc));
+		if (!arcs) error("Not enough memory!");
+		arc_max = new_arc_count;
+	}
 
-	return (node_id) i;
+	node_count = new_node_count;
+	arc_count = 0;
+	for (i=0; i<node_count; i++)
+	{
+		nodes[i].first = -1;
+		nodes[i].tr_cap = 0;
+	}
+	flow = 0;
+}
+
+void Graph::release()
+{
+	free(nodes);
+	free(arcs);
+	nodes = NULL;
+	arcs = NULL;
+	node_count = node_max = 0;
+	arc_count = arc_max = 0;
 }
 
 void Graph::add_edge(node_id from, node_id to, captype cap, captype rev_cap)
 {
-	arc *a, *a_rev;
+	int a, a_rev;
 
-	a = arc_block -> New(2);
+	if (arc_count + 2 > arc_max) error("Too many arcs!");
+	a = arc_count;
 	a_rev = a + 1;
+	arc_count += 2;
 
-	a -> sister = a_rev;
-	a_rev -> sister = a;
-	a -> next = ((node*)from) -> first;
-	((node*)from) -> first = a;
-	a_rev -> next = ((node*)to) -> first;
-	((node*)to) -> first = a_rev;
-	a -> head = (node*)to;
-	a_rev -> head = (node*)from;
-	a -> r_cap = cap;
-	a_rev -> r_cap = rev_cap;
+	arcs[a].next = nodes[from].first;
+	nodes[from].first = a;
+	arcs[a_rev].next = nodes[to].first;
+	nodes[to].first = a_rev;
+	arcs[a].head = to;
+	arcs[a_rev].head = from;
+	arcs[a].r_cap = cap;
+	arcs[a_rev].r_cap = rev_cap;
 }
 
 void Graph::set_tweights(node_id i, captype cap_source, captype cap_sink)
 {
 	flow += (cap_source < cap_sink) ? cap_source : cap_sink;
-	((node*)i) -> tr_cap = cap_source - cap_sink;
+	nodes[i].tr_cap = cap_source - cap_sink;
 }
 
 void Graph::add_tweights(node_id i, captype cap_source, captype cap_sink)
 {
-	captype delta = ((node*)i) -> tr_cap;
+	captype delta = nodes[i].tr_cap;
 	if (delta > 0) cap_source += delta;
 	else           cap_sink   -= delta;
 	flow += (cap_source < cap_sink) ? cap_source : cap_sink;
-	((node*)i) -> tr_cap = cap_source - cap_sink;
+	nodes[i].tr_cap = cap_source - cap_sink;
 }
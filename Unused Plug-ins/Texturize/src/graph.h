@@ -17,11 +17,15 @@
 	from the sink. (The original algorithm used only the former one).
 	Details will be described in my PhD thesis.
 
-	This implementation uses an adjacency list graph representation.
+	This implementation uses an adjacency list graph representation
+	held in two contiguous arrays, nodes and arcs referring to each
+	other by index. The arrays are kept between uses of the graph and
+	only grow when a larger graph is needed, so a graph cut for each of
+	many patches does not allocate memory once the first is done.
 	Memory allocation:
-		Nodes: 22 bytes + one field to hold a residual capacity
+		Nodes: 26 bytes + one field to hold a residual capacity
 		       of t-links (by default it is 'short' - 2 bytes)
-		Arcs: 12 bytes + one field to hold a residual capacity
+		Arcs: 8 bytes + one field to hold a residual capacity
 		      (by default it is 'short' - 2 bytes)
 	(Note that arcs are always added in pairs - in forward and reverse directions)
 
@@ -46,24 +50,22 @@
 
 	void main()
 	{
-		Graph::node_id nodes[2];
 		Graph *g = new Graph();
 
-		nodes[0] = g -> add_node();
-		nodes[1] = g -> add_node();
-		g -> set_tweights(nodes[0], 1, 5);
-		g -> set_tweights(nodes[1], 2, 6);
-		g -> add_edge(nodes[0], nodes[1], 3, 4);
+		g -> reset(2, 2);
+		g -> set_tweights(0, 1, 5);
+		g -> set_tweights(1, 2, 6);
+		g -> add_edge(0, 1, 3, 4);
 
 		Graph::flowtype flow = g -> maxflow();
 
 		printf("Flow = %d\n", flow);
 		printf("Minimum cut:\n");
-		if (g->what_segment(nodes[0]) == Graph::SOURCE)
+		if (g->what_segment(0) == Graph::SOURCE)
 			printf("node0 is in the SOURCE set\n");
 		else
 			printf("node0 is in the SINK set\n");
-		if (g->what_segment(nodes[1]) == Graph::SOURCE)
+		if (g->what_segment(1) == Graph::SOURCE)
 			printf("node1 is in the SOURCE set\n");
 		else
 			printf("node1 is in the SINK set\n");
@@ -77,17 +79,6 @@
 #ifndef __GRAPH_H__
 #define __GRAPH_H__
 
-#include "block.hpp"
-
-/*
-	Nodes, arcs and pointers to nodes are
-	added in blocks for memory and time efficiency.
-	Below are numbers of items in blocks
-*/
-#define NODE_BLOCK_SIZE 512
-#define ARC_BLOCK_SIZE 1024
-#define NODEPTR_BLOCK_SIZE 128
-
 class Graph
 {
 public:
@@ -103,7 +94,8 @@ public:
 	/** Type of total flow */
 	typedef int flowtype;
 
-	typedef void * node_id;
+	/** Nodes are numbered from 0 */
+	typedef int node_id;
 
 	/* interface functions */
 
@@ -116,8 +108,13 @@ public:
 	/** Destructor */
 	~Graph();
 
-	/** Adds a node to the graph */
-	node_id add_node();
+	/** Empties the graph and gives it 'node_count' unconnected nodes,
+	   numbered from 0, with room for 'arc_count' arcs (two for each
+	   edge). Memory from earlier uses of the graph is reused. */
+	void reset(int node_count, int arc_count);
+
+	/** Frees the memory kept for later uses of the graph */
+	void release();
 
 	/** Adds a bidirectional edge between 'from' and 'to'
 	   with the weights 'cap' and 'rev_cap' */
@@ -137,7 +134,7 @@ public:
 	   segment the node 'i' belongs (Graph::SOURCE or Graph::SINK) */
 	termtype what_segment(node_id i);
 
-	/** Computes the maxflow. Can be called only once. */
+	/** Computes the maxflow. Can be called only once after each reset. */
 	flowtype maxflow();
 
 /***********************************************************************/
@@ -147,16 +144,15 @@ public:
 private:
 	/* internal variables and functions */
 
-	struct arc_st;
-
-	/** node structure */
+	/** node structure, links are indices or one of the special values in maxflow.cpp */
 	typedef struct node_st
 	{
-		arc_st			*first;		/**< first outcoming arc */
+		int				first;		/**< first outcoming arc */
 
-		arc_st			*parent;	/**< node's parent */
-		node_st			*next;		/**< pointer to the next active node
-									   (or to itself if it is the last node in the list) */
+		int				parent;		/**< node's parent */
+		int				next;		/**< the next active node
+									   (or the node itself if it is the last node in the list) */
+		int				next_orphan;	/**< the next node in the list of orphans */
 		int				TS;			/**< timestamp showing when DIST was computed */
 		int				DIST;		/**< distance to the terminal */
 		short			is_sink;	/**< flag showing whether the node is in the source or in the sink tree */
@@ -165,26 +161,19 @@ private:
 									   otherwise         -tr_cap is residual capacity of the arc node->SINK */
 	} node;
 
-	/** arc structure */
+	/** arc structure, the reverse of arc a is arc a^1 */
 	typedef struct arc_st
 	{
-		node_st			*head;		/**< node the arc points to */
-		arc_st			*next;		/**< next arc with the same originating node */
-		arc_st			*sister;	/**< reverse arc */
+		int				head;		/**< node the arc points to */
+		int				next;		/**< next arc with the same originating node */
 
 		captype			r_cap;		/**< residual capacity */
 	} arc;
 
-	/** 'pointer to node' structure */
-	typedef struct nodeptr_st
-	{
-		node_st			*ptr;
-		nodeptr_st		*next;
-	} nodeptr;
-
-	Block<node>			*node_block;
-	Block<arc>			*arc_block;
-	DBlock<nodeptr>		*nodeptr_block;
+	node				*nodes;		/**< the nodes of the graph */
+	int					node_count, node_max;
+	arc					*arcs;		/**< the arcs of the graph */
+	int					arc_count, arc_max;
 
 	void	(*error_function)(const char *);	/**< this function is called if a error occurs,
 										   with a corresponding error message
@@ -194,20 +183,26 @@ private:
 
 /***********************************************************************/
 
-	node				*queue_first[2], *queue_last[2];	/**< list of active nodes */
-	nodeptr				*orphan_first, *orphan_last;		/**< list of pointers to orphans */
-	int					TIME;								/**< monotonically increasing global counter */
+	int					queue_first[2], queue_last[2];	/**< list of active nodes */
+	int					orphan_first, orphan_last;		/**< list of orphans */
+	int					TIME;							/**< monotonically increasing global counter */
 
 /***********************************************************************/
 
+	void error(const char *message);
+
 	/* functions for processing active list */
-	void set_active(node *i);
-	node *next_active();
+	void set_active(int i);
+	int next_active();
+
+	/* functions for processing the list of orphans */
+	void add_orphan_front(int i);
+	void add_orphan_back(int i);
 
 	void maxflow_init();
-	void augment(arc *middle_arc);
-	void process_source_orphan(node *i);
-	void process_sink_orphan(node *i);
+	void augment(int middle_arc);
+	void process_source_orphan(int i);
+	void process_sink_orphan(int i);
 };
 
 #endif
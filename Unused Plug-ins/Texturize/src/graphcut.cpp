@@ -26,6 +26,9 @@ extern "C" {
 #define HAS_CUT_NORTH(r) (r) & CUT_NORTH
 #define HAS_CUT_WEST(r)  (r) & CUT_WEST
 
+// Le graphe est réutilisé d'un patch à l'autre pour ne pas réallouer sa mémoire.
+static Graph graphe;
+
 // ||pixel1 - pixel2||^2
 // Expérimentalement, le carré semble mieux marcher que la norme 2.
 inline Graph::captype
@@ -96,16 +99,12 @@ decoupe_graphe (int* patch_posn,
 {
 ////////////////////////////////////////////////////////////////////////////////
 // Déclaration des variables
-  gint k, x_p, y_p, x_i, y_i;// nb_sommets, sommet_courant; // Compteurs
+  gint x_p, y_p, x_i, y_i;// nb_sommets, sommet_courant; // Compteurs
   gint real_x_i, real_y_i;
   gint x_inf, y_inf, x_sup, y_sup;
-  int chute_patch_posn[2];
-  Graph * graphe = new Graph(); // Le graphe à couper
-  Graph::node_id node_of_pixel[width_p * height_p]; // Le noeud du graph auquel correspond un pointeur.
-  for (k=0; k<width_p * height_p; k++) node_of_pixel[k] = NULL;
-
+  gint width_r, height_r;
   Graph::captype poids; // Pour calculer le poids d'un arc avant de le déclarer à Graph:add_edge
-  Graph::node_id first_node = NULL, node_sommet_courant; 
+  Graph::node_id first_node = -1, node_sommet_courant;
   guchar r;
   guchar new_r;
 
@@ -160,27 +159,14 @@ decoupe_graphe (int* patch_posn,
 //     }
 //   }
 
-  // On commence par parcourir tout le patch une première fois pour créer les noeuds
-  // et faire les liens dans node_of_pixel
-
-  for (real_x_i = x_inf;
-       real_x_i < x_sup;
-       real_x_i++) {
-    x_p = real_x_i - patch_posn[0];
-    x_i = modulo (real_x_i, width_i);
-    for (real_y_i = y_inf;
-         real_y_i < y_sup;
-         real_y_i++) {
-      y_p = real_y_i - patch_posn[1];
-      y_i = modulo (real_y_i, height_i);
+  // Chaque pixel de la région commune au patch et à l'image a son noeud,
+  // numéroté colonne par colonne : (real_x_i - x_inf) * height_r + (real_y_i - y_inf).
+  // Les noeuds des pixels non remplis restent isolés.
+  // Chaque pixel crée au plus deux arêtes (nord et ouest), soit quatre arcs.
 
-      // Si le pixel de l'image n'est pas rempli, on ne fait rien et on passe au suivant
-      if (rempli[x_i][y_i]) {
-        node_of_pixel[x_p * height_p + y_p] = graphe->add_node ();
-        if (first_node == NULL) first_node = node_of_pixel[x_p * height_p + y_p];
-      }
-    }
-  }
+  width_r  = MAX (0, x_sup - x_inf);
+  height_r = MAX (0, y_sup - y_inf);
+  graphe.reset (width_r * height_r, 4 * width_r * height_r);
 
   // On crée les arcs.
   /*
@@ -227,7 +213,8 @@ decoupe_graphe (int* patch_posn,
         continue;
       } else {
         // Création du noeud et liens
-        node_sommet_courant = node_of_pixel[x_p * height_p + y_p];
+        node_sommet_courant = (real_x_i - x_inf) * height_r + (real_y_i - y_inf);
+        if (first_node == -1) first_node = node_sommet_courant;
 
         // Si le voisin nord existe dans le patch et si le pixel nord
         // est rempli dans l'image, on crée un lien vers lui
@@ -238,9 +225,9 @@ decoupe_graphe (int* patch_posn,
                                patch + ((y_p * width_p + x_p) * channels),
                                image + (((modulo (y_i - 1, height_i)) * width_i + x_i) * channels),
                                patch + (((y_p - 1) * width_p + x_p) * channels));
-          graphe->add_edge (node_sommet_courant,
-                            node_of_pixel[x_p * height_p + y_p - 1],
-                            poids, poids);
+          graphe.add_edge (node_sommet_courant,
+                           node_sommet_courant - 1,
+                           poids, poids);
         }
 
         // Si le voisin ouest existe dans le patch et si le pixel ouest
@@ -252,9 +239,9 @@ decoupe_graphe (int* patch_posn,
                                patch + ((y_p * width_p + x_p) * channels),
                                image + ((y_i * width_i + (modulo (x_i, width_i) - 1)) * channels),
                                patch + ((y_p * width_p + (x_p - 1)) * channels));
-          graphe->add_edge (node_sommet_courant,
-                            node_of_pixel[(x_p - 1) * height_p + y_p],
-                            poids, poids);
+          graphe.add_edge (node_sommet_courant,
+                           node_sommet_courant - height_r,
+                           poids, poids);
         }
 
         // Si je suis au bord du patch et si en plus, dans le cas !make_tileable,
@@ -262,7 +249,7 @@ decoupe_graphe (int* patch_posn,
         if (    (make_tileable && (x_p == 0 || y_p == 0 || x_p == width_p - 1 || y_p == height_p - 1))
             || (!make_tileable && (x_p == 0 || y_p == 0 || x_p == width_p - 1 || y_p == height_p - 1)
 		               &&  x_i != 0 && y_i != 0 && x_i != width_i - 1 && y_i != height_i - 1)) {
-          graphe->add_tweights (node_sommet_courant, MAX_CAPACITY, 0);
+          graphe.add_tweights (node_sommet_courant, MAX_CAPACITY, 0);
 	}
 
         // Si l'un de mes voisins existe et n'est pas rempli, me relier au puits
@@ -277,22 +264,22 @@ decoupe_graphe (int* patch_posn,
                  || (x_p != width_p - 1  && !rempli[modulo (x_i + 1, width_i)][y_i])           // Est
                  || (x_p != 0            && !rempli[modulo (x_i - 1, width_i)][y_i])))) {      // Ouest
 	  //	  printf ("Connecting %i, %i to Sink\n", x_p, y_p);
-          graphe->add_tweights (node_sommet_courant, 0, MAX_CAPACITY);
+          graphe.add_tweights (node_sommet_courant, 0, MAX_CAPACITY);
 	}
       }
     }
   }
 
   // Si !make_tileable, on relie à la source le pixel haut gauche de patch \cap image
-  if (!make_tileable) {
-    graphe->add_tweights (first_node, MAX_CAPACITY, 0);
+  if (!make_tileable && first_node != -1) {
+    graphe.add_tweights (first_node, MAX_CAPACITY, 0);
   }
 
 
 ////////////////////////////////////////////////////////////////////////////////
 // Calcul de la coupe
 
-  graphe->maxflow ();
+  graphe.maxflow ();
 
 ////////////////////////////////////////////////////////////////////////////////
 // Mise_a_jour de l'image
@@ -305,7 +292,7 @@ decoupe_graphe (int* patch_posn,
       y_i = modulo (real_y_i, height_i);
       r = rempli[x_i][y_i];
       if (r) {
-        if (graphe->what_segment(node_of_pixel[x_p * height_p + y_p]) == Graph::SINK) {
+        if (graphe.what_segment((real_x_i - x_inf) * height_r + (real_y_i - y_inf)) == Graph::SINK) {
           paste_patch_pixel_to_image (width_i, height_i, width_p, height_p, x_i, y_i, x_p, y_p,
                                       channels, image, patch); //,
                                       //coupe_h_here, coupe_v_here);
@@ -319,10 +306,11 @@ decoupe_graphe (int* patch_posn,
     }
   }
 
-////////////////////////////////////////////////////////////////////////////////
-//On nettoie tout
-
-  delete graphe;
-
   return;
 }
+
+void
+libere_graphe (void)
+{
+  graphe.release ();
+}
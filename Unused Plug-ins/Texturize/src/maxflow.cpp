@@ -5,10 +5,15 @@
 #include "graph.h"
 
 /*
-	special constants for node->parent
+	special constants for node->parent, node->next,
+	node->next_orphan, node->first and arc->next
 */
-#define TERMINAL ( (arc *) 1 )		/* to terminal */
-#define ORPHAN   ( (arc *) 2 )		/* orphan */
+#define NONE     -1		/* no node or arc */
+#define TERMINAL -2		/* to terminal */
+#define ORPHAN   -3		/* orphan */
+
+/* the reverse of an arc */
+#define SISTER(a) ((a) ^ 1)
 
 #define INFINITE_D 1000000000		/* infinite distance to the terminal */
 
@@ -16,9 +21,9 @@
 
 /*
 	Functions for processing active list.
-	i->next points to the next node in the list
-	(or to i, if i is the last node in the list).
-	If i->next is NULL iff i is not in the list.
+	i->next is the next node in the list
+	(or i, if i is the last node in the list).
+	i->next is NONE iff i is not in the list.
 
 	There are two queues. Active nodes are added
 	to the end of the second queue and read from
@@ -27,15 +32,15 @@
 	(and the second queue becomes empty).
 */
 
-inline void Graph::set_active(node *i)
+inline void Graph::set_active(int i)
 {
-	if (!i->next)
+	if (nodes[i].next == NONE)
 	{
 		/* it's not in the list yet */
-		if (queue_last[1]) queue_last[1] -> next = i;
-		else               queue_first[1]        = i;
+		if (queue_last[1] != NONE) nodes[queue_last[1]].next = i;
+		else                       queue_first[1]            = i;
 		queue_last[1] = i;
-		i -> next = i;
+		nodes[i].next = i;
 	}
 }
 
@@ -44,51 +49,75 @@ inline void Graph::set_active(node *i)
 	If it is connected to the sink, it stays in the list,
 	otherwise it is removed from the list
 */
-inline Graph::node * Graph::next_active()
+inline int Graph::next_active()
 {
-	node *i;
+	int i;
 
 	while ( 1 )
 	{
-		if (!(i=queue_first[0]))
+		if ((i=queue_first[0]) == NONE)
 		{
 			queue_first[0] = i = queue_first[1];
 			queue_last[0]  = queue_last[1];
-			queue_first[1] = NULL;
-			queue_last[1]  = NULL;
-			if (!i) return NULL;
+			queue_first[1] = NONE;
+			queue_last[1]  = NONE;
+			if (i == NONE) return NONE;
 		}
 
 		/* remove it from the active list */
-		if (i->next == i) queue_first[0] = queue_last[0] = NULL;
-		else              queue_first[0] = i -> next;
-		i -> next = NULL;
+		if (nodes[i].next == i) queue_first[0] = queue_last[0] = NONE;
+		else                    queue_first[0] = nodes[i].next;
+		nodes[i].next = NONE;
 
 		/* a node in the list is active iff it has a parent */
-		if (i->parent) return i;
+		if (nodes[i].parent != NONE) return i;
 	}
 }
 
 /***********************************************************************/
 
+/*
+	Functions for processing the list of orphans.
+	Orphans found while augmenting are added to the front,
+	those found while adopting are added to the back.
+*/
+
+inline void Graph::add_orphan_front(int i)
+{
+	nodes[i].parent = ORPHAN;
+	nodes[i].next_orphan = orphan_first;
+	orphan_first = i;
+}
+
+inline void Graph::add_orphan_back(int i)
+{
+	nodes[i].parent = ORPHAN;
+	nodes[i].next_orphan = NONE;
+	if (orphan_last != NONE) nodes[orphan_last].next_orphan = i;
+	else                     orphan_first                   = i;
+	orphan_last = i;
+}
+
+/***********************************************************************/
+
 void Graph::maxflow_init()
 {
 	node *i;
 
-	queue_first[0] = queue_last[0] = NULL;
-	queue_first[1] = queue_last[1] = NULL;
-	orphan_first = NULL;
+	queue_first[0] = queue_last[0] = NONE;
+	queue_first[1] = queue_last[1] = NONE;
+	orphan_first = orphan_last = NONE;
 
-	for (i=node_block->ScanFirst(); i; i=node_block->ScanNext())
+	for (i=nodes; i<nodes+node_count; i++)
 	{
-		i -> next = NULL;
+		i -> next = NONE;
 		i -> TS = 0;
 		if (i->tr_cap > 0)
 		{
 			/* i is connected to the source */
 			i -> is_sink = 0;
 			i -> parent = TERMINAL;
-			set_active(i);
+			set_active(i - nodes);
 			i -> TS = 0;
 			i -> DIST = 1;
 		}
@@ -97,13 +126,13 @@ void Graph::maxflow_init()
 			/* i is connected to the sink */
 			i -> is_sink = 1;
 			i -> parent = TERMINAL;
-			set_active(i);
+			set_active(i - nodes);
 			i -> TS = 0;
 			i -> DIST = 1;
 		}
 		else
 		{
-			i -> parent = NULL;
+			i -> parent = NONE;
 		}
 	}
 	TIME = 0;
@@ -111,90 +140,72 @@ void Graph::maxflow_init()
 
 /***********************************************************************/
 
-void Graph::augment(arc *middle_arc)
+void Graph::augment(int middle_arc)
 {
-	node *i;
-	arc *a;
+	int i, a;
 	captype bottleneck;
-	nodeptr *np;
 
 
 	/* 1. Finding bottleneck capacity */
 	/* 1a - the source tree */
-	bottleneck = middle_arc -> r_cap;
-	for (i=middle_arc->sister->head; ; i=a->head)
+	bottleneck = arcs[middle_arc].r_cap;
+	for (i=arcs[SISTER(middle_arc)].head; ; i=arcs[a].head)
 	{
-		a = i -> parent;
+		a = nodes[i].parent;
 		if (a == TERMINAL) break;
-		if (bottleneck > a->sister->r_cap) bottleneck = a -> sister -> r_cap;
+		if (bottleneck > arcs[SISTER(a)].r_cap) bottleneck = arcs[SISTER(a)].r_cap;
 	}
-	if (bottleneck > i->tr_cap) bottleneck = i -> tr_cap;
+	if (bottleneck > nodes[i].tr_cap) bottleneck = nodes[i].tr_cap;
 	/* 1b - the sink tree */
-	for (i=middle_arc->head; ; i=a->head)
+	for (i=arcs[middle_arc].head; ; i=arcs[a].head)
 	{
-		a = i -> parent;
+		a = nodes[i].parent;
 		if (a == TERMINAL) break;
-		if (bottleneck > a->r_cap) bottleneck = a -> r_cap;
+		if (bottleneck > arcs[a].r_cap) bottleneck = arcs[a].r_cap;
 	}
-	if (bottleneck > - i->tr_cap) bottleneck = - i -> tr_cap;
+	if (bottleneck > - nodes[i].tr_cap) bottleneck = - nodes[i].tr_cap;
 
 
 	/* 2. Augmenting */
 	/* 2a - the source tree */
-	middle_arc -> sister -> r_cap += bottleneck;
-	middle_arc -> r_cap -= bottleneck;
-	for (i=middle_arc->sister->head; ; i=a->head)
+	arcs[SISTER(middle_arc)].r_cap += bottleneck;
+	arcs[middle_arc].r_cap -= bottleneck;
+	for (i=arcs[SISTER(middle_arc)].head; ; i=arcs[a].head)
 	{
-		a = i -> parent;
+		a = nodes[i].parent;
 		if (a == TERMINAL) break;
-		a -> r_cap += bottleneck;
-		a -> sister -> r_cap -= bottleneck;
-		if (!a->sister->r_cap)
+		arcs[a].r_cap += bottleneck;
+		arcs[SISTER(a)].r_cap -= bottleneck;
+		if (!arcs[SISTER(a)].r_cap)
 		{
 			/* add i to the adoption list */
-			i -> parent = ORPHAN;
-			np = nodeptr_block -> New();
-			np -> ptr = i;
-			np -> next = orphan_first;
-			orphan_first = np;
+			add_orphan_front(i);
 		}
 	}
-	i -> tr_cap -= bottleneck;
-	if (!i->tr_cap)
+	nodes[i].tr_cap -= bottleneck;
+	if (!nodes[i].tr_cap)
 	{
 		/* add i to the adoption list */
-		i -> parent = ORPHAN;
-		np = nodeptr_block -> New();
-		np -> ptr = i;
-		np -> next = orphan_first;
-		orphan_first = np;
+		add_orphan_front(i);
 	}
 	/* 2b - the sink tree */
-	for (i=middle_arc->head; ; i=a->head)
+	for (i=arcs[middle_arc].head; ; i=arcs[a].head)
 	{
-		a = i -> parent;
+		a = nodes[i].parent;
 		if (a == TERMINAL) break;
-		a -> sister -> r_cap += bottleneck;
-		a -> r_cap -= bottleneck;
-		if (!a->r_cap)
+		arcs[SISTER(a)].r_cap += bottleneck;
+		arcs[a].r_cap -= bottleneck;
+		if (!arcs[a].r_cap)
 		{
 			/* add i to the adoption list */
-			i -> parent = ORPHAN;
-			np = nodeptr_block -> New();
-			np -> ptr = i;
-			np -> next = orphan_first;
-			orphan_first = np;
+			add_orphan_front(i);
 		}
 	}
-	i -> tr_cap += bottleneck;
-	if (!i->tr_cap)
+	nodes[i].tr_cap += bottleneck;
+	if (!nodes[i].tr_cap)
 	{
 		/* add i to the adoption list */
-		i -> parent = ORPHAN;
-		np = nodeptr_block -> New();
-		np -> ptr = i;
-		np -> next = orphan_first;
-		orphan_first = np;
+		add_orphan_front(i);
 	}
 
 
@@ -203,123 +214,113 @@ void Graph::augment(arc *middle_arc)
 
 /***********************************************************************/
 
-void Graph::process_source_orphan(node *i)
+void Graph::process_source_orphan(int i)
 {
-	node *j;
-	arc *a0, *a0_min = NULL, *a;
-	nodeptr *np;
+	int j, a0, a0_min = NONE, a;
 	int d, d_min = INFINITE_D;
 
 	/* trying to find a new parent */
-	for (a0=i->first; a0; a0=a0->next)
-	if (a0->sister->r_cap)
+	for (a0=nodes[i].first; a0!=NONE; a0=arcs[a0].next)
+	if (arcs[SISTER(a0)].r_cap)
 	{
-		j = a0 -> head;
-		if (!j->is_sink && (a=j->parent))
+		j = arcs[a0].head;
+		if (!nodes[j].is_sink && (a=nodes[j].parent) != NONE)
 		{
 			/* checking the origin of j */
 			d = 0;
 			while ( 1 )
 			{
-				if (j->TS == TIME)
+				if (nodes[j].TS == TIME)
 				{
-					d += j -> DIST;
+					d += nodes[j].DIST;
 					break;
 				}
-				a = j -> parent;
+				a = nodes[j].parent;
 				d ++;
 				if (a==TERMINAL)
 				{
-					j -> TS = TIME;
-					j -> DIST = 1;
+					nodes[j].TS = TIME;
+					nodes[j].DIST = 1;
 					break;
 				}
 				if (a==ORPHAN) { d = INFINITE_D; break; }
-				j = a -> head;
+				j = arcs[a].head;
 			}
 			if (d<INFINITE_D) /* j originates from the source - done */
-        {
+			{
 				if (d<d_min)
 				{
 					a0_min = a0;
 					d_min = d;
 				}
 				/* set marks along the path */
-				for (j=a0->head; j->TS!=TIME; j=j->parent->head)
+				for (j=arcs[a0].head; nodes[j].TS!=TIME; j=arcs[nodes[j].parent].head)
 				{
-					j -> TS = TIME;
-					j -> DIST = d --;
+					nodes[j].TS = TIME;
+					nodes[j].DIST = d --;
 				}
 			}
 		}
 	}
 
-	if ((i->parent = a0_min))
+	if ((nodes[i].parent = a0_min) != NONE)
 	{
-		i -> TS = TIME;
-		i -> DIST = d_min + 1;
+		nodes[i].TS = TIME;
+		nodes[i].DIST = d_min + 1;
 	}
 	else
 	{
 		/* no parent is found */
-		i -> TS = 0;
+		nodes[i].TS = 0;
 
 		/* process neighbors */
-		for (a0=i->first; a0; a0=a0->next)
+		for (a0=nodes[i].first; a0!=NONE; a0=arcs[a0].next)
 		{
-			j = a0 -> head;
-			if (!j->is_sink && (a=j->parent))
+			j = arcs[a0].head;
+			if (!nodes[j].is_sink && (a=nodes[j].parent) != NONE)
 			{
-				if (a0->sister->r_cap) set_active(j);
-				if (a!=TERMINAL && a!=ORPHAN && a->head==i)
+				if (arcs[SISTER(a0)].r_cap) set_active(j);
+				if (a!=TERMINAL && a!=ORPHAN && arcs[a].head==i)
 				{
 					/* add j to the adoption list */
-					j -> parent = ORPHAN;
-					np = nodeptr_block -> New();
-					np -> ptr = j;
-					if (orphan_last) orphan_last -> next = np;
-					else             orphan_first        = np;
-					orphan_last = np;
-					np -> next = NULL;
+					add_orphan_back(j);
 				}
 			}
 		}
 	}
 }
 
-void Graph::process_sink_orphan(node *i)
+void Graph::process_sink_orphan(int i)
 {
-	node *j;
-	arc *a0, *a0_min = NULL, *a;
-	nodeptr *np;
+	int j, a0, a0_min = NONE, a;
 	int d, d_min = INFINITE_D;
 
 	/* trying to find a new parent */
-	for (a0=i->first; a0; a0=a0->next)
-	if (a0->r_cap)
+	for (a0=nodes[i].first; a0!=NONE; a0=arcs[a0].next)
+	if (arcs[a0].r_cap)
 	{
-		j = a0 -> head;
-		if (j->is_sink && (a=j->parent))
+		j = arcs[a0].head;
+		if (nodes[j].is_sink && (a=nodes[j].parent) != NONE)
 		{
 			/* checking the origin of j */
 			d = 0;
 			while ( 1 )
 			{
-				if (j->TS == TIME)
+				if (nodes[j].TS == TIME)
 				{
-					d += j -> DIST;
+					d += nodes[j].DIST;
 					break;
 				}
-				a = j -> parent;
+				a = nodes[j].parent;
 				d ++;
 				if (a==TERMINAL)
 				{
-					j -> TS = TIME;
-					j -> DIST = 1;
+					nodes[j].TS = TIME;
+					nodes[j].DIST = 1;
 					break;
 				}
 				if (a==ORPHAN) { d = INFINITE_D; break; }
-				j = a -> head;
+				j = arcs[a].head;
 			}
 			if (d<INFINITE_D) /* j originates from the sink - done */
 			{
@@ -329,42 +330,36 @@ void Graph::process_sink_orphan(node *i)
 					d_min = d;
 				}
 				/* set marks along the path */
-				for (j=a0->head; j->TS!=TIME; j=j->parent->head)
+				for (j=arcs[a0].head; nodes[j].TS!=TIME; j=arcs[nodes[j].parent].head)
 				{
-					j -> TS = TIME;
-					j -> DIST = d --;
+					nodes[j].TS = TIME;
+					nodes[j].DIST = d --;
 				}
 			}
 		}
 	}
 
-	if ((i->parent = a0_min))
+	if ((nodes[i].parent = a0_min) != NONE)
 	{
-		i -> TS = TIME;
-		i -> DIST = d_min + 1;
+		nodes[i].TS = TIME;
+		nodes[i].DIST = d_min + 1;
 	}
 	else
 	{
 		/* no parent is found */
-		i -> TS = 0;
+		nodes[i].TS = 0;
 
 		/* process neighbors */
-		for (a0=i->first; a0; a0=a0->next)
+		for (a0=nodes[i].first; a0!=NONE; a0=arcs[a0].next)
 		{
-			j = a0 -> head;
-			if (j->is_sink && (a=j->parent))
+			j = arcs[a0].head;
+			if (nodes[j].is_sink && (a=nodes[j].parent) != NONE)
 			{
-				if (a0->r_cap) set_active(j);
-				if (a!=TERMINAL && a!=ORPHAN && a->head==i)
+				if (arcs[a0].r_cap) set_active(j);
+				if (a!=TERMINAL && a!=ORPHAN && arcs[a].head==i)
 				{
 					/* add j to the adoption list */
-					j -> parent = ORPHAN;
-					np = nodeptr_block -> New();
-					np -> ptr = j;
-					if (orphan_last) orphan_last -> next = np;
-					else             orphan_first        = np;
-					orphan_last = np;
-					np -> next = NULL;
+					add_orphan_back(j);
 				}
 			}
 		}
@@ -375,84 +370,82 @@ void Graph::process_sink_orphan(node *i)
 
 Graph::flowtype Graph::maxflow()
 {
-	node *i, *j, *current_node = NULL;
-	arc *a;
-	nodeptr *np, *np_next;
+	int i, j, a, current_node = NONE;
+	int np, np_next;
 
 	maxflow_init();
-	nodeptr_block = new DBlock<nodeptr>(NODEPTR_BLOCK_SIZE, error_function);
 
 	while ( 1 )
 	{
-		if ((i=current_node))
+		if ((i=current_node) != NONE)
 		{
-			i -> next = NULL; /* remove active flag */
-			if (!i->parent) i = NULL;
+			nodes[i].next = NONE; /* remove active flag */
+			if (nodes[i].parent == NONE) i = NONE;
 		}
-		if (!i)
+		if (i == NONE)
 		{
-			if (!(i = next_active())) break;
+			if ((i = next_active()) == NONE) break;
 		}
 
 		/* growth */
-		if (!i->is_sink)
-    {
+		if (!nodes[i].is_sink)
+		{
 			/* grow source tree */
-      for (a=i->first; a; a=a->next)
-        if (a->r_cap)
-        {
-          j = a -> head;
-          if (!j->parent)
-          {
-            j -> is_sink = 0;
-            j -> parent = a -> sister;
-            j -> TS = i -> TS;
-            j -> DIST = i -> DIST + 1;
-            set_active(j);
-          }
-          else if (j->is_sink) break;
-          else if (j->TS <= i->TS &&
-                   j->DIST > i->DIST)
-          {
-            /* heuristic - trying to make the distance from j to the source shorter */
-            j -> parent = a -> sister;
-            j -> TS = i -> TS;
-            j -> DIST = i -> DIST + 1;
-          }
-        }
-      }
+			for (a=nodes[i].first; a!=NONE; a=arcs[a].next)
+			if (arcs[a].r_cap)
+			{
+				j = arcs[a].head;
+				if (nodes[j].parent == NONE)
+				{
+					nodes[j].is_sink = 0;
+					nodes[j].parent = SISTER(a);
+					nodes[j].TS = nodes[i].TS;
+					nodes[j].DIST = nodes[i].DIST + 1;
+					set_active(j);
+				}
+				else if (nodes[j].is_sink) break;
+				else if (nodes[j].TS <= nodes[i].TS &&
+				         nodes[j].DIST > nodes[i].DIST)
+				{
+					/* heuristic - trying to make the distance from j to the source shorter */
+					nodes[j].parent = SISTER(a);
+					nodes[j].TS = nodes[i].TS;
+					nodes[j].DIST = nodes[i].DIST + 1;
+				}
+			}
+		}
 		else
 		{
 			/* grow sink tree */
-			for (a=i->first; a; a=a->next)
-			if (a->sister->r_cap)
+			for (a=nodes[i].first; a!=NONE; a=arcs[a].next)
+			if (arcs[SISTER(a)].r_cap)
 			{
-				j = a -> head;
-				if (!j->parent)
+				j = arcs[a].head;
+				if (nodes[j].parent == NONE)
 				{
-					j -> is_sink = 1;
-					j -> parent = a -> sister;
-					j -> TS = i -> TS;
-					j -> DIST = i -> DIST + 1;
+					nodes[j].is_sink = 1;
+					nodes[j].parent = SISTER(a);
+					nodes[j].TS = nodes[i].TS;
+					nodes[j].DIST = nodes[i].DIST + 1;
 					set_active(j);
 				}
-				else if (!j->is_sink) { a = a -> sister; break; }
-				else if (j->TS <= i->TS &&
-				         j->DIST > i->DIST)
+				else if (!nodes[j].is_sink) { a = SISTER(a); break; }
+				else if (nodes[j].TS <= nodes[i].TS &&
+				         nodes[j].DIST > nodes[i].DIST)
 				{
 					/* heuristic - trying to make the distance from j to the sink shorter */
-					j -> parent = a -> sister;
-					j -> TS = i -> TS;
-					j -> DIST = i -> DIST + 1;
+					nodes[j].parent = SISTER(a);
+					nodes[j].TS = nodes[i].TS;
+					nodes[j].DIST = nodes[i].DIST + 1;
 				}
 			}
 		}
 
 		TIME ++;
 
-		if (a)
+		if (a != NONE)
 		{
-			i -> next = i; /* set active flag */
+			nodes[i].next = i; /* set active flag */
 			current_node = i;
 
 			/* augmentation */
@@ -460,30 +453,26 @@ Graph::flowtype Graph::maxflow()
 			/* augmentation end */
 
 			/* adoption */
-			while ((np=orphan_first))
+			while ((np=orphan_first) != NONE)
 			{
-				np_next = np -> next;
-				np -> next = NULL;
+				np_next = nodes[np].next_orphan;
+				nodes[np].next_orphan = NONE;
 
-				while ((np=orphan_first))
+				while ((np=orphan_first) != NONE)
 				{
-					orphan_first = np -> next;
-					i = np -> ptr;
-					nodeptr_block -> Delete(np);
-					if (!orphan_first) orphan_last = NULL;
-					if (i->is_sink) process_sink_orphan(i);
-					else            process_source_orphan(i);
+					orphan_first = nodes[np].next_orphan;
+					if (orphan_first == NONE) orphan_last = NONE;
+					if (nodes[np].is_sink) process_sink_orphan(np);
+					else                   process_source_orphan(np);
 				}
 
 				orphan_first = np_next;
 			}
 			/* adoption end */
 		}
-		else current_node = NULL;
+		else current_node = NONE;
 	}
 
-	delete nodeptr_block;
-
 	return flow;
 }
 
@@ -491,6 +480,6 @@ Graph::flowtype Graph::maxflow()
 
 Graph::termtype Graph::what_segment(node_id i)
 {
-	if (((node*)i)->parent && !((node*)i)->is_sink) return SOURCE;
+	if (nodes[i].parent != NONE && !nodes[i].is_sink) return SOURCE;
 	return SINK;
 }
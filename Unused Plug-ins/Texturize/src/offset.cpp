@@ -16,51 +16,76 @@
 #include "GIMPBridge.h"
 #include "texturize.h"
 
-/* Calcule la distance entre image_tab et patch_tab pour la zone remplie:
- * (x_min,y_min) -> (x_max,y_max) dans image_tab
- * (x_min,y_min)-posn -> (x_max,y_max)-posn dans patch_tab */
-
-float
-difference (gint width_i, gint height_i, gint width_p, gint height_p,
-            guchar * image, guchar * patch,
-            gint posn_x, gint posn_y,
-            gint x_min, gint y_min, gint x_max, gint y_max,
-            gint channels, guchar ** rempli)
+#include <algorithm>
+#include <complex>
+#include <vector>
+#include <dispatch/dispatch.h>
+
+typedef std::complex<double> cplx;
+
+/* The offset search minimises the mean squared difference between the
+ * filled part of the image and the patch.  For a position p it is
+ *
+ *   SSD(p) = sum_q M(q) I(q)^2 - 2 sum_q M(q) I(q) P(q-p) + sum_q M(q) P(q-p)^2
+ *
+ * where M is the rempli mask and q ranges over the patch placed at p.  Each
+ * term is a cross-correlation so all positions are scored at once with
+ * FFTs rather than by comparing the patch at every position in turn. */
+
+// In-place radix-2 FFT of n (a power of two) points spaced stride apart.
+static void
+fft_1d (cplx *data, gint n, gint stride, gboolean inverse)
 {
-  gint    somme = 0, zone=0, x_i, y_i, k;
-  guchar *image_ptr, *patch_ptr;
-  gint    real_y_i, real_x_i;
+  gint i, j, bit, len;
 
-  for (y_i = y_min; y_i < y_max; y_i++)
+  for (i = 1, j = 0; i < n; i++)
   {
-    real_y_i = modulo (y_i, height_i);
-
-    image_ptr = image + (real_y_i * width_i + modulo (x_min, width_i)) * channels;
-    patch_ptr = patch + ((real_y_i - posn_y) * width_p + modulo (x_min, width_i) - posn_x) * channels;
+    for (bit = n >> 1; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j) std::swap (data[i * stride], data[j * stride]);
+  }
 
-    for (x_i = x_min; x_i < x_max; x_i++)
+  for (len = 2; len <= n; len <<= 1)
+  {
+    double angle = (inverse ? 2.0 : -2.0) * M_PI / len;
+    cplx   wlen (cos (angle), sin (angle));
+    for (i = 0; i < n; i += len)
     {
-      real_x_i = modulo (x_i, width_i);
-
-      if (rempli[real_x_i][real_y_i])
+      cplx w (1.0, 0.0);
+      for (j = 0; j < len / 2; j++)
       {
-        for(k = 0 ; k < channels; k++)
-        {
-          somme += abs (*image_ptr++ - *patch_ptr++);
-          zone ++;
-        }
-      }
-      else
-      {
-        image_ptr += channels;
-        patch_ptr += channels;
+        cplx u = data[(i + j) * stride];
+        cplx v = data[(i + j + len / 2) * stride] * w;
+        data[(i + j) * stride] = u + v;
+        data[(i + j + len / 2) * stride] = u - v;
+        w *= wlen;
       }
     }
   }
-  if (zone == 0) {printf("bug:zone=0\n"); exit(-1);}
-  return (((float) somme) / ((float) zone));
 }
 
+// 2D FFT of an nx by ny array, rows and columns are transformed in parallel.
+static void
+fft_2d (cplx *data, gint nx, gint ny, gboolean inverse)
+{
+  dispatch_queue_t queue = dispatch_get_global_queue (0, 0);
+
+  dispatch_apply (ny, queue, ^(size_t y) { fft_1d (data + y * nx, nx, 1, inverse); });
+  dispatch_apply (nx, queue, ^(size_t x) { fft_1d (data + x, ny, nx, inverse); });
+  if (inverse)
+  {
+    double scale = 1.0 / ((double) nx * ny);
+    for (gint k = 0; k < nx * ny; k++) data[k] *= scale;
+  }
+}
+
+static gint
+power_of_two (gint x)
+{
+  gint n = 1;
+  while (n < x) n <<= 1;
+  return n;
+}
 
 void
 offset_optimal (gint    *resultat,
@@ -70,35 +95,96 @@ offset_optimal (gint    *resultat,
                 gint     channels, guchar **rempli,
                 gboolean tileable)
 {
-  gint x_i, y_i;
-  float best_difference = HUGE, tmp_difference;
+  gint   n_x = x_patch_posn_max - x_patch_posn_min, n_y = y_patch_posn_max - y_patch_posn_min;
+  gint   width_r = n_x + width_p - 1, height_r = n_y + height_p - 1;
+  gint   nx = power_of_two (width_r), ny = power_of_two (height_r), size = nx * ny;
+  float  best_difference = HUGE;
+  std::vector<cplx> f_mask (size), f_box (size), tmp (size), numerator (size), zone (size);
+  gint   x, y, k;
+
+  resultat[0] = x_patch_posn_min; resultat[1] = y_patch_posn_min;
+  if (n_x <= 0 || n_y <= 0) return;
 
-  for (x_i = x_patch_posn_min; x_i < x_patch_posn_max; x_i++) {
-    for (y_i = y_patch_posn_min; y_i < y_patch_posn_max; y_i++) {
-      if (tileable) /* Move this test outside the loops? */
+  /* Fill buf with the region of the image under every candidate position,
+   * weighted by the mask and passed through value (k < 0 for the mask alone,
+   * k < channels for a channel, k == channels for the sum of squares). */
+  auto fill_region = [&] (std::vector<cplx> &buf, gint k)
+  {
+    cplx *buf_ptr = buf.data ();
+    std::fill (buf.begin (), buf.end (), cplx (0.0, 0.0));
+    dispatch_apply (height_r, dispatch_get_global_queue (0, 0), ^(size_t v) {
+      gint real_y = y_patch_posn_min + (gint) v, real_x, u, c;
+      double value;
+      if (tileable) real_y = ((real_y % height_i) + height_i) % height_i;
+      else if (real_y < 0 || real_y >= height_i) return;
+      for (u = 0; u < width_r; u++)
       {
-        tmp_difference = difference (
-          width_i, height_i,
-          width_p, height_p,
-          image, patch,
-          x_i, y_i,
-          MAX (0, x_i), MAX (0, y_i), x_i + width_p, y_i + height_p,
-          channels, rempli);
+        real_x = x_patch_posn_min + u;
+        if (tileable) real_x = ((real_x % width_i) + width_i) % width_i;
+        else if (real_x < 0 || real_x >= width_i) continue;
+        if (!rempli[real_x][real_y]) continue;
+        guchar *pixel = image + (real_y * width_i + real_x) * channels;
+        if (k < 0) value = 1.0;
+        else if (k < channels) value = pixel[k];
+        else for (value = 0.0, c = 0; c < channels; c++) value += (double) pixel[c] * pixel[c];
+        buf_ptr[v * nx + u] = value;
       }
-      else
+    });
+    fft_2d (buf_ptr, nx, ny, FALSE);
+  };
+
+  // Likewise for the patch (k < 0 for its extent).
+  auto fill_patch = [&] (std::vector<cplx> &buf, gint k)
+  {
+    cplx *buf_ptr = buf.data ();
+    std::fill (buf.begin (), buf.end (), cplx (0.0, 0.0));
+    dispatch_apply (height_p, dispatch_get_global_queue (0, 0), ^(size_t v) {
+      gint u, c;
+      double value;
+      for (u = 0; u < width_p; u++)
       {
-        tmp_difference = difference (
-          width_i, height_i,
-          width_p, height_p,
-          image, patch,
-          x_i, y_i,
-          MAX (0,x_i), MAX (0,y_i), MIN (x_i + width_p, width_i), MIN (y_i + height_p, height_i),
-          channels, rempli);
+        guchar *pixel = patch + (v * width_p + u) * channels;
+        if (k < 0) value = 1.0;
+        else if (k < channels) value = pixel[k];
+        else for (value = 0.0, c = 0; c < channels; c++) value += (double) pixel[c] * pixel[c];
+        buf_ptr[v * nx + u] = value;
       }
+    });
+    fft_2d (buf_ptr, nx, ny, FALSE);
+  };
+
+  // Accumulate the correlations in the frequency domain
+  auto accumulate = [&] (std::vector<cplx> &dest, std::vector<cplx> &a, std::vector<cplx> &b, double weight)
+  {
+    for (gint i = 0; i < size; i++) dest[i] += weight * a[i] * std::conj (b[i]);
+  };
+
+  fill_region (f_mask, -1);
+  fill_patch (f_box, -1);
+  accumulate (zone, f_mask, f_box, 1.0);
+  fill_patch (tmp, channels);
+  accumulate (numerator, f_mask, tmp, 1.0);
+  fill_region (tmp, channels);
+  accumulate (numerator, tmp, f_box, 1.0);
+  for (k = 0; k < channels; k++)
+  {
+    fill_region (tmp, k);
+    fill_patch (f_box, k);
+    accumulate (numerator, tmp, f_box, -2.0);
+  }
+  fft_2d (numerator.data (), nx, ny, TRUE);
+  fft_2d (zone.data (), nx, ny, TRUE);
+
+  // Pick the position with the smallest mean difference over its filled zone
+  for (x = 0; x < n_x; x++) {
+    for (y = 0; y < n_y; y++) {
+      double filled = zone[y * nx + x].real ();
+      if (filled < 0.5) continue;
+      float tmp_difference = (float) (numerator[y * nx + x].real () / (filled * channels));
       if (tmp_difference < best_difference)
       {
         best_difference = tmp_difference;
-        resultat[0] = x_i; resultat[1] = y_i;
+        resultat[0] = x_patch_posn_min + x; resultat[1] = y_patch_posn_min + y;
       }
     }
   }
@@ -38,6 +38,7 @@ int render(unsigned char *image_in, int width_in, int height_in, unsigned char *
 	while (compter_remplis (rempli,width_out,height_out) < (width_out * height_out)) {
 		if (pixel_a_remplir (rempli, width_out, height_out, cur_posn) == NULL) {
 			g_message (_("There was a problem when filling the new image."));
+			libere_graphe ();
 			return -1;
 		};
 
@@ -67,6 +68,7 @@ int render(unsigned char *image_in, int width_in, int height_in, unsigned char *
 		[progressBar display];
 	}
 
+	libere_graphe ();
 	g_free (coupe_h_here);
 	g_free (coupe_h_west);
 	g_free (coupe_v_here);
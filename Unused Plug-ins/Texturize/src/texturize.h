@@ -16,6 +16,9 @@ void decoupe_graphe(
     guchar  *coupe_v_here, guchar * coupe_v_north,  //*< idem for vertical cuts
     gboolean make_tileable, gboolean invert);
 
+//! Frees the graph decoupe_graphe keeps from one patch to the next.
+void libere_graphe (void);
+
 //! Allocates the memory (with malloc) and fills with 0.
 guchar ** init_guchar_tab_2d (gint x, gint y);
 
@@ -16,7 +16,30 @@
 OSStatus GenerateThumbnailForURL(void *thisInterface, QLThumbnailRequestRef thumbnail, CFURLRef url, CFStringRef contentTypeUTI, CFDictionaryRef options, CGSize maxSize)
 {
 	@autoreleasepool {
-		XCFContent *contents = [[XCFContent alloc] initWithContentsOfFile: [(__bridge NSURL *)url path]];
+		NSString *path = [(__bridge NSURL *)url path];
+		XCFContent *headers = [[XCFContent alloc] initWithHeadersOfFile:path];
+		if (headers == nil)
+			return noErr;
+		
+		// Prefer the thumbnail the GIMP embeds in the file
+		ParasiteData *thumbParasite = [headers parasiteWithName:@"gimp-image-thumbnail"];
+		if (thumbParasite && thumbParasite->size > 0) {
+			NSData *thumbData = [NSData dataWithBytes:thumbParasite->data length:thumbParasite->size];
+			if ([[NSBitmapImageRep alloc] initWithData:thumbData]) {
+				QLThumbnailRequestSetImageWithData(thumbnail, (__bridge CFDataRef)thumbData, NULL);
+				return noErr;
+			}
+		}
+		
+		// Otherwise read at the largest reduction that still covers the requested size
+		int reduction = 1;
+		CGFloat scale = MIN(maxSize.width / [headers width], maxSize.height / [headers height]);
+		while (scale > 0 && reduction * 2 * scale <= 1.0)
+			reduction *= 2;
+		
+		XCFContent *contents = [[XCFContent alloc] initWithContentsOfFile:path reduction:reduction];
+		if (contents == nil)
+			return noErr;
 		SeaWhiteboard *whiteboard = [[SeaWhiteboard alloc] initWithContent:contents];
 		[whiteboard update];
 		
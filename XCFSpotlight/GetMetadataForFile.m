@@ -63,8 +63,8 @@ Boolean GetMetadataForFile(void* thisInterface,
     // Don't assume that there is an autorelease pool around the calling of this function.
     @autoreleasepool {
 		NSMutableDictionary *nsAttribs = (__bridge NSMutableDictionary*)attributes;
-		// load the document at the specified location
-		XCFContent *contents = [[XCFContent alloc] initWithContentsOfFile: (__bridge NSString *)pathToFile];
+		// load the document's headers at the specified location, none of the metadata needs pixels
+		XCFContent *contents = [[XCFContent alloc] initWithHeadersOfFile: (__bridge NSString *)pathToFile];
 		if (contents) {
 			int width = [contents width];
 			int height = [contents height];